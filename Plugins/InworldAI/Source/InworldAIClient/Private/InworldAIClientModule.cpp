@@ -1,6 +1,7 @@
 // Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
 
 #include "InworldAIClientModule.h"
+#include "InworldMetrics.h"
 
 #define LOCTEXT_NAMESPACE "FInworldAIClientModule"
 
@@ -36,6 +37,7 @@ void FInworldAIClientModule::StartupModule()
 
 void FInworldAIClientModule::ShutdownModule()
 {
+	FInworldClientMetrics::StopExport();
 	Inworld::LogClearLoggerCallback();
 }
 
@@ -0,0 +1,149 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#include "InworldAgentHandles.h"
+#include "InworldPackets.h"
+#include "InworldAIClientModule.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
+void FInworldAgentHandles::Reset()
+{
+	AgentIds.Reset();
+	HandleByAgentId.Reset();
+	LastHandle = INDEX_NONE;
+}
+
+int32 FInworldAgentHandles::Add(const FString& AgentId)
+{
+	if (const int32* Handle = HandleByAgentId.Find(AgentId))
+	{
+		return *Handle;
+	}
+
+	const int32 Handle = AgentIds.Add(AgentId);
+	HandleByAgentId.Add(AgentId, Handle);
+	return Handle;
+}
+
+int32 FInworldAgentHandles::Find(const FString& AgentId) const
+{
+	const int32* Handle = HandleByAgentId.Find(AgentId);
+	return Handle ? *Handle : INDEX_NONE;
+}
+
+void FInworldAgentHandles::Resolve(FInworldRouting& Routing) const
+{
+	Routing.Source.Handle = Routing.Source.Type == EInworldActorType::AGENT ? FindCached(Routing.Source.Name) : INDEX_NONE;
+	Routing.Target.Handle = Routing.Target.Type == EInworldActorType::AGENT ? FindCached(Routing.Target.Name) : INDEX_NONE;
+}
+
+int32 FInworldAgentHandles::FindCached(const FString& AgentId) const
+{
+	if (AgentIds.IsValidIndex(LastHandle) && AgentIds[LastHandle] == AgentId)
+	{
+		return LastHandle;
+	}
+
+	const int32 Handle = Find(AgentId);
+	if (Handle != INDEX_NONE)
+	{
+		LastHandle = Handle;
+	}
+	return Handle;
+}
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+	// Inworld.Debug.AgentDispatchBenchmark [Packets] [Agents]
+	void RunAgentDispatchBenchmark(const TArray<FString>& Args)
+	{
+		const int32 NumPackets = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+		const int32 NumAgents = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 200;
+
+		FInworldAgentHandles Handles;
+		TMap<FString, int32> IndexByAgentId;
+		TArray<FString> AgentIds;
+		for (int32 i = 0; i < NumAgents; i++)
+		{
+			const FString& AgentId = AgentIds.Add_GetRef(FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower));
+			Handles.Add(AgentId);
+			IndexByAgentId.Add(AgentId, i);
+		}
+
+		// Agents answer in runs of chunks, every fourth packet is the player talking to one.
+		FRandomStream Random(42);
+		TArray<FInworldRouting> Routings;
+		Routings.Reserve(NumPackets);
+		int32 Agent = 0;
+		for (int32 i = 0; i < NumPackets; i++)
+		{
+			if (i % 8 == 0)
+			{
+				Agent = Random.RandRange(0, NumAgents - 1);
+			}
+			const FInworldActor AgentActor(EInworldActorType::AGENT, AgentIds[Agent]);
+			const FInworldActor Player(EInworldActorType::PLAYER, TEXT("player"));
+			Routings.Add(i % 4 == 3 ? FInworldRouting(Player, AgentActor) : FInworldRouting(AgentActor, Player));
+		}
+
+		// Both dispatch to a per agent counter, like they would to a character component.
+		TArray<int32> ByIdHits, ByHandleHits;
+		ByIdHits.SetNumZeroed(NumAgents);
+		ByHandleHits.SetNumZeroed(NumAgents);
+
+		const double ByIdStart = FPlatformTime::Seconds();
+		for (const FInworldRouting& Routing : Routings)
+		{
+			if (const int32* Index = IndexByAgentId.Find(Routing.Source.Name))
+			{
+				ByIdHits[*Index]++;
+			}
+			if (const int32* Index = IndexByAgentId.Find(Routing.Target.Name))
+			{
+				ByIdHits[*Index]++;
+			}
+		}
+		const double ByIdTime = FPlatformTime::Seconds() - ByIdStart;
+
+		// Resolving happens once per packet when it is translated.
+		const double ResolveStart = FPlatformTime::Seconds();
+		for (FInworldRouting& Routing : Routings)
+		{
+			Handles.Resolve(Routing);
+		}
+		const double ResolveTime = FPlatformTime::Seconds() - ResolveStart;
+
+		const double ByHandleStart = FPlatformTime::Seconds();
+		for (const FInworldRouting& Routing : Routings)
+		{
+			if (ByHandleHits.IsValidIndex(Routing.Source.Handle))
+			{
+				ByHandleHits[Routing.Source.Handle]++;
+			}
+			if (ByHandleHits.IsValidIndex(Routing.Target.Handle))
+			{
+				ByHandleHits[Routing.Target.Handle]++;
+			}
+		}
+		const double ByHandleTime = FPlatformTime::Seconds() - ByHandleStart;
+
+		auto NsPerPacket = [NumPackets](double Seconds) { return Seconds * 1.0e9 / NumPackets; };
+		UE_LOG(LogInworldAIClient, Log, TEXT("Inworld agent dispatch benchmark: %d packets across %d agents"), NumPackets, NumAgents);
+		UE_LOG(LogInworldAIClient, Log, TEXT("  by agent id     %8.1f ns/packet"), NsPerPacket(ByIdTime));
+		UE_LOG(LogInworldAIClient, Log, TEXT("  resolve handles %8.1f ns/packet (at translation)"), NsPerPacket(ResolveTime));
+		UE_LOG(LogInworldAIClient, Log, TEXT("  by handle       %8.1f ns/packet"), NsPerPacket(ByHandleTime));
+		if (ByIdHits != ByHandleHits)
+		{
+			UE_LOG(LogInworldAIClient, Error, TEXT("Inworld agent dispatch benchmark: dispatch by handle reached different agents"));
+		}
+	}
+}
+
+static FAutoConsoleCommand CmdAgentDispatchBenchmark(
+	TEXT("Inworld.Debug.AgentDispatchBenchmark"),
+	TEXT("Time dispatching packets to agents by id against by interned handle. Args: [Packets=100000] [Agents=200]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunAgentDispatchBenchmark)
+);
+#endif
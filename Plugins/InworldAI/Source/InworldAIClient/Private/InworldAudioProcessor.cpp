@@ -0,0 +1,192 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#include "InworldAudioProcessor.h"
+#include "InworldAIClientModule.h"
+#include "InworldMetrics.h"
+
+#include "Async/Async.h"
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Stats/Stats.h"
+
+static TAutoConsoleVariable<float> CVarAECLatencyBudgetMs(
+	TEXT("Inworld.Audio.AECLatencyBudgetMs"), 500.f,
+	TEXT("Audio chunks waiting longer than this for echo cancellation are dropped")
+);
+
+static TAutoConsoleVariable<int32> CVarAECMaxQueuedChunks(
+	TEXT("Inworld.Audio.AECMaxQueuedChunks"), 16,
+	TEXT("Oldest audio chunks waiting for echo cancellation are dropped above this")
+);
+
+DECLARE_STATS_GROUP(TEXT("InworldAudio"), STATGROUP_InworldAudio, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("AEC Chunk"), STAT_InworldAECChunk, STATGROUP_InworldAudio);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AEC Queue Depth"), STAT_InworldAECQueueDepth, STATGROUP_InworldAudio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AEC Dropped Chunks"), STAT_InworldAECDroppedChunks, STATGROUP_InworldAudio);
+
+FInworldAudioProcessor::FInworldAudioProcessor(FSendAudio InSendAudio, FSendSessionControl InSendSessionControl)
+	: SendAudio(MoveTemp(InSendAudio))
+	, SendSessionControl(MoveTemp(InSendSessionControl))
+	, WakeUpEvent(FPlatformProcess::GetSynchEventFromPool())
+{
+	Thread.Reset(FRunnableThread::Create(this, TEXT("InworldAudioProcessor"), 0, TPri_AboveNormal));
+}
+
+FInworldAudioProcessor::~FInworldAudioProcessor()
+{
+	if (Thread.IsValid())
+	{
+		Thread->Kill(true);
+		Thread.Reset();
+	}
+	FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+	WakeUpEvent = nullptr;
+}
+
+void FInworldAudioProcessor::QueueAudio(const FString& AgentId, TArray<int16>&& Mic, TArray<int16>&& Playback)
+{
+	FCommand Command;
+	Command.Type = ECommand::Audio;
+	Command.AgentId = AgentId;
+	Command.Mic = MoveTemp(Mic);
+	Command.Playback = MoveTemp(Playback);
+	Queue(MoveTemp(Command));
+}
+
+void FInworldAudioProcessor::QueueStartSession(const FString& AgentId)
+{
+	FCommand Command;
+	Command.Type = ECommand::StartSession;
+	Command.AgentId = AgentId;
+	Queue(MoveTemp(Command));
+}
+
+void FInworldAudioProcessor::QueueStopSession(const FString& AgentId)
+{
+	FCommand Command;
+	Command.Type = ECommand::StopSession;
+	Command.AgentId = AgentId;
+	Queue(MoveTemp(Command));
+}
+
+void FInworldAudioProcessor::Queue(FCommand&& Command)
+{
+	check(IsInGameThread());
+	Command.QueuedTime = FPlatformTime::Seconds();
+	// Counted first, the worker may dequeue it as soon as it is enqueued.
+	QueueDepth++;
+	Commands.Enqueue(MoveTemp(Command));
+	WakeUpEvent->Trigger();
+}
+
+FInworldAudioProcessorStats FInworldAudioProcessor::GetStats() const
+{
+	FScopeLock Lock(&StatsLock);
+	FInworldAudioProcessorStats Result = Stats;
+	Result.QueueDepth = QueueDepth;
+	return Result;
+}
+
+uint32 FInworldAudioProcessor::Run()
+{
+	while (!bStopping)
+	{
+		FCommand Command;
+		if (!Commands.Dequeue(Command))
+		{
+			WakeUpEvent->Wait(100);
+			continue;
+		}
+
+		const int32 Depth = --QueueDepth;
+		SET_DWORD_STAT(STAT_InworldAECQueueDepth, Depth);
+		FInworldClientMetrics::Get().AECQueueDepth.Set(Depth);
+		{
+			FScopeLock Lock(&StatsLock);
+			Stats.MaxQueueDepth = FMath::Max(Stats.MaxQueueDepth, Depth + 1);
+		}
+
+		// Session commands are never dropped, they keep the filter and the server in sync.
+		if (Command.Type == ECommand::Audio)
+		{
+			const double WaitedMs = (FPlatformTime::Seconds() - Command.QueuedTime) * 1000.0;
+			if (WaitedMs > CVarAECLatencyBudgetMs.GetValueOnAnyThread() || Depth >= CVarAECMaxQueuedChunks.GetValueOnAnyThread())
+			{
+				INC_DWORD_STAT(STAT_InworldAECDroppedChunks);
+				FInworldClientMetrics::Get().AECDroppedChunks.Add();
+				FScopeLock Lock(&StatsLock);
+				Stats.FramesDropped++;
+				continue;
+			}
+		}
+
+		Process(Command);
+	}
+	return 0;
+}
+
+void FInworldAudioProcessor::Stop()
+{
+	bStopping = true;
+	WakeUpEvent->Trigger();
+}
+
+void FInworldAudioProcessor::Process(FCommand& Command)
+{
+	switch (Command.Type)
+	{
+	case ECommand::StartSession:
+		Filter.Reset();
+		PostSessionControl(Command.AgentId, true);
+		break;
+	case ECommand::StopSession:
+	{
+		int16 Remainder[Inworld::AECFilter::FrameSize];
+		PostAudio(Command.AgentId, Remainder, static_cast<int32>(Filter.Flush(Remainder)));
+		PostSessionControl(Command.AgentId, false);
+		break;
+	}
+	case ECommand::Audio:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_InworldAECChunk);
+		const double Start = FPlatformTime::Seconds();
+
+		Filtered.SetNumUninitialized(static_cast<int32>(Filter.GetMaxOutputSize(Command.Mic.Num())));
+		const int32 NumFiltered = static_cast<int32>(Filter.Process(Command.Mic.GetData(), Command.Mic.Num(), Command.Playback.GetData(), Command.Playback.Num(), Filtered.GetData()));
+		PostAudio(Command.AgentId, Filtered.GetData(), NumFiltered);
+
+		const double FrameMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+		FInworldClientMetrics::Get().AECFrameUs.Record(static_cast<uint64>(FrameMs * 1000.0));
+		FScopeLock Lock(&StatsLock);
+		Stats.FramesProcessed++;
+		Stats.LastFrameMs = FrameMs;
+		Stats.MaxFrameMs = FMath::Max(Stats.MaxFrameMs, FrameMs);
+		TotalFrameMs += FrameMs;
+		Stats.AvgFrameMs = TotalFrameMs / Stats.FramesProcessed;
+		break;
+	}
+	}
+}
+
+void FInworldAudioProcessor::PostAudio(const FString& AgentId, const int16* Samples, int32 Num)
+{
+	if (Num == 0)
+	{
+		return;
+	}
+
+	std::string Data(reinterpret_cast<const char*>(Samples), Num * sizeof(int16));
+	AsyncTask(ENamedThreads::GameThread, [SendAudio = SendAudio, AgentId, Data = MoveTemp(Data)]() mutable
+	{
+		SendAudio(AgentId, MoveTemp(Data));
+	});
+}
+
+void FInworldAudioProcessor::PostSessionControl(const FString& AgentId, bool bStart)
+{
+	AsyncTask(ENamedThreads::GameThread, [SendSessionControl = SendSessionControl, AgentId, bStart]()
+	{
+		SendSessionControl(AgentId, bStart);
+	});
+}
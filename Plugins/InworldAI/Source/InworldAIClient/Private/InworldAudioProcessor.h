@@ -0,0 +1,80 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Containers/Queue.h"
+#include "InworldClient.h"
+
+#include <string>
+
+THIRD_PARTY_INCLUDES_START
+#include "AECFilter.h"
+THIRD_PARTY_INCLUDES_END
+
+// Echo cancellation off the game thread. Mic and playback chunk pairs are queued from the game thread,
+// filtered on a dedicated thread, and the filtered audio is handed back to the game thread to be sent.
+// Audio session start and stop go through the same queue to stay ordered with the audio.
+// Chunks waiting longer than the latency budget are dropped, oldest first.
+class FInworldAudioProcessor : public FRunnable
+{
+public:
+	// Called on the game thread.
+	using FSendAudio = TFunction<void(const FString& AgentId, std::string&& Data)>;
+	using FSendSessionControl = TFunction<void(const FString& AgentId, bool bStart)>;
+
+	FInworldAudioProcessor(FSendAudio InSendAudio, FSendSessionControl InSendSessionControl);
+	virtual ~FInworldAudioProcessor();
+
+	// Game thread only.
+	void QueueAudio(const FString& AgentId, TArray<int16>&& Mic, TArray<int16>&& Playback);
+	void QueueStartSession(const FString& AgentId);
+	void QueueStopSession(const FString& AgentId);
+
+	FInworldAudioProcessorStats GetStats() const;
+
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	enum class ECommand : uint8
+	{
+		Audio,
+		StartSession,
+		StopSession,
+	};
+
+	struct FCommand
+	{
+		ECommand Type = ECommand::Audio;
+		FString AgentId;
+		TArray<int16> Mic;
+		TArray<int16> Playback;
+		double QueuedTime = 0.0;
+	};
+
+	void Queue(FCommand&& Command);
+	void Process(FCommand& Command);
+	void PostAudio(const FString& AgentId, const int16* Samples, int32 Num);
+	void PostSessionControl(const FString& AgentId, bool bStart);
+
+	FSendAudio SendAudio;
+	FSendSessionControl SendSessionControl;
+
+	// Single producer (game thread), single consumer (worker), lock-free.
+	TQueue<FCommand, EQueueMode::Spsc> Commands;
+	TAtomic<int32> QueueDepth { 0 };
+	FEvent* WakeUpEvent = nullptr;
+	TAtomic<bool> bStopping { false };
+	TUniquePtr<FRunnableThread> Thread;
+
+	// Worker only.
+	Inworld::AECFilter Filter;
+	TArray<int16> Filtered;
+
+	mutable FCriticalSection StatsLock;
+	FInworldAudioProcessorStats Stats;
+	double TotalFrameMs = 0.0;
+};
@@ -10,6 +10,8 @@
 #include "InworldUtils.h"
 #include "InworldAsyncRoutine.h"
 #include "InworldPacketTranslator.h"
+#include "InworldAudioProcessor.h"
+#include "InworldMetrics.h"
 
 THIRD_PARTY_INCLUDES_START
 #include "Packets.h"
@@ -19,6 +21,9 @@ THIRD_PARTY_INCLUDES_END
 
 #include "Async/Async.h"
 #include "Async/TaskGraphInterfaces.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
 
 #include <Interfaces/IPluginManager.h>
 
@@ -26,6 +31,16 @@ const FString DefaultTargetUrl = "api-engine.inworld.ai:443";
 
 #include <string>
 
+static TAutoConsoleVariable<bool> CVarSaveSessionSnapshots(
+	TEXT("Inworld.Session.SaveSnapshots"), true,
+	TEXT("Also write saved session states to Saved/Inworld/Sessions")
+);
+
+static TAutoConsoleVariable<bool> CVarRestoreSessionSnapshots(
+	TEXT("Inworld.Session.RestoreSnapshots"), false,
+	TEXT("Restore the last saved session state of the scene and user when a session is started without one")
+);
+
 #if !UE_BUILD_SHIPPING
 
 #include "AudioSessionDumper.h"
@@ -40,6 +55,21 @@ static TAutoConsoleVariable<FString> CVarSoundDumpPath(
 	TEXT("Specifiy path for audio input dump file")
 );
 
+static TAutoConsoleVariable<bool> CVarRecordPackets(
+	TEXT("Inworld.Debug.RecordPackets"), false,
+	TEXT("Record the packets of started sessions to Saved/Inworld/Recordings")
+);
+
+static TAutoConsoleVariable<FString> CVarReplayPackets(
+	TEXT("Inworld.Debug.ReplayPackets"), TEXT(""),
+	TEXT("Path of a packet recording started sessions replay instead of connecting")
+);
+
+static TAutoConsoleVariable<float> CVarReplaySpeed(
+	TEXT("Inworld.Debug.ReplaySpeed"), 1.f,
+	TEXT("Speed packet recordings are replayed at, 0 replays them without waiting")
+);
+
 FInworldClient::FOnAudioDumperCVarChanged FInworldClient::OnAudioDumperCVarChanged;
 
 FAutoConsoleVariableSink FInworldClient::CVarSink(FConsoleCommandDelegate::CreateStatic(&FInworldClient::OnCVarsChanged));
@@ -89,9 +119,11 @@ void FInworldClient::Init()
 		},
 		[this](std::shared_ptr<Inworld::Packet> Packet)
 		{
-			InworldPacketTranslator PacketTranslator;
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			InworldPacketTranslator PacketTranslator(AgentHandles);
 			Packet->Accept(PacketTranslator);
 			OnInworldPacketReceived.ExecuteIfBound(PacketTranslator.GetPacket());
+			FInworldClientMetrics::Get().RecordDispatch(*Packet, FPlatformTime::Cycles64() - StartCycles);
 		}
 	);
 
@@ -131,6 +163,7 @@ void FInworldClient::Destroy()
 	}
 	OnAudioDumperCVarChanged.Remove(OnAudioDumperCVarChangedHandle);
 #endif
+	AudioProcessor.Reset();
 	if (InworldClient)
 	{
 		InworldClient->DestroyClient();
@@ -177,6 +210,34 @@ void FInworldClient::Start(const FString& SceneName, const FInworldPlayerProfile
 	Options.Capabilities.PhonemeInfo = Capabilities.PhonemeInfo;
 	Options.Capabilities.LoadSceneInSession = Capabilities.LoadSceneInSession;
 
+	if (CVarSaveSessionSnapshots.GetValueOnGameThread() || CVarRestoreSessionSnapshots.GetValueOnGameThread())
+	{
+		const FString SnapshotDir = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir() / TEXT("Inworld") / TEXT("Sessions"));
+		if (IFileManager::Get().MakeDirectory(*SnapshotDir, true))
+		{
+			const FString SnapshotName = FMD5::HashAnsiString(*(SceneName + TEXT("|") + UTF8_TO_TCHAR(Options.UserId.c_str())));
+			Options.SessionSnapshotPath = TCHAR_TO_UTF8(*(SnapshotDir / SnapshotName + TEXT(".bin")));
+			Options.bRestoreSessionSnapshot = CVarRestoreSessionSnapshots.GetValueOnGameThread();
+		}
+	}
+
+#if !UE_BUILD_SHIPPING
+	const FString ReplayPath = CVarReplayPackets.GetValueOnGameThread();
+	if (!ReplayPath.IsEmpty())
+	{
+		Options.PacketReplayPath = TCHAR_TO_UTF8(*FPaths::ConvertRelativePathToFull(ReplayPath));
+		Options.PacketReplaySpeed = FMath::Max(CVarReplaySpeed.GetValueOnGameThread(), 0.f);
+	}
+	else if (CVarRecordPackets.GetValueOnGameThread())
+	{
+		const FString RecordingDir = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir() / TEXT("Inworld") / TEXT("Recordings"));
+		if (IFileManager::Get().MakeDirectory(*RecordingDir, true))
+		{
+			Options.PacketRecordingPath = TCHAR_TO_UTF8(*(RecordingDir / FDateTime::Now().ToString() + TEXT(".iwpr")));
+		}
+	}
+#endif
+
 	Inworld::SessionInfo Info;
 	Info.Token = TCHAR_TO_UTF8(*SessionToken.Token);
 	Info.ExpirationTime = SessionToken.ExpirationTime;
@@ -193,12 +254,14 @@ void FInworldClient::Start(const FString& SceneName, const FInworldPlayerProfile
 		{
 			TArray<FInworldAgentInfo> AgentInfos;
 			AgentInfos.Reserve(ResultAgentInfos.size());
+			AgentHandles.Reset();
 			for (const auto& ResultAgentInfo : ResultAgentInfos)
 			{
 				auto& AgentInfo = AgentInfos.AddDefaulted_GetRef();
 				AgentInfo.AgentId = UTF8_TO_TCHAR(ResultAgentInfo.AgentId.c_str());
 				AgentInfo.BrainName = UTF8_TO_TCHAR(ResultAgentInfo.BrainName.c_str());
 				AgentInfo.GivenName = UTF8_TO_TCHAR(ResultAgentInfo.GivenName.c_str());
+				AgentHandles.Add(AgentInfo.AgentId);
 			}
 			OnSceneLoaded.ExecuteIfBound(AgentInfos);
 		}
@@ -227,7 +290,7 @@ void FInworldClient::SaveSession()
 			FInworldSave Save;
 			if (!bSuccess)
 			{
-				UE_LOG(LogInworldAIClient, Error, TEXT("Couldn't generate user id."));
+				UE_LOG(LogInworldAIClient, Error, TEXT("Couldn't save session."));
 				OnSessionSaved.ExecuteIfBound(Save, false);
 				return;
 			}
@@ -285,7 +348,7 @@ FString FInworldClient::GetSessionId() const
 TSharedPtr<FInworldPacket> FInworldClient::SendTextMessage(const FString& AgentId, const FString& Text)
 {
 	auto Packet = InworldClient->SendTextMessage(TCHAR_TO_UTF8(*AgentId), TCHAR_TO_UTF8(*Text));
-	InworldPacketTranslator PacketTranslator;
+	InworldPacketTranslator PacketTranslator(AgentHandles);
 	Packet->Accept(PacketTranslator);
 	return PacketTranslator.GetPacket();
 }
@@ -293,7 +356,7 @@ TSharedPtr<FInworldPacket> FInworldClient::SendTextMessage(const FString& AgentI
 #if !UE_BUILD_SHIPPING
 void DumpAudio(TSharedPtr<class FAsyncAudioDumper> AudioDumper, std::shared_ptr<Inworld::DataEvent> DataEvent)
 {
-	if (AudioDumper.IsValid())
+	if (AudioDumper.IsValid() && DataEvent)
 	{
 		std::string data = DataEvent->GetDataChunk();
 		TArray<uint8> Chunk((uint8*)data.data(), data.size());
@@ -328,33 +391,134 @@ void FInworldClient::SendSoundMessageWithEAC(const FString& AgentId, USoundWave*
 	std::vector<int16_t> inputdata, outputdata;
 	if (Inworld::Utils::SoundWaveToVec(Input, inputdata) && Inworld::Utils::SoundWaveToVec(Output, outputdata))
 	{
-		auto packet = InworldClient->SendSoundMessageWithAEC(TCHAR_TO_UTF8(*AgentId), inputdata, outputdata);
-#if !UE_BUILD_SHIPPING
-		DumpAudio(AsyncAudioDumper, packet);
-#endif
+		SendFilteredSoundMessage(AgentId, TArray<int16>(inputdata.data(), static_cast<int32>(inputdata.size())), TArray<int16>(outputdata.data(), static_cast<int32>(outputdata.size())));
 	}
 }
 
 void FInworldClient::SendSoundDataMessageWithEAC(const FString& AgentId, const TArray<uint8>& InputData, const TArray<uint8>& OutputData)
 {
-	std::vector<int16> inputdata((int16*)InputData.GetData(), ((int16*)InputData.GetData()) + (InputData.Num() / 2));
-	std::vector<int16> outputdata((int16*)OutputData.GetData(), ((int16*)OutputData.GetData()) + (OutputData.Num() / 2));
-	auto packet = InworldClient->SendSoundMessageWithAEC(TCHAR_TO_UTF8(*AgentId), inputdata, outputdata);
+	SendFilteredSoundMessage(AgentId,
+		TArray<int16>(reinterpret_cast<const int16*>(InputData.GetData()), InputData.Num() / 2),
+		TArray<int16>(reinterpret_cast<const int16*>(OutputData.GetData()), OutputData.Num() / 2));
+}
+
+void FInworldClient::SendFilteredSoundMessage(const FString& AgentId, TArray<int16>&& InputData, TArray<int16>&& OutputData)
+{
+	if (!AudioProcessor)
+	{
+		TWeakPtr<Inworld::FClient> ClientWeakPtr = InworldClient;
 #if !UE_BUILD_SHIPPING
-	DumpAudio(AsyncAudioDumper, packet);
+		TWeakPtr<FAsyncAudioDumper> AudioDumperWeakPtr = AsyncAudioDumper;
+#endif
+		AudioProcessor = MakeShared<FInworldAudioProcessor>(
+			[=](const FString& FilteredAgentId, std::string&& Data)
+			{
+				if (auto Client = ClientWeakPtr.Pin())
+				{
+					auto packet = Client->SendSoundMessage(TCHAR_TO_UTF8(*FilteredAgentId), Data);
+#if !UE_BUILD_SHIPPING
+					DumpAudio(AudioDumperWeakPtr.Pin(), packet);
 #endif
+				}
+			},
+			[=](const FString& SessionAgentId, bool bStart)
+			{
+				if (auto Client = ClientWeakPtr.Pin())
+				{
+					if (bStart)
+					{
+						Client->StartAudioSession(TCHAR_TO_UTF8(*SessionAgentId));
+					}
+					else
+					{
+						Client->StopAudioSession(TCHAR_TO_UTF8(*SessionAgentId));
+					}
+				}
+			});
+	}
+
+	AudioProcessor->QueueAudio(AgentId, MoveTemp(InputData), MoveTemp(OutputData));
 }
 
 void FInworldClient::StartAudioSession(const FString& AgentId)
 {
+	// Ordered with the audio waiting for echo cancellation.
+	if (AudioProcessor)
+	{
+		AudioProcessor->QueueStartSession(AgentId);
+		return;
+	}
 	InworldClient->StartAudioSession(TCHAR_TO_UTF8(*AgentId));
 }
 
 void FInworldClient::StopAudioSession(const FString& AgentId)
 {
+	if (AudioProcessor)
+	{
+		AudioProcessor->QueueStopSession(AgentId);
+		return;
+	}
 	InworldClient->StopAudioSession(TCHAR_TO_UTF8(*AgentId));
 }
 
+bool FInworldClient::GetAudioProcessorStats(FInworldAudioProcessorStats& OutStats) const
+{
+	if (!AudioProcessor)
+	{
+		return false;
+	}
+	OutStats = AudioProcessor->GetStats();
+	return true;
+}
+
+FInworldTransportStats FInworldClient::GetTransportStats() const
+{
+	FInworldTransportStats OutStats;
+	if (!InworldClient)
+	{
+		return OutStats;
+	}
+
+	const Inworld::ClientBase::TransportStats Stats = InworldClient->GetTransportStats();
+	OutStats.PacketsReceived = Stats.PacketsReceived;
+	OutStats.BytesReceived = Stats.BytesReceived;
+	OutStats.PacketsSent = Stats.PacketsSent;
+	OutStats.BytesSent = Stats.BytesSent;
+	OutStats.WriteQueueDepth = Stats.WriteQueueDepth;
+	return OutStats;
+}
+
+void FInworldClient::GetTimeToFirstAudioStats(TMap<FString, FInworldTimeToFirstAudioStats>& OutStats) const
+{
+	OutStats.Reset();
+	if (!InworldClient)
+	{
+		return;
+	}
+
+	constexpr double UsToMs = 1000.0;
+	for (const auto& Pair : InworldClient->GetPerceivedLatencyTracker().GetTimeToFirstAudioByAgent())
+	{
+		const Inworld::LatencyHistogram& Histogram = Pair.second;
+		const Inworld::HistogramStats Stats = Histogram.GetStats(UsToMs);
+
+		FInworldTimeToFirstAudioStats& AgentStats = OutStats.Add(UTF8_TO_TCHAR(Pair.first.c_str()));
+		AgentStats.Count = Stats.Count;
+		AgentStats.P50Ms = Stats.P50;
+		AgentStats.P95Ms = Stats.P95;
+		AgentStats.MaxMs = Stats.Max;
+
+		uint64 Below = 0;
+		for (int32 i = 0; i < FInworldTimeToFirstAudioStats::NumBuckets - 1; i++)
+		{
+			const uint64 BelowBound = Histogram.CountBelow(FInworldTimeToFirstAudioStats::BucketBoundsMs[i] * 1000);
+			AgentStats.Buckets[i] = BelowBound - Below;
+			Below = BelowBound;
+		}
+		AgentStats.Buckets[FInworldTimeToFirstAudioStats::NumBuckets - 1] = Stats.Count - Below;
+	}
+}
+
 void FInworldClient::SendCustomEvent(const FString& AgentId, const FString& Name, const TMap<FString, FString>& Params)
 {
 	std::unordered_map<std::string, std::string> params;
@@ -0,0 +1,245 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#include "InworldMetrics.h"
+#include "InworldAIClientModule.h"
+
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "Packets.h"
+THIRD_PARTY_INCLUDES_END
+
+#include <atomic>
+
+namespace
+{
+	class FPlaybackAudioVisitor : public Inworld::PacketVisitor
+	{
+	public:
+		explicit FPlaybackAudioVisitor(const FInworldClientMetrics& InMetrics) : Metrics(InMetrics) {}
+
+		virtual void Visit(const Inworld::AudioDataEvent& Event) override
+		{
+			Metrics.PlaybackAudioChunks.Add();
+			Metrics.PlaybackAudioBytes.Add(Event.GetDataChunk().size());
+		}
+
+	private:
+		const FInworldClientMetrics& Metrics;
+	};
+
+	FTSTicker::FDelegateHandle ExportTickerHandle;
+	// Set while a periodic export writes, a slow disk skips snapshots rather than piling up writes.
+	std::atomic<bool> bExportWriting { false };
+}
+
+FInworldClientMetrics::FInworldClientMetrics()
+{
+	Inworld::MetricsRegistry& Registry = Inworld::GetMetricsRegistry();
+	PacketsDispatched = Registry.RegisterCounter("inworld.unreal.dispatch.packets");
+	DispatchUs = Registry.RegisterHistogram("inworld.unreal.dispatch.packet_us");
+	PlaybackAudioChunks = Registry.RegisterCounter("inworld.unreal.playback.audio_chunks");
+	PlaybackAudioBytes = Registry.RegisterCounter("inworld.unreal.playback.audio_bytes");
+	AECQueueDepth = Registry.RegisterGauge("inworld.unreal.aec.queue");
+	AECDroppedChunks = Registry.RegisterCounter("inworld.unreal.aec.dropped_chunks");
+	AECFrameUs = Registry.RegisterHistogram("inworld.unreal.aec.frame_us");
+}
+
+const FInworldClientMetrics& FInworldClientMetrics::Get()
+{
+	static const FInworldClientMetrics Metrics;
+	return Metrics;
+}
+
+void FInworldClientMetrics::RecordDispatch(Inworld::Packet& Packet, uint64 DispatchCycles) const
+{
+	PacketsDispatched.Add();
+	DispatchUs.Record(static_cast<uint64>(FPlatformTime::ToSeconds64(DispatchCycles) * 1.0e6));
+
+	FPlaybackAudioVisitor Visitor(*this);
+	Packet.Accept(Visitor);
+}
+
+void FInworldClientMetrics::StopExport()
+{
+	if (ExportTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(ExportTickerHandle);
+		ExportTickerHandle.Reset();
+	}
+}
+
+namespace
+{
+	FString GetExportPath(const TArray<FString>& Args, int32 Index)
+	{
+		const FString Path = FPaths::ConvertRelativePathToFull(Args.IsValidIndex(Index) ? Args[Index] : FPaths::ProjectSavedDir() / TEXT("Inworld") / TEXT("Metrics.csv"));
+		IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+		return Path;
+	}
+
+	bool ExportSnapshot(const FString& Path)
+	{
+		return Inworld::MetricsRegistry::AppendToFile(Inworld::GetMetricsRegistry().Snapshot(), TCHAR_TO_UTF8(*Path));
+	}
+
+	void DumpMetrics(const TArray<FString>& Args)
+	{
+		const Inworld::MetricsSnapshot Snapshot = Inworld::GetMetricsRegistry().Snapshot();
+		UE_LOG(LogInworldAIClient, Log, TEXT("Inworld metrics, %d registered:"), static_cast<int32>(Snapshot.Metrics.size()));
+		for (const Inworld::MetricValue& Metric : Snapshot.Metrics)
+		{
+			if (Metric.Type == Inworld::MetricType::Histogram)
+			{
+				const Inworld::HistogramStats& Stats = Metric.Histogram;
+				UE_LOG(LogInworldAIClient, Log, TEXT("  %s: %llu, p50 %.0f, p95 %.0f, p99 %.0f, max %.0f"),
+					UTF8_TO_TCHAR(Metric.Name.c_str()), Stats.Count, Stats.P50, Stats.P95, Stats.P99, Stats.Max);
+			}
+			else
+			{
+				UE_LOG(LogInworldAIClient, Log, TEXT("  %s: %lld"), UTF8_TO_TCHAR(Metric.Name.c_str()), Metric.Value);
+			}
+		}
+	}
+
+	void ExportMetrics(const TArray<FString>& Args)
+	{
+		const FString Path = GetExportPath(Args, 0);
+		if (ExportSnapshot(Path))
+		{
+			UE_LOG(LogInworldAIClient, Log, TEXT("Inworld metrics appended to %s"), *Path);
+		}
+	}
+
+	void StartExportMetrics(const TArray<FString>& Args)
+	{
+		const float Interval = Args.Num() > 0 ? FMath::Max(FCString::Atof(*Args[0]), 0.1f) : 1.f;
+		const FString Path = GetExportPath(Args, 1);
+
+		FInworldClientMetrics::StopExport();
+		ExportTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Path](float)
+			{
+				// Snapshots are taken on the ticker, the file is written off the game thread.
+				if (!bExportWriting.exchange(true))
+				{
+					Async(EAsyncExecution::ThreadPool, [Path, Snapshot = Inworld::GetMetricsRegistry().Snapshot()]()
+						{
+							Inworld::MetricsRegistry::AppendToFile(Snapshot, TCHAR_TO_UTF8(*Path));
+							bExportWriting = false;
+						});
+				}
+				return true;
+			}), Interval);
+		UE_LOG(LogInworldAIClient, Log, TEXT("Inworld metrics appended to %s every %.1fs"), *Path, Interval);
+	}
+
+	void StopExportMetrics(const TArray<FString>& Args)
+	{
+		FInworldClientMetrics::StopExport();
+	}
+}
+
+static FAutoConsoleCommand CmdDumpMetrics(
+	TEXT("Inworld.Metrics.Dump"),
+	TEXT("Log every metric of the Inworld metrics registry"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&DumpMetrics)
+);
+
+static FAutoConsoleCommand CmdExportMetrics(
+	TEXT("Inworld.Metrics.Export"),
+	TEXT("Append a snapshot of the Inworld metrics registry to a file, JSON lines for .json and .jsonl, CSV otherwise. Args: [Path=Saved/Inworld/Metrics.csv]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&ExportMetrics)
+);
+
+static FAutoConsoleCommand CmdStartExportMetrics(
+	TEXT("Inworld.Metrics.StartExport"),
+	TEXT("Append a snapshot of the Inworld metrics registry to a file periodically. Args: [IntervalSeconds=1] [Path=Saved/Inworld/Metrics.csv]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&StartExportMetrics)
+);
+
+static FAutoConsoleCommand CmdStopExportMetrics(
+	TEXT("Inworld.Metrics.StopExport"),
+	TEXT("Stop Inworld.Metrics.StartExport"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&StopExportMetrics)
+);
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+	// Inworld.Debug.MetricsBenchmark [Threads] [UpdatesPerThread]
+	void RunMetricsBenchmark(const TArray<FString>& Args)
+	{
+		const int32 NumThreads = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 16;
+		const int32 NumUpdates = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 1000000;
+
+		Inworld::MetricsRegistry Registry;
+		const Inworld::MetricsRegistry::Counter Counter = Registry.RegisterCounter("benchmark.counter");
+		const Inworld::MetricsRegistry::Histogram Histogram = Registry.RegisterHistogram("benchmark.histogram_us");
+		// What every thread updating one counter costs, the cache line bounces between the cores.
+		std::atomic<uint64> Shared { 0 };
+
+		// Nanoseconds per update, averaged over the threads updating at the same time.
+		auto Run = [NumThreads, NumUpdates](auto Update)
+		{
+			std::atomic<int32> NumReady { 0 };
+			std::atomic<bool> bGo { false };
+			TArray<TFuture<double>> Threads;
+			for (int32 t = 0; t < NumThreads; t++)
+			{
+				Threads.Add(Async(EAsyncExecution::Thread, [&]()
+					{
+						NumReady++;
+						while (!bGo)
+						{
+							FPlatformProcess::Yield();
+						}
+						const double Start = FPlatformTime::Seconds();
+						for (int32 i = 0; i < NumUpdates; i++)
+						{
+							Update(i);
+						}
+						return FPlatformTime::Seconds() - Start;
+					}));
+			}
+			while (NumReady < NumThreads)
+			{
+				FPlatformProcess::Yield();
+			}
+			bGo = true;
+
+			double Seconds = 0.0;
+			for (TFuture<double>& Thread : Threads)
+			{
+				Seconds += Thread.Get();
+			}
+			return Seconds * 1.0e9 / (static_cast<double>(NumThreads) * NumUpdates);
+		};
+
+		const double CounterNs = Run([&Counter](int32 i) { Counter.Add(); });
+		const double HistogramNs = Run([&Histogram](int32 i) { Histogram.Record(i & 4095); });
+		const double SharedNs = Run([&Shared](int32 i) { Shared.fetch_add(1, std::memory_order_relaxed); });
+
+		UE_LOG(LogInworldAIClient, Log, TEXT("Inworld metrics benchmark: %d threads, %d updates each"), NumThreads, NumUpdates);
+		UE_LOG(LogInworldAIClient, Log, TEXT("  counter        %8.2f ns/update"), CounterNs);
+		UE_LOG(LogInworldAIClient, Log, TEXT("  histogram      %8.2f ns/update"), HistogramNs);
+		UE_LOG(LogInworldAIClient, Log, TEXT("  shared atomic  %8.2f ns/update (unsharded baseline)"), SharedNs);
+
+		const Inworld::MetricsSnapshot Snapshot = Registry.Snapshot();
+		const uint64 Expected = static_cast<uint64>(NumThreads) * NumUpdates;
+		if (Snapshot.Find("benchmark.counter")->Value != static_cast<int64>(Expected) || Snapshot.Find("benchmark.histogram_us")->Histogram.Count != Expected)
+		{
+			UE_LOG(LogInworldAIClient, Error, TEXT("Inworld metrics benchmark: updates were lost"));
+		}
+	}
+}
+
+static FAutoConsoleCommand CmdMetricsBenchmark(
+	TEXT("Inworld.Debug.MetricsBenchmark"),
+	TEXT("Time updating Inworld metrics from many threads at once against one shared atomic. Args: [Threads=16] [UpdatesPerThread=1000000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunMetricsBenchmark)
+);
+#endif
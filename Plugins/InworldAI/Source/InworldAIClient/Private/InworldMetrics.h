@@ -0,0 +1,41 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "Utils/MetricsRegistry.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace Inworld
+{
+	class Packet;
+}
+
+// Metrics the engine integration publishes to the NDK metrics registry, next to the NDK's transport, queue and latency ones.
+// Handles are registered once, updating them is lock-free from any thread.
+struct FInworldClientMetrics
+{
+	static const FInworldClientMetrics& Get();
+
+	// Counts the packet, and agent audio in it as handed to playback.
+	void RecordDispatch(Inworld::Packet& Packet, uint64 DispatchCycles) const;
+
+	// Stops Inworld.Metrics.StartExport, its ticker must not outlive the module.
+	static void StopExport();
+
+	// Packets translated and handed to the game, and the game thread time that took.
+	Inworld::MetricsRegistry::Counter PacketsDispatched;
+	Inworld::MetricsRegistry::Histogram DispatchUs;
+
+	Inworld::MetricsRegistry::Counter PlaybackAudioChunks;
+	Inworld::MetricsRegistry::Counter PlaybackAudioBytes;
+
+	Inworld::MetricsRegistry::Gauge AECQueueDepth;
+	Inworld::MetricsRegistry::Counter AECDroppedChunks;
+	Inworld::MetricsRegistry::Histogram AECFrameUs;
+
+private:
+	FInworldClientMetrics();
+};
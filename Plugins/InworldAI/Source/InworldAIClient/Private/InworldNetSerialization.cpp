@@ -0,0 +1,377 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#include "InworldNetSerialization.h"
+#include "InworldAIClientModule.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Engine/PackageMapClient.h"
+#include "Engine/NetConnection.h"
+#include "Engine/ActorChannel.h"
+#include "Engine/DemoNetDriver.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/UnrealType.h"
+#include "UObject/CoreNet.h"
+
+static TAutoConsoleVariable<bool> CVarNetEventStats(
+	TEXT("Inworld.Net.EventStats"), false,
+	TEXT("Record replicated Inworld event sizes, see Inworld.Net.DumpEventStats")
+);
+
+namespace
+{
+	constexpr uint32 MaxDictionaryEntries = 1024;
+	// Index generations the receiver keeps apart, see FSenderDictionary.
+	constexpr uint32 DictionaryGenerations = 8;
+	constexpr uint32 MaxStringSize = 1024 * 1024;
+
+	enum class EDictionaryString : uint8
+	{
+		Inline,
+		Define,
+		Reference,
+		Max = Reference
+	};
+
+	struct FScopeDefinitions
+	{
+		// Definitions went out on this channel, a reopened channel defines its strings again.
+		TWeakObjectPtr<UActorChannel> Channel;
+		TSet<uint32> Defined;
+	};
+
+	// Full dictionaries recycle the least recently used index. A recycled index is defined again in every scope
+	// before being referenced, and its generation is bumped so references of other scopes still in flight resolve
+	// the string they were sent for. A reference outlives DictionaryGenerations recycles of its index only if
+	// thousands of new strings are sent during its round trip.
+	struct FSenderDictionary
+	{
+		TMap<FString, uint32> Indices;
+		TArray<FString> Strings;
+		TArray<uint8> Generations;
+		TArray<uint64> LastUsed;
+		uint64 UseCount = 0;
+		TMap<FObjectKey, FScopeDefinitions> Scopes;
+	};
+
+	struct FEventStats
+	{
+		uint64 Count = 0;
+		uint64 CompactBits = 0;
+		uint64 LegacyBits = 0;
+	};
+
+	const UObject* GCurrentScope = nullptr;
+	TMap<FObjectKey, FSenderDictionary> GSenderDictionaries;
+	// Indexed by dictionary index and generation.
+	TMap<FObjectKey, TArray<FString>> GReceiverDictionaries;
+	TMap<FString, FEventStats> GEventStats;
+
+	template<typename TValue>
+	TValue& FindOrAddDictionary(TMap<FObjectKey, TValue>& Dictionaries, UPackageMap* Map)
+	{
+		const FObjectKey Key(Map);
+		if (TValue* Dictionary = Dictionaries.Find(Key))
+		{
+			return *Dictionary;
+		}
+
+		// New connection, drop the ones that were closed.
+		for (auto It = Dictionaries.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().ResolveObjectPtr())
+			{
+				It.RemoveCurrent();
+			}
+		}
+		return Dictionaries.Add(Key);
+	}
+
+	UActorChannel* FindScopeChannel(UPackageMap* Map, const UObject* Scope)
+	{
+		UNetConnection* Connection = Cast<UNetConnection>(Map->GetOuter());
+		const AActor* Actor = Cast<AActor>(Scope);
+		if (!Actor)
+		{
+			Actor = Scope->GetTypedOuter<AActor>();
+		}
+		return Connection && Actor ? Connection->FindActorChannelRef(const_cast<AActor*>(Actor)) : nullptr;
+	}
+
+	TSet<uint32>& FindOrAddDefinitions(FSenderDictionary& Dictionary, UPackageMap* Map, const UObject* Scope)
+	{
+		UActorChannel* Channel = FindScopeChannel(Map, Scope);
+		const FObjectKey Key(Scope);
+		FScopeDefinitions* Definitions = Dictionary.Scopes.Find(Key);
+		if (!Definitions)
+		{
+			// New scope, drop the ones that were destroyed.
+			for (auto It = Dictionary.Scopes.CreateIterator(); It; ++It)
+			{
+				if (!It.Key().ResolveObjectPtr())
+				{
+					It.RemoveCurrent();
+				}
+			}
+			Definitions = &Dictionary.Scopes.Add(Key);
+		}
+
+		if (Definitions->Channel.Get() != Channel)
+		{
+			Definitions->Channel = Channel;
+			Definitions->Defined.Reset();
+		}
+		return Definitions->Defined;
+	}
+
+	uint32 AddDictionaryString(FSenderDictionary& Dictionary, const FString& Str)
+	{
+		uint32 Index = Dictionary.Strings.Num();
+		if (Index < MaxDictionaryEntries)
+		{
+			Dictionary.Strings.Add(Str);
+			Dictionary.Generations.Add(0);
+			Dictionary.LastUsed.Add(0);
+		}
+		else
+		{
+			Index = 0;
+			for (uint32 Candidate = 1; Candidate < MaxDictionaryEntries; ++Candidate)
+			{
+				if (Dictionary.LastUsed[Candidate] < Dictionary.LastUsed[Index])
+				{
+					Index = Candidate;
+				}
+			}
+
+			Dictionary.Indices.Remove(Dictionary.Strings[Index]);
+			Dictionary.Strings[Index] = Str;
+			Dictionary.Generations[Index] = static_cast<uint8>((Dictionary.Generations[Index] + 1) % DictionaryGenerations);
+			for (auto& Pair : Dictionary.Scopes)
+			{
+				Pair.Value.Defined.Remove(Index);
+			}
+		}
+
+		Dictionary.Indices.Add(Str, Index);
+		return Index;
+	}
+
+	bool CanUseDictionary(UPackageMap* Map)
+	{
+		if (!Map)
+		{
+			return false;
+		}
+
+		// Replays are scrubbed from checkpoints, definitions may be skipped.
+		const UNetConnection* Connection = Cast<UNetConnection>(Map->GetOuter());
+		return !Connection || !Connection->GetDriver() || !Connection->GetDriver()->IsA<UDemoNetDriver>();
+	}
+
+	void DumpEventStats()
+	{
+		UE_LOG(LogInworldAIClient, Log, TEXT("Inworld replicated event sizes (bytes per event):"));
+		for (const auto& Pair : GEventStats)
+		{
+			const FEventStats& Stats = Pair.Value;
+			if (Stats.Count == 0)
+			{
+				continue;
+			}
+
+			const double Compact = Stats.CompactBits / 8.0 / Stats.Count;
+			const double Legacy = Stats.LegacyBits / 8.0 / Stats.Count;
+			UE_LOG(LogInworldAIClient, Log, TEXT("  %-10s count %6llu, before %8.1f, after %8.1f, %5.1f%%"),
+				*Pair.Key, Stats.Count, Legacy, Compact, Legacy > 0.0 ? Compact * 100.0 / Legacy : 0.0);
+		}
+	}
+}
+
+static FAutoConsoleCommand CmdDumpEventStats(
+	TEXT("Inworld.Net.DumpEventStats"),
+	TEXT("Log bytes per replicated Inworld event before and after compact serialization"),
+	FConsoleCommandDelegate::CreateStatic(&DumpEventStats)
+);
+
+static FAutoConsoleCommand CmdResetEventStats(
+	TEXT("Inworld.Net.ResetEventStats"),
+	TEXT("Reset replicated Inworld event sizes"),
+	FConsoleCommandDelegate::CreateLambda([]() { GEventStats.Empty(); })
+);
+
+Inworld::Net::FDictionaryScope::FDictionaryScope(const UObject* Scope)
+	: PreviousScope(GCurrentScope)
+{
+	check(IsInGameThread());
+	GCurrentScope = Scope;
+}
+
+Inworld::Net::FDictionaryScope::~FDictionaryScope()
+{
+	GCurrentScope = PreviousScope;
+}
+
+void Inworld::Net::SerializeString(FArchive& Ar, FString& Str)
+{
+	if (Ar.IsLoading())
+	{
+		uint32 Size = 0;
+		Ar.SerializeIntPacked(Size);
+		if (Ar.IsError() || Size > MaxStringSize)
+		{
+			Ar.SetError();
+			Str.Empty();
+			return;
+		}
+
+		TArray<ANSICHAR> Utf8;
+		Utf8.SetNumUninitialized(Size);
+		Ar.Serialize(Utf8.GetData(), Size);
+		const FUTF8ToTCHAR Converted(Utf8.GetData(), Size);
+		Str = FString(Converted.Length(), Converted.Get());
+	}
+	else
+	{
+		FTCHARToUTF8 Utf8(*Str, Str.Len());
+		uint32 Size = Utf8.Length();
+		Ar.SerializeIntPacked(Size);
+		Ar.Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Size);
+	}
+}
+
+void Inworld::Net::SerializeBool(FArchive& Ar, bool& bValue)
+{
+	uint8 Bit = bValue ? 1 : 0;
+	Ar.SerializeBits(&Bit, 1);
+	bValue = Bit != 0;
+}
+
+void Inworld::Net::SerializeDictionaryString(FArchive& Ar, UPackageMap* Map, FString& Str)
+{
+	EDictionaryString Kind = EDictionaryString::Inline;
+	uint32 Index = 0;
+	uint32 Generation = 0;
+
+	if (Ar.IsSaving())
+	{
+		if (GCurrentScope && !Str.IsEmpty() && CanUseDictionary(Map))
+		{
+			FSenderDictionary& Dictionary = FindOrAddDictionary(GSenderDictionaries, Map);
+			TSet<uint32>& Defined = FindOrAddDefinitions(Dictionary, Map, GCurrentScope);
+			if (const uint32* Existing = Dictionary.Indices.Find(Str))
+			{
+				Index = *Existing;
+				Kind = Defined.Contains(Index) ? EDictionaryString::Reference : EDictionaryString::Define;
+			}
+			else
+			{
+				Index = AddDictionaryString(Dictionary, Str);
+				Kind = EDictionaryString::Define;
+			}
+
+			if (Kind == EDictionaryString::Define)
+			{
+				Defined.Add(Index);
+			}
+			Dictionary.LastUsed[Index] = ++Dictionary.UseCount;
+			Generation = Dictionary.Generations[Index];
+		}
+	}
+
+	SerializeEnum(Ar, Kind, EDictionaryString::Max);
+	if (Kind != EDictionaryString::Inline)
+	{
+		Ar.SerializeInt(Index, MaxDictionaryEntries);
+		Ar.SerializeInt(Generation, DictionaryGenerations);
+	}
+	if (Kind != EDictionaryString::Reference)
+	{
+		SerializeString(Ar, Str);
+	}
+
+	if (!Ar.IsLoading() || Ar.IsError() || Kind == EDictionaryString::Inline)
+	{
+		return;
+	}
+
+	TArray<FString>& Dictionary = FindOrAddDictionary(GReceiverDictionaries, Map);
+	const int32 Slot = Index * DictionaryGenerations + Generation;
+	if (Kind == EDictionaryString::Define)
+	{
+		if (Dictionary.Num() <= Slot)
+		{
+			Dictionary.SetNum(Slot + 1);
+		}
+		Dictionary[Slot] = Str;
+	}
+	else if (Dictionary.IsValidIndex(Slot) && !Dictionary[Slot].IsEmpty())
+	{
+		Str = Dictionary[Slot];
+	}
+	else
+	{
+		UE_LOG(LogInworldAIClient, Warning, TEXT("Inworld::Net unknown dictionary string %u, generation %u"), Index, Generation);
+		Str.Empty();
+	}
+}
+
+bool Inworld::Net::SerializeEvent(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess, const TCHAR* EventType,
+	TFunctionRef<void(FArchive&, UPackageMap*)> Compact, TFunctionRef<void(FArchive&, UPackageMap*)> Legacy)
+{
+	if (Ar.IsSaving() && IsEventStatsEnabled())
+	{
+		FNetBitWriter CompactWriter(Map, 0);
+		Compact(CompactWriter, Map);
+		Ar.SerializeBits(CompactWriter.GetData(), CompactWriter.GetNumBits());
+
+		FNetBitWriter LegacyWriter(Map, 0);
+		Legacy(LegacyWriter, Map);
+
+		RecordEventStats(EventType, CompactWriter.GetNumBits(), LegacyWriter.GetNumBits());
+	}
+	else
+	{
+		Compact(Ar, Map);
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+bool Inworld::Net::IsEventStatsEnabled()
+{
+	return CVarNetEventStats.GetValueOnAnyThread();
+}
+
+void Inworld::Net::RecordEventStats(const TCHAR* EventType, uint64 CompactBits, uint64 LegacyBits)
+{
+	check(IsInGameThread());
+	FEventStats& Stats = GEventStats.FindOrAdd(EventType);
+	Stats.Count++;
+	Stats.CompactBits += CompactBits;
+	Stats.LegacyBits += LegacyBits;
+}
+
+void Inworld::Net::SerializeLegacyStruct(FArchive& Ar, UPackageMap* Map, const UStruct* Struct, void* Data)
+{
+	for (TFieldIterator<FProperty> It(Struct); It; ++It)
+	{
+		FProperty* Property = *It;
+		if (Property->HasAnyPropertyFlags(CPF_RepSkip))
+		{
+			continue;
+		}
+
+		void* Value = Property->ContainerPtrToValuePtr<void>(Data);
+		if (FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+		{
+			SerializeLegacyStruct(Ar, Map, StructProperty->Struct, Value);
+			continue;
+		}
+
+		// RPC parameters send a bit per property telling if it differs from the default.
+		uint8 bSend = 1;
+		Ar.SerializeBits(&bSend, 1);
+		Property->NetSerializeItem(Ar, Map, Value);
+	}
+}
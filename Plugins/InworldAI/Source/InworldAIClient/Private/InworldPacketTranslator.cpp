@@ -5,6 +5,19 @@ THIRD_PARTY_INCLUDES_START
 #include "Utils/Utils.h"
 THIRD_PARTY_INCLUDES_END
 
+void InworldPacketTranslator::Visit(const Inworld::ChangeSceneEvent& Event)
+{
+	if (AgentHandles)
+	{
+		AgentHandles->Reset();
+		for (const auto& AgentInfo : Event.GetAgentInfos())
+		{
+			AgentHandles->Add(UTF8_TO_TCHAR(AgentInfo.AgentId.c_str()));
+		}
+	}
+	MakePacket<Inworld::ChangeSceneEvent, FInworldChangeSceneEvent>(Event);
+}
+
 void InworldPacketTranslator::TranslateInworldActor(const Inworld::Actor& Original, FInworldActor& New)
 {
 	New.Type = static_cast<EInworldActorType>(Original._Type);
@@ -28,6 +41,7 @@ void InworldPacketTranslator::TranslateInworldPacket(const Inworld::Packet& Orig
 {
 	TranslateInworldPacketId(Original._PacketId, New.PacketId);
 	TranslateInworldRouting(Original._Routing, New.Routing);
+	New.Timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(Original._Timestamp.time_since_epoch()).count();
 }
 
 template<>
@@ -50,16 +64,14 @@ template<>
 void InworldPacketTranslator::TranslateEvent<Inworld::AudioDataEvent, FInworldAudioDataEvent>(const Inworld::AudioDataEvent& Original, FInworldAudioDataEvent& New)
 {
 	TranslateEvent<Inworld::DataEvent, FInworldDataEvent>(Original, New);
-	New.VisemeInfos.Reserve(Original.GetPhonemeInfos().size());
-	for (const auto& PhonemeInfo : Original.GetPhonemeInfos())
+	static_assert(static_cast<int32>(Inworld::Utils::Viseme::STOP) == static_cast<int32>(EInworldViseme::STOP), "Viseme enums must match");
+
+	std::vector<Inworld::Utils::VisemeInfo> VisemeInfos;
+	Inworld::Utils::PhonemesToVisemes(Original, VisemeInfos);
+	New.VisemeInfos.Reserve(VisemeInfos.size());
+	for (const auto& VisemeInfo : VisemeInfos)
 	{
-		const FString Code = UTF8_TO_TCHAR(Inworld::Utils::PhonemeToViseme(PhonemeInfo.Code).c_str());
-		if (!Code.IsEmpty())
-		{
-			auto& VisemeInfoRef = New.VisemeInfos.AddDefaulted_GetRef();
-			VisemeInfoRef.Code = Code;
-			VisemeInfoRef.Timestamp = PhonemeInfo.Timestamp;
-		}
+		New.VisemeInfos.Emplace(static_cast<EInworldViseme>(VisemeInfo.Code), FInworldVisemeInfo::QuantizeTimestamp(VisemeInfo.Timestamp));
 	}
 }
 
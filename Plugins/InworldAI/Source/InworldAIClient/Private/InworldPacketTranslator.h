@@ -7,10 +7,14 @@ THIRD_PARTY_INCLUDES_START
 THIRD_PARTY_INCLUDES_END
 
 #include "InworldPackets.h"
+#include "InworldAgentHandles.h"
 
 class InworldPacketTranslator : public Inworld::PacketVisitor
 {
 public:
+	InworldPacketTranslator() = default;
+	// Incoming packets get agent handles on their routing, a scene change interns the new agents first.
+	explicit InworldPacketTranslator(FInworldAgentHandles& InAgentHandles) : AgentHandles(&InAgentHandles) {}
 	virtual ~InworldPacketTranslator() = default;
 
 	virtual void Visit(const Inworld::TextEvent& Event) override { MakePacket<Inworld::TextEvent, FInworldTextEvent>(Event); }
@@ -20,12 +24,13 @@ public:
 	virtual void Visit(const Inworld::ControlEvent& Event) override { MakePacket<Inworld::ControlEvent, FInworldControlEvent>(Event); }
 	virtual void Visit(const Inworld::EmotionEvent& Event) override { MakePacket<Inworld::EmotionEvent, FInworldEmotionEvent>(Event); };
 	virtual void Visit(const Inworld::CustomEvent& Event) override { MakePacket<Inworld::CustomEvent, FInworldCustomEvent>(Event); };
-	virtual void Visit(const Inworld::ChangeSceneEvent& Event) override { MakePacket<Inworld::ChangeSceneEvent, FInworldChangeSceneEvent>(Event); };
+	virtual void Visit(const Inworld::ChangeSceneEvent& Event) override;
 
 	TSharedPtr<FInworldPacket> GetPacket() { return Packet; }
 
 protected:
 	TSharedPtr<FInworldPacket> Packet;
+	FInworldAgentHandles* AgentHandles = nullptr;
 
 	static void TranslateInworldActor(const Inworld::Actor& Original, FInworldActor& New);
 	static void TranslateInworldRouting(const Inworld::Routing& Original, FInworldRouting& New);
@@ -40,6 +45,10 @@ protected:
 	{
 		TSharedPtr<TNew> NewPacket = TSharedPtr<TNew>(new TNew());
 		TranslateEvent<TOrig, TNew>(Event, *NewPacket.Get());
+		if (AgentHandles)
+		{
+			AgentHandles->Resolve(NewPacket->Routing);
+		}
 		Packet = NewPacket;
 	}
 };
@@ -1,8 +1,14 @@
 // Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
 
 #include "InworldPackets.h"
+#include "InworldNetSerialization.h"
+#include "InworldAIClientModule.h"
+THIRD_PARTY_INCLUDES_START
+#include "Utils/Utils.h"
+THIRD_PARTY_INCLUDES_END
 
 #include <string>
+#include <vector>
 
 void AppendToDebugString(FString& DbgStr, const FString& Str)
 {
@@ -22,6 +28,7 @@ void FInworldAudioDataEvent::ConvertToReplicatableEvents(const FInworldAudioData
 		FInworldAudioDataEvent& RepEvent = RepEvents[i];
 		RepEvent.PacketId = Event.PacketId;
 		RepEvent.Routing = Event.Routing;
+		RepEvent.Timestamp = Event.Timestamp;
 		RepEvent.bFinal = false;
 		RepEvent.Chunk = TArray<uint8>(Event.Chunk.GetData() + (DataMaxSize * i), FMath::Min(DataMaxSize, (Event.Chunk.Num() - (DataMaxSize * i))));
 	}
@@ -51,20 +58,6 @@ void SerializeArray(FMemoryArchive& Ar, TArray<T>& Array)
 	}
 }
 
-template<typename T>
-void SerializeStructArray(FMemoryArchive& Ar, TArray<T>& Array)
-{
-	int32 Size = Array.Num();
-	SerializeValue<int32>(Ar, Size);
-
-	Array.SetNum(Size);
-
-	for (T& Val : Array)
-	{
-		Val.Serialize(Ar);
-	}
-}
-
 static void SerializeChunk(FMemoryArchive& Ar, TArray<uint8>& Chunk)
 {
 	int32 Size = Chunk.Num();
@@ -149,6 +142,7 @@ void FInworldPacket::Serialize(FMemoryArchive& Ar)
 {
 	PacketId.Serialize(Ar);
 	Routing.Serialize(Ar);
+	SerializeValue<int64>(Ar, Timestamp);
 }
 
 FString FInworldPacket::ToDebugString() const
@@ -160,6 +154,21 @@ FString FInworldPacket::ToDebugString() const
 	return Str;
 }
 
+void FInworldPacket::NetSerializePacket(FArchive& Ar, UPackageMap* Map)
+{
+	// UID is unique per packet, ids and names repeat across the packets of an interaction.
+	Inworld::Net::SerializeString(Ar, PacketId.UID);
+	Inworld::Net::SerializeDictionaryString(Ar, Map, PacketId.UtteranceId);
+	Inworld::Net::SerializeDictionaryString(Ar, Map, PacketId.InteractionId);
+
+	Inworld::Net::SerializeEnum(Ar, Routing.Source.Type);
+	Inworld::Net::SerializeDictionaryString(Ar, Map, Routing.Source.Name);
+	Inworld::Net::SerializeEnum(Ar, Routing.Target.Type);
+	Inworld::Net::SerializeDictionaryString(Ar, Map, Routing.Target.Name);
+
+	Ar << Timestamp;
+}
+
 void FInworldDataEvent::Serialize(FMemoryArchive& Ar)
 {
 	FInworldPacket::Serialize(Ar);
@@ -177,7 +186,18 @@ void FInworldAudioDataEvent::Serialize(FMemoryArchive& Ar)
 {
 	FInworldDataEvent::Serialize(Ar);
 
-	SerializeStructArray<FInworldVisemeInfo>(Ar, VisemeInfos);
+	const int64 VisemesOffset = Ar.Tell();
+	FInworldVisemeInfo::SerializeArray(Ar, VisemeInfos);
+	if (Ar.IsSaving() && Inworld::Net::IsEventStatsEnabled())
+	{
+		// Previously an int32 count, then per info an int32 length, TCHAR code and float timestamp.
+		uint64 LegacyBytes = sizeof(int32);
+		for (const FInworldVisemeInfo& Info : VisemeInfos)
+		{
+			LegacyBytes += sizeof(int32) + FCString::Strlen(FInworldVisemeInfo::CodeToString(Info.Code)) * sizeof(TCHAR) + sizeof(float);
+		}
+		Inworld::Net::RecordEventStats(TEXT("Visemes"), (Ar.Tell() - VisemesOffset) * 8, LegacyBytes * 8);
+	}
 	SerializeValue<bool>(Ar, bFinal);
 }
 
@@ -190,10 +210,94 @@ void FInworldAudioDataEvent::AppendDebugString(FString& Str) const
 	AppendToDebugString(Str, bFinal ? TEXT("Final") : TEXT("Not final"));
 }
 
-void FInworldVisemeInfo::Serialize(FMemoryArchive& Ar)
+static const TCHAR* const VisemeCodes[] =
+{
+	TEXT("PP"), TEXT("FF"), TEXT("TH"), TEXT("DD"), TEXT("Kk"), TEXT("CH"), TEXT("SS"), TEXT("Nn"),
+	TEXT("RR"), TEXT("Aa"), TEXT("E"), TEXT("I"), TEXT("O"), TEXT("U"), TEXT("STOP"),
+};
+static constexpr int32 NumVisemeCodes = UE_ARRAY_COUNT(VisemeCodes);
+static_assert(NumVisemeCodes == static_cast<int32>(EInworldViseme::STOP) + 1, "VisemeCodes must match EInworldViseme");
+
+const TCHAR* FInworldVisemeInfo::CodeToString(EInworldViseme Code)
+{
+	const int32 Idx = static_cast<int32>(Code);
+	return Idx < NumVisemeCodes ? VisemeCodes[Idx] : TEXT("STOP");
+}
+
+bool FInworldVisemeInfo::CodeFromString(const FString& Str, EInworldViseme& OutCode)
+{
+	for (int32 Idx = 0; Idx < NumVisemeCodes; Idx++)
+	{
+		// Case sensitive, "Kk" and "Nn" are not "KK" and "NN".
+		if (Str.Equals(VisemeCodes[Idx], ESearchCase::CaseSensitive))
+		{
+			OutCode = static_cast<EInworldViseme>(Idx);
+			return true;
+		}
+	}
+	return false;
+}
+
+static_assert(FInworldVisemeInfo::TicksPerSecond == Inworld::Utils::VisemeTicksPerSecond, "Viseme ticks must match");
+
+float FInworldVisemeInfo::QuantizeTimestamp(float Timestamp)
+{
+	return Inworld::Utils::QuantizeVisemeTimestamp(Timestamp);
+}
+
+void FInworldVisemeInfo::SerializeArray(FArchive& Ar, TArray<FInworldVisemeInfo>& Infos)
 {
-	SerializeString(Ar, Code);
-	SerializeValue<float>(Ar, Timestamp);
+	// 64k visemes.
+	constexpr uint32 MaxEncodedSize = 512 * 1024;
+
+	std::vector<Inworld::Utils::VisemeInfo> Visemes;
+	std::string Encoded;
+	if (Ar.IsSaving())
+	{
+		Visemes.reserve(Infos.Num());
+		for (const FInworldVisemeInfo& Info : Infos)
+		{
+			Visemes.push_back({ static_cast<Inworld::Utils::Viseme>(Info.Code), Info.Timestamp });
+		}
+		Inworld::Utils::EncodeVisemes(Visemes, Encoded);
+		if (Encoded.size() > MaxEncodedSize)
+		{
+			// The other side wouldn't load it, the utterance plays without visemes instead.
+			UE_LOG(LogInworldAIClient, Warning, TEXT("%d visemes don't fit in a replicated utterance, dropped"), Infos.Num());
+			Encoded.clear();
+		}
+	}
+
+	// The encoding is shared with the NDK tests, it is written length delimited.
+	uint32 Size = static_cast<uint32>(Encoded.size());
+	Ar.SerializeIntPacked(Size);
+	if (Ar.IsLoading())
+	{
+		if (Ar.IsError() || Size > MaxEncodedSize)
+		{
+			Ar.SetError();
+			Infos.Empty();
+			return;
+		}
+		Encoded.resize(Size);
+	}
+	Ar.Serialize(Encoded.data(), Size);
+
+	if (Ar.IsLoading())
+	{
+		Infos.Reset();
+		if (Ar.IsError() || !Inworld::Utils::DecodeVisemes(Encoded, Visemes))
+		{
+			Ar.SetError();
+			return;
+		}
+
+		Infos.Reserve(Visemes.size());
+		for (const Inworld::Utils::VisemeInfo& Info : Visemes)
+		{
+			Infos.Emplace(static_cast<EInworldViseme>(Info.Code), Info.Timestamp);
+		}
+	}
 }
 
 void FInworldTextEvent::AppendDebugString(FString& Str) const
@@ -203,18 +307,52 @@ void FInworldTextEvent::AppendDebugString(FString& Str) const
 	AppendToDebugString(Str, Final ? TEXT("Final") : TEXT("Not final"));
 }
 
+bool FInworldTextEvent::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	return Inworld::Net::SerializeEvent(Ar, Map, bOutSuccess, TEXT("Text"),
+		[this](FArchive& EventAr, UPackageMap* EventMap)
+		{
+			NetSerializePacket(EventAr, EventMap);
+			Inworld::Net::SerializeString(EventAr, Text);
+			Inworld::Net::SerializeBool(EventAr, Final);
+		},
+		[this](FArchive& EventAr, UPackageMap* EventMap) { Inworld::Net::SerializeLegacyStruct(EventAr, EventMap, StaticStruct(), this); });
+}
+
 void FInworldSilenceEvent::AppendDebugString(FString& Str) const
 {
 	AppendToDebugString(Str, TEXT("Silence"));
 	AppendToDebugString(Str, FString::SanitizeFloat(Duration));
 }
 
+bool FInworldSilenceEvent::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	return Inworld::Net::SerializeEvent(Ar, Map, bOutSuccess, TEXT("Silence"),
+		[this](FArchive& EventAr, UPackageMap* EventMap)
+		{
+			NetSerializePacket(EventAr, EventMap);
+			EventAr << Duration;
+		},
+		[this](FArchive& EventAr, UPackageMap* EventMap) { Inworld::Net::SerializeLegacyStruct(EventAr, EventMap, StaticStruct(), this); });
+}
+
 void FInworldControlEvent::AppendDebugString(FString& Str) const
 {
 	AppendToDebugString(Str, TEXT("Control"));
 	AppendToDebugString(Str, FString::FromInt(static_cast<int32>(Action)));
 }
 
+bool FInworldControlEvent::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	return Inworld::Net::SerializeEvent(Ar, Map, bOutSuccess, TEXT("Control"),
+		[this](FArchive& EventAr, UPackageMap* EventMap)
+		{
+			NetSerializePacket(EventAr, EventMap);
+			Inworld::Net::SerializeEnum(EventAr, Action);
+		},
+		[this](FArchive& EventAr, UPackageMap* EventMap) { Inworld::Net::SerializeLegacyStruct(EventAr, EventMap, StaticStruct(), this); });
+}
+
 void FInworldEmotionEvent::AppendDebugString(FString& Str) const
 {
 	AppendToDebugString(Str, TEXT("Emotion"));
@@ -222,6 +360,18 @@ void FInworldEmotionEvent::AppendDebugString(FString& Str) const
 	AppendToDebugString(Str, FString::FromInt(static_cast<int32>(Strength)));
 }
 
+bool FInworldEmotionEvent::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	return Inworld::Net::SerializeEvent(Ar, Map, bOutSuccess, TEXT("Emotion"),
+		[this](FArchive& EventAr, UPackageMap* EventMap)
+		{
+			NetSerializePacket(EventAr, EventMap);
+			Inworld::Net::SerializeEnum(EventAr, Behavior);
+			Inworld::Net::SerializeEnum(EventAr, Strength);
+		},
+		[this](FArchive& EventAr, UPackageMap* EventMap) { Inworld::Net::SerializeLegacyStruct(EventAr, EventMap, StaticStruct(), this); });
+}
+
 /*
 FInworldCustomEvent::FInworldCustomEvent(const Inworld::CustomEvent& Event)
 	: FInworldPacket(Event)
@@ -247,6 +397,57 @@ void FInworldCustomEvent::AppendDebugString(FString& Str) const
 	}
 }
 
+bool FInworldCustomEvent::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	return Inworld::Net::SerializeEvent(Ar, Map, bOutSuccess, TEXT("Custom"),
+		[this](FArchive& EventAr, UPackageMap* EventMap)
+		{
+			NetSerializePacket(EventAr, EventMap);
+			Inworld::Net::SerializeDictionaryString(EventAr, EventMap, Name);
+
+			uint32 NumParams = Params.Num();
+			EventAr.SerializeIntPacked(NumParams);
+			if (EventAr.IsLoading())
+			{
+				constexpr uint32 MaxParams = 1024;
+				if (NumParams > MaxParams)
+				{
+					EventAr.SetError();
+					return;
+				}
+
+				Params.Empty(NumParams);
+				for (uint32 i = 0; i < NumParams && !EventAr.IsError(); i++)
+				{
+					FString Key, Value;
+					Inworld::Net::SerializeDictionaryString(EventAr, EventMap, Key);
+					Inworld::Net::SerializeString(EventAr, Value);
+					Params.Add(MoveTemp(Key), MoveTemp(Value));
+				}
+			}
+			else
+			{
+				for (auto& Param : Params)
+				{
+					FString Key = Param.Key;
+					Inworld::Net::SerializeDictionaryString(EventAr, EventMap, Key);
+					Inworld::Net::SerializeString(EventAr, Param.Value);
+				}
+			}
+		},
+		[this](FArchive& EventAr, UPackageMap* EventMap)
+		{
+			// Previous serialization, sent the timestamp and params only.
+			TArray<FString> ParamKeys;
+			TArray<FString> ParamValues;
+			Params.GenerateKeyArray(ParamKeys);
+			Params.GenerateValueArray(ParamValues);
+			EventAr << Timestamp;
+			EventAr << ParamKeys;
+			EventAr << ParamValues;
+		});
+}
+
 void FInworldChangeSceneEvent::AppendDebugString(FString& Str) const
 {
 	AppendToDebugString(Str, TEXT("ChangeScene"));
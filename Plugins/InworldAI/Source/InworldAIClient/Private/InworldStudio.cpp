@@ -2,7 +2,6 @@
 
 #include "InworldStudio.h"
 #include "InworldAIClientModule.h"
-#include "InworldAsyncRoutine.h"
 
 #include "Async/Async.h"
 #include "Async/TaskGraphInterfaces.h"
@@ -13,9 +12,9 @@ THIRD_PARTY_INCLUDES_START
 #pragma warning(disable:4583)
 #pragma warning(disable:4582)
 #include "GrpcHelpers.h"
+#include "Studio.h"
 #pragma warning(pop)
 // UNREAL ENGINE 4
-#include "RunnableCommand.h"
 THIRD_PARTY_INCLUDES_END
 
 #include <string>
@@ -28,19 +27,32 @@ namespace Inworld
 		void RequestStudioUserData(const FString& Token, const FString& ServerUrl, TFunction<void(bool bSuccess)> InCallback);
 
 		void CancelRequests();
-		bool IsRequestInProgress() const { return Requests.Num() != 0; }
+		bool IsRequestInProgress() const { return bRequestInProgress; }
 
 		const FString& GetError() const { return ErrorMessage; }
 		FInworldStudioUserData GetStudioUserData() const { return StudioUserData; }
 
+		void EnableCache(const FString& FilePath, const FString& CacheKey);
+		bool LoadCachedStudioUserData();
+		bool HasStudioUserDataChanged() const { return bStudioUserDataChanged; }
+
 	private:
+		// Upper bound of Studio requests in flight, per-workspace requests are queued above it.
+		static constexpr uint32 MaxConcurrentRequests = 8;
+
 		TFunction<void(bool bSuccess)> Callback;
 		FString ServerUrl;
-		FString InworldToken;
 		FInworldStudioUserData StudioUserData;
 
-		FCriticalSection RequestsMutex;
-		TArray<FInworldAsyncRoutine> Requests;
+		TUniquePtr<Inworld::StudioFetcher> Fetcher;
+		uint32 RequestId = 0;
+		bool bRequestInProgress = false;
+
+		TUniquePtr<Inworld::StudioCache> Cache;
+		TOptional<uint64> CachedDataHash;
+		// The cache doesn't store API key secrets, the first fetch after a load delivers them.
+		bool bCachedDataWithoutSecrets = false;
+		bool bStudioUserDataChanged = false;
 
 		FString ErrorMessage;
 
@@ -48,14 +60,13 @@ namespace Inworld
 		TWeakPtr<FStudio> SelfWeakPtr;
 
 	private:
-		void Request(const std::string& ThreadName, std::unique_ptr<Inworld::Runnable> Runnable);
-		void CheckDoneRequests();
+		void OnFetchDone(uint32 InRequestId, bool bSuccess, const FString& Error);
+		void SetStudioUserData(const Inworld::StudioUserData& Data);
 
-		void OnGenerateUserToken(const InworldV1alpha::GenerateTokenUserResponse& Response);
-		void OnWorkspacesReady(const InworldV1alpha::ListWorkspacesResponse& Response);
-		void OnApiKeysReady(const InworldV1alpha::ListApiKeysResponse& Response, FInworldStudioUserWorkspaceData& Workspace);
-		void OnScenesReady(const InworldV1alpha::ListScenesResponse& Response, FInworldStudioUserWorkspaceData& Workspace);
-		void OnCharactersReady(const InworldV1alpha::ListCharactersResponse& Response, FInworldStudioUserWorkspaceData& Workspace);
+		void OnWorkspaceReady(const Inworld::StudioWorkspaceData& Data, FInworldStudioUserWorkspaceData& Workspace);
+		void OnApiKeysReady(const std::vector<InworldV1alpha::ApiKey>& ApiKeys, FInworldStudioUserWorkspaceData& Workspace);
+		void OnScenesReady(const std::vector<InworldV1alpha::Scene>& Scenes, FInworldStudioUserWorkspaceData& Workspace);
+		void OnCharactersReady(const std::vector<InworldV1alpha::Character>& Characters, FInworldStudioUserWorkspaceData& Workspace);
 
 		void Error(FString Error);
 		void ClearError();
@@ -98,55 +109,122 @@ FInworldStudioUserData FInworldStudio::GetStudioUserData() const
 	return InworldStudio->GetStudioUserData();
 }
 
+void FInworldStudio::EnableCache(const FString& FilePath, const FString& CacheKey)
+{
+	InworldStudio->EnableCache(FilePath, CacheKey);
+}
+
+bool FInworldStudio::LoadCachedStudioUserData()
+{
+	return InworldStudio->LoadCachedStudioUserData();
+}
+
+bool FInworldStudio::HasStudioUserDataChanged() const
+{
+	return InworldStudio->HasStudioUserDataChanged();
+}
+
 void Inworld::FStudio::RequestStudioUserData(const FString& InToken, const FString& InServerUrl, TFunction<void(bool bSuccess)> InCallback)
 {
 	ClearError();
 
+	if (!Fetcher || ServerUrl != InServerUrl)
+	{
+		Fetcher.Reset();
+		Fetcher = MakeUnique<Inworld::StudioFetcher>(std::make_shared<Inworld::GrpcStudioService>(TCHAR_TO_UTF8(*InServerUrl)), MaxConcurrentRequests);
+	}
+
 	ServerUrl = InServerUrl;
 	Callback = InCallback;
+	bRequestInProgress = true;
 
-	Request(
-		"RunnableGenerateUserTokenRequest",
-		std::make_unique<Inworld::RunnableGenerateUserTokenRequest>(
-			TCHAR_TO_UTF8(*InToken),
-			TCHAR_TO_UTF8(*InServerUrl),
-			[this](const grpc::Status& Status, const InworldV1alpha::GenerateTokenUserResponse& Response)
-			{
-				if (!Status.ok())
+	const uint32 CurrentRequestId = ++RequestId;
+	Fetcher->Fetch(
+		TCHAR_TO_UTF8(*InToken),
+		[SelfWeakPtr = SelfWeakPtr, CurrentRequestId](bool bSuccess, const std::string& Error)
+		{
+			const FString ErrorMessage = UTF8_TO_TCHAR(Error.c_str());
+			AsyncTask(ENamedThreads::GameThread, [SelfWeakPtr, CurrentRequestId, bSuccess, ErrorMessage]()
 				{
-					Error(FString::Printf(TEXT("FRunnableGenerateUserTokenRequest FALURE! %s, Code: %d"), UTF8_TO_TCHAR(Status.error_message().c_str()), Status.error_code()));
-					return;
+					if (TSharedPtr<FStudio> Studio = SelfWeakPtr.Pin())
+					{
+						Studio->OnFetchDone(CurrentRequestId, bSuccess, ErrorMessage);
+					}
 				}
-
-				OnGenerateUserToken(Response);
-			}
-		)
+			);
+		}
 	);
 }
 
-void Inworld::FStudio::OnGenerateUserToken(const InworldV1alpha::GenerateTokenUserResponse& Response)
+void Inworld::FStudio::OnFetchDone(uint32 InRequestId, bool bSuccess, const FString& Message)
 {
-	InworldToken = UTF8_TO_TCHAR(Response.token().c_str());
-	StudioUserData.Workspaces.Empty();
-
-	Request(
-		"RunnableListWorkspacesRequest",
-		std::make_unique<Inworld::RunnableListWorkspacesRequest>(
-			TCHAR_TO_UTF8(*InworldToken),
-			TCHAR_TO_UTF8(*ServerUrl),
-			[this](const grpc::Status& Status, const InworldV1alpha::ListWorkspacesResponse& Response)
-			{
-				if (!Status.ok())
-				{
-					Error(FString::Printf(TEXT("FRunnableListWorkspacesRequest FALURE! %s, Code: %d"), UTF8_TO_TCHAR(Status.error_message().c_str()), Status.error_code()));
-					return;
-				}
+	if (InRequestId != RequestId || !bRequestInProgress)
+	{
+		return;
+	}
 
-				OnWorkspacesReady(Response);
-				CheckDoneRequests();
-			}
-		)
-	);
+	if (!bSuccess)
+	{
+		Error(Message);
+		return;
+	}
+
+	bRequestInProgress = false;
+
+	if (!Message.IsEmpty())
+	{
+		// Partial failure, data of the workspaces that were fetched is still delivered.
+		UE_LOG(LogInworldAIClient, Warning, TEXT("%s"), *Message);
+		ErrorMessage = Message;
+	}
+
+	const auto& Data = Fetcher->GetData();
+	const uint64 DataHash = Inworld::StudioCache::Hash(Data);
+	bStudioUserDataChanged = !CachedDataHash.IsSet() || CachedDataHash.GetValue() != DataHash || bCachedDataWithoutSecrets;
+	if (bStudioUserDataChanged)
+	{
+		SetStudioUserData(Data);
+		CachedDataHash = DataHash;
+		bCachedDataWithoutSecrets = false;
+
+		// Incomplete data isn't cached, the next request refetches it.
+		if (Cache && Message.IsEmpty())
+		{
+			Cache->Save(Data);
+		}
+	}
+
+	Callback(true);
+}
+
+void Inworld::FStudio::SetStudioUserData(const Inworld::StudioUserData& Data)
+{
+	StudioUserData.Workspaces.Empty(static_cast<int32>(Data._Workspaces.size()));
+	for (const auto& WorkspaceData : Data._Workspaces)
+	{
+		OnWorkspaceReady(WorkspaceData, StudioUserData.Workspaces.Emplace_GetRef());
+	}
+}
+
+void Inworld::FStudio::EnableCache(const FString& FilePath, const FString& CacheKey)
+{
+	Cache = MakeUnique<Inworld::StudioCache>(TCHAR_TO_UTF8(*FilePath), TCHAR_TO_UTF8(*CacheKey));
+	CachedDataHash.Reset();
+	bCachedDataWithoutSecrets = false;
+}
+
+bool Inworld::FStudio::LoadCachedStudioUserData()
+{
+	Inworld::StudioUserData Data;
+	if (!Cache || !Cache->Load(Data))
+	{
+		return false;
+	}
+
+	SetStudioUserData(Data);
+	CachedDataHash = Inworld::StudioCache::Hash(Data);
+	bCachedDataWithoutSecrets = true;
+	return true;
 }
 
 static FString CreateShortName(const FString& Name)
@@ -160,86 +238,22 @@ static FString CreateShortName(const FString& Name)
 	return MoveTemp(ShortName);
 }
 
-void Inworld::FStudio::OnWorkspacesReady(const InworldV1alpha::ListWorkspacesResponse& Response)
+void Inworld::FStudio::OnWorkspaceReady(const Inworld::StudioWorkspaceData& Data, FInworldStudioUserWorkspaceData& Workspace)
 {
-	StudioUserData.Workspaces.Reserve(Response.workspaces_size());
-
-	for (int32 i = 0; i < Response.workspaces_size(); i++)
-	{
-		const auto& GrpcWorkspace = Response.workspaces(i);
-		auto& Workspace = StudioUserData.Workspaces.Emplace_GetRef();
-		Workspace.Name = UTF8_TO_TCHAR(GrpcWorkspace.name().data());
-		Workspace.ShortName = CreateShortName(Workspace.Name);
-
-		Request(
-			"RunnableListScenesRequest",
-			std::make_unique<Inworld::RunnableListScenesRequest>(
-				TCHAR_TO_UTF8(*InworldToken),
-				TCHAR_TO_UTF8(*ServerUrl),
-				GrpcWorkspace.name(),
-				[this, &Workspace](const grpc::Status& Status, const InworldV1alpha::ListScenesResponse& Response)
-				{
-					if (!Status.ok())
-					{
-						Error(FString::Printf(TEXT("FRunnableListScenesRequest FALURE! %s, Code: %d"), UTF8_TO_TCHAR(Status.error_message().c_str()), Status.error_code()));
-						return;
-					}
+	Workspace.Name = UTF8_TO_TCHAR(Data._Name.c_str());
+	Workspace.ShortName = CreateShortName(Workspace.Name);
 
-					OnScenesReady(Response, Workspace);
-					CheckDoneRequests();
-				}
-			)
-		);
-
-		Request(
-			"RunnableListCharactersRequest",
-			std::make_unique<Inworld::RunnableListCharactersRequest>(
-				TCHAR_TO_UTF8(*InworldToken),
-				TCHAR_TO_UTF8(*ServerUrl),
-				GrpcWorkspace.name(),
-				[this, &Workspace](const grpc::Status& Status, const InworldV1alpha::ListCharactersResponse& Response)
-				{
-					if (!Status.ok())
-					{
-						Error(FString::Printf(TEXT("FRunnableListCharactersRequest FALURE! %s, Code: %d"), UTF8_TO_TCHAR(Status.error_message().c_str()), Status.error_code()));
-						return;
-					}
-
-					OnCharactersReady(Response, Workspace);
-					CheckDoneRequests();
-				}
-			)
-		);
-
-		Request(
-			"RunnableListApiKeysRequest",
-			std::make_unique<Inworld::RunnableListApiKeysRequest>(
-				TCHAR_TO_UTF8(*InworldToken),
-				TCHAR_TO_UTF8(*ServerUrl),
-				GrpcWorkspace.name(),
-				[this, &Workspace](const grpc::Status& Status, const InworldV1alpha::ListApiKeysResponse& Response)
-				{
-					if (!Status.ok())
-					{
-						Error(FString::Printf(TEXT("FRunnableListCharactersRequest FALURE! %s, Code: %d"), UTF8_TO_TCHAR(Status.error_message().c_str()), Status.error_code()));
-						return;
-					}
-
-					OnApiKeysReady(Response, Workspace);
-					CheckDoneRequests();
-				}
-			)
-		);
-	}
+	OnScenesReady(Data._Scenes, Workspace);
+	OnCharactersReady(Data._Characters, Workspace);
+	OnApiKeysReady(Data._ApiKeys, Workspace);
 }
 
-void Inworld::FStudio::OnApiKeysReady(const InworldV1alpha::ListApiKeysResponse& Response, FInworldStudioUserWorkspaceData& Workspace)
+void Inworld::FStudio::OnApiKeysReady(const std::vector<InworldV1alpha::ApiKey>& ApiKeys, FInworldStudioUserWorkspaceData& Workspace)
 {
-	Workspace.ApiKeys.Reserve(Response.api_keys_size());
+	Workspace.ApiKeys.Reserve(static_cast<int32>(ApiKeys.size()));
 
-	for (int32 i = 0; i < Response.api_keys_size(); i++)
+	for (const auto& GrpcApiKey : ApiKeys)
 	{
-		const auto& GrpcApiKey = Response.api_keys(i);
 		auto& ApiKey = Workspace.ApiKeys.Emplace_GetRef();
 		ApiKey.Name = UTF8_TO_TCHAR(GrpcApiKey.name().data());
 		ApiKey.Key = UTF8_TO_TCHAR(GrpcApiKey.key().data());
@@ -248,13 +262,12 @@ void Inworld::FStudio::OnApiKeysReady(const InworldV1alpha::ListApiKeysResponse&
 	}
 }
 
-void Inworld::FStudio::OnScenesReady(const InworldV1alpha::ListScenesResponse& Response, FInworldStudioUserWorkspaceData& Workspace)
+void Inworld::FStudio::OnScenesReady(const std::vector<InworldV1alpha::Scene>& Scenes, FInworldStudioUserWorkspaceData& Workspace)
 {
-	Workspace.Scenes.Reserve(Response.scenes_size());
+	Workspace.Scenes.Reserve(static_cast<int32>(Scenes.size()));
 
-	for (int32 i = 0; i < Response.scenes_size(); i++)
+	for (const auto& GrpcScene : Scenes)
 	{
-		const auto& GrpcScene = Response.scenes(i);
 		auto& Scene = Workspace.Scenes.Emplace_GetRef();
 		Scene.Name = UTF8_TO_TCHAR(GrpcScene.name().data());
 		Scene.ShortName = CreateShortName(Scene.Name);
@@ -266,13 +279,12 @@ void Inworld::FStudio::OnScenesReady(const InworldV1alpha::ListScenesResponse& R
 	}
 }
 
-void Inworld::FStudio::OnCharactersReady(const InworldV1alpha::ListCharactersResponse& Response, FInworldStudioUserWorkspaceData& Workspace)
+void Inworld::FStudio::OnCharactersReady(const std::vector<InworldV1alpha::Character>& Characters, FInworldStudioUserWorkspaceData& Workspace)
 {
-	Workspace.Characters.Reserve(Response.characters_size());
+	Workspace.Characters.Reserve(static_cast<int32>(Characters.size()));
 
-	for (int32 i = 0; i < Response.characters_size(); i++)
+	for (const auto& GrpcCharacter : Characters)
 	{
-		const auto& GrpcCharacter = Response.characters(i);
 		auto& Character = Workspace.Characters.Emplace_GetRef();
 		Inworld::GrpcHelper::CharacterInfo CharInfo = Inworld::GrpcHelper::CreateCharacterInfo(GrpcCharacter);
 		Character.Name = UTF8_TO_TCHAR(CharInfo._Name.c_str());
@@ -287,49 +299,12 @@ void Inworld::FStudio::OnCharactersReady(const InworldV1alpha::ListCharactersRes
 
 void Inworld::FStudio::CancelRequests()
 {
-	FScopeLock Lock(&RequestsMutex);
-
-	for (auto& Request : Requests)
+	if (Fetcher)
 	{
-		Request.Stop();
+		Fetcher->Cancel();
 	}
 
-	Requests.Empty();
-}
-
-void Inworld::FStudio::Request(const std::string& ThreadName, std::unique_ptr<Inworld::Runnable> Runnable)
-{
-	FScopeLock Lock(&RequestsMutex);
-
-	auto& AsyncTask = Requests.Emplace_GetRef();
-	AsyncTask.Start(ThreadName, std::move(Runnable));
-}
-
-void Inworld::FStudio::CheckDoneRequests()
-{
-	AsyncTask(ENamedThreads::GameThread, [this]()
-		{
-			FScopeLock Lock(&RequestsMutex);
-
-			for (int32 i = 0; i < Requests.Num();)
-			{
-				auto& Request = Requests[i];
-				if (Request.IsDone())
-				{
-					Requests.RemoveAt(i, 1, false);
-				}
-				else
-				{
-					i++;
-				}
-			}
-
-			if (Requests.Num() == 0)
-			{
-				Callback(true);
-			}
-		}
-	);
+	bRequestInProgress = false;
 }
 
 void Inworld::FStudio::Error(FString Message)
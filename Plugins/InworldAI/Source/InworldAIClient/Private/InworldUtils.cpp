@@ -12,7 +12,6 @@
 #define UI UI_ST
 THIRD_PARTY_INCLUDES_START
 #include "openssl/hmac.h"
-#include "Utils/SslCredentials.h"
 THIRD_PARTY_INCLUDES_END
 #undef UI
 
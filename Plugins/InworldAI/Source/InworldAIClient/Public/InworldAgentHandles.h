@@ -0,0 +1,34 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FInworldRouting;
+
+/**
+ * Agent ids of the loaded scene interned into small indices. Incoming packets carry them on their routing,
+ * so they are dispatched by array index rather than by hashing ids. Handles stay valid until the next Reset.
+ */
+class INWORLDAICLIENT_API FInworldAgentHandles
+{
+public:
+	void Reset();
+	// Returns the existing handle for a known id.
+	int32 Add(const FString& AgentId);
+	int32 Find(const FString& AgentId) const;
+
+	// Sets the handles of the agents on the routing, players and unknown agents get INDEX_NONE.
+	void Resolve(FInworldRouting& Routing) const;
+
+	int32 Num() const { return AgentIds.Num(); }
+	const FString& GetAgentId(int32 Handle) const { return AgentIds[Handle]; }
+
+private:
+	int32 FindCached(const FString& AgentId) const;
+
+	TArray<FString> AgentIds;
+	TMap<FString, int32> HandleByAgentId;
+	// Packets come in runs from the same agent, e.g. audio chunks, the last one found is checked first.
+	mutable int32 LastHandle = INDEX_NONE;
+};
@@ -4,6 +4,7 @@
 
 #include "InworldEnums.h"
 #include "InworldPackets.h"
+#include "InworldAgentHandles.h"
 
 #if !UE_BUILD_SHIPPING
 #include "HAL/IConsoleManager.h"
@@ -22,6 +23,42 @@ DECLARE_DELEGATE_TwoParams(FOnInworldLatency, FString, int32)
 DECLARE_DELEGATE_OneParam(FOnInworldConnectionStateChanged, EInworldConnectionState);
 DECLARE_DELEGATE_OneParam(FOnInworldPacketReceived, TSharedPtr<FInworldPacket>);
 
+struct FInworldAudioProcessorStats
+{
+	int32 QueueDepth = 0;
+	int32 MaxQueueDepth = 0;
+	uint64 FramesProcessed = 0;
+	uint64 FramesDropped = 0;
+	double LastFrameMs = 0.0;
+	double MaxFrameMs = 0.0;
+	double AvgFrameMs = 0.0;
+};
+
+// Over the lifetime of the client.
+struct FInworldTransportStats
+{
+	uint64 PacketsReceived = 0;
+	uint64 BytesReceived = 0;
+	uint64 PacketsSent = 0;
+	uint64 BytesSent = 0;
+	// Packets waiting to be written to the gRPC stream.
+	int32 WriteQueueDepth = 0;
+};
+
+// From the player's final text to the first audio of the reply.
+struct FInworldTimeToFirstAudioStats
+{
+	// Upper bounds of Buckets, the last bucket has the slower replies.
+	static constexpr int32 NumBuckets = 5;
+	static constexpr int32 BucketBoundsMs[NumBuckets - 1] = { 250, 500, 1000, 2000 };
+
+	uint64 Count = 0;
+	double P50Ms = 0.0;
+	double P95Ms = 0.0;
+	double MaxMs = 0.0;
+	uint64 Buckets[NumBuckets] = {};
+};
+
 USTRUCT()
 struct INWORLDAICLIENT_API FInworldClient
 {
@@ -55,6 +92,13 @@ public:
 	void StartAudioSession(const FString& AgentId);
 	void StopAudioSession(const FString& AgentId);
 
+	// Echo cancellation runs on a worker started with the first audio sent with AEC.
+	bool GetAudioProcessorStats(FInworldAudioProcessorStats& OutStats) const;
+
+	FInworldTransportStats GetTransportStats() const;
+	// By agent id, agents that didn't reply with audio yet are left out.
+	void GetTimeToFirstAudioStats(TMap<FString, FInworldTimeToFirstAudioStats>& OutStats) const;
+
 	void SendCustomEvent(const FString& AgentId, const FString& Name, const TMap<FString, FString>& Params);
 	void SendChangeSceneEvent(const FString& SceneName);
 
@@ -70,10 +114,19 @@ public:
 
 	FOnInworldPacketReceived OnInworldPacketReceived;
 
+	// Interned when a scene is loaded or changed, clients intern the agents they hear about.
+	FInworldAgentHandles& GetAgentHandles() { return AgentHandles; }
+	const FInworldAgentHandles& GetAgentHandles() const { return AgentHandles; }
+
 private:
 	FString GenerateUserId();
 
+	void SendFilteredSoundMessage(const FString& AgentId, TArray<int16>&& InputData, TArray<int16>&& OutputData);
+
 	TSharedPtr<Inworld::FClient> InworldClient;
+	TSharedPtr<class FInworldAudioProcessor> AudioProcessor;
+
+	FInworldAgentHandles AgentHandles;
 
 #if !UE_BUILD_SHIPPING
 	TSharedPtr<class FAsyncAudioDumper> AsyncAudioDumper;
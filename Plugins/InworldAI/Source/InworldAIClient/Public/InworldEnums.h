@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Misc/EnumRange.h"
 #include "UObject/ObjectMacros.h"
 
 UENUM(BlueprintType)
@@ -49,6 +50,8 @@ enum class EInworldCharacterEmotionalBehavior : uint8
 	SURPRISE = 17,
 	JOY = 18,
 };
+// Keep the last value up to date, replication sizes the enum from it.
+ENUM_RANGE_BY_FIRST_AND_LAST(EInworldCharacterEmotionalBehavior, EInworldCharacterEmotionalBehavior::NEUTRAL, EInworldCharacterEmotionalBehavior::JOY);
 
 UENUM(BlueprintType)
 enum class EInworldCharacterEmotionStrength : uint8
@@ -58,6 +61,7 @@ enum class EInworldCharacterEmotionStrength : uint8
 	STRONG = 2,
 	NORMAL = 3,
 };
+ENUM_RANGE_BY_FIRST_AND_LAST(EInworldCharacterEmotionStrength, EInworldCharacterEmotionStrength::UNSPECIFIED, EInworldCharacterEmotionStrength::NORMAL);
 
 UENUM(BlueprintType)
 enum class EInworldActorType : uint8
@@ -66,6 +70,7 @@ enum class EInworldActorType : uint8
 	PLAYER = 1,
 	AGENT = 2,
 };
+ENUM_RANGE_BY_FIRST_AND_LAST(EInworldActorType, EInworldActorType::UNKNOWN, EInworldActorType::AGENT);
 
 UENUM(BlueprintType)
 enum class EInworldControlEventAction : uint8
@@ -77,4 +82,25 @@ enum class EInworldControlEventAction : uint8
 	TTS_PLAYBACK_START = 4,
 	TTS_PLAYBACK_END = 5,
 };
+ENUM_RANGE_BY_FIRST_AND_LAST(EInworldControlEventAction, EInworldControlEventAction::UNKNOWN, EInworldControlEventAction::TTS_PLAYBACK_END);
 
+// Same order as FInworldCharacterVisemeBlends.
+UENUM(BlueprintType)
+enum class EInworldViseme : uint8
+{
+	PP,
+	FF,
+	TH,
+	DD,
+	Kk,
+	CH,
+	SS,
+	Nn,
+	RR,
+	Aa,
+	E,
+	I,
+	O,
+	U,
+	STOP,
+};
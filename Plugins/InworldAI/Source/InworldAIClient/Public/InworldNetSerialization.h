@@ -0,0 +1,60 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/EnumRange.h"
+
+class UPackageMap;
+
+namespace Inworld
+{
+	namespace Net
+	{
+		// Strings that repeat across events (interaction and utterance ids, actor names) are sent once per connection
+		// and referenced by index afterwards. References are only emitted within the scope that sent the definition,
+		// reliable RPCs of one actor channel arrive in order so the receiver always has the definition first.
+		// A scope defines its strings again when its actor channel is reopened, full dictionaries recycle the least
+		// recently used entries. Without a scope strings are sent inline.
+		class INWORLDAICLIENT_API FDictionaryScope
+		{
+		public:
+			FDictionaryScope(const UObject* Scope);
+			~FDictionaryScope();
+
+		private:
+			const UObject* PreviousScope;
+		};
+
+		// UTF-8 encoded, length packed.
+		INWORLDAICLIENT_API void SerializeString(FArchive& Ar, FString& Str);
+		INWORLDAICLIENT_API void SerializeDictionaryString(FArchive& Ar, UPackageMap* Map, FString& Str);
+		INWORLDAICLIENT_API void SerializeBool(FArchive& Ar, bool& bValue);
+
+		template<typename TEnum>
+		void SerializeEnum(FArchive& Ar, TEnum& Value, TEnum MaxValue)
+		{
+			uint32 Raw = static_cast<uint32>(Value);
+			Ar.SerializeInt(Raw, static_cast<uint32>(MaxValue) + 1);
+			Value = static_cast<TEnum>(Raw);
+		}
+
+		// Sized by the enum's range, see ENUM_RANGE_BY_FIRST_AND_LAST.
+		template<typename TEnum>
+		void SerializeEnum(FArchive& Ar, TEnum& Value)
+		{
+			SerializeEnum(Ar, Value, static_cast<TEnum>(TEnumRangeTraits<TEnum>::End - 1));
+		}
+
+		// Serializes an event with Compact, and when Inworld.Net.EventStats is enabled records its size
+		// along with the size Legacy would have taken. See Inworld.Net.DumpEventStats.
+		INWORLDAICLIENT_API bool SerializeEvent(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess, const TCHAR* EventType,
+			TFunctionRef<void(FArchive&, UPackageMap*)> Compact, TFunctionRef<void(FArchive&, UPackageMap*)> Legacy);
+
+		INWORLDAICLIENT_API bool IsEventStatsEnabled();
+		INWORLDAICLIENT_API void RecordEventStats(const TCHAR* EventType, uint64 CompactBits, uint64 LegacyBits);
+
+		// Default property replication of a struct, used as the baseline for event stats.
+		INWORLDAICLIENT_API void SerializeLegacyStruct(FArchive& Ar, UPackageMap* Map, const UStruct* Struct, void* Data);
+	}
+}
@@ -31,6 +31,9 @@ struct INWORLDAICLIENT_API FInworldActor
 	EInworldActorType Type =  EInworldActorType::UNKNOWN;
 	UPROPERTY()
 	FString Name;
+
+	// Agent handle in the loaded scene, see FInworldAgentHandles. Local to the process, not serialized.
+	int32 Handle = INDEX_NONE;
 };
 
 USTRUCT()
@@ -120,12 +123,18 @@ struct INWORLDAICLIENT_API FInworldPacket
 
 	virtual void Serialize(FMemoryArchive& Ar);
 
+	// Shared part of the replicated event structs NetSerialize.
+	void NetSerializePacket(FArchive& Ar, class UPackageMap* Map);
+
 	FString ToDebugString() const;
 
 	UPROPERTY()
 	FInworldPacketId PacketId;
 	UPROPERTY()
 	FInworldRouting Routing;
+	// Sender time in nanoseconds since Unix epoch.
+	UPROPERTY()
+	int64 Timestamp = 0;
 
 protected:
 	virtual void AppendDebugString(FString& Str) const PURE_VIRTUAL(FInworldPacket::AppendDebugString);
@@ -146,10 +155,21 @@ struct INWORLDAICLIENT_API FInworldTextEvent : public FInworldPacket
 	UPROPERTY()
 	bool Final = false;
 
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
 protected:
 	virtual void AppendDebugString(FString& Str) const override;
 };
 
+template<>
+struct TStructOpsTypeTraits<FInworldTextEvent> : public TStructOpsTypeTraitsBase2<FInworldTextEvent>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
 USTRUCT()
 struct INWORLDAICLIENT_API FInworldDataEvent : public FInworldPacket
 {
@@ -174,10 +194,23 @@ struct INWORLDAICLIENT_API FInworldVisemeInfo
 	GENERATED_BODY()
 
 	FInworldVisemeInfo() = default;
+	FInworldVisemeInfo(EInworldViseme InCode, float InTimestamp)
+		: Code(InCode)
+		, Timestamp(InTimestamp)
+	{}
 
-	void Serialize(FMemoryArchive& Ar);
+	// Code as in FInworldCharacterVisemeBlends, e.g. "PP".
+	static const TCHAR* CodeToString(EInworldViseme Code);
+	static bool CodeFromString(const FString& Str, EInworldViseme& OutCode);
 
-	FString Code;
+	// Timestamps are kept in whole ticks, which makes the delta coded serialization lossless.
+	static constexpr int32 TicksPerSecond = 1000;
+	static float QuantizeTimestamp(float Timestamp);
+
+	// Inworld::Utils::EncodeVisemes, codes as bytes followed by packed deltas of quantized timestamps.
+	static void SerializeArray(FArchive& Ar, TArray<FInworldVisemeInfo>& Infos);
+
+	EInworldViseme Code = EInworldViseme::STOP;
 	float Timestamp = 0.f;
 };
 
@@ -215,10 +248,21 @@ struct INWORLDAICLIENT_API FInworldSilenceEvent : public FInworldPacket
 	UPROPERTY()
 	float Duration = 0.f;
 
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
 protected:
 	virtual void AppendDebugString(FString& Str) const;
 };
 
+template<>
+struct TStructOpsTypeTraits<FInworldSilenceEvent> : public TStructOpsTypeTraitsBase2<FInworldSilenceEvent>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
 USTRUCT()
 struct INWORLDAICLIENT_API FInworldControlEvent : public FInworldPacket
 {
@@ -232,10 +276,21 @@ struct INWORLDAICLIENT_API FInworldControlEvent : public FInworldPacket
 	UPROPERTY()
 	EInworldControlEventAction Action = EInworldControlEventAction::UNKNOWN;
 
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
 protected:
 	virtual void AppendDebugString(FString& Str) const;
 };
 
+template<>
+struct TStructOpsTypeTraits<FInworldControlEvent> : public TStructOpsTypeTraitsBase2<FInworldControlEvent>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
 USTRUCT()
 struct INWORLDAICLIENT_API FInworldEmotionEvent : public FInworldPacket
 {
@@ -251,10 +306,21 @@ struct INWORLDAICLIENT_API FInworldEmotionEvent : public FInworldPacket
 	UPROPERTY()
 	EInworldCharacterEmotionStrength Strength = EInworldCharacterEmotionStrength::NORMAL;
 
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
 protected:
 	virtual void AppendDebugString(FString& Str) const;
 };
 
+template<>
+struct TStructOpsTypeTraits<FInworldEmotionEvent> : public TStructOpsTypeTraitsBase2<FInworldEmotionEvent>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
 USTRUCT()
 struct INWORLDAICLIENT_API FInworldCustomEvent : public FInworldPacket
 {
@@ -271,31 +337,7 @@ struct INWORLDAICLIENT_API FInworldCustomEvent : public FInworldPacket
 	UPROPERTY(NotReplicated)
 	TMap<FString, FString> Params;
 	
-	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
-	{
-		TArray<FString> ParamKeys;
-		TArray<FString> ParamValues;
-
-		if (Ar.IsLoading())
-		{
-			Ar << ParamKeys;
-			Ar << ParamValues;
-			for (auto It = ParamKeys.CreateConstIterator(); It; ++It)
-			{
-				Params.Add(ParamKeys[It.GetIndex()], ParamValues[It.GetIndex()]);
-			}
-		}
-		else
-		{
-			Params.GenerateKeyArray(ParamKeys);
-			Params.GenerateValueArray(ParamValues);
-			Ar << ParamKeys;
-			Ar << ParamValues;
-		}
-
-		bOutSuccess = true;
-		return true;
-	}
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
 	
 protected:
 	virtual void AppendDebugString(FString& Str) const;
@@ -28,6 +28,12 @@ public:
 	const FString& GetError() const;
 	FInworldStudioUserData GetStudioUserData() const;
 
+	// Studio data of the last complete request is stored in FilePath, bound to CacheKey.
+	void EnableCache(const FString& FilePath, const FString& CacheKey);
+	bool LoadCachedStudioUserData();
+	// False if the last request returned the same data as the cache.
+	bool HasStudioUserDataChanged() const;
+
 private:
 
 	TSharedPtr<Inworld::FStudio> InworldStudio;
@@ -26,6 +26,14 @@
 #include "Innequin/InnequinPluginDataAsset.h"
 #include "Interfaces/IPluginManager.h"
 #include "UObject/SavePackage.h"
+#include "HAL/FileManager.h"
+#include "EngineUtils.h"
+#include "Engine/Engine.h"
+#include "Engine/Level.h"
+#include "Misc/Paths.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Editor.h"
 
 static FString ServerUrl = "api-studio.inworld.ai:443";
 
@@ -37,13 +45,38 @@ const FString& UInworldEditorApiSubsystem::GetSavedStudioAccessToken() const
 
 void UInworldEditorApiSubsystem::RequestStudioData(const FString& ExchangeToken)
 {
+	const FString CacheDir = FPaths::ProjectSavedDir() / TEXT("InworldAI");
+	IFileManager::Get().MakeDirectory(*CacheDir, true);
+	Studio.EnableCache(CacheDir / TEXT("StudioCache.bin"), ServerUrl + TEXT("|") + ExchangeToken);
+
+	// Serve the cached data right away and refresh it in the background, the refresh delivers API key secrets.
+	const bool bServedFromCache = Studio.LoadCachedStudioUserData();
+	if (bServedFromCache)
+	{
+		CacheStudioData(Studio.GetStudioUserData());
+		OnLogin.Broadcast(true, Studio.GetStudioUserData());
+	}
+
 	FInworldEditorClientOptions Options;
 	Options.ServerUrl = ServerUrl;
 	Options.ExchangeToken = ExchangeToken;
-	EditorClient.RequestFirebaseToken(Options, [this](const FString& FirebaseToken)
+	EditorClient.RequestFirebaseToken(Options, [this, bServedFromCache](const FString& FirebaseToken)
 		{
-			Studio.RequestStudioUserData(FirebaseToken, ServerUrl, [this](bool bSuccess) 
+			Studio.RequestStudioUserData(FirebaseToken, ServerUrl, [this, bServedFromCache](bool bSuccess) 
 				{
+					if (bServedFromCache && !bSuccess)
+					{
+						// The cache has no API key secrets, the login isn't usable without the refresh.
+						UE_LOG(LogInworldAIEditor, Warning, TEXT("Couldn't refresh Studio data, cached API keys have no secrets: %s"), *Studio.GetError());
+						OnLogin.Broadcast(false, Studio.GetStudioUserData());
+						return;
+					}
+
+					if (bServedFromCache && !Studio.HasStudioUserDataChanged())
+					{
+						return;
+					}
+
 					CacheStudioData(Studio.GetStudioUserData());
 					OnLogin.Broadcast(bSuccess, Studio.GetStudioUserData());
 				}
@@ -79,51 +112,212 @@ TArray<FString> UInworldEditorApiSubsystem::GetWorldActorNames() const
 
 void UInworldEditorApiSubsystem::SetupActor(const FInworldStudioUserCharacterData& Data, const FString& Name, const FString& PreviousName)
 {
-	if ((Name.IsEmpty() && PreviousName.IsEmpty()) || (Name == PreviousName))
+	FInworldCharacterActorSetup Setup;
+	Setup.Data = Data;
+	Setup.Name = Name;
+	Setup.PreviousName = PreviousName;
+	SetupActors({ Setup });
+}
+
+void UInworldEditorApiSubsystem::SetupActors(const TArray<FInworldCharacterActorSetup>& Setups)
+{
+	TArray<AActor*> ConfiguredActors;
+	ConfiguredActors.Reserve(Setups.Num());
+
+	for (const FInworldCharacterActorSetup& Setup : Setups)
 	{
-		UE_LOG(LogInworldAIEditor, Error, TEXT("UInworldEditorApiSubsystem::SetupActor invalid names '%s', '%s'"), *Name, *PreviousName);
-		return;
+		const FString& Name = Setup.Name;
+		const FString& PreviousName = Setup.PreviousName;
+		if ((Name.IsEmpty() && PreviousName.IsEmpty()) || (Name == PreviousName))
+		{
+			UE_LOG(LogInworldAIEditor, Error, TEXT("UInworldEditorApiSubsystem::SetupActor invalid names '%s', '%s'"), *Name, *PreviousName);
+			continue;
+		}
+
+		if (AActor* PreviousActor = FindActorByName(PreviousName))
+		{
+			if (auto* Component = PreviousActor->FindComponentByClass<UInworldCharacterComponent>())
+			{
+				UnindexCharacterComponent(Component);
+				PreviousActor->RemoveInstanceComponent(Component);
+			}
+		}
+
+		AActor* Actor = FindActorByName(Name);
+		if (!Actor)
+		{
+			continue;
+		}
+
+		auto* Component = NewObject<UInworldCharacterComponent>(Actor);
+		if (!Component)
+		{
+			UE_LOG(LogInworldAIEditor, Error, TEXT("UInworldEditorApiSubsystem::SetupActor couldn't create UInworldCharacterComponent"));
+			continue;
+		}
+
+		Actor->AddInstanceComponent(Component);
+		Component->SetBrainName(Setup.Data.Name);
+		Component->RegisterComponent();
+
+		ConfiguredActors.Add(Actor);
+	}
+
+	// Only actors of the editor level can be selected.
+	if (GEditor && ConfiguredActors.Num() != 0 && GetIndexedWorld() == GetWorld())
+	{
+		FSelectionStateOfLevel SelectionState;
+		for (AActor* Actor : ConfiguredActors)
+		{
+			SelectionState.SelectedActors.Add(Actor->GetPathName());
+		}
+		GEditor->SetSelectionStateOfLevel(SelectionState);
+	}
+}
+
+TArray<AActor*> UInworldEditorApiSubsystem::GetActorsWithBrainName(const FString& BrainName)
+{
+	if (bCharacterIndexDirty)
+	{
+		RebuildCharacterIndex();
 	}
 
 	TArray<AActor*> Actors;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AActor::StaticClass(), Actors);
-	
-	for (auto* Actor : Actors)
+	if (auto* Components = CharacterComponentIndex.Find(BrainName))
 	{
-		if (Actor->GetName() == PreviousName)
+		for (const TWeakObjectPtr<UInworldCharacterComponent>& Component : *Components)
 		{
-			if (auto* Component = Actor->GetComponentByClass(UInworldCharacterComponent::StaticClass()))
+			// Brain name may have been changed in the details panel since the component was indexed.
+			if (Component.IsValid() && Component->GetBrainName() == BrainName && Component->GetOwner())
 			{
-				Actor->RemoveInstanceComponent(Component);
-				continue;
+				Actors.AddUnique(Component->GetOwner());
 			}
 		}
+	}
+	return Actors;
+}
+
+AActor* UInworldEditorApiSubsystem::FindActorByName(const FString& Name) const
+{
+	UWorld* World = GetIndexedWorld();
+	if (Name.IsEmpty() || !World)
+	{
+		return nullptr;
+	}
+
+	// Actors are outered to their level, a name lookup is a hash lookup per loaded level.
+	const FName ActorName(*Name, FNAME_Find);
+	if (ActorName.IsNone())
+	{
+		return nullptr;
+	}
 
-		if (Actor->GetName() == Name)
+	for (ULevel* Level : World->GetLevels())
+	{
+		if (AActor* Actor = Level ? FindObjectFast<AActor>(Level, ActorName) : nullptr)
 		{
-			auto* Component = NewObject<UInworldCharacterComponent>(Actor);
-			if (!Component)
-			{
-				UE_LOG(LogInworldAIEditor, Error, TEXT("UInworldEditorApiSubsystem::SetupActor couldn't create UInworldCharacterComponent"));
-				continue;
-			}
+			return Actor;
+		}
+	}
+	return nullptr;
+}
 
-			Actor->AddInstanceComponent(Component);
-			Component->SetBrainName(Data.Name);
-			Component->RegisterComponent();
+UWorld* UInworldEditorApiSubsystem::GetIndexedWorld() const
+{
+	return IndexedWorld.IsValid() ? IndexedWorld.Get() : GetWorld();
+}
 
-			if (GEditor)
-			{
-				FSelectionStateOfLevel SelectionState;
-				GEditor->SetSelectionStateOfLevel(SelectionState);
+void UInworldEditorApiSubsystem::SetIndexedWorld(UWorld* World)
+{
+	IndexedWorld = World != GetWorld() ? World : nullptr;
+	bCharacterIndexDirty = true;
+}
 
-				SelectionState.SelectedActors.Add(Actor->GetPathName());
-				GEditor->SetSelectionStateOfLevel(SelectionState);
-			}
+void UInworldEditorApiSubsystem::IndexCharacterComponent(UInworldCharacterComponent* Component)
+{
+	if (!bCharacterIndexDirty)
+	{
+		CharacterComponentIndex.FindOrAdd(Component->GetBrainName()).AddUnique(Component);
+	}
+}
+
+void UInworldEditorApiSubsystem::UnindexCharacterComponent(UInworldCharacterComponent* Component)
+{
+	if (auto* Components = CharacterComponentIndex.Find(Component->GetBrainName()))
+	{
+		Components->Remove(Component);
+	}
+}
+
+void UInworldEditorApiSubsystem::IndexActor(AActor* Actor)
+{
+	if (Actor && Actor->GetWorld() == GetIndexedWorld())
+	{
+		TInlineComponentArray<UInworldCharacterComponent*> Components(Actor);
+		for (UInworldCharacterComponent* Component : Components)
+		{
+			IndexCharacterComponent(Component);
+		}
+	}
+}
+
+void UInworldEditorApiSubsystem::RebuildCharacterIndex()
+{
+	CharacterComponentIndex.Empty();
+	bCharacterIndexDirty = false;
+
+	for (TActorIterator<AActor> It(GetIndexedWorld()); It; ++It)
+	{
+		IndexActor(*It);
+	}
+}
+
+void UInworldEditorApiSubsystem::OnLevelActorAdded(AActor* Actor)
+{
+	IndexActor(Actor);
+}
+
+void UInworldEditorApiSubsystem::OnLevelActorDeleted(AActor* Actor)
+{
+	if (Actor && Actor->GetWorld() == GetIndexedWorld())
+	{
+		TInlineComponentArray<UInworldCharacterComponent*> Components(Actor);
+		for (UInworldCharacterComponent* Component : Components)
+		{
+			UnindexCharacterComponent(Component);
 		}
 	}
 }
 
+void UInworldEditorApiSubsystem::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+	if (World == GetIndexedWorld() && Level)
+	{
+		for (AActor* Actor : Level->Actors)
+		{
+			IndexActor(Actor);
+		}
+	}
+}
+
+void UInworldEditorApiSubsystem::OnLevelRemovedFromWorld(ULevel* Level, UWorld* World)
+{
+	if (World == GetIndexedWorld())
+	{
+		// Null level means all levels were removed, stale weak pointers are skipped on lookup either way.
+		bCharacterIndexDirty = true;
+	}
+}
+
+void UInworldEditorApiSubsystem::OnCharacterBrainNameSet(UInworldCharacterComponent* Component)
+{
+	// Added to an existing actor, recreated by a construction script, or renamed.
+	if (Component && Component->GetWorld() == GetIndexedWorld())
+	{
+		IndexCharacterComponent(Component);
+	}
+}
+
 const FInworldStudioUserData& UInworldEditorApiSubsystem::GetCachedStudioData() const
 {
 	FInworldAIEditorModule* Module = static_cast<FInworldAIEditorModule*>(FModuleManager::Get().GetModule("InworldAIEditor"));
@@ -323,6 +517,16 @@ void UInworldEditorApiSubsystem::Initialize(FSubsystemCollectionBase& Collection
 	FOnCharacterStudioDataAction ActionDelegate;
 	ActionDelegate.BindDynamic(this, &UInworldEditorApiSubsystem::CreateInnequinActor);
 	BindActionForCharacterData(FName("Create Inworld Avatar"), PermissionDelegate, ActionDelegate);
+
+	if (GEngine)
+	{
+		LevelActorAddedHandle = GEngine->OnLevelActorAdded().AddUObject(this, &UInworldEditorApiSubsystem::OnLevelActorAdded);
+		LevelActorDeletedHandle = GEngine->OnLevelActorDeleted().AddUObject(this, &UInworldEditorApiSubsystem::OnLevelActorDeleted);
+	}
+	LevelAddedToWorldHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UInworldEditorApiSubsystem::OnLevelAddedToWorld);
+	LevelRemovedFromWorldHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UInworldEditorApiSubsystem::OnLevelRemovedFromWorld);
+	CharacterBrainNameSetHandle = UInworldCharacterComponent::OnBrainNameSetInEditor.AddUObject(this, &UInworldEditorApiSubsystem::OnCharacterBrainNameSet);
+	bCharacterIndexDirty = true;
 }
 
 void UInworldEditorApiSubsystem::Deinitialize()
@@ -336,6 +540,16 @@ void UInworldEditorApiSubsystem::Deinitialize()
 	Module.UnbindMenuAssetAction(FName("Inworld Character"));
 
 	UnbindActionForCharacterData(FName("Create Inworld Avatar"));
+
+	if (GEngine)
+	{
+		GEngine->OnLevelActorAdded().Remove(LevelActorAddedHandle);
+		GEngine->OnLevelActorDeleted().Remove(LevelActorDeletedHandle);
+	}
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedToWorldHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedFromWorldHandle);
+	UInworldCharacterComponent::OnBrainNameSetInEditor.Remove(CharacterBrainNameSetHandle);
+	CharacterComponentIndex.Empty();
 }
 
 void UInworldEditorApiSubsystem::SavePackageToCharacterFolder(UObject* Object, const FInworldStudioUserCharacterData& CharacterData, const FString& NamePrefix, FString NameSuffix)
@@ -501,3 +715,112 @@ void UInworldEditorApiSubsystem::CreateInnequinActor(const FInworldStudioUserCha
 	FKismetEditorUtilities::CompileBlueprint(Blueprint);
 	SavePackageToCharacterFolder(Blueprint, CharacterData, "BP");
 }
+
+// Inworld.Debug.CharacterSyncBenchmark [Actors] [Characters]
+// Points the editor subsystem's character index at a transient world of its own, the editor level is left alone.
+class FInworldCharacterSyncBenchmark
+{
+public:
+	static void Run(const TArray<FString>& Args)
+	{
+		const int32 NumActors = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 2) : 100000;
+		// The last actor is left for a component added after the sync.
+		const int32 NumCharacters = FMath::Clamp(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 50, 1, NumActors - 1);
+
+		UWorld* EditorWorld = GEditor ? GEditor->GetEditorWorldContext().World() : nullptr;
+		UInworldEditorApiSubsystem* Subsystem = EditorWorld ? EditorWorld->GetSubsystem<UInworldEditorApiSubsystem>() : nullptr;
+		if (!Subsystem)
+		{
+			UE_LOG(LogInworldAIEditor, Error, TEXT("Inworld character sync benchmark: no editor world"));
+			return;
+		}
+
+		UWorld* World = UWorld::CreateWorld(EWorldType::Inactive, false, TEXT("InworldCharacterSyncBenchmark"));
+		Subsystem->SetIndexedWorld(World);
+
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		TArray<AActor*> Actors;
+		Actors.Reserve(NumActors);
+		for (int32 i = 0; i < NumActors; i++)
+		{
+			Actors.Add(World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters));
+		}
+
+		// The Studio sync sets up every character of a workspace, then looks their actors up.
+		TArray<FInworldCharacterActorSetup> Setups;
+		TArray<FString> BrainNames;
+		for (int32 i = 0; i < NumCharacters; i++)
+		{
+			FInworldCharacterActorSetup& Setup = Setups.AddDefaulted_GetRef();
+			Setup.Data.Name = BrainNames.Add_GetRef(FString::Printf(TEXT("workspaces/benchmark/characters/%d"), i));
+			Setup.Name = Actors[i * (NumActors / NumCharacters)]->GetName();
+		}
+
+		const double SetupStart = FPlatformTime::Seconds();
+		Subsystem->SetupActors(Setups);
+		const double SetupTime = FPlatformTime::Seconds() - SetupStart;
+
+		// Before the index, every lookup iterated the level.
+		auto ScanLookup = [World](const FString& BrainName)
+		{
+			TArray<AActor*> Found;
+			for (TActorIterator<AActor> It(World); It; ++It)
+			{
+				UInworldCharacterComponent* Component = It->FindComponentByClass<UInworldCharacterComponent>();
+				if (Component && Component->GetBrainName() == BrainName)
+				{
+					Found.Add(*It);
+				}
+			}
+			return Found;
+		};
+
+		int32 ScanFound = 0;
+		const double ScanStart = FPlatformTime::Seconds();
+		for (const FString& BrainName : BrainNames)
+		{
+			ScanFound += ScanLookup(BrainName).Num();
+		}
+		const double ScanTime = FPlatformTime::Seconds() - ScanStart;
+
+		int32 IndexFound = 0;
+		const double IndexStart = FPlatformTime::Seconds();
+		for (const FString& BrainName : BrainNames)
+		{
+			IndexFound += Subsystem->GetActorsWithBrainName(BrainName).Num();
+		}
+		const double IndexTime = FPlatformTime::Seconds() - IndexStart;
+
+		// Renaming a component in the details panel and adding one to an existing actor reach the index too.
+		UInworldCharacterComponent* Renamed = Actors[0]->FindComponentByClass<UInworldCharacterComponent>();
+		const FString RenamedBrainName = TEXT("workspaces/benchmark/characters/renamed");
+		Renamed->SetBrainName(RenamedBrainName);
+		Renamed->PostEditChange();
+		UInworldCharacterComponent* Added = NewObject<UInworldCharacterComponent>(Actors[NumActors - 1]);
+		Actors[NumActors - 1]->AddInstanceComponent(Added);
+		Added->SetBrainName(BrainNames[0]);
+		Added->RegisterComponent();
+		const bool bUpdated = Subsystem->GetActorsWithBrainName(RenamedBrainName).Num() == ScanLookup(RenamedBrainName).Num() &&
+			Subsystem->GetActorsWithBrainName(BrainNames[0]).Num() == ScanLookup(BrainNames[0]).Num();
+
+		Subsystem->SetIndexedWorld(nullptr);
+		World->DestroyWorld(false);
+		World->RemoveFromRoot();
+
+		UE_LOG(LogInworldAIEditor, Log, TEXT("Inworld character sync benchmark: %d characters in %d actors"), NumCharacters, NumActors);
+		UE_LOG(LogInworldAIEditor, Log, TEXT("  setup           %8.2f ms"), SetupTime * 1000.0);
+		UE_LOG(LogInworldAIEditor, Log, TEXT("  lookup by scan  %8.2f ms"), ScanTime * 1000.0);
+		UE_LOG(LogInworldAIEditor, Log, TEXT("  lookup by index %8.2f ms"), IndexTime * 1000.0);
+		if (ScanFound != IndexFound || !bUpdated)
+		{
+			UE_LOG(LogInworldAIEditor, Error, TEXT("Inworld character sync benchmark: index lookups found different actors than scans"));
+		}
+	}
+};
+
+static FAutoConsoleCommand CmdCharacterSyncBenchmark(
+	TEXT("Inworld.Debug.CharacterSyncBenchmark"),
+	TEXT("Time setting up and looking up Studio characters in a large transient level, by level scan against by index. Args: [Actors=100000] [Characters=50]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FInworldCharacterSyncBenchmark::Run)
+);
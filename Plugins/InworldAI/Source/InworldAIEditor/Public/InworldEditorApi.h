@@ -16,6 +16,23 @@ DECLARE_DYNAMIC_DELEGATE_OneParam(FOnCharacterStudioDataAction, const FInworldSt
 
 DECLARE_DYNAMIC_DELEGATE_RetVal_OneParam(bool, FOnCharacterStudioDataPermission, const FInworldStudioUserCharacterData&, CharacterStudioData);
 
+USTRUCT(BlueprintType)
+struct FInworldCharacterActorSetup
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, Category = "Inworld")
+	FInworldStudioUserCharacterData Data;
+
+	/** Actor to add the character component to */
+	UPROPERTY(BlueprintReadWrite, Category = "Inworld")
+	FString Name;
+
+	/** Actor to remove the character component from */
+	UPROPERTY(BlueprintReadWrite, Category = "Inworld")
+	FString PreviousName;
+};
+
 UCLASS(BlueprintType, Config = InworldAI)
 class INWORLDAIEDITOR_API UInworldEditorApiSubsystem : public UWorldSubsystem
 {
@@ -48,6 +65,13 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Inworld")
 	void SetupActor(const FInworldStudioUserCharacterData& Data, const FString& Name, const FString& PreviousName);
 
+	/** Sets up many characters in one pass, actors are looked up by name without scanning the level */
+	UFUNCTION(BlueprintCallable, Category = "Inworld")
+	void SetupActors(const TArray<FInworldCharacterActorSetup>& Setups);
+
+	UFUNCTION(BlueprintCallable, Category = "Inworld")
+	TArray<AActor*> GetActorsWithBrainName(const FString& BrainName);
+
 	UFUNCTION(BlueprintPure, Category = "Inworld")
 	const FString& GetError() { return !EditorClient.GetError().IsEmpty() ? EditorClient.GetError() : Studio.GetError(); }
 
@@ -105,6 +129,37 @@ private:
 
 	void CacheStudioData(const FInworldStudioUserData& Data);
 
+	AActor* FindActorByName(const FString& Name) const;
+
+	/** The editor world, unless the character index is pointed at another one. */
+	UWorld* GetIndexedWorld() const;
+	void SetIndexedWorld(UWorld* World);
+
+	void IndexCharacterComponent(class UInworldCharacterComponent* Component);
+	void UnindexCharacterComponent(class UInworldCharacterComponent* Component);
+	void IndexActor(AActor* Actor);
+	void RebuildCharacterIndex();
+
+	void OnLevelActorAdded(AActor* Actor);
+	void OnLevelActorDeleted(AActor* Actor);
+	void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+	void OnLevelRemovedFromWorld(ULevel* Level, UWorld* World);
+	void OnCharacterBrainNameSet(class UInworldCharacterComponent* Component);
+
+	/**
+	 * Character components of the indexed world by brain name, maintained from actor, level and component delegates.
+	 * Components stay listed under brain names they no longer have, lookups skip them.
+	 */
+	TMap<FString, TArray<TWeakObjectPtr<class UInworldCharacterComponent>>> CharacterComponentIndex;
+	bool bCharacterIndexDirty = true;
+	TWeakObjectPtr<UWorld> IndexedWorld;
+
+	FDelegateHandle LevelActorAddedHandle;
+	FDelegateHandle LevelActorDeletedHandle;
+	FDelegateHandle LevelAddedToWorldHandle;
+	FDelegateHandle LevelRemovedFromWorldHandle;
+	FDelegateHandle CharacterBrainNameSetHandle;
+
 	struct FCharacterStudioDataFunctions
 	{
 	public:
@@ -115,4 +170,6 @@ private:
 	TMap<FName, FCharacterStudioDataFunctions> CharacterStudioDataFunctionMap;
 
 	TSharedPtr<class FInworldEditorRestartRequiredNotification> RestartRequiredNotification;
+
+	friend class FInworldCharacterSyncBenchmark;
 };
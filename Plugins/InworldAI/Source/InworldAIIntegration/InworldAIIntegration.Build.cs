@@ -28,6 +28,7 @@ public class InworldAIIntegration : ModuleRules
             {
                 "ApplicationCore",
                 "AudioMixer",
+                "InworldAINdk",
                 "InworldAIPlatform",
                 "Networking",
                 "Sockets",
@@ -11,6 +11,10 @@
 #include "TimerManager.h"
 #include "InworldAudioRepl.h"
 
+THIRD_PARTY_INCLUDES_START
+#include "Utils/ReconnectBackoff.h"
+THIRD_PARTY_INCLUDES_END
+
 static TAutoConsoleVariable<bool> CVarLogAllPackets(
 TEXT("Inworld.Debug.LogAllPackets"), false,
 TEXT("Enable/Disable logging all packets going from server")
@@ -93,6 +97,10 @@ void UInworldApiSubsystem::StopSession()
 {
     UnpossessAgents();
 
+    GetWorld()->GetTimerManager().ClearTimer(RetryConnectionTimerHandle);
+    ReconnectBackoff->Reset();
+    DisconnectedTime = 0.0;
+
     Client->Stop();
 }
 
@@ -104,6 +112,7 @@ void UInworldApiSubsystem::SaveSession(FOnSaveReady Delegate)
             Client->OnSessionSaved.Unbind();
         }
     );
+    Client->SaveSession();
 }
 
 void UInworldApiSubsystem::SetResponseLatencyTrackerDelegate(FResponseLatencyTrackerDelegate Delegate)
@@ -121,16 +130,27 @@ void UInworldApiSubsystem::ClearResponseLatencyTrackerDelegate()
 
 void UInworldApiSubsystem::PossessAgents(const TArray<FInworldAgentInfo>& AgentInfos)
 {
+    AgentInfoByBrain.Reserve(AgentInfos.Num());
     for (const auto& AgentInfo : AgentInfos)
     {
-        FString BrainName = AgentInfo.BrainName;
+        const FString& BrainName = AgentInfo.BrainName;
         AgentInfoByBrain.Add(BrainName, AgentInfo);
-        if (CharacterComponentByBrainName.Contains(BrainName))
+
+        const int32 Handle = Client->GetAgentHandles().Add(AgentInfo.AgentId);
+        if (Handle >= BrainNameByHandle.Num())
+        {
+            BrainNameByHandle.SetNum(Handle + 1);
+        }
+        BrainNameByHandle[Handle] = BrainName;
+
+        if (bPossessAgentsOnDemand)
+        {
+            continue;
+        }
+
+        if (auto* Component = CharacterComponentByBrainName.FindRef(BrainName))
         {
-            auto Component = CharacterComponentByBrainName[BrainName];
-            CharacterComponentByAgentId.Add(AgentInfo.AgentId, Component);
-            Component->Possess(AgentInfo);
-            CharacterComponentByAgentId.Add(Component->GetAgentId(), Component);
+            BindCharacterComponent(Component, AgentInfo);
         }
         else if (BrainName != FString("__DUMMY__"))
         {
@@ -157,8 +177,9 @@ void UInworldApiSubsystem::UnpossessAgents()
     {
         Component->Unpossess();
     }
-    CharacterComponentByAgentId.Empty();
+    CharacterComponentByHandle.Reset();
     AgentInfoByBrain.Empty();
+    BrainNameByHandle.Reset();
     bCharactersInitialized = false;
 }
 
@@ -175,11 +196,12 @@ void UInworldApiSubsystem::RegisterCharacterComponent(Inworld::ICharacterCompone
 
     if (bCharactersInitialized)
     {
-        if (AgentInfoByBrain.Contains(BrainName))
+        if (const auto* AgentInfo = AgentInfoByBrain.Find(BrainName))
         {
-            auto AgentInfo = AgentInfoByBrain[BrainName];
-            CharacterComponentByAgentId.Add(AgentInfo.AgentId, Component);
-            Component->Possess(AgentInfo);
+            if (!bPossessAgentsOnDemand)
+            {
+                BindCharacterComponent(Component, *AgentInfo);
+            }
         }
         else
         {
@@ -197,7 +219,7 @@ void UInworldApiSubsystem::UnregisterCharacterComponent(Inworld::ICharacterCompo
     }
 
     Component->Unpossess();
-    CharacterComponentByAgentId.Remove(Component->GetAgentId());
+    SetCharacterComponentByAgentId(Component->GetAgentId(), nullptr);
     CharacterComponentByBrainName.Remove(BrainName);
     CharacterComponentRegistry.Remove(Component);
 }
@@ -209,9 +231,9 @@ bool UInworldApiSubsystem::IsCharacterComponentRegistered(Inworld::ICharacterCom
 
 void UInworldApiSubsystem::UpdateCharacterComponentRegistrationOnClient(Inworld::ICharacterComponent* Component, const FString& NewAgentId, const FString& OldAgentId)
 {
-    if (CharacterComponentByAgentId.Contains(OldAgentId) && CharacterComponentByAgentId[OldAgentId] == Component)
+    if (GetCharacterComponentByAgentId(OldAgentId) == Component)
     {
-        CharacterComponentByAgentId.Remove(OldAgentId);
+        SetCharacterComponentByAgentId(OldAgentId, nullptr);
     }
 
     if (NewAgentId.IsEmpty())
@@ -220,11 +242,56 @@ void UInworldApiSubsystem::UpdateCharacterComponentRegistrationOnClient(Inworld:
     }
     else
     {
-        CharacterComponentByAgentId.Add(NewAgentId, Component);
+        SetCharacterComponentByAgentId(NewAgentId, Component);
         CharacterComponentRegistry.AddUnique(Component);
     }
 }
 
+bool UInworldApiSubsystem::PossessCharacterComponent(const FString& BrainName)
+{
+    auto* Component = CharacterComponentByBrainName.FindRef(BrainName);
+    if (!Component)
+    {
+        return false;
+    }
+
+    if (!Component->GetAgentId().IsEmpty())
+    {
+        return true;
+    }
+
+    const auto* AgentInfo = bCharactersInitialized ? AgentInfoByBrain.Find(BrainName) : nullptr;
+    if (!AgentInfo)
+    {
+        return false;
+    }
+
+    BindCharacterComponent(Component, *AgentInfo);
+    UE_LOG(LogInworldAIIntegration, Log, TEXT("Character possessed: %s, Id: %s"), *BrainName, *AgentInfo->AgentId);
+    return true;
+}
+
+void UInworldApiSubsystem::BindCharacterComponent(Inworld::ICharacterComponent* Component, const FInworldAgentInfo& AgentInfo)
+{
+    SetCharacterComponentByAgentId(AgentInfo.AgentId, Component);
+    Component->Possess(AgentInfo);
+    SetCharacterComponentByAgentId(Component->GetAgentId(), Component);
+}
+
+Inworld::ICharacterComponent* UInworldApiSubsystem::FindOrPossessCharacterComponentByHandle(int32 Handle)
+{
+    if (auto* Component = GetCharacterComponentByHandle(Handle))
+    {
+        return Component;
+    }
+
+    if (bPossessAgentsOnDemand && BrainNameByHandle.IsValidIndex(Handle) && PossessCharacterComponent(BrainNameByHandle[Handle]))
+    {
+        return GetCharacterComponentByHandle(Handle);
+    }
+    return nullptr;
+}
+
 void UInworldApiSubsystem::SendTextMessage(const FString& AgentId, const FString& Text)
 {
     if (!ensureMsgf(!AgentId.IsEmpty(), TEXT("AgentId must be valid!")))
@@ -233,10 +300,9 @@ void UInworldApiSubsystem::SendTextMessage(const FString& AgentId, const FString
     }
 
     TSharedPtr<FInworldPacket> Packet = Client->SendTextMessage(AgentId, Text);
-    auto* AgentComponentPtr = CharacterComponentByAgentId.Find(AgentId);
-    if (AgentComponentPtr)
+    if (auto* AgentComponent = GetCharacterComponentByHandle(Packet->Routing.Target.Handle))
     {
-        (*AgentComponentPtr)->HandlePacket(Packet);
+        AgentComponent->HandlePacket(Packet);
     }
 }
 
@@ -323,11 +389,33 @@ void UInworldApiSubsystem::GetConnectionError(FString& Message, int32& Code)
 
 Inworld::ICharacterComponent* UInworldApiSubsystem::GetCharacterComponentByAgentId(const FString& AgentId) const
 {
-    if (CharacterComponentByAgentId.Contains(AgentId))
+    return Client ? GetCharacterComponentByHandle(Client->GetAgentHandles().Find(AgentId)) : nullptr;
+}
+
+void UInworldApiSubsystem::SetCharacterComponentByAgentId(const FString& AgentId, Inworld::ICharacterComponent* Component)
+{
+    if (!Client)
     {
-        return CharacterComponentByAgentId[AgentId];
+        return;
     }
-    return nullptr;
+
+    if (!Component)
+    {
+        const int32 Handle = Client->GetAgentHandles().Find(AgentId);
+        if (CharacterComponentByHandle.IsValidIndex(Handle))
+        {
+            CharacterComponentByHandle[Handle] = nullptr;
+        }
+        return;
+    }
+
+    // Agents not in the loaded scene, e.g. on clients, are interned as they come.
+    const int32 Handle = Client->GetAgentHandles().Add(AgentId);
+    if (Handle >= CharacterComponentByHandle.Num())
+    {
+        CharacterComponentByHandle.SetNumZeroed(Handle + 1);
+    }
+    CharacterComponentByHandle[Handle] = Component;
 }
 
 void UInworldApiSubsystem::CancelResponse(const FString& AgentId, const FString& InteractionId, const TArray<FString>& UtteranceIds)
@@ -348,6 +436,15 @@ void UInworldApiSubsystem::StartAudioReplication()
 	}
 }
 
+void UInworldApiSubsystem::SetAudioReplToken(uint64 Token)
+{
+	StartAudioReplication();
+	if (AudioRepl)
+	{
+		AudioRepl->SetClientToken(Token);
+	}
+}
+
 bool UInworldApiSubsystem::DoesSupportWorldType(EWorldType::Type WorldType) const
 {
     return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
@@ -359,26 +456,44 @@ void UInworldApiSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 
     Client = MakeShared<FInworldClient>();
 
+    Inworld::ReconnectBackoff::Settings BackoffSettings;
+    BackoffSettings.BaseDelay = RetryConnectionIntervalTime;
+    BackoffSettings.MaxDelay = MaxRetryConnectionTime;
+    BackoffSettings.Jitter = RetryConnectionJitter;
+    ReconnectBackoff = MakeShared<Inworld::ReconnectBackoff>(BackoffSettings);
+
     Client->OnConnectionStateChanged.BindLambda([this](EInworldConnectionState ConnectionState)
         {
             OnConnectionStateChanged.Broadcast(ConnectionState);
 
             if (ConnectionState == EInworldConnectionState::Connected)
             {
-                CurrentRetryConnectionTime = 1.f;
+                if (DisconnectedTime > 0.0)
+                {
+                    UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld session resumed in %.0fms after %d attempts"),
+                        (FPlatformTime::Seconds() - DisconnectedTime) * 1000.0, ReconnectBackoff->GetAttempts());
+                    DisconnectedTime = 0.0;
+                }
+                ReconnectBackoff->Reset();
             }
 
             if (ConnectionState == EInworldConnectionState::Disconnected)
             {
-                if (CurrentRetryConnectionTime == 0.f)
+                if (DisconnectedTime == 0.0)
+                {
+                    DisconnectedTime = FPlatformTime::Seconds();
+                }
+
+                // The session and its token are kept, a resume only reopens the stream.
+                const float Delay = ReconnectBackoff->NextDelay();
+                if (Delay <= 0.f)
                 {
                     ResumeSession();
                 }
                 else
                 {
-                    GetWorld()->GetTimerManager().SetTimer(RetryConnectionTimerHandle, this, &UInworldApiSubsystem::ResumeSession, CurrentRetryConnectionTime);
+                    GetWorld()->GetTimerManager().SetTimer(RetryConnectionTimerHandle, this, &UInworldApiSubsystem::ResumeSession, Delay);
                 }
-                CurrentRetryConnectionTime += FMath::Min(CurrentRetryConnectionTime + RetryConnectionIntervalTime, MaxRetryConnectionTime);
             }
         }
     );
@@ -422,16 +537,15 @@ void UInworldApiSubsystem::OnWorldBeginPlay(UWorld& InWorld)
 
 void UInworldApiSubsystem::DispatchPacket(TSharedPtr<FInworldPacket> InworldPacket)
 {
-	auto* SourceComponentPtr = CharacterComponentByAgentId.Find(InworldPacket->Routing.Source.Name);
-	if (SourceComponentPtr)
+	// Handles are set when the packet is translated.
+	if (auto* SourceComponent = FindOrPossessCharacterComponentByHandle(InworldPacket->Routing.Source.Handle))
 	{
-		(*SourceComponentPtr)->HandlePacket(InworldPacket);
+		SourceComponent->HandlePacket(InworldPacket);
 	}
 
-	auto* TargetComponentPtr = CharacterComponentByAgentId.Find(InworldPacket->Routing.Target.Name);
-	if (TargetComponentPtr)
+	if (auto* TargetComponent = FindOrPossessCharacterComponentByHandle(InworldPacket->Routing.Target.Handle))
 	{
-		(*TargetComponentPtr)->HandlePacket(InworldPacket);
+		TargetComponent->HandlePacket(InworldPacket);
 	}
 
     if (ensure(InworldPacket))
@@ -456,5 +570,149 @@ void UInworldApiSubsystem::ReplicateAudioEventFromServer(FInworldAudioDataEvent&
 
 void UInworldApiSubsystem::HandleAudioEventOnClient(TSharedPtr<FInworldAudioDataEvent> Packet)
 {
+    // Handles are local to the process, replicated packets are resolved here.
+    Client->GetAgentHandles().Resolve(Packet->Routing);
     DispatchPacket(Packet);
 }
+
+#if !UE_BUILD_SHIPPING
+
+// Inworld.Debug.SceneLoadBenchmark [Agents] [Components] [Targeted]
+class FInworldSceneLoadBenchmark
+{
+public:
+    static void Run(const TArray<FString>& Args, UWorld* World)
+    {
+        const int32 NumAgents = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 500;
+        const int32 NumComponents = FMath::Min(Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 80, NumAgents);
+        const int32 NumTargeted = FMath::Min(Args.Num() > 2 ? FMath::Max(FCString::Atoi(*Args[2]), 1) : 5, NumComponents);
+
+        // The scene as the engine serves it, characters placed in the level have a component.
+        TArray<FInworldAgentInfo> AgentInfos;
+        AgentInfos.Reserve(NumAgents);
+        for (int32 i = 0; i < NumAgents; i++)
+        {
+            auto& AgentInfo = AgentInfos.AddDefaulted_GetRef();
+            AgentInfo.BrainName = FString::Printf(TEXT("workspaces/benchmark/characters/character_%d"), i);
+            AgentInfo.AgentId = FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower);
+            AgentInfo.GivenName = FString::Printf(TEXT("Character %d"), i);
+        }
+
+        UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld scene load benchmark: %d agents, %d components, %d spoken to"), NumAgents, NumComponents, NumTargeted);
+        for (const bool bOnDemand : { false, true })
+        {
+            Measure(World, AgentInfos, NumComponents, NumTargeted, bOnDemand);
+        }
+    }
+
+private:
+    struct FCharacter : public Inworld::ICharacterComponent
+    {
+        virtual void Possess(const FInworldAgentInfo& InAgentInfo) override { AgentInfo = InAgentInfo; }
+        virtual void Unpossess() override { AgentInfo = FInworldAgentInfo(); }
+        virtual const FString& GetAgentId() const override { return AgentInfo.AgentId; }
+        virtual const FString& GetGivenName() const override { return AgentInfo.GivenName; }
+        virtual const FString& GetBrainName() const override { return BrainName; }
+        virtual void HandlePacket(TSharedPtr<FInworldPacket> Packet) override { Packets++; }
+        virtual AActor* GetComponentOwner() const override { return nullptr; }
+        virtual Inworld::IPlayerComponent* GetTargetPlayer() override { return nullptr; }
+
+        FString BrainName;
+        FInworldAgentInfo AgentInfo;
+        int32 Packets = 0;
+    };
+
+    static SIZE_T GetAllocatedSize(const FInworldAgentInfo& AgentInfo)
+    {
+        return AgentInfo.BrainName.GetAllocatedSize() + AgentInfo.AgentId.GetAllocatedSize() + AgentInfo.GivenName.GetAllocatedSize();
+    }
+
+    static void Measure(UWorld* World, const TArray<FInworldAgentInfo>& AgentInfos, int32 NumComponents, int32 NumTargeted, bool bOnDemand)
+    {
+        // A subsystem of its own, the world's keeps its components and session.
+        UInworldApiSubsystem* Subsystem = NewObject<UInworldApiSubsystem>(World);
+        Subsystem->Client = MakeShared<FInworldClient>();
+        Subsystem->bPossessAgentsOnDemand = bOnDemand;
+
+        TArray<FCharacter> Characters;
+        Characters.SetNum(NumComponents);
+        for (int32 i = 0; i < NumComponents; i++)
+        {
+            Characters[i].BrainName = AgentInfos[i].BrainName;
+            Subsystem->RegisterCharacterComponent(&Characters[i]);
+        }
+
+        // Like FInworldClient does when the scene is loaded.
+        const double LoadStart = FPlatformTime::Seconds();
+        FInworldAgentHandles& Handles = Subsystem->Client->GetAgentHandles();
+        Handles.Reset();
+        for (const auto& AgentInfo : AgentInfos)
+        {
+            Handles.Add(AgentInfo.AgentId);
+        }
+        Subsystem->PossessAgents(AgentInfos);
+        const double LoadTime = FPlatformTime::Seconds() - LoadStart;
+
+        int32 NumPossessedOnLoad = 0;
+        for (const auto& Character : Characters)
+        {
+            NumPossessedOnLoad += Character.GetAgentId().IsEmpty() ? 0 : 1;
+        }
+
+        // Every character spoken to answers a few times.
+        const FInworldActor Player(EInworldActorType::PLAYER, TEXT("player"));
+        const double SessionStart = FPlatformTime::Seconds();
+        for (int32 i = 0; i < NumTargeted; i++)
+        {
+            const int32 Index = i * NumComponents / NumTargeted;
+            Subsystem->PossessCharacterComponent(Characters[Index].BrainName);
+            for (int32 Reply = 0; Reply < 10; Reply++)
+            {
+                auto Packet = MakeShared<FInworldTextEvent>();
+                Packet->Routing = FInworldRouting(FInworldActor(EInworldActorType::AGENT, AgentInfos[Index].AgentId), Player);
+                Handles.Resolve(Packet->Routing);
+                Subsystem->DispatchPacket(Packet);
+            }
+        }
+        const double SessionTime = FPlatformTime::Seconds() - SessionStart;
+
+        int32 NumPossessed = 0;
+        int32 NumPackets = 0;
+        SIZE_T BoundBytes = Subsystem->CharacterComponentByHandle.GetAllocatedSize() + Subsystem->BrainNameByHandle.GetAllocatedSize();
+        for (const auto& Character : Characters)
+        {
+            NumPossessed += Character.GetAgentId().IsEmpty() ? 0 : 1;
+            NumPackets += Character.Packets;
+            BoundBytes += GetAllocatedSize(Character.AgentInfo);
+        }
+        SIZE_T SceneBytes = Subsystem->AgentInfoByBrain.GetAllocatedSize();
+        for (const auto& Pair : Subsystem->AgentInfoByBrain)
+        {
+            SceneBytes += Pair.Key.GetAllocatedSize() + GetAllocatedSize(Pair.Value);
+        }
+
+        UE_LOG(LogInworldAIIntegration, Log, TEXT("  %s: scene load %.3fms with %d possessed, session %.3fms with %d possessed, %d packets dispatched, %.1fKB agent info, %.1fKB bound"),
+            bOnDemand ? TEXT("on demand") : TEXT("eager    "), LoadTime * 1000.0, NumPossessedOnLoad, SessionTime * 1000.0, NumPossessed, NumPackets,
+            SceneBytes / 1024.0, BoundBytes / 1024.0);
+        if (NumPackets != NumTargeted * 10)
+        {
+            UE_LOG(LogInworldAIIntegration, Error, TEXT("Inworld scene load benchmark: %d of %d packets reached their character"), NumPackets, NumTargeted * 10);
+        }
+
+        Subsystem->UnpossessAgents();
+        for (auto& Character : Characters)
+        {
+            Subsystem->UnregisterCharacterComponent(&Character);
+        }
+        Subsystem->Client.Reset();
+        Subsystem->MarkAsGarbage();
+    }
+};
+
+static FAutoConsoleCommandWithWorldAndArgs CmdSceneLoadBenchmark(
+    TEXT("Inworld.Debug.SceneLoadBenchmark"),
+    TEXT("Load a synthetic scene into a separate subsystem, possessing agents eagerly and on demand, and log time and memory. Args: [Agents=500] [Components=80] [Targeted=5]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&FInworldSceneLoadBenchmark::Run)
+);
+
+#endif
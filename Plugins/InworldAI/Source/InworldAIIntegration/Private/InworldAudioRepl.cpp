@@ -4,15 +4,46 @@
 #include "InworldPackets.h"
 #include "InworldSockets.h"
 #include "InworldApi.h"
+#include "InworldPlayerComponent.h"
+#include "InworldAIIntegrationModule.h"
 
 #include "Serialization/MemoryWriter.h"
 #include "Serialization/MemoryReader.h"
 
+#include "HAL/IConsoleManager.h"
+
 #include <GameFramework/Controller.h>
+#include <GameFramework/Pawn.h>
 #include <GameFramework/PlayerController.h>
+#include <GameFramework/PlayerState.h>
 
 #include <Engine/NetConnection.h>
 
+static TAutoConsoleVariable<int32> CVarAudioReplPortOffset(
+	TEXT("Inworld.AudioRepl.PortOffset"), -1000,
+	TEXT("UDP port of the audio replication socket relative to the server's game port")
+);
+
+static TAutoConsoleVariable<int32> CVarAudioReplServerBufferKB(
+	TEXT("Inworld.AudioRepl.ServerBufferKB"), 4096,
+	TEXT("Send and receive buffer size of the server's audio replication socket, shared by every connection")
+);
+
+static TAutoConsoleVariable<int32> CVarAudioReplClientBufferKB(
+	TEXT("Inworld.AudioRepl.ClientBufferKB"), 512,
+	TEXT("Receive buffer size of the client's audio replication socket")
+);
+
+static TAutoConsoleVariable<int32> CVarAudioReplPacingKBps(
+	TEXT("Inworld.AudioRepl.PacingKBps"), 256,
+	TEXT("Audio replication send rate per connection, datagrams above it wait in the connection's queue")
+);
+
+static TAutoConsoleVariable<int32> CVarAudioReplMaxQueuedKB(
+	TEXT("Inworld.AudioRepl.MaxQueuedKB"), 256,
+	TEXT("Oldest audio waiting to be sent to a connection is dropped above this")
+);
+
 void UInworldAudioRepl::PostLoad()
 {
 	Super::PostLoad();
@@ -20,22 +51,37 @@ void UInworldAudioRepl::PostLoad()
 
 void UInworldAudioRepl::BeginDestroy()
 {
-	for (auto& Socket : AudioSockets)
+	if (ServerSocket)
+	{
+		ServerSocket->Deinitialize();
+		ServerSocket.Reset();
+	}
+	if (ClientSocket)
 	{
-		Socket.Value->Deinitialize();
-		Socket.Value.Reset();
+		ClientSocket->Deinitialize();
+		ClientSocket.Reset();
 	}
-	AudioSockets.Empty();
 	
 	Super::BeginDestroy();
 }
 
 void UInworldAudioRepl::Tick(float DeltaTime)
 {
-	if (GetWorld() && GetWorld()->GetNetMode() == NM_Client)
+	if (!GetWorld())
+	{
+		return;
+	}
+
+	if (GetWorld()->GetNetMode() == NM_Client)
 	{
 		ListenAudioSocket();
 	}
+	else if (Inworld::FSocketMultiplexServer* Socket = GetServerSocket())
+	{
+		// Opened up front so clients hold a token and have said hello before the first audio event.
+		AuthorizeConnections();
+		Socket->Tick();
+	}
 }
 
 TStatId UInworldAudioRepl::GetStatId() const
@@ -51,15 +97,75 @@ void UInworldAudioRepl::ReplicateAudioEvent(FInworldAudioDataEvent& Event)
 		return;
 	}
 
+	Inworld::FSocketMultiplexServer* Socket = GetServerSocket();
+	if (!Socket)
+	{
+		return;
+	}
+
 	TArray<uint8> Data;
 	FMemoryWriter Ar(Data);
 	Event.Serialize(Ar);
 
+	// Connections are told apart by player id, clients say hello with theirs and their token.
 	for (; It; ++It)
 	{
-		if (UNetConnection* Connection = It->Get()->GetNetConnection())
+		const AController* Controller = It->Get();
+		if (Controller && Controller->GetNetConnection() && Controller->PlayerState)
 		{
-			GetAudioSocket(*Connection->RemoteAddr.Get()).ProcessData(Data);
+			Socket->Send(Controller->PlayerState->GetPlayerId(), Data);
+		}
+	}
+}
+
+bool UInworldAudioRepl::GetServerStats(Inworld::FSocketMultiplexStats& OutStats) const
+{
+	if (!ServerSocket)
+	{
+		return false;
+	}
+	OutStats = ServerSocket->GetStats();
+	return true;
+}
+
+void UInworldAudioRepl::AuthorizeConnections()
+{
+	// Players come and go rarely, no need to look every frame.
+	const double Now = FPlatformTime::Seconds();
+	if (Now < NextAuthorizeTime)
+	{
+		return;
+	}
+	NextAuthorizeTime = Now + 0.25;
+
+	TSet<uint32, DefaultKeyFuncs<uint32>, TInlineSetAllocator<64>> Connected;
+	for (auto It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* Controller = It->Get();
+		if (!Controller || !Controller->GetNetConnection() || !Controller->PlayerState)
+		{
+			continue;
+		}
+
+		const uint32 ConnectionId = Controller->PlayerState->GetPlayerId();
+		Connected.Add(ConnectionId);
+
+		// The token goes through the player's own component, only its owning connection gets client RPCs.
+		UInworldPlayerComponent* PlayerComponent = Controller->GetPawn() ? Controller->GetPawn()->FindComponentByClass<UInworldPlayerComponent>() : nullptr;
+		TWeakObjectPtr<UInworldPlayerComponent>& SentTo = TokenSentTo.FindOrAdd(ConnectionId);
+		if (PlayerComponent && SentTo.Get() != PlayerComponent)
+		{
+			PlayerComponent->ClientSetAudioReplToken(ServerSocket->Authorize(ConnectionId));
+			SentTo = PlayerComponent;
+		}
+	}
+
+	for (auto It = TokenSentTo.CreateIterator(); It; ++It)
+	{
+		if (!Connected.Contains(It.Key()))
+		{
+			ServerSocket->Revoke(It.Key());
+			It.RemoveCurrent();
 		}
 	}
 }
@@ -67,68 +173,94 @@ void UInworldAudioRepl::ReplicateAudioEvent(FInworldAudioDataEvent& Event)
 void UInworldAudioRepl::ListenAudioSocket()
 {
 	auto* Ctrl = GetWorld()->GetFirstPlayerController();
-	if (!Ctrl)
+	if (!Ctrl || !Ctrl->PlayerState)
 	{
 		return;
 	}
 
 	auto* Connection = Ctrl->GetNetConnection();
-	if (!Connection)
+	if (!Connection || !Connection->RemoteAddr.IsValid() || ClientToken == 0)
 	{
 		return;
 	}
 
-	auto* Driver = Connection->GetDriver();
-	if (!Driver)
+	auto* Socket = GetClientSocket(*Connection->RemoteAddr, Ctrl->PlayerState->GetPlayerId(), ClientToken);
+	if (!Socket)
 	{
 		return;
 	}
 
+	Socket->Receive(ReceivedPayloads);
+	if (ReceivedPayloads.Num() == 0)
+	{
+		return;
+	}
 
-	TArray<uint8> Data;
-	if (!GetAudioSocket(*Driver->GetLocalAddr().Get()).ProcessData(Data))
+	auto* InworldApi = GetWorld()->GetSubsystem<UInworldApiSubsystem>();
+	if (!ensure(InworldApi))
 	{
 		return;
 	}
 
-	FMemoryReader Ar(Data);
+	for (const TArrayView<const uint8>& Payload : ReceivedPayloads)
+	{
+		FMemoryReaderView Ar(MakeMemoryView(Payload));
 
-	TSharedPtr<FInworldAudioDataEvent> Event = MakeShared<FInworldAudioDataEvent>();
-	Event->Serialize(Ar);
+		TSharedPtr<FInworldAudioDataEvent> Event = MakeShared<FInworldAudioDataEvent>();
+		Event->Serialize(Ar);
 
-	auto* InworldApi = GetWorld()->GetSubsystem<UInworldApiSubsystem>();
-	if (ensure(InworldApi))
-	{
 		InworldApi->HandleAudioEventOnClient(Event);
 	}
 }
 
-Inworld::FSocketBase& UInworldAudioRepl::GetAudioSocket(const FInternetAddr& IpAddr)
+Inworld::FSocketMultiplexServer* UInworldAudioRepl::GetServerSocket()
 {
-	const FString IpAddrStr = IpAddr.ToString(true);
-	if (auto* Socket = AudioSockets.Find(IpAddrStr))
+	if (ServerSocket || bServerSocketFailed)
 	{
-		return *Socket->Get();
+		return ServerSocket.Get();
 	}
 
-	Inworld::FSocketSettings Settings;
-	Settings.IpAddr = IpAddr.ToString(false);
-	Settings.Port = FMath::Clamp(IpAddr.GetPort() - 1000, 0, 64 * 1024);
-	Settings.BufferSize = 2 * 1024 * 1024;
-	Settings.Name = FString::Printf(TEXT("Inworld %s"), *IpAddrStr);
+	const int32 GamePort = GetWorld()->URL.Port;
+	Inworld::FSocketMultiplexSettings Settings;
+	Settings.Port = FMath::Clamp(GamePort + CVarAudioReplPortOffset.GetValueOnGameThread(), 0, 64 * 1024 - 1);
+	Settings.BufferSize = FMath::Max(CVarAudioReplServerBufferKB.GetValueOnGameThread(), 64) * 1024;
+	Settings.PacingBytesPerSecond = FMath::Max(CVarAudioReplPacingKBps.GetValueOnGameThread(), 1) * 1024;
+	Settings.MaxQueuedBytes = FMath::Max(CVarAudioReplMaxQueuedKB.GetValueOnGameThread(), 1) * 1024;
+	Settings.Name = FString::Printf(TEXT("Inworld Audio :%d"), Settings.Port);
 
-	TUniquePtr<Inworld::FSocketBase> Socket;
-	if (GetWorld()->GetNetMode() == NM_Client)
+	ServerSocket = MakeUnique<Inworld::FSocketMultiplexServer>();
+	if (!ServerSocket->Initialize(Settings))
 	{
-		Socket = MakeUnique<Inworld::FSocketReceive>();
+		UE_LOG(LogInworldAIIntegration, Error, TEXT("Audio replication is off, port %d (game port %d %+d) is taken, see Inworld.AudioRepl.PortOffset"),
+			Settings.Port, GamePort, CVarAudioReplPortOffset.GetValueOnGameThread());
+		ServerSocket.Reset();
+		bServerSocketFailed = true;
 	}
-	else
+
+	return ServerSocket.Get();
+}
+
+Inworld::FSocketMultiplexClient* UInworldAudioRepl::GetClientSocket(const FInternetAddr& ServerAddr, uint32 ConnectionId, uint64 Token)
+{
+	if (ClientSocket && ClientSocket->GetConnectionId() == ConnectionId && ClientSocket->GetToken() == Token)
+	{
+		return ClientSocket.Get();
+	}
+
+	if (ClientSocket)
 	{
-		Socket = MakeUnique<Inworld::FSocketSend>();
+		ClientSocket->Deinitialize();
 	}
 
-	Socket->Initialize(Settings);
-	AudioSockets.Add(IpAddrStr, MoveTemp(Socket));
+	TSharedRef<FInternetAddr> AudioAddr = ServerAddr.Clone();
+	AudioAddr->SetPort(FMath::Clamp(ServerAddr.GetPort() + CVarAudioReplPortOffset.GetValueOnGameThread(), 0, 64 * 1024 - 1));
+
+	ClientSocket = MakeUnique<Inworld::FSocketMultiplexClient>();
+	const uint32 BufferSize = FMath::Max(CVarAudioReplClientBufferKB.GetValueOnGameThread(), 64) * 1024;
+	if (!ClientSocket->Initialize(FString::Printf(TEXT("Inworld Audio %s"), *AudioAddr->ToString(true)), *AudioAddr, ConnectionId, Token, BufferSize))
+	{
+		ClientSocket.Reset();
+	}
 
-	return *AudioSockets.Find(IpAddrStr)->Get();
+	return ClientSocket.Get();
 }
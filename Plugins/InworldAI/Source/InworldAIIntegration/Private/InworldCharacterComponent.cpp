@@ -5,6 +5,7 @@
 #include "InworldAIIntegrationModule.h"
 #include "Engine/EngineBaseTypes.h"
 #include "InworldPlayerComponent.h"
+#include "InworldNetSerialization.h"
 #include <Camera/CameraComponent.h>
 #include <Net/UnrealNetwork.h>
 #include <Engine/World.h>
@@ -122,12 +123,41 @@ void UInworldCharacterComponent::Unpossess()
 	GivenName = FString();
 }
 
+#if WITH_EDITOR
+UInworldCharacterComponent::FOnInworldCharacterBrainNameSet UInworldCharacterComponent::OnBrainNameSetInEditor;
+
+void UInworldCharacterComponent::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Undo reports no property.
+	const FName PropertyName = PropertyChangedEvent.GetPropertyName();
+	if (PropertyName.IsNone() || PropertyName == GET_MEMBER_NAME_CHECKED(UInworldCharacterComponent, BrainName))
+	{
+		OnBrainNameSetInEditor.Broadcast(this);
+	}
+}
+#endif
+
+void UInworldCharacterComponent::OnRegister()
+{
+	Super::OnRegister();
+
+#if WITH_EDITOR
+	if (GetWorld() && !GetWorld()->IsGameWorld())
+	{
+		OnBrainNameSetInEditor.Broadcast(this);
+	}
+#endif
+}
+
 void UInworldCharacterComponent::SetBrainName(const FString& Name)
 {
 #if WITH_EDITOR
 	if (GetWorld() == nullptr || !GetWorld()->IsPlayInEditor())
 	{
 		BrainName = Name;
+		OnBrainNameSetInEditor.Broadcast(this);
 		return;
 	}
 #endif
@@ -162,6 +192,8 @@ void UInworldCharacterComponent::HandlePacket(TSharedPtr<FInworldPacket> Packet)
 {
     if (ensure(Packet))
 	{
+		// Events are multicast on this component's channel, strings repeated across them are sent once.
+		Inworld::Net::FDictionaryScope NetDictionaryScope(this);
 		Packet->Accept(*this);
     }
 }
@@ -218,7 +250,7 @@ void UInworldCharacterComponent::CancelCurrentInteraction()
 
 void UInworldCharacterComponent::SendTextMessage(const FString& Text) const
 {
-    if (ensure(!AgentId.IsEmpty()))
+    if (ensure(EnsurePossessed()))
     {
         InworldSubsystem->SendTextMessage(AgentId, Text);
     }
@@ -226,7 +258,7 @@ void UInworldCharacterComponent::SendTextMessage(const FString& Text) const
 
 void UInworldCharacterComponent::SendTrigger(const FString& Name, const TMap<FString, FString>& Params)
 {
-    if (ensure(!AgentId.IsEmpty()))
+    if (ensure(EnsurePossessed()))
     {
         InworldSubsystem->SendTrigger(AgentId, Name, Params);
     }
@@ -234,7 +266,7 @@ void UInworldCharacterComponent::SendTrigger(const FString& Name, const TMap<FSt
 
 void UInworldCharacterComponent::SendAudioMessage(USoundWave* SoundWave) const
 {
-    if (ensure(!AgentId.IsEmpty()))
+    if (ensure(EnsurePossessed()))
     {
         InworldSubsystem->SendAudioMessage(AgentId, SoundWave);
     }
@@ -242,7 +274,7 @@ void UInworldCharacterComponent::SendAudioMessage(USoundWave* SoundWave) const
 
 void UInworldCharacterComponent::StartAudioSession() const
 {
-    if (ensure(!AgentId.IsEmpty()))
+    if (ensure(EnsurePossessed()))
     {
         InworldSubsystem->StartAudioSession(AgentId);
     }
@@ -256,6 +288,15 @@ void UInworldCharacterComponent::StopAudioSession() const
     }
 }
 
+bool UInworldCharacterComponent::EnsurePossessed() const
+{
+	if (AgentId.IsEmpty() && InworldSubsystem.IsValid() && GetNetMode() != NM_Client)
+	{
+		InworldSubsystem->PossessCharacterComponent(BrainName);
+	}
+	return !AgentId.IsEmpty();
+}
+
 bool UInworldCharacterComponent::Register()
 {
     if (BrainName.IsEmpty())
@@ -392,7 +433,7 @@ void UInworldCharacterComponent::VisitAudioOnClient(const FInworldAudioDataEvent
 		{
 			FCharacterUtteranceVisemeInfo& VisemeInfo_Ref = MessageToUpdate->VisemeInfos.AddDefaulted_GetRef();
 			VisemeInfo_Ref.Timestamp = VisemeInfo.Timestamp;
-			VisemeInfo_Ref.Code = VisemeInfo.Code;
+			VisemeInfo_Ref.Code = FInworldVisemeInfo::CodeToString(VisemeInfo.Code);
 		}
 	});
 }
@@ -2,11 +2,14 @@
 
 #include "InworldCharacterPlaybackHistory.h"
 #include "InworldCharacterMessage.h"
+#include "InworldAIIntegrationModule.h"
+#include "HAL/IConsoleManager.h"
 
 void FInworldCharacterInteractionHistory::Add(const FString& InteractionId, const FString& UtteranceId, const FString& Text, bool bPlayerInteraction
 	// ORIGINS MODIFY
 	, bool bInTextFinal
 	// END ORIGINS MODIFY
+	, FOnChange OnChange
 )
 {
 	if (IsInteractionCanceled(InteractionId))
@@ -14,50 +17,140 @@ void FInworldCharacterInteractionHistory::Add(const FString& InteractionId, cons
 		return;
 	}
 
-	auto* Interaction = Interactions.FindByPredicate([UtteranceId](const auto& I) { return I.UtteranceId == UtteranceId; });
-	if (Interaction)
+	if (const int32* Slot = SlotByUtteranceId.Find(UtteranceId))
 	{
-		*Interaction = FInworldCharacterInteraction(InteractionId, UtteranceId, Text, bPlayerInteraction
+		FInworldCharacterInteraction& Interaction = Entries[*Slot];
+		Interaction.InteractionId = InteractionId;
+		Interaction.Text = Text;
+		Interaction.bPlayerInteraction = bPlayerInteraction;
 		// ORIGINS MODIFY
-		, bInTextFinal
+		Interaction.bTextFinal = bInTextFinal;
 		// END ORIGINS MODIFY
-		);
+		bOrderedDirty = true;
+		OnChange(Interaction, EInworldCharacterInteractionChange::Updated);
 		return;
 	}
 
-	Interactions.Emplace(InteractionId, UtteranceId, Text, bPlayerInteraction
+	int32 Slot;
+	if (Count < MaxEntries)
+	{
+		Slot = GetSlot(Count++);
+	}
+	else
+	{
+		Slot = First;
+		First = GetSlot(1);
+		SlotByUtteranceId.Remove(Entries[Slot].UtteranceId);
+		OnChange(Entries[Slot], EInworldCharacterInteractionChange::Evicted);
+	}
+
+	FInworldCharacterInteraction Interaction(InteractionId, UtteranceId, Text, bPlayerInteraction
 		// ORIGINS MODIFY
 		, bInTextFinal
 		// END ORIGINS MODIFY
 	);
-
-	if (Interactions.Num() > MaxEntries)
+	if (Slot == Entries.Num())
 	{
-		Interactions.RemoveAt(0, 1, false);
+		Entries.Add(MoveTemp(Interaction));
 	}
+	else
+	{
+		Entries[Slot] = MoveTemp(Interaction);
+	}
+	SlotByUtteranceId.Add(UtteranceId, Slot);
+	bOrderedDirty = true;
+	OnChange(Entries[Slot], EInworldCharacterInteractionChange::Added);
 }
 
 void FInworldCharacterInteractionHistory::Clear()
 {
-	Interactions.Empty();
+	Entries.Empty();
+	SlotByUtteranceId.Empty();
+	Ordered.Empty();
+	First = 0;
+	Count = 0;
+	bOrderedDirty = false;
 }
 
 void FInworldCharacterInteractionHistory::SetMaxEntries(uint32 Val)
 {
-	MaxEntries = Val;
-	Interactions.Reserve(MaxEntries);
+	const int32 NewMaxEntries = FMath::Clamp<uint32>(Val, 1, MAX_int32);
+	if (NewMaxEntries == MaxEntries)
+	{
+		Entries.Reserve(MaxEntries);
+		return;
+	}
+
+	// The newest entries are kept, oldest at the front.
+	TArray<FInworldCharacterInteraction> Kept;
+	const int32 NumKept = FMath::Min(Count, NewMaxEntries);
+	Kept.Reserve(NewMaxEntries);
+	for (int32 i = Count - NumKept; i < Count; i++)
+	{
+		Kept.Add(MoveTemp(Entries[GetSlot(i)]));
+	}
+
+	Entries = MoveTemp(Kept);
+	MaxEntries = NewMaxEntries;
+	First = 0;
+	Count = NumKept;
+	SlotByUtteranceId.Reset();
+	SlotByUtteranceId.Reserve(MaxEntries);
+	for (int32 i = 0; i < Count; i++)
+	{
+		SlotByUtteranceId.Add(Entries[i].UtteranceId, i);
+	}
+	bOrderedDirty = true;
+}
+
+const FInworldCharacterInteraction* FInworldCharacterInteractionHistory::Find(const FString& UtteranceId) const
+{
+	const int32* Slot = SlotByUtteranceId.Find(UtteranceId);
+	return Slot ? &Entries[*Slot] : nullptr;
+}
+
+const TArray<FInworldCharacterInteraction>& FInworldCharacterInteractionHistory::GetInteractions() const
+{
+	if (bOrderedDirty)
+	{
+		Ordered.Reset(Count);
+		for (int32 i = 0; i < Count; i++)
+		{
+			Ordered.Add(Entries[GetSlot(i)]);
+		}
+		bOrderedDirty = false;
+	}
+	return Ordered;
 }
 
-void FInworldCharacterInteractionHistory::CancelUtterance(const FString& InteractionId, const FString& UtteranceId)
+void FInworldCharacterInteractionHistory::CancelUtterance(const FString& InteractionId, const FString& UtteranceId, FOnChange OnChange)
 {
 	CanceledInteractions.Add(InteractionId);
-	Interactions.RemoveAll([&UtteranceId, &InteractionId](const auto& I) { return I.UtteranceId == UtteranceId && I.InteractionId == InteractionId; });
+
+	const int32* Slot = SlotByUtteranceId.Find(UtteranceId);
+	if (!Slot || Entries[*Slot].InteractionId != InteractionId)
+	{
+		return;
+	}
+
+	// Interrupts are rare, the newer entries are shifted down over the canceled one.
+	const int32 Index = (*Slot - First + MaxEntries) % MaxEntries;
+	const FInworldCharacterInteraction Removed = MoveTemp(Entries[*Slot]);
+	SlotByUtteranceId.Remove(UtteranceId);
+	for (int32 i = Index; i < Count - 1; i++)
+	{
+		FInworldCharacterInteraction& Next = Entries[GetSlot(i + 1)];
+		SlotByUtteranceId.Add(Next.UtteranceId, GetSlot(i));
+		Entries[GetSlot(i)] = MoveTemp(Next);
+	}
+	Count--;
+	bOrderedDirty = true;
+	OnChange(Removed, EInworldCharacterInteractionChange::Removed);
 }
 
 bool FInworldCharacterInteractionHistory::IsInteractionCanceled(const FString& InteractionId) const
 {
-	int32 Idx;
-	return CanceledInteractions.Find(InteractionId, Idx);
+	return CanceledInteractions.Contains(InteractionId);
 }
 
 void FInworldCharacterInteractionHistory::ClearCanceledInteraction(const FString& InteractionId)
@@ -75,23 +168,215 @@ void UInworldCharacterPlaybackHistory::BeginPlay_Implementation()
 
 void UInworldCharacterPlaybackHistory::OnCharacterUtterance_Implementation(const FCharacterMessageUtterance& Message)
 {
-	InteractionHistory.Add(Message);
-	OnInteractionsChanged.Broadcast(InteractionHistory.GetInteractions());
+	InteractionHistory.Add(Message, [this](const auto& Interaction, auto Change) { BroadcastChange(Interaction, Change); });
+	BroadcastInteractions();
 }
 
 void UInworldCharacterPlaybackHistory::OnCharacterUtteranceInterrupt_Implementation(const FCharacterMessageUtterance& Message)
 {
-	InteractionHistory.CancelUtterance(Message.InteractionId, Message.UtteranceId);
-	OnInteractionsChanged.Broadcast(InteractionHistory.GetInteractions());
+	InteractionHistory.CancelUtterance(Message.InteractionId, Message.UtteranceId, [this](const auto& Interaction, auto Change) { BroadcastChange(Interaction, Change); });
+	BroadcastInteractions();
 }
 
 void UInworldCharacterPlaybackHistory::OnCharacterPlayerTalk_Implementation(const FCharacterMessagePlayerTalk& Message)
 {
-	InteractionHistory.Add(Message);
-	OnInteractionsChanged.Broadcast(InteractionHistory.GetInteractions());
+	InteractionHistory.Add(Message, [this](const auto& Interaction, auto Change) { BroadcastChange(Interaction, Change); });
+	BroadcastInteractions();
 }
 
 void UInworldCharacterPlaybackHistory::OnCharacterInteractionEnd_Implementation(const FCharacterMessageInteractionEnd& Message)
 {
 	InteractionHistory.ClearCanceledInteraction(Message.InteractionId);
 }
+
+void UInworldCharacterPlaybackHistory::BroadcastChange(const FInworldCharacterInteraction& Interaction, EInworldCharacterInteractionChange Change)
+{
+	bInteractionsChanged = true;
+	OnInteractionChanged.Broadcast(Interaction, Change);
+}
+
+void UInworldCharacterPlaybackHistory::BroadcastInteractions()
+{
+	if (bInteractionsChanged && OnInteractionsChanged.IsBound())
+	{
+		OnInteractionsChanged.Broadcast(InteractionHistory.GetInteractions());
+	}
+	bInteractionsChanged = false;
+}
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+	// The history as it was before the ring, a plain array searched by utterance id and broadcast whole.
+	struct FArrayInteractionHistory
+	{
+		void Add(const FString& InteractionId, const FString& UtteranceId, const FString& Text, bool bPlayerInteraction, bool bTextFinal)
+		{
+			if (CanceledInteractions.Contains(InteractionId))
+			{
+				return;
+			}
+			if (auto* Interaction = Interactions.FindByPredicate([&UtteranceId](const auto& I) { return I.UtteranceId == UtteranceId; }))
+			{
+				*Interaction = FInworldCharacterInteraction(InteractionId, UtteranceId, Text, bPlayerInteraction, bTextFinal);
+				return;
+			}
+			Interactions.Emplace(InteractionId, UtteranceId, Text, bPlayerInteraction, bTextFinal);
+			if (Interactions.Num() > MaxEntries)
+			{
+				Interactions.RemoveAt(0, 1, false);
+			}
+		}
+
+		void CancelUtterance(const FString& InteractionId, const FString& UtteranceId)
+		{
+			CanceledInteractions.Add(InteractionId);
+			Interactions.RemoveAll([&](const auto& I) { return I.UtteranceId == UtteranceId && I.InteractionId == InteractionId; });
+		}
+
+		TArray<FInworldCharacterInteraction> Interactions;
+		TArray<FString> CanceledInteractions;
+		int32 MaxEntries = 50;
+	};
+
+	struct FInteractionHistoryBenchmarkResult
+	{
+		double Seconds = 0.0;
+		// Entries handed to or scanned by the consumer.
+		uint64 EntriesNotified = 0;
+		int32 FinalsSeen = 0;
+	};
+
+	// Inworld.Debug.InteractionHistoryBenchmark [Interactions] [MaxEntries] [UpdatesPerUtterance]
+	void RunInteractionHistoryBenchmark(const TArray<FString>& Args)
+	{
+		const int32 NumInteractions = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+		const int32 MaxEntries = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 500;
+		const int32 NumUpdates = Args.Num() > 2 ? FMath::Max(FCString::Atoi(*Args[2]), 1) : 8;
+		// Every 50th character utterance is interrupted halfway.
+		constexpr int32 InterruptEvery = 50;
+
+		// A long session, the player talks and the character answers, text arrives in partial updates.
+		struct FMessage
+		{
+			FString InteractionId;
+			FString UtteranceId;
+			FString Text;
+			bool bPlayer;
+			bool bFinal;
+			bool bInterrupt;
+		};
+		TArray<FMessage> Messages;
+		Messages.Reserve(NumInteractions * (NumUpdates + 1));
+		int32 NumExpectedFinals = 0;
+		for (int32 i = 0; i < NumInteractions; i++)
+		{
+			const bool bPlayer = i % 2 == 0;
+			const FString InteractionId = FString::Printf(TEXT("interaction-%d"), i / 2);
+			const FString UtteranceId = FString::Printf(TEXT("%s-utterance-%d"), bPlayer ? TEXT("player") : TEXT("character"), i);
+			const bool bInterrupted = !bPlayer && (i / 2) % InterruptEvery == InterruptEvery - 1;
+			FString Text;
+			for (int32 Update = 0; Update < NumUpdates; Update++)
+			{
+				Text += TEXT("lorem ipsum dolor sit amet ");
+				if (bInterrupted && Update == NumUpdates / 2)
+				{
+					Messages.Add({ InteractionId, UtteranceId, Text, bPlayer, false, true });
+					break;
+				}
+				Messages.Add({ InteractionId, UtteranceId, Text, bPlayer, Update == NumUpdates - 1, false });
+			}
+			NumExpectedFinals += bInterrupted ? 0 : 1;
+		}
+
+		FInteractionHistoryBenchmarkResult ArrayResult;
+		{
+			FArrayInteractionHistory History;
+			History.MaxEntries = MaxEntries;
+			History.Interactions.Reserve(MaxEntries);
+			// Like UOriginInteractionWatcher did, rescanning the broadcast array from the last index it processed.
+			int32 NumProcessed = 0;
+			const double Start = FPlatformTime::Seconds();
+			for (const FMessage& Message : Messages)
+			{
+				if (Message.bInterrupt)
+				{
+					History.CancelUtterance(Message.InteractionId, Message.UtteranceId);
+				}
+				else
+				{
+					History.Add(Message.InteractionId, Message.UtteranceId, Message.Text, Message.bPlayer, Message.bFinal);
+				}
+				const TArray<FInworldCharacterInteraction>& Interactions = History.Interactions;
+				for (int32 i = NumProcessed; i < Interactions.Num() && Interactions[i].bTextFinal; i++)
+				{
+					ArrayResult.FinalsSeen++;
+					NumProcessed = i + 1;
+				}
+				ArrayResult.EntriesNotified += Interactions.Num();
+			}
+			ArrayResult.Seconds = FPlatformTime::Seconds() - Start;
+		}
+
+		FInteractionHistoryBenchmarkResult RingResult;
+		{
+			FInworldCharacterInteractionHistory History;
+			History.SetMaxEntries(MaxEntries);
+			// Like UOriginInteractionWatcher does, holding interactions back until they are final.
+			TArray<FString> Pending;
+			TSet<FString> Finals;
+			auto OnChange = [&RingResult, &Pending, &Finals](const FInworldCharacterInteraction& Interaction, EInworldCharacterInteractionChange Change)
+			{
+				RingResult.EntriesNotified++;
+				if (Change == EInworldCharacterInteractionChange::Added)
+				{
+					Pending.Add(Interaction.UtteranceId);
+				}
+				else if (Change != EInworldCharacterInteractionChange::Updated)
+				{
+					Pending.Remove(Interaction.UtteranceId);
+				}
+				if (Interaction.bTextFinal && Change != EInworldCharacterInteractionChange::Evicted)
+				{
+					Finals.Add(Interaction.UtteranceId);
+				}
+				int32 NumFinal = 0;
+				while (NumFinal < Pending.Num() && Finals.Remove(Pending[NumFinal]) > 0)
+				{
+					NumFinal++;
+				}
+				RingResult.FinalsSeen += NumFinal;
+				Pending.RemoveAt(0, NumFinal, false);
+			};
+			const double Start = FPlatformTime::Seconds();
+			for (const FMessage& Message : Messages)
+			{
+				if (Message.bInterrupt)
+				{
+					History.CancelUtterance(Message.InteractionId, Message.UtteranceId, OnChange);
+				}
+				else
+				{
+					History.Add(Message.InteractionId, Message.UtteranceId, Message.Text, Message.bPlayer, Message.bFinal, OnChange);
+				}
+			}
+			RingResult.Seconds = FPlatformTime::Seconds() - Start;
+		}
+
+		UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld interaction history benchmark: %d interactions, %d messages, %d entries kept, %d final interactions"),
+			NumInteractions, Messages.Num(), MaxEntries, NumExpectedFinals);
+		for (const auto& Result : { TPair<const TCHAR*, FInteractionHistoryBenchmarkResult>(TEXT("array"), ArrayResult), TPair<const TCHAR*, FInteractionHistoryBenchmarkResult>(TEXT("ring "), RingResult) })
+		{
+			UE_LOG(LogInworldAIIntegration, Log, TEXT("  %s: %.3fms, %.3fus per message, %llu entries notified (%.1f per message), %d final interactions seen by the consumer"),
+				Result.Key, Result.Value.Seconds * 1000.0, Result.Value.Seconds * 1000000.0 / Messages.Num(), Result.Value.EntriesNotified,
+				double(Result.Value.EntriesNotified) / Messages.Num(), Result.Value.FinalsSeen);
+		}
+	}
+}
+
+static FAutoConsoleCommand CmdInteractionHistoryBenchmark(
+	TEXT("Inworld.Debug.InteractionHistoryBenchmark"),
+	TEXT("Run a long synthetic session through the interaction history and its previous array implementation, log time and notified entries. Args: [Interactions=10000] [MaxEntries=500] [UpdatesPerUtterance=8]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunInteractionHistoryBenchmark)
+);
+#endif
@@ -10,8 +10,14 @@
 #include "InworldPlayerComponent.h"
 
 #include "UObject/UObjectIterator.h"
+#include "HAL/IConsoleManager.h"
 //#include "NDK/Utils/Log.h"
 
+static TAutoConsoleVariable<float> CVarMetricsInterval(
+	TEXT("Inworld.Debug.MetricsInterval"), 0.25f,
+	TEXT("Seconds between samples of the Inworld metrics shown by the gameplay debugger, 0 to stop sampling")
+);
+
 FInworldGameplayDebuggerCategory::FInworldGameplayDebuggerCategory()
 {
 	SetDataPackReplication<FRepData>(&DataPack);
@@ -40,6 +46,17 @@ void FInworldGameplayDebuggerCategory::CollectData(APlayerController* OwnerPC, A
 	InworldApi->Client->GetConnectionError(DataPack.SessionError, DataPack.ErrorCode);
 	DataPack.SessionId = InworldApi->Client->GetSessionId();
 
+	const double Now = FPlatformTime::Seconds();
+	const float MetricsInterval = CVarMetricsInterval.GetValueOnGameThread();
+	if (MetricsInterval > 0.f && Now - LastMetricsTime >= MetricsInterval)
+	{
+		MetricsCollector.Collect(OwnerPC->GetWorld());
+		LastMetricsTime = Now;
+	}
+	const FInworldMetrics& Metrics = MetricsCollector.GetMetrics();
+	DataPack.Metrics = Metrics;
+	DataPack.Metrics.TimeToFirstAudio.Empty();
+
 	for (auto* Component : InworldApi->GetCharacterComponents())
 	{
 		auto* Comp = static_cast<UInworldCharacterComponent*>(Component);
@@ -59,6 +76,10 @@ void FInworldGameplayDebuggerCategory::CollectData(APlayerController* OwnerPC, A
 		Data.EmotionalBehavior = static_cast<uint8>(Comp->GetEmotionalBehavior());
 		Data.EmotionStrength = static_cast<uint8>(Comp->GetEmotionStrength());
 		Data.bPendingRepAudioEvent = !Comp->PendingRepAudioEvents.IsEmpty();
+		if (const auto* TimeToFirstAudio = Metrics.TimeToFirstAudio.Find(Data.AgentId))
+		{
+			Data.TimeToFirstAudio = *TimeToFirstAudio;
+		}
 	}
 
 	for (TObjectIterator<UInworldPlayerAudioCaptureComponent> Itr; Itr; ++Itr)
@@ -107,6 +128,23 @@ void FInworldGameplayDebuggerCategory::DrawData(APlayerController* OwnerPC, FGam
 	}
 	CanvasContext.Printf(TEXT("Session Id:   {yellow}%s"), *DataPack.SessionId);
 
+	const FInworldMetrics& Metrics = DataPack.Metrics;
+	CanvasContext.Printf(TEXT("Packets in / out:   {yellow}%.1f/s {white}/ {yellow}%.1f/s"), Metrics.PacketsReceivedPerSecond, Metrics.PacketsSentPerSecond);
+	CanvasContext.Printf(TEXT("Bytes in / out:   {yellow}%.1fKB/s {white}/ {yellow}%.1fKB/s"), Metrics.BytesReceivedPerSecond / 1024.0, Metrics.BytesSentPerSecond / 1024.0);
+	CanvasContext.Printf(TEXT("Write queue:   %s%d"), Metrics.WriteQueueDepth > 10 ? TEXT("{red}") : TEXT("{yellow}"), Metrics.WriteQueueDepth);
+	CanvasContext.Printf(TEXT("Audio capture buffered:   %s%.0fms"), Metrics.AudioCaptureBufferedMs > 300.f ? TEXT("{red}") : TEXT("{yellow}"), Metrics.AudioCaptureBufferedMs);
+	if (Metrics.VoiceFramesReceived > 0)
+	{
+		const double LossPercent = 100.0 * Metrics.VoiceFramesLost / (Metrics.VoiceFramesReceived + Metrics.VoiceFramesLost);
+		CanvasContext.Printf(TEXT("Unreliable voice:   {yellow}%.1f%% {white}lost, {yellow}%.1fms {white}jitter, %llu received, %llu late, %llu recovered"),
+			LossPercent, Metrics.VoiceJitterMs, Metrics.VoiceFramesReceived, Metrics.VoiceFramesLate, Metrics.VoiceFramesRecovered);
+	}
+	if (Metrics.AudioReplConnections > 0)
+	{
+		CanvasContext.Printf(TEXT("Audio replication:   {yellow}%d {white}connections, {yellow}%d {white}bytes queued, {yellow}%llu {white}datagrams dropped"),
+			Metrics.AudioReplConnections, Metrics.AudioReplQueuedBytes, Metrics.AudioReplDroppedDatagrams);
+	}
+
 	int32 PlayerIdx = 0;
 	for (auto& Data : DataPack.PlayerData)
 	{
@@ -175,6 +213,20 @@ void FInworldGameplayDebuggerCategory::DrawData(APlayerController* OwnerPC, FGam
 				*EmotionalBehavior,
 				*EmotionalStrength);
 
+			const FInworldTimeToFirstAudioStats& TimeToFirstAudio = Data.TimeToFirstAudio;
+			if (TimeToFirstAudio.Count > 0)
+			{
+				Text += FString::Printf(TEXT("\n{white}Time To First Audio: {yellow}%.0fms {white}p50, {yellow}%.0fms {white}p95, {yellow}%.0fms {white}max of %llu"),
+					TimeToFirstAudio.P50Ms, TimeToFirstAudio.P95Ms, TimeToFirstAudio.MaxMs, TimeToFirstAudio.Count);
+
+				static const TCHAR* BucketNames[FInworldTimeToFirstAudioStats::NumBuckets] = { TEXT("<250ms"), TEXT("<500ms"), TEXT("<1s"), TEXT("<2s"), TEXT(">2s") };
+				for (int32 i = 0; i < FInworldTimeToFirstAudioStats::NumBuckets; i++)
+				{
+					const int32 BarLength = static_cast<int32>(FMath::DivideAndRoundUp<uint64>(TimeToFirstAudio.Buckets[i] * 20, TimeToFirstAudio.Count));
+					Text += FString::Printf(TEXT("\n{white}%6s {yellow}%s {white}%llu"), BucketNames[i], *FString::ChrN(BarLength, TEXT('|')), TimeToFirstAudio.Buckets[i]);
+				}
+			}
+
 			float SizeX = 0.0f, SizeY = 0.0f;
 			OverheadContext.MeasureString(Text, SizeX, SizeY);
 			OverheadContext.PrintAt(ScreenLoc.X - (SizeX * 0.5f), ScreenLoc.Y - (SizeY * 1.2f), Text);
@@ -213,6 +265,21 @@ void FInworldGameplayDebuggerCategory::FRepData::Serialize(FArchive& Ar)
 	Ar << SessionStatus;
 	Ar << SessionError;
 	Ar << SessionId;
+
+	Ar << Metrics.PacketsReceivedPerSecond;
+	Ar << Metrics.PacketsSentPerSecond;
+	Ar << Metrics.BytesReceivedPerSecond;
+	Ar << Metrics.BytesSentPerSecond;
+	Ar << Metrics.WriteQueueDepth;
+	Ar << Metrics.AudioCaptureBufferedMs;
+	Ar << Metrics.VoiceFramesReceived;
+	Ar << Metrics.VoiceFramesLost;
+	Ar << Metrics.VoiceFramesLate;
+	Ar << Metrics.VoiceFramesRecovered;
+	Ar << Metrics.VoiceJitterMs;
+	Ar << Metrics.AudioReplConnections;
+	Ar << Metrics.AudioReplDroppedDatagrams;
+	Ar << Metrics.AudioReplQueuedBytes;
 }
 
 void FInworldGameplayDebuggerCategory::FCharRepData::Serialize(FArchive& Ar)
@@ -226,6 +293,14 @@ void FInworldGameplayDebuggerCategory::FCharRepData::Serialize(FArchive& Ar)
 	Ar << bPendingRepAudioEvent;
 	Ar << EmotionalBehavior;
 	Ar << EmotionStrength;
+	Ar << TimeToFirstAudio.Count;
+	Ar << TimeToFirstAudio.P50Ms;
+	Ar << TimeToFirstAudio.P95Ms;
+	Ar << TimeToFirstAudio.MaxMs;
+	for (uint64& Bucket : TimeToFirstAudio.Buckets)
+	{
+		Ar << Bucket;
+	}
 }
 
 void FInworldGameplayDebuggerCategory::FPlayerRepData::Serialize(FArchive& Ar)
@@ -0,0 +1,104 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#include "InworldMetricsCollector.h"
+#include "InworldApi.h"
+#include "InworldAudioRepl.h"
+#include "InworldPlayerAudioCaptureComponent.h"
+#include "InworldAIIntegrationModule.h"
+
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "Utils/RateMeter.h"
+THIRD_PARTY_INCLUDES_END
+
+FInworldMetricsCollector::FInworldMetricsCollector()
+	: TransportRates(MakeUnique<Inworld::RateMeter<4>>())
+{}
+
+FInworldMetricsCollector::~FInworldMetricsCollector() = default;
+
+void FInworldMetricsCollector::Collect(UWorld* World)
+{
+	Metrics = FInworldMetrics();
+
+	auto* InworldApi = World ? World->GetSubsystem<UInworldApiSubsystem>() : nullptr;
+	if (!InworldApi || !InworldApi->Client)
+	{
+		TransportRates->Reset();
+		return;
+	}
+
+	const FInworldTransportStats Transport = InworldApi->Client->GetTransportStats();
+	TransportRates->Sample({ Transport.PacketsReceived, Transport.PacketsSent, Transport.BytesReceived, Transport.BytesSent }, std::chrono::steady_clock::now());
+	Metrics.PacketsReceivedPerSecond = TransportRates->GetRate(0);
+	Metrics.PacketsSentPerSecond = TransportRates->GetRate(1);
+	Metrics.BytesReceivedPerSecond = TransportRates->GetRate(2);
+	Metrics.BytesSentPerSecond = TransportRates->GetRate(3);
+	Metrics.WriteQueueDepth = Transport.WriteQueueDepth;
+
+	InworldApi->Client->GetTimeToFirstAudioStats(Metrics.TimeToFirstAudio);
+
+	Inworld::FSocketMultiplexStats ReplStats;
+	if (InworldApi->AudioRepl && InworldApi->AudioRepl->GetServerStats(ReplStats))
+	{
+		Metrics.AudioReplConnections = ReplStats.Connections;
+		Metrics.AudioReplDroppedDatagrams = ReplStats.DroppedDatagrams;
+		Metrics.AudioReplQueuedBytes = ReplStats.QueuedBytes;
+	}
+
+	for (TObjectIterator<UInworldPlayerAudioCaptureComponent> It; It; ++It)
+	{
+		UInworldPlayerAudioCaptureComponent* AudioCapture = *It;
+		if (AudioCapture->GetWorld() != World)
+		{
+			continue;
+		}
+
+		Metrics.AudioCaptureBufferedMs = FMath::Max(Metrics.AudioCaptureBufferedMs, AudioCapture->GetCaptureBufferedMs());
+
+		FInworldVoiceTransportStats VoiceStats;
+		if (AudioCapture->GetVoiceTransportStats(VoiceStats))
+		{
+			Metrics.VoiceFramesReceived += VoiceStats.Received;
+			Metrics.VoiceFramesLost += VoiceStats.Lost;
+			Metrics.VoiceFramesLate += VoiceStats.Late;
+			Metrics.VoiceFramesRecovered += VoiceStats.Recovered;
+			Metrics.VoiceJitterMs = FMath::Max(Metrics.VoiceJitterMs, VoiceStats.JitterMs);
+		}
+	}
+}
+
+void FInworldMetricsCollector::LogMetrics() const
+{
+	UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld metrics: in %.1f packets/s %.1f KB/s, out %.1f packets/s %.1f KB/s, write queue %d"),
+		Metrics.PacketsReceivedPerSecond, Metrics.BytesReceivedPerSecond / 1024.0, Metrics.PacketsSentPerSecond, Metrics.BytesSentPerSecond / 1024.0, Metrics.WriteQueueDepth);
+	UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld metrics: audio capture %.0fms buffered, voice %llu received, %llu lost, %llu late, %llu recovered, jitter %.1fms"),
+		Metrics.AudioCaptureBufferedMs, Metrics.VoiceFramesReceived, Metrics.VoiceFramesLost, Metrics.VoiceFramesLate, Metrics.VoiceFramesRecovered, Metrics.VoiceJitterMs);
+	UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld metrics: audio replication to %d connections, %d bytes queued, %llu datagrams dropped"),
+		Metrics.AudioReplConnections, Metrics.AudioReplQueuedBytes, Metrics.AudioReplDroppedDatagrams);
+	for (const auto& Pair : Metrics.TimeToFirstAudio)
+	{
+		const FInworldTimeToFirstAudioStats& Stats = Pair.Value;
+		UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld metrics: %s time to first audio of %llu replies, p50 %.0fms, p95 %.0fms, max %.0fms, <250ms %llu, <500ms %llu, <1s %llu, <2s %llu, slower %llu"),
+			*Pair.Key, Stats.Count, Stats.P50Ms, Stats.P95Ms, Stats.MaxMs, Stats.Buckets[0], Stats.Buckets[1], Stats.Buckets[2], Stats.Buckets[3], Stats.Buckets[4]);
+	}
+}
+
+namespace
+{
+	// Rates are since the previous call, or over the last couple of seconds when called more often.
+	void DumpMetrics(const TArray<FString>& Args, UWorld* World)
+	{
+		static FInworldMetricsCollector Collector;
+		Collector.Collect(World);
+		Collector.LogMetrics();
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdDumpMetrics(
+	TEXT("Inworld.Debug.DumpMetrics"),
+	TEXT("Log packet flow, audio capture, voice transport and time to first audio metrics of the world's Inworld session. Works headless."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&DumpMetrics)
+);
@@ -0,0 +1,564 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#include "InworldPipelineBenchmark.h"
+#include "InworldApi.h"
+#include "InworldCharacterComponent.h"
+#include "InworldAudioComponent.h"
+#include "InworldAIIntegrationModule.h"
+
+#include "Audio.h"
+#include "AudioDevice.h"
+#include "Containers/Ticker.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "Packets.h"
+#include "world-engine.pb.h"
+#include "Utils/PacketRecording.h"
+#include "Utils/MetricsRegistry.h"
+THIRD_PARTY_INCLUDES_END
+
+#include <algorithm>
+#include <sstream>
+
+void UInworldBenchmarkPlaybackAudio::Tick_Implementation(float DeltaTime)
+{
+	Super::Tick_Implementation(DeltaTime);
+
+	if (!bSimulatingPlayback || !AudioComponent.IsValid())
+	{
+		return;
+	}
+
+	// The events a playing sound's audio component broadcasts.
+	SimulatedPlaybackTime += DeltaTime;
+	if (SimulatedPlaybackTime >= SoundDuration)
+	{
+		bSimulatingPlayback = false;
+		AudioComponent->OnAudioFinishedNative.Broadcast(AudioComponent.Get());
+	}
+	else
+	{
+		AudioComponent->OnAudioPlaybackPercentNative.Broadcast(AudioComponent.Get(), SoundWave, SimulatedPlaybackTime / SoundDuration);
+	}
+}
+
+void UInworldBenchmarkPlaybackAudio::OnCharacterUtterance_Implementation(const FCharacterMessageUtterance& Message)
+{
+	Super::OnCharacterUtterance_Implementation(Message);
+
+	bSimulatingPlayback = false;
+	if (SoundWave == nullptr)
+	{
+		return;
+	}
+
+	OnAudioStarted.Broadcast(Message.InteractionId, Message.VisemeInfos.Num());
+	if (AudioComponent.IsValid() && !AudioComponent->IsPlaying())
+	{
+		bSimulatingPlayback = true;
+		SimulatedPlaybackTime = 0.f;
+	}
+}
+
+void UInworldBenchmarkPlaybackAudio::OnCharacterUtteranceInterrupt_Implementation(const FCharacterMessageUtterance& Message)
+{
+	bSimulatingPlayback = false;
+	Super::OnCharacterUtteranceInterrupt_Implementation(Message);
+}
+
+#if !UE_BUILD_SHIPPING
+
+// Inworld.Debug.PipelineBenchmark [Characters] [InteractionsPerMinute] [Seconds] [Quit]
+// Replays a synthetic session, see Inworld.Debug.ReplayPackets, to characters spawned in the world: every packet goes
+// through the NDK read task, FInworldClient translation, UInworldApiSubsystem::DispatchPacket, the character's message
+// queue and audio playback with visemes. Runs headless, e.g. -game -nullrhi -nosound -ExecCmds="Inworld.Debug.PipelineBenchmark 16 20 60 Quit".
+class FInworldPipelineBenchmark
+{
+public:
+	static void Run(const TArray<FString>& Args, UWorld* World)
+	{
+		if (Instance.IsValid())
+		{
+			UE_LOG(LogInworldAIIntegration, Warning, TEXT("Inworld pipeline benchmark is already running"));
+			return;
+		}
+
+		FSettings Settings;
+		TArray<float> Values;
+		for (const FString& Arg : Args)
+		{
+			if (Arg.Equals(TEXT("Quit"), ESearchCase::IgnoreCase))
+			{
+				Settings.bQuit = true;
+			}
+			else
+			{
+				Values.Add(FCString::Atof(*Arg));
+			}
+		}
+		Settings.NumCharacters = Values.Num() > 0 ? FMath::Max(FMath::RoundToInt(Values[0]), 1) : 16;
+		Settings.InteractionsPerMinute = Values.Num() > 1 ? FMath::Max(Values[1], 0.1f) : 20.f;
+		Settings.Seconds = Values.Num() > 2 ? FMath::Max(Values[2], 1.f) : 60.f;
+
+		auto* Subsystem = World && World->IsGameWorld() && World->HasBegunPlay() ? World->GetSubsystem<UInworldApiSubsystem>() : nullptr;
+		if (!Subsystem)
+		{
+			UE_LOG(LogInworldAIIntegration, Error, TEXT("Inworld pipeline benchmark needs a game world that has begun play"));
+		}
+		else if (Subsystem->GetConnectionState() != EInworldConnectionState::Idle)
+		{
+			UE_LOG(LogInworldAIIntegration, Error, TEXT("Inworld pipeline benchmark needs the world's Inworld session to be stopped"));
+		}
+		else
+		{
+			Instance = MakeUnique<FInworldPipelineBenchmark>(*Subsystem, Settings);
+			if (Instance->Start())
+			{
+				FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&TickInstance));
+				return;
+			}
+			Instance.Reset();
+		}
+
+		if (Settings.bQuit)
+		{
+			RequestEngineExit(TEXT("Inworld pipeline benchmark failed"));
+		}
+	}
+
+	struct FSettings
+	{
+		int32 NumCharacters = 16;
+		// Per character, every interaction is one utterance.
+		float InteractionsPerMinute = 20.f;
+		float Seconds = 60.f;
+		bool bQuit = false;
+	};
+
+	FInworldPipelineBenchmark(UInworldApiSubsystem& InSubsystem, const FSettings& InSettings)
+		: Subsystem(&InSubsystem)
+		, World(InSubsystem.GetWorld())
+		, Settings(InSettings)
+	{}
+
+	~FInworldPipelineBenchmark()
+	{
+		FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	}
+
+private:
+	static constexpr float LeadInSeconds = 1.f;
+	// Time queued utterances get to play out after the last interaction.
+	static constexpr float MaxDrainSeconds = 30.f;
+	static constexpr float UtteranceSeconds = 2.f;
+	static constexpr int32 SampleRate = 16000;
+
+	bool Start()
+	{
+		const FString Dir = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir() / TEXT("Inworld") / TEXT("Benchmarks"));
+		if (!IFileManager::Get().MakeDirectory(*Dir, true))
+		{
+			UE_LOG(LogInworldAIIntegration, Error, TEXT("Inworld pipeline benchmark can't create %s"), *Dir);
+			return false;
+		}
+		RecordingPath = Dir / TEXT("Pipeline.iwpr");
+		ResultPath = Dir / FString::Printf(TEXT("Pipeline-%s.json"), *FDateTime::Now().ToString());
+
+		for (int32 i = 0; i < Settings.NumCharacters; i++)
+		{
+			AgentIds.Add(FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower));
+		}
+		if (!WriteRecording())
+		{
+			return false;
+		}
+
+		IConsoleVariable* ReplayPathVar = IConsoleManager::Get().FindConsoleVariable(TEXT("Inworld.Debug.ReplayPackets"));
+		IConsoleVariable* ReplaySpeedVar = IConsoleManager::Get().FindConsoleVariable(TEXT("Inworld.Debug.ReplaySpeed"));
+		if (!ReplayPathVar || !ReplaySpeedVar)
+		{
+			UE_LOG(LogInworldAIIntegration, Error, TEXT("Inworld pipeline benchmark needs Inworld.Debug.ReplayPackets"));
+			return false;
+		}
+
+		SpawnCharacters();
+
+		UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld pipeline benchmark: %d characters, %.1f interactions per minute each, %.0fs, audio %s"),
+			Settings.NumCharacters, Settings.InteractionsPerMinute, Settings.Seconds, World->GetAudioDeviceRaw() ? TEXT("played") : TEXT("simulated"));
+
+		StartMemory = PeakMemory = FPlatformMemory::GetStats().UsedPhysical;
+		BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddRaw(this, &FInworldPipelineBenchmark::OnBeginFrame);
+		EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FInworldPipelineBenchmark::OnEndFrame);
+
+		// The session reads the cvars as it starts, they are put back right after.
+		const FString PreviousReplayPath = ReplayPathVar->GetString();
+		const float PreviousReplaySpeed = ReplaySpeedVar->GetFloat();
+		ReplayPathVar->Set(*RecordingPath, ECVF_SetByConsole);
+		ReplaySpeedVar->Set(1.f, ECVF_SetByConsole);
+
+		FInworldPlayerProfile PlayerProfile;
+		PlayerProfile.Name = TEXT("Benchmark");
+		FInworldAuth Auth;
+		Auth.ApiKey = TEXT("benchmark");
+		Auth.ApiSecret = TEXT("benchmark");
+		ReplayStartTime = FPlatformTime::Seconds();
+		Subsystem->StartSession_V2(TEXT("workspaces/benchmark/scenes/pipeline"), PlayerProfile, FInworldCapabilitySet(), Auth, FInworldSessionToken(), FInworldEnvironment(), FString(), FInworldSave());
+
+		ReplayPathVar->Set(*PreviousReplayPath, ECVF_SetByConsole);
+		ReplaySpeedVar->Set(PreviousReplaySpeed, ECVF_SetByConsole);
+		return true;
+	}
+
+	static FString GetBrainName(int32 Index)
+	{
+		return FString::Printf(TEXT("workspaces/benchmark/characters/character_%d"), Index);
+	}
+
+	static FString GetInteractionId(int32 Character, int32 Interaction)
+	{
+		return FString::Printf(TEXT("benchmark-%d-%d"), Character, Interaction);
+	}
+
+	enum class EStep : uint8
+	{
+		Text,
+		Audio,
+		InteractionEnd,
+	};
+
+	struct FScheduledPacket
+	{
+		double Time;
+		int32 Character;
+		int32 Interaction;
+		EStep Step;
+	};
+
+	bool WriteRecording()
+	{
+		Inworld::PacketRecorder Recorder;
+		if (!Recorder.Open(TCHAR_TO_UTF8(*RecordingPath)))
+		{
+			UE_LOG(LogInworldAIIntegration, Error, TEXT("Inworld pipeline benchmark can't write %s"), *RecordingPath);
+			return false;
+		}
+		const auto Origin = std::chrono::steady_clock::now();
+		auto At = [Origin](double Seconds)
+		{
+			return Origin + std::chrono::microseconds(static_cast<int64>(Seconds * 1000000.0));
+		};
+
+		ai::inworld::engine::LoadSceneResponse Scene;
+		for (int32 i = 0; i < Settings.NumCharacters; i++)
+		{
+			auto* Agent = Scene.add_agents();
+			Agent->set_agent_id(TCHAR_TO_UTF8(*AgentIds[i]));
+			Agent->set_brain_name(TCHAR_TO_UTF8(*GetBrainName(i)));
+			Agent->set_given_name(TCHAR_TO_UTF8(*FString::Printf(TEXT("Character %d"), i)));
+		}
+		Recorder.Record(Inworld::RecordedPacketKind::Scene, Scene.SerializeAsString(), Origin);
+
+		// Characters answer in turn, spread evenly over the interval. Audio and the end follow the text as the server sends them.
+		const double Interval = 60.0 / Settings.InteractionsPerMinute;
+		TArray<FScheduledPacket> Schedule;
+		for (int32 Character = 0; Character < Settings.NumCharacters; Character++)
+		{
+			for (int32 Interaction = 0; ; Interaction++)
+			{
+				const double Time = LeadInSeconds + Interval * (Interaction + static_cast<double>(Character) / Settings.NumCharacters);
+				if (Time >= Settings.Seconds)
+				{
+					break;
+				}
+				Schedule.Add({ Time, Character, Interaction, EStep::Text });
+				Schedule.Add({ Time + 0.05, Character, Interaction, EStep::Audio });
+				Schedule.Add({ Time + 0.1, Character, Interaction, EStep::InteractionEnd });
+				DueTimeByInteraction.Add(GetInteractionId(Character, Interaction), Time);
+			}
+		}
+		Schedule.StableSort([](const FScheduledPacket& A, const FScheduledPacket& B) { return A.Time < B.Time; });
+		NumInteractions = DueTimeByInteraction.Num();
+
+		TArray<int16> Samples;
+		Samples.SetNumZeroed(static_cast<int32>(UtteranceSeconds * SampleRate));
+		TArray<uint8> Wave;
+		SerializeWaveFile(Wave, reinterpret_cast<const uint8*>(Samples.GetData()), Samples.Num() * sizeof(int16), 1, SampleRate);
+		const std::string WaveData(reinterpret_cast<const char*>(Wave.GetData()), Wave.Num());
+
+		int32 PacketId = 0;
+		for (const FScheduledPacket& Scheduled : Schedule)
+		{
+			Recorder.Record(Inworld::RecordedPacketKind::Incoming, MakePacket(Scheduled, PacketId++, WaveData), At(Scheduled.Time));
+		}
+		return true;
+	}
+
+	std::string MakePacket(const FScheduledPacket& Scheduled, int32 PacketId, const std::string& WaveData) const
+	{
+		static const char* Phonemes[] = { "h", "i", "l", "u", "w", "d", "s", "m", "f", "n", "b", "k", "t", "z", "p", "v" };
+
+		InworldPakets::InworldPacket Packet;
+		Packet.mutable_routing()->mutable_source()->set_type(InworldPakets::Actor_Type_AGENT);
+		Packet.mutable_routing()->mutable_source()->set_name(TCHAR_TO_UTF8(*AgentIds[Scheduled.Character]));
+		Packet.mutable_routing()->mutable_target()->set_type(InworldPakets::Actor_Type_PLAYER);
+		const FString InteractionId = GetInteractionId(Scheduled.Character, Scheduled.Interaction);
+		Packet.mutable_packet_id()->set_packet_id(std::to_string(PacketId));
+		Packet.mutable_packet_id()->set_interaction_id(TCHAR_TO_UTF8(*InteractionId));
+		Packet.mutable_packet_id()->set_utterance_id(TCHAR_TO_UTF8(*(InteractionId + TEXT("-0"))));
+
+		switch (Scheduled.Step)
+		{
+		case EStep::Text:
+			Packet.mutable_text()->set_text("The quick brown fox jumps over the lazy dog, again and again, until the benchmark is over.");
+			Packet.mutable_text()->set_final(true);
+			break;
+		case EStep::Audio:
+		{
+			auto* DataChunk = Packet.mutable_data_chunk();
+			DataChunk->set_type(InworldPakets::DataChunk_DataType_AUDIO);
+			DataChunk->set_chunk(WaveData);
+			// About as many phonemes as speech has.
+			constexpr int32 PhonemesPerSecond = 12;
+			for (int32 i = 0; i < static_cast<int32>(UtteranceSeconds * PhonemesPerSecond); i++)
+			{
+				auto* Info = DataChunk->add_additional_phoneme_info();
+				Info->set_phoneme(Phonemes[i % UE_ARRAY_COUNT(Phonemes)]);
+				const int64 Nanos = static_cast<int64>(i) * 1000000000 / PhonemesPerSecond;
+				Info->mutable_start_offset()->set_seconds(Nanos / 1000000000);
+				Info->mutable_start_offset()->set_nanos(static_cast<int32>(Nanos % 1000000000));
+			}
+			break;
+		}
+		case EStep::InteractionEnd:
+			Packet.mutable_control()->set_action(InworldPakets::ControlEvent_Action_INTERACTION_END);
+			break;
+		}
+		return Packet.SerializeAsString();
+	}
+
+	void SpawnCharacters()
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags = RF_Transient;
+		for (int32 i = 0; i < Settings.NumCharacters; i++)
+		{
+			AActor* Actor = World->SpawnActor<AActor>(SpawnParams);
+			Actors.Add(Actor);
+
+			// The playback finds the audio component as it begins play.
+			auto* AudioComponent = NewObject<UInworldAudioComponent>(Actor, TEXT("InworldAudio"));
+			AudioComponent->bAutoActivate = false;
+			Actor->SetRootComponent(AudioComponent);
+			AudioComponent->RegisterComponent();
+
+			auto* CharacterComponent = NewObject<UInworldCharacterComponent>(Actor, TEXT("InworldCharacter"));
+			CharacterComponent->BrainName = GetBrainName(i);
+			CharacterComponent->PlaybackTypes.Add(UInworldBenchmarkPlaybackAudio::StaticClass());
+			CharacterComponent->RegisterComponent();
+
+			if (auto* Playback = CharacterComponent->GetPlaybackNative<UInworldBenchmarkPlaybackAudio>())
+			{
+				Playback->OnAudioStarted.AddRaw(this, &FInworldPipelineBenchmark::OnAudioStarted);
+			}
+		}
+	}
+
+	void OnAudioStarted(const FString& InteractionId, int32 InNumVisemes)
+	{
+		double DueTime;
+		if (DueTimeByInteraction.RemoveAndCopyValue(InteractionId, DueTime))
+		{
+			TimesToFirstAudioMs.Add((FPlatformTime::Seconds() - ReplayStartTime - DueTime) * 1000.0);
+		}
+		NumUtterances++;
+		NumVisemes += InNumVisemes;
+	}
+
+	void OnBeginFrame()
+	{
+		FrameStartCycles = FPlatformTime::Cycles64();
+	}
+
+	void OnEndFrame()
+	{
+		if (FrameStartCycles != 0)
+		{
+			FrameMs.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - FrameStartCycles));
+		}
+	}
+
+	static bool TickInstance(float DeltaTime)
+	{
+		if (Instance->Tick())
+		{
+			return true;
+		}
+		Instance->Finish();
+		Instance.Reset();
+		return false;
+	}
+
+	bool Tick()
+	{
+		PeakMemory = FMath::Max<uint64>(PeakMemory, FPlatformMemory::GetStats().UsedPhysical);
+
+		if (!Subsystem.IsValid() || !World.IsValid())
+		{
+			UE_LOG(LogInworldAIIntegration, Error, TEXT("Inworld pipeline benchmark: the world went away"));
+			return false;
+		}
+		if (Subsystem->GetConnectionState() == EInworldConnectionState::Failed)
+		{
+			UE_LOG(LogInworldAIIntegration, Error, TEXT("Inworld pipeline benchmark: the replay failed to start"));
+			return false;
+		}
+
+		const double Elapsed = FPlatformTime::Seconds() - ReplayStartTime;
+		return Elapsed < Settings.Seconds || (DueTimeByInteraction.Num() != 0 && Elapsed < Settings.Seconds + MaxDrainSeconds);
+	}
+
+	struct FStats
+	{
+		double Mean = 0.0;
+		double P50 = 0.0;
+		double P95 = 0.0;
+		double P99 = 0.0;
+		double Max = 0.0;
+
+		explicit FStats(TArray<double> Values)
+		{
+			if (Values.Num() == 0)
+			{
+				return;
+			}
+			Values.Sort();
+			double Sum = 0.0;
+			for (const double Value : Values)
+			{
+				Sum += Value;
+			}
+			auto Percentile = [&Values](double P)
+			{
+				return Values[FMath::Clamp(FMath::CeilToInt(P * Values.Num()) - 1, 0, Values.Num() - 1)];
+			};
+			Mean = Sum / Values.Num();
+			P50 = Percentile(0.5);
+			P95 = Percentile(0.95);
+			P99 = Percentile(0.99);
+			Max = Values.Last();
+		}
+
+		FString ToJson() const
+		{
+			return FString::Printf(TEXT("{\"mean\":%.3f,\"p50\":%.3f,\"p95\":%.3f,\"p99\":%.3f,\"max\":%.3f}"), Mean, P50, P95, P99, Max);
+		}
+	};
+
+	void Finish()
+	{
+		FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+		const uint64 EndMemory = FPlatformMemory::GetStats().UsedPhysical;
+		const bool bAudioDevice = World.IsValid() && World->GetAudioDeviceRaw() != nullptr;
+
+		if (Subsystem.IsValid())
+		{
+			Subsystem->StopSession();
+		}
+		for (const auto& Actor : Actors)
+		{
+			if (Actor.IsValid())
+			{
+				Actor->Destroy();
+			}
+		}
+
+		const FStats FrameStats(FrameMs);
+		const FStats AudioStats(TimesToFirstAudioMs);
+		const double ToMB = 1.0 / (1024.0 * 1024.0);
+
+		// NDK and engine integration metrics, cumulative for the process.
+		std::ostringstream Metrics;
+		Inworld::MetricsRegistry::WriteJson(Inworld::GetMetricsRegistry().Snapshot(), Metrics);
+		FString MetricsJson = UTF8_TO_TCHAR(Metrics.str().c_str());
+		MetricsJson.TrimEndInline();
+
+		FString Json = TEXT("{");
+		Json += FString::Printf(TEXT("\"characters\":%d,\"interactions_per_minute\":%.3f,\"seconds\":%.3f,\"utterance_seconds\":%.3f,\"audio_device\":%s,"),
+			Settings.NumCharacters, Settings.InteractionsPerMinute, Settings.Seconds, UtteranceSeconds, bAudioDevice ? TEXT("true") : TEXT("false"));
+		Json += FString::Printf(TEXT("\"frames\":%d,\"game_thread_ms\":%s,"), FrameMs.Num(), *FrameStats.ToJson());
+		Json += FString::Printf(TEXT("\"memory_mb\":{\"start\":%.3f,\"end\":%.3f,\"peak\":%.3f,\"growth\":%.3f},"),
+			StartMemory * ToMB, EndMemory * ToMB, PeakMemory * ToMB, (static_cast<double>(EndMemory) - static_cast<double>(StartMemory)) * ToMB);
+		Json += FString::Printf(TEXT("\"interactions\":%d,\"interactions_played\":%d,\"utterances_played\":%d,\"visemes\":%d,"),
+			NumInteractions, TimesToFirstAudioMs.Num(), NumUtterances, NumVisemes);
+		Json += FString::Printf(TEXT("\"time_to_first_audio_ms\":%s,"), *AudioStats.ToJson());
+		Json += FString::Printf(TEXT("\"metrics\":%s}\n"), *MetricsJson);
+
+		const bool bSaved = FFileHelper::SaveStringToFile(Json, *ResultPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+
+		UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld pipeline benchmark: %d frames, game thread mean %.2fms, p95 %.2fms, max %.2fms"),
+			FrameMs.Num(), FrameStats.Mean, FrameStats.P95, FrameStats.Max);
+		UE_LOG(LogInworldAIIntegration, Log, TEXT("  time to first audio p50 %.1fms, p95 %.1fms, max %.1fms, %d of %d interactions played"),
+			AudioStats.P50, AudioStats.P95, AudioStats.Max, TimesToFirstAudioMs.Num(), NumInteractions);
+		UE_LOG(LogInworldAIIntegration, Log, TEXT("  memory %+.1fMB, peak %+.1fMB"),
+			(static_cast<double>(EndMemory) - static_cast<double>(StartMemory)) * ToMB, (static_cast<double>(PeakMemory) - static_cast<double>(StartMemory)) * ToMB);
+		if (bSaved)
+		{
+			UE_LOG(LogInworldAIIntegration, Log, TEXT("  results written to %s"), *ResultPath);
+		}
+		else
+		{
+			UE_LOG(LogInworldAIIntegration, Error, TEXT("Inworld pipeline benchmark can't write %s"), *ResultPath);
+		}
+
+		if (Settings.bQuit)
+		{
+			RequestEngineExit(TEXT("Inworld pipeline benchmark finished"));
+		}
+	}
+
+	static TUniquePtr<FInworldPipelineBenchmark> Instance;
+
+	TWeakObjectPtr<UInworldApiSubsystem> Subsystem;
+	TWeakObjectPtr<UWorld> World;
+	const FSettings Settings;
+
+	FString RecordingPath;
+	FString ResultPath;
+	TArray<FString> AgentIds;
+	TArray<TWeakObjectPtr<AActor>> Actors;
+
+	double ReplayStartTime = 0.0;
+	// Interactions yet to play, by when they were due since the replay started.
+	TMap<FString, double> DueTimeByInteraction;
+	int32 NumInteractions = 0;
+	int32 NumUtterances = 0;
+	int32 NumVisemes = 0;
+	TArray<double> TimesToFirstAudioMs;
+
+	FDelegateHandle BeginFrameHandle;
+	FDelegateHandle EndFrameHandle;
+	uint64 FrameStartCycles = 0;
+	TArray<double> FrameMs;
+
+	uint64 StartMemory = 0;
+	uint64 PeakMemory = 0;
+};
+
+TUniquePtr<FInworldPipelineBenchmark> FInworldPipelineBenchmark::Instance;
+
+static FAutoConsoleCommandWithWorldAndArgs CmdPipelineBenchmark(
+	TEXT("Inworld.Debug.PipelineBenchmark"),
+	TEXT("Replay a synthetic session to characters spawned in the world, from packet ingest to audio playback, and write game thread time, memory growth and time to first audio to Saved/Inworld/Benchmarks. Args: [Characters=16] [InteractionsPerMinute=20] [Seconds=60] [Quit]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&FInworldPipelineBenchmark::Run)
+);
+
+#endif
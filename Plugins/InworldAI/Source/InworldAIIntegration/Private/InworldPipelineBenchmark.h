@@ -0,0 +1,30 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InworldCharacterPlaybackAudio.h"
+
+#include "InworldPipelineBenchmark.generated.h"
+
+// Audio playback of Inworld.Debug.PipelineBenchmark characters. Reports when each utterance's audio starts,
+// and plays it out on the game thread when there is no audio device, as in a -nosound run, so visemes are
+// still blended and the message queue still waits for the audio to finish.
+UCLASS(NotBlueprintable, Transient)
+class UInworldBenchmarkPlaybackAudio : public UInworldCharacterPlaybackAudio
+{
+	GENERATED_BODY()
+
+public:
+	DECLARE_MULTICAST_DELEGATE_TwoParams(FOnBenchmarkAudioStarted, const FString& /*InteractionId*/, int32 /*NumVisemes*/);
+	FOnBenchmarkAudioStarted OnAudioStarted;
+
+	virtual void Tick_Implementation(float DeltaTime) override;
+
+	virtual void OnCharacterUtterance_Implementation(const FCharacterMessageUtterance& Message) override;
+	virtual void OnCharacterUtteranceInterrupt_Implementation(const FCharacterMessageUtterance& Message) override;
+
+private:
+	bool bSimulatingPlayback = false;
+	float SimulatedPlaybackTime = 0.f;
+};
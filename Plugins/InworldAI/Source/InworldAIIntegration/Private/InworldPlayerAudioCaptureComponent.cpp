@@ -9,6 +9,8 @@
 #include "AudioMixerSubmix.h"
 #include "InworldApi.h"
 #include "InworldAIPlatformModule.h"
+#include "InworldAIIntegrationModule.h"
+#include "TimerManager.h"
 
 #include "Runtime/Launch/Resources/Version.h"
 
@@ -27,7 +29,38 @@
 #include <Net/UnrealNetwork.h>
 #include <GameFramework/PlayerController.h>
 
+THIRD_PARTY_INCLUDES_START
+#include "Utils/VoiceActivityDetector.h"
+#include "Utils/VoiceJitterBuffer.h"
+THIRD_PARTY_INCLUDES_END
+
 constexpr uint32 gSamplesPerSec = 16000;
+constexpr int32 gChunksPerSec = 10;
+
+// Runs on the locally controlled player, before the chunks are replicated.
+struct FInworldVoiceActivityGate
+{
+    FInworldVoiceActivityGate(const Inworld::VoiceActivityDetector::Settings& Settings, int32 PreRollChunks)
+        : Detector(Settings)
+        , Gate(PreRollChunks)
+    {}
+
+    Inworld::VoiceActivityDetector Detector;
+    Inworld::VoiceActivityGate<FPlayerVoiceCaptureInfoRep> Gate;
+};
+
+// Sequencing and parity on the owning client, reordering on the server.
+struct FInworldVoiceTransport
+{
+    FInworldVoiceTransport(const Inworld::VoiceJitterBuffer::Settings& Settings)
+        : Encoder(Settings.FecGroupSize)
+        , JitterBuffer(Settings)
+    {}
+
+    uint32 NextSequence = 0;
+    Inworld::VoiceFecEncoder Encoder;
+    Inworld::VoiceJitterBuffer JitterBuffer;
+};
 
 struct FInworldMicrophoneAudioCapture : public FInworldAudioCapture
 {
@@ -108,10 +141,25 @@ void UInworldPlayerAudioCaptureComponent::BeginPlay()
 
     SetIsReplicated(true);
 
+    if (bUnreliableVoice)
+    {
+        Inworld::VoiceJitterBuffer::Settings Settings;
+        Settings.MaxWait = std::chrono::milliseconds(FMath::Max(VoiceJitterBufferMs, 0));
+        Settings.FecGroupSize = FMath::Clamp(VoiceFecGroupSize, 0, 32);
+        Settings.FrameInterval = std::chrono::milliseconds(1000 / gChunksPerSec);
+        VoiceTransport = MakeShared<FInworldVoiceTransport>(Settings);
+    }
+
     if (GetOwnerRole() == ROLE_Authority)
     {
         InworldSubsystem = GetWorld()->GetSubsystem<UInworldApiSubsystem>();
 
+        // Missing chunks are skipped once they waited long enough, even if nothing else arrives.
+        if (VoiceTransport.IsValid())
+        {
+            GetWorld()->GetTimerManager().SetTimer(VoiceTransportTimerHandle, FTimerDelegate::CreateUObject(this, &UInworldPlayerAudioCaptureComponent::ReleaseVoiceCaptureFrames, false), 0.02f, true);
+        }
+
         PlayerComponent = Cast<UInworldPlayerComponent>(GetOwner()->GetComponentByClass(UInworldPlayerComponent::StaticClass()));
         if (ensureMsgf(PlayerComponent.IsValid(), TEXT("UInworldPlayerAudioCaptureComponent::BeginPlay: add InworldPlayerComponent.")))
         {
@@ -156,6 +204,14 @@ void UInworldPlayerAudioCaptureComponent::BeginPlay()
             OutputAudioCapture = MakeShared<FInworldSubmixAudioCapture>(this, OnOutputCapture);
         }
 
+        if (bEnableVAD)
+        {
+            Inworld::VoiceActivityDetector::Settings Settings;
+            Settings.HangoverMs = FMath::Max(VADHangoverMs, 0);
+            const int32 PreRollChunks = FMath::DivideAndRoundUp(FMath::Max(VADPreRollMs, 0), 1000 / gChunksPerSec);
+            VoiceActivityGate = MakeShared<FInworldVoiceActivityGate>(Settings, PreRollChunks);
+        }
+
         InputAudioCapture->RequestCapturePermission();
         if (OutputAudioCapture.IsValid())
         {
@@ -178,9 +234,40 @@ void UInworldPlayerAudioCaptureComponent::EndPlay(const EEndPlayReason::Type End
         StopCapture();
     }
 
+    if (VoiceTransportTimerHandle.IsValid())
+    {
+        GetWorld()->GetTimerManager().ClearTimer(VoiceTransportTimerHandle);
+
+        const auto& Stats = VoiceTransport->JitterBuffer.GetStats();
+        UE_LOG(LogInworldAIIntegration, Log, TEXT("Unreliable voice of %s: received %llu, released %llu, recovered %llu, lost %llu, late %llu, duplicates %llu"),
+            *GetOwner()->GetName(), Stats.Received, Stats.Released, Stats.Recovered, Stats.Lost, Stats.Late, Stats.Duplicates);
+    }
+
     Super::EndPlay(EndPlayReason);
 }
 
+float UInworldPlayerAudioCaptureComponent::GetCaptureBufferedMs()
+{
+    FScopeLock InputScopedLock(&InputBuffer.CriticalSection);
+    return InputBuffer.Data.Num() / 2 * 1000.f / gSamplesPerSec;
+}
+
+bool UInworldPlayerAudioCaptureComponent::GetVoiceTransportStats(FInworldVoiceTransportStats& OutStats) const
+{
+    if (!VoiceTransport.IsValid())
+    {
+        return false;
+    }
+
+    const auto& Stats = VoiceTransport->JitterBuffer.GetStats();
+    OutStats.Received = Stats.Received;
+    OutStats.Lost = Stats.Lost;
+    OutStats.Late = Stats.Late;
+    OutStats.Recovered = Stats.Recovered;
+    OutStats.JitterMs = Stats.JitterMs;
+    return true;
+}
+
 void UInworldPlayerAudioCaptureComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
     Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
@@ -222,7 +309,7 @@ void UInworldPlayerAudioCaptureComponent::TickComponent(float DeltaTime, enum EL
         FScopeLock InputScopedLock(&InputBuffer.CriticalSection);
         FScopeLock OutputScopedLock(&OutputBuffer.CriticalSection);
 
-        constexpr int32 SampleSendSize = (gSamplesPerSec / 10) * 2; // 0.1s of data per send, mult by 2 from Buffer (uint8) to PCM (uint16)
+        constexpr int32 SampleSendSize = (gSamplesPerSec / gChunksPerSec) * 2; // 0.1s of data per send, mult by 2 from Buffer (uint8) to PCM (uint16)
         while (InputBuffer.Data.Num() > SampleSendSize && (!bEnableAEC || OutputBuffer.Data.Num() > SampleSendSize))
         {
             FPlayerVoiceCaptureInfoRep VoiceCaptureInfoRep;
@@ -251,7 +338,24 @@ void UInworldPlayerAudioCaptureComponent::TickComponent(float DeltaTime, enum EL
                 OutputBuffer.Data.SetNum(OutputBuffer.Data.Num() - SampleSendSize);
             }
 
-            Server_ProcessVoiceCaptureChunk(VoiceCaptureInfoRep);
+            if (!VoiceActivityGate.IsValid())
+            {
+                SendVoiceCaptureChunk(MoveTemp(VoiceCaptureInfoRep));
+                continue;
+            }
+
+            // Muted chunks are silence, they don't need to go through the detector.
+            const bool bActive = !bMuted && VoiceActivityGate->Detector.Process(reinterpret_cast<const int16*>(VoiceCaptureInfoRep.MicSoundData.GetData()), VoiceCaptureInfoRep.MicSoundData.Num() / 2);
+            VoiceActivityGate->Gate.Push(MoveTemp(VoiceCaptureInfoRep), bActive, [this](FPlayerVoiceCaptureInfoRep&& Chunk)
+                {
+                    SendVoiceCaptureChunk(MoveTemp(Chunk));
+                });
+
+            const auto& GateStats = VoiceActivityGate->Gate.GetStats();
+            VoiceActivityStats.CapturedChunks = GateStats.Chunks;
+            VoiceActivityStats.SentChunks = GateStats.SentChunks;
+            VoiceActivityStats.SuppressedChunks = GateStats.SuppressedChunks;
+            VoiceActivityStats.SuppressedBytes = GateStats.SuppressedChunks * SampleSendSize * (bEnableAEC ? 2 : 1);
         }
     }
 }
@@ -353,7 +457,80 @@ void UInworldPlayerAudioCaptureComponent::StopCapture()
     OutputBuffer.Data.Empty();
 }
 
+void UInworldPlayerAudioCaptureComponent::SendVoiceCaptureChunk(FPlayerVoiceCaptureInfoRep&& VoiceCaptureInfoRep)
+{
+    if (!VoiceTransport.IsValid())
+    {
+        Server_ProcessVoiceCaptureChunk(VoiceCaptureInfoRep);
+        return;
+    }
+
+    TArray<uint8> Frame = MoveTemp(VoiceCaptureInfoRep.MicSoundData);
+    Frame.Append(VoiceCaptureInfoRep.OutputSoundData);
+
+    const uint32 Sequence = VoiceTransport->NextSequence++;
+    Inworld::VoiceFrameData Parity;
+    const bool bParity = VoiceTransport->Encoder.Add(Sequence, Inworld::VoiceFrameData(Frame.GetData(), Frame.GetData() + Frame.Num()), Parity);
+
+    Server_ProcessVoiceCaptureFrame(Sequence, Frame);
+    if (bParity)
+    {
+        Server_ProcessVoiceCaptureParity(Sequence / VoiceTransport->Encoder.GetGroupSize(), TArray<uint8>(Parity.data(), Parity.size()));
+    }
+}
+
+void UInworldPlayerAudioCaptureComponent::Server_ProcessVoiceCaptureFrame_Implementation(uint32 Sequence, const TArray<uint8>& Frame)
+{
+    if (VoiceTransport.IsValid())
+    {
+        VoiceTransport->JitterBuffer.PushFrame(Sequence, Inworld::VoiceFrameData(Frame.GetData(), Frame.GetData() + Frame.Num()), std::chrono::steady_clock::now());
+        ReleaseVoiceCaptureFrames(false);
+    }
+}
+
+void UInworldPlayerAudioCaptureComponent::Server_ProcessVoiceCaptureParity_Implementation(uint32 Group, const TArray<uint8>& Parity)
+{
+    if (VoiceTransport.IsValid())
+    {
+        VoiceTransport->JitterBuffer.PushParity(Group, Inworld::VoiceFrameData(Parity.GetData(), Parity.GetData() + Parity.Num()), std::chrono::steady_clock::now());
+        ReleaseVoiceCaptureFrames(false);
+    }
+}
+
+void UInworldPlayerAudioCaptureComponent::ReleaseVoiceCaptureFrames(bool bFlush)
+{
+    if (!VoiceTransport.IsValid())
+    {
+        return;
+    }
+
+    auto ProcessFrame = [this](uint32 Sequence, Inworld::VoiceFrameData&& Frame)
+    {
+        // Microphone and playback chunks are the same size.
+        const int32 FrameSize = static_cast<int32>(Frame.size());
+        const int32 MicSize = bEnableAEC ? FrameSize / 2 : FrameSize;
+        FPlayerVoiceCaptureInfoRep PlayerVoiceCaptureInfo;
+        PlayerVoiceCaptureInfo.MicSoundData.Append(Frame.data(), MicSize);
+        PlayerVoiceCaptureInfo.OutputSoundData.Append(Frame.data() + MicSize, FrameSize - MicSize);
+        ProcessVoiceCaptureChunk(PlayerVoiceCaptureInfo);
+    };
+
+    if (bFlush)
+    {
+        VoiceTransport->JitterBuffer.Flush(ProcessFrame);
+    }
+    else
+    {
+        VoiceTransport->JitterBuffer.Release(std::chrono::steady_clock::now(), ProcessFrame);
+    }
+}
+
 void UInworldPlayerAudioCaptureComponent::Server_ProcessVoiceCaptureChunk_Implementation(FPlayerVoiceCaptureInfoRep PlayerVoiceCaptureInfo)
+{
+    ProcessVoiceCaptureChunk(PlayerVoiceCaptureInfo);
+}
+
+void UInworldPlayerAudioCaptureComponent::ProcessVoiceCaptureChunk(const FPlayerVoiceCaptureInfoRep& PlayerVoiceCaptureInfo)
 {
 	if (bEnableAEC)
 	{
@@ -387,6 +564,8 @@ void UInworldPlayerAudioCaptureComponent::OnPlayerTargetSet(UInworldCharacterCom
 
 void UInworldPlayerAudioCaptureComponent::OnPlayerTargetClear(UInworldCharacterComponent* Target)
 {
+    ReleaseVoiceCaptureFrames(true);
+
     if (Target)
     {
         InworldSubsystem->StopAudioSession(Target->GetAgentId());
@@ -403,6 +582,12 @@ void UInworldPlayerAudioCaptureComponent::Rep_ServerCapturingVoice()
 {
     if (bServerCapturingVoice)
 	{
+        // Chunks held from the previous audio session must not leak into the new one.
+        if (VoiceActivityGate.IsValid() && !bCapturingVoice)
+        {
+            VoiceActivityGate->Detector.Reset();
+            VoiceActivityGate->Gate.Reset();
+        }
         StartCapture();
     }
     else
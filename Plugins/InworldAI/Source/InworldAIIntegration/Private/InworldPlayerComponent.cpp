@@ -40,6 +40,11 @@ Inworld::ICharacterComponent* UInworldPlayerComponent::GetTargetCharacter()
 
 void UInworldPlayerComponent::SetTargetInworldCharacter(UInworldCharacterComponent* Character)
 {
+    if (Character && Character->GetAgentId().IsEmpty() && InworldSubsystem.IsValid())
+    {
+        InworldSubsystem->PossessCharacterComponent(Character->GetBrainName());
+    }
+
     if (!ensureMsgf(Character && !Character->GetAgentId().IsEmpty(), TEXT("UInworldPlayerComponent::SetTargetCharacter: the Character must have valid AgentId")))
     {
         return;
@@ -130,6 +135,15 @@ void UInworldPlayerComponent::SendAudioDataMessageWithAECToTarget(const TArray<u
     }
 }
 
+void UInworldPlayerComponent::ClientSetAudioReplToken_Implementation(uint64 Token)
+{
+    // May arrive before BeginPlay.
+    if (auto* Subsystem = GetWorld() ? GetWorld()->GetSubsystem<UInworldApiSubsystem>() : nullptr)
+    {
+        Subsystem->SetAudioReplToken(Token);
+    }
+}
+
 void UInworldPlayerComponent::OnRep_TargetCharacterAgentId(FString OldAgentId)
 {
     if (!ensure(InworldSubsystem.IsValid()))
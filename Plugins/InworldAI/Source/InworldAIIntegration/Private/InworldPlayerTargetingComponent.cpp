@@ -43,7 +43,8 @@ void UInworldPlayerTargetingComponent::UpdateTargetCharacter()
     const FVector Location = GetOwner()->GetActorLocation();
     for (auto& Character : CharacterComponents)
     {
-        if (!Character || Character->GetAgentId().IsEmpty())
+        // Unpossessed characters of the scene are possessed when targeted.
+        if (!Character || (Character->GetAgentId().IsEmpty() && !InworldSubsystem->CanPossessCharacterComponent(Character->GetBrainName())))
         {
             continue;
         }
@@ -3,12 +3,132 @@
 #include "InworldSockets.h"
 
 #include "IPAddress.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
 #include "Common/UdpSocketBuilder.h"
-#include "Common/UdpSocketReceiver.h"
 #include "Common/UdpSocketSender.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Async/Async.h"
+#include "Algo/AllOf.h"
 
 #include "InworldAIIntegrationModule.h"
 
+#include <random>
+
+namespace
+{
+	constexpr int32 MaxDatagramSize = 64 * 1024;
+	// Datagrams received in one go before they are handed over, keeps the consumer fed under a flood.
+	constexpr int32 MaxBatchDatagrams = 1024;
+
+	// Multiplexed datagrams start with the magic and their type, hellos and acks carry the connection id after it,
+	// hellos then the connection's token.
+	constexpr uint32 MultiplexMagic = 0x41574E49;
+	constexpr int32 MultiplexHeaderSize = sizeof(uint32) + sizeof(uint8);
+	constexpr int32 MultiplexHandshakeSize = MultiplexHeaderSize + sizeof(uint32);
+	constexpr int32 MultiplexHelloSize = MultiplexHandshakeSize + sizeof(uint64);
+	enum class EMultiplexType : uint8
+	{
+		Hello = 1,
+		Ack = 2,
+		Data = 3,
+	};
+
+	// Clients say hello this often until acknowledged, then as a keep alive.
+	constexpr double HelloInterval = 0.5;
+	constexpr double KeepAliveInterval = 5.0;
+	// Hellos handled per tick, so a flood can't stall the game thread.
+	constexpr int32 MaxHellosPerTick = 256;
+	// Pacing lets a connection send this much of a second's budget in one go.
+	constexpr double PacingBurstSeconds = 0.05;
+
+	void WriteUint32(uint8* Into, uint32 Value)
+	{
+		Into[0] = static_cast<uint8>(Value);
+		Into[1] = static_cast<uint8>(Value >> 8);
+		Into[2] = static_cast<uint8>(Value >> 16);
+		Into[3] = static_cast<uint8>(Value >> 24);
+	}
+
+	uint32 ReadUint32(const uint8* From)
+	{
+		return From[0] | (From[1] << 8) | (From[2] << 16) | (static_cast<uint32>(From[3]) << 24);
+	}
+
+	void WriteMultiplexHeader(uint8* Into, EMultiplexType Type)
+	{
+		WriteUint32(Into, MultiplexMagic);
+		Into[sizeof(uint32)] = static_cast<uint8>(Type);
+	}
+
+	bool ReadMultiplexHeader(TArrayView<const uint8> Datagram, EMultiplexType& OutType)
+	{
+		if (Datagram.Num() < MultiplexHeaderSize || ReadUint32(Datagram.GetData()) != MultiplexMagic)
+		{
+			return false;
+		}
+		OutType = static_cast<EMultiplexType>(Datagram[sizeof(uint32)]);
+		return true;
+	}
+
+	bool ReadHandshake(TArrayView<const uint8> Datagram, EMultiplexType Type, uint32& OutConnectionId)
+	{
+		EMultiplexType DatagramType;
+		if (Datagram.Num() != MultiplexHandshakeSize || !ReadMultiplexHeader(Datagram, DatagramType) || DatagramType != Type)
+		{
+			return false;
+		}
+		OutConnectionId = ReadUint32(Datagram.GetData() + MultiplexHeaderSize);
+		return true;
+	}
+
+	TArray<uint8, TFixedAllocator<MultiplexHandshakeSize>> MakeHandshake(EMultiplexType Type, uint32 ConnectionId)
+	{
+		TArray<uint8, TFixedAllocator<MultiplexHandshakeSize>> Datagram;
+		Datagram.SetNumUninitialized(MultiplexHandshakeSize);
+		WriteMultiplexHeader(Datagram.GetData(), Type);
+		WriteUint32(Datagram.GetData() + MultiplexHeaderSize, ConnectionId);
+		return Datagram;
+	}
+
+	bool ReadHello(TArrayView<const uint8> Datagram, uint32& OutConnectionId, uint64& OutToken)
+	{
+		EMultiplexType DatagramType;
+		if (Datagram.Num() != MultiplexHelloSize || !ReadMultiplexHeader(Datagram, DatagramType) || DatagramType != EMultiplexType::Hello)
+		{
+			return false;
+		}
+		OutConnectionId = ReadUint32(Datagram.GetData() + MultiplexHeaderSize);
+		OutToken = ReadUint32(Datagram.GetData() + MultiplexHandshakeSize) | (static_cast<uint64>(ReadUint32(Datagram.GetData() + MultiplexHandshakeSize + sizeof(uint32))) << 32);
+		return true;
+	}
+
+	TArray<uint8, TFixedAllocator<MultiplexHelloSize>> MakeHello(uint32 ConnectionId, uint64 Token)
+	{
+		TArray<uint8, TFixedAllocator<MultiplexHelloSize>> Datagram;
+		Datagram.SetNumUninitialized(MultiplexHelloSize);
+		WriteMultiplexHeader(Datagram.GetData(), EMultiplexType::Hello);
+		WriteUint32(Datagram.GetData() + MultiplexHeaderSize, ConnectionId);
+		WriteUint32(Datagram.GetData() + MultiplexHandshakeSize, static_cast<uint32>(Token));
+		WriteUint32(Datagram.GetData() + MultiplexHandshakeSize + sizeof(uint32), static_cast<uint32>(Token >> 32));
+		return Datagram;
+	}
+
+	// Tokens must not be guessable, random_device draws from the OS entropy source on the platforms we ship.
+	uint64 MakeToken()
+	{
+		std::random_device Random;
+		uint64 Token = 0;
+		while (Token == 0)
+		{
+			Token = (static_cast<uint64>(Random()) << 32) | Random();
+		}
+		return Token;
+	}
+}
+
 
 bool Inworld::FSocketSend::Initialize(const FSocketSettings& Settings)
 {
@@ -63,6 +183,11 @@ bool Inworld::FSocketSend::ProcessData(TArray<uint8>& Data)
 	return Data.Num() == BytesSent;
 }
 
+Inworld::FSocketReceive::~FSocketReceive()
+{
+	Deinitialize();
+}
+
 bool Inworld::FSocketReceive::Initialize(const FSocketSettings& Settings)
 {
 	FIPv4Address Addr;
@@ -83,28 +208,18 @@ bool Inworld::FSocketReceive::Initialize(const FSocketSettings& Settings)
 		return false;
 	}
 
-	Receiver = new FUdpSocketReceiver(Socket, FTimespan::FromMilliseconds(100), *Settings.Name);
-
-	Receiver->OnDataReceived().BindLambda([this](const FArrayReaderPtr& DataPtr, const FIPv4Endpoint& Endpoint)
-		{
-			TArray<uint8> NewData;
-			NewData.AddUninitialized(DataPtr->TotalSize());
-			DataPtr->Serialize(NewData.GetData(), DataPtr->TotalSize());
-			DataQueue.Enqueue(NewData);
-		});
-
-	Receiver->Start();
+	bStopping = false;
+	Thread.Reset(FRunnableThread::Create(this, *Settings.Name, 0, TPri_AboveNormal));
 
 	return true;
 }
 
 bool Inworld::FSocketReceive::Deinitialize()
 {
-	if (Receiver)
+	if (Thread.IsValid())
 	{
-		Receiver->Stop();
-		delete Receiver;
-		Receiver = nullptr;
+		Thread->Kill(true);
+		Thread.Reset();
 	}
 
 	if (!Socket)
@@ -121,5 +236,686 @@ bool Inworld::FSocketReceive::Deinitialize()
 
 bool Inworld::FSocketReceive::ProcessData(TArray<uint8>& Data)
 {
-	return DataQueue.Dequeue(Data);
+	if (ReadIndex >= ReadBatch.Num())
+	{
+		ReadIndex = 0;
+		if (!DrainAll(ReadBatch))
+		{
+			return false;
+		}
+	}
+
+	const TArrayView<const uint8> Datagram = ReadBatch[ReadIndex++];
+	Data.Reset();
+	Data.Append(Datagram.GetData(), Datagram.Num());
+	return true;
+}
+
+bool Inworld::FSocketReceive::DrainAll(FDatagramBatch& OutBatch)
+{
+	OutBatch.Reset();
+
+	FScopeLock Lock(&PendingLock);
+	if (PendingBatch.IsEmpty())
+	{
+		return false;
+	}
+
+	Swap(OutBatch, PendingBatch);
+	return true;
+}
+
+bool Inworld::FSocketReceive::SendTo(TArrayView<const uint8> Data, const FInternetAddr& Addr)
+{
+	int32 BytesSent = 0;
+	return Socket && Socket->SendTo(Data.GetData(), Data.Num(), BytesSent, Addr) && BytesSent == Data.Num();
+}
+
+int32 Inworld::FSocketReceive::GetPortNo() const
+{
+	return Socket ? Socket->GetPortNo() : 0;
+}
+
+Inworld::FSocketReceiveStats Inworld::FSocketReceive::GetStats() const
+{
+	FScopeLock Lock(&PendingLock);
+	return Stats;
+}
+
+uint32 Inworld::FSocketReceive::Run()
+{
+	const FTimespan WaitTime = FTimespan::FromMilliseconds(100);
+	while (!bStopping)
+	{
+		if (!Socket->Wait(ESocketWaitConditions::WaitForRead, WaitTime))
+		{
+			continue;
+		}
+
+		// Datagrams are read straight into the tail of the batch buffer.
+		int32 BytesRead = 0;
+		do
+		{
+			const int32 Offset = ReceiveBatch.Data.Num();
+			const int32 DataCapacity = ReceiveBatch.Data.Max();
+			const int32 EndsCapacity = ReceiveBatch.Ends.Max();
+			ReceiveBatch.Data.SetNumUninitialized(Offset + MaxDatagramSize, false);
+
+			BytesRead = 0;
+			const bool bRead = Socket->Recv(ReceiveBatch.Data.GetData() + Offset, MaxDatagramSize, BytesRead);
+			ReceiveBatch.Data.SetNumUninitialized(Offset + (bRead ? BytesRead : 0), false);
+			if (bRead && BytesRead > 0)
+			{
+				ReceiveBatch.Ends.Add(Offset + BytesRead);
+			}
+
+			if (ReceiveBatch.Data.Max() != DataCapacity || ReceiveBatch.Ends.Max() != EndsCapacity)
+			{
+				FScopeLock Lock(&PendingLock);
+				Stats.Allocations++;
+			}
+		} while (BytesRead > 0 && ReceiveBatch.Num() < MaxBatchDatagrams);
+
+		Publish();
+	}
+	return 0;
+}
+
+void Inworld::FSocketReceive::Stop()
+{
+	bStopping = true;
+}
+
+void Inworld::FSocketReceive::Publish()
+{
+	if (ReceiveBatch.IsEmpty())
+	{
+		return;
+	}
+
+	FScopeLock Lock(&PendingLock);
+	Stats.Datagrams += ReceiveBatch.Num();
+	Stats.Bytes += ReceiveBatch.Data.Num();
+	Stats.Batches++;
+
+	// Usually the consumer took the previous batch, then the buffers are swapped and nothing is copied.
+	if (PendingBatch.IsEmpty())
+	{
+		Swap(PendingBatch, ReceiveBatch);
+		ReceiveBatch.Reset();
+		return;
+	}
+
+	const int32 Offset = PendingBatch.Data.Num();
+	PendingBatch.Data.Append(ReceiveBatch.Data);
+	for (const int32 End : ReceiveBatch.Ends)
+	{
+		PendingBatch.Ends.Add(Offset + End);
+	}
+	ReceiveBatch.Reset();
+}
+
+Inworld::FSocketMultiplexServer::~FSocketMultiplexServer()
+{
+	Deinitialize();
+}
+
+bool Inworld::FSocketMultiplexServer::Initialize(const FSocketMultiplexSettings& InSettings)
+{
+	Settings = InSettings;
+
+	// Not reusable, a second server on the same port should fail here rather than steal half the datagrams.
+	Socket = FUdpSocketBuilder(*Settings.Name)
+		.AsNonBlocking()
+		.BoundToPort(Settings.Port)
+		.WithReceiveBufferSize(Settings.BufferSize)
+		.WithSendBufferSize(Settings.BufferSize)
+		.Build();
+
+	if (!Socket)
+	{
+		UE_LOG(LogInworldAIIntegration, Error, TEXT("FSocketMultiplexServer::Initialize couldn't bind port %d"), Settings.Port);
+		return false;
+	}
+
+	ReceiveBuffer.SetNumUninitialized(MaxDatagramSize);
+	return true;
+}
+
+void Inworld::FSocketMultiplexServer::Deinitialize()
+{
+	Connections.Empty();
+	Tokens.Empty();
+
+	if (!Socket)
+	{
+		return;
+	}
+
+	Socket->Close();
+	ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+	Socket = nullptr;
+}
+
+uint64 Inworld::FSocketMultiplexServer::Authorize(uint32 ConnectionId)
+{
+	if (const uint64* Token = Tokens.Find(ConnectionId))
+	{
+		return *Token;
+	}
+	return Tokens.Add(ConnectionId, MakeToken());
+}
+
+void Inworld::FSocketMultiplexServer::Revoke(uint32 ConnectionId)
+{
+	Tokens.Remove(ConnectionId);
+	if (const FConnection* Connection = Connections.Find(ConnectionId))
+	{
+		Stats.DroppedDatagrams += Connection->Queue.Num() - Connection->QueueHead;
+		Connections.Remove(ConnectionId);
+	}
+}
+
+bool Inworld::FSocketMultiplexServer::Send(uint32 ConnectionId, TArrayView<const uint8> Data)
+{
+	FConnection* Connection = Connections.Find(ConnectionId);
+	if (!Socket || !Connection)
+	{
+		Stats.DroppedDatagrams++;
+		return false;
+	}
+
+	TArray<uint8>& Datagram = Connection->Queue.AddDefaulted_GetRef();
+	Datagram.SetNumUninitialized(MultiplexHeaderSize + Data.Num());
+	WriteMultiplexHeader(Datagram.GetData(), EMultiplexType::Data);
+	FMemory::Memcpy(Datagram.GetData() + MultiplexHeaderSize, Data.GetData(), Data.Num());
+	Connection->QueuedBytes += Datagram.Num();
+
+	// The oldest audio is the least useful once the connection falls this far behind.
+	while (Connection->QueuedBytes > static_cast<int32>(Settings.MaxQueuedBytes) && Connection->Queue.Num() - Connection->QueueHead > 1)
+	{
+		PopFront(*Connection);
+		Stats.DroppedDatagrams++;
+	}
+
+	Flush(*Connection, FPlatformTime::Seconds());
+	return true;
+}
+
+void Inworld::FSocketMultiplexServer::Tick()
+{
+	if (!Socket)
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	ReceiveHellos(Now);
+
+	for (auto It = Connections.CreateIterator(); It; ++It)
+	{
+		if (Now - It.Value().LastHello > Settings.ConnectionTimeout)
+		{
+			Stats.DroppedDatagrams += It.Value().Queue.Num() - It.Value().QueueHead;
+			It.RemoveCurrent();
+			continue;
+		}
+		Flush(It.Value(), Now);
+	}
+}
+
+int32 Inworld::FSocketMultiplexServer::GetPortNo() const
+{
+	return Socket ? Socket->GetPortNo() : 0;
+}
+
+Inworld::FSocketMultiplexStats Inworld::FSocketMultiplexServer::GetStats() const
+{
+	FSocketMultiplexStats Result = Stats;
+	Result.Connections = Connections.Num();
+	Result.QueuedBytes = 0;
+	for (const auto& Connection : Connections)
+	{
+		Result.QueuedBytes += Connection.Value.QueuedBytes;
+	}
+	return Result;
+}
+
+void Inworld::FSocketMultiplexServer::ReceiveHellos(double Now)
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	TSharedRef<FInternetAddr> FromAddr = SocketSubsystem->CreateInternetAddr();
+
+	for (int32 i = 0; i < MaxHellosPerTick; i++)
+	{
+		int32 BytesRead = 0;
+		if (!Socket->RecvFrom(ReceiveBuffer.GetData(), ReceiveBuffer.Num(), BytesRead, *FromAddr) || BytesRead <= 0)
+		{
+			return;
+		}
+
+		uint32 ConnectionId;
+		uint64 Token;
+		if (!ReadHello(TArrayView<const uint8>(ReceiveBuffer.GetData(), BytesRead), ConnectionId, Token))
+		{
+			continue;
+		}
+
+		// Player ids are replicated to everyone, only the token proves the hello comes from the player.
+		const uint64* ExpectedToken = Tokens.Find(ConnectionId);
+		if (!ExpectedToken || *ExpectedToken != Token)
+		{
+			Stats.RejectedHellos++;
+			continue;
+		}
+
+		FConnection* Connection = Connections.Find(ConnectionId);
+		if (!Connection)
+		{
+			Connection = &Connections.Add(ConnectionId);
+			Connection->Tokens = Settings.PacingBytesPerSecond * PacingBurstSeconds;
+			Connection->LastRefill = Now;
+		}
+		// The address may change, e.g. when a NAT mapping expired, the latest hello with the token wins.
+		if (!Connection->Addr.IsValid() || !Connection->Addr->CompareEndpoints(*FromAddr))
+		{
+			Connection->Addr = FromAddr->Clone();
+		}
+		Connection->LastHello = Now;
+
+		const auto Ack = MakeHandshake(EMultiplexType::Ack, ConnectionId);
+		int32 BytesSent;
+		Socket->SendTo(Ack.GetData(), Ack.Num(), BytesSent, *Connection->Addr);
+	}
 }
+
+void Inworld::FSocketMultiplexServer::Flush(FConnection& Connection, double Now)
+{
+	const double Burst = Settings.PacingBytesPerSecond * PacingBurstSeconds;
+	Connection.Tokens = FMath::Min(Burst, Connection.Tokens + (Now - Connection.LastRefill) * Settings.PacingBytesPerSecond);
+	Connection.LastRefill = Now;
+
+	// A datagram goes out while there is any budget left, larger ones put the budget in debt.
+	while (Connection.QueueHead < Connection.Queue.Num() && Connection.Tokens > 0.0)
+	{
+		const TArray<uint8>& Datagram = Connection.Queue[Connection.QueueHead];
+		int32 BytesSent = 0;
+		if (!Socket->SendTo(Datagram.GetData(), Datagram.Num(), BytesSent, *Connection.Addr))
+		{
+			// The send buffer is full, try again next tick.
+			return;
+		}
+
+		Connection.Tokens -= Datagram.Num();
+		Stats.SentDatagrams++;
+		Stats.SentBytes += Datagram.Num();
+		PopFront(Connection);
+	}
+}
+
+void Inworld::FSocketMultiplexServer::PopFront(FConnection& Connection)
+{
+	Connection.QueuedBytes -= Connection.Queue[Connection.QueueHead].Num();
+	Connection.QueueHead++;
+	if (Connection.QueueHead == Connection.Queue.Num())
+	{
+		Connection.Queue.Reset();
+		Connection.QueueHead = 0;
+	}
+	else if (Connection.QueueHead >= 64 && Connection.QueueHead * 2 >= Connection.Queue.Num())
+	{
+		Connection.Queue.RemoveAt(0, Connection.QueueHead, false);
+		Connection.QueueHead = 0;
+	}
+}
+
+bool Inworld::FSocketMultiplexClient::Initialize(const FString& Name, const FInternetAddr& InServerAddr, uint32 InConnectionId, uint64 InToken, uint32 BufferSize)
+{
+	FSocketSettings Settings;
+	Settings.IpAddr = TEXT("0.0.0.0");
+	Settings.Port = 0;
+	Settings.BufferSize = BufferSize;
+	Settings.Name = Name;
+	if (!Socket.Initialize(Settings))
+	{
+		return false;
+	}
+
+	ServerAddr = InServerAddr.Clone();
+	ConnectionId = InConnectionId;
+	Token = InToken;
+	bAcknowledged = false;
+	LastHello = 0.0;
+	return true;
+}
+
+void Inworld::FSocketMultiplexClient::Deinitialize()
+{
+	Socket.Deinitialize();
+	ServerAddr.Reset();
+	bAcknowledged = false;
+}
+
+void Inworld::FSocketMultiplexClient::Receive(TArray<TArrayView<const uint8>>& OutPayloads)
+{
+	OutPayloads.Reset();
+	if (!ServerAddr.IsValid())
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	if (LastHello == 0.0 || Now - LastHello >= (bAcknowledged ? KeepAliveInterval : HelloInterval))
+	{
+		const auto Hello = MakeHello(ConnectionId, Token);
+		Socket.SendTo(Hello, *ServerAddr);
+		LastHello = Now;
+	}
+
+	if (!Socket.DrainAll(Batch))
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < Batch.Num(); i++)
+	{
+		const TArrayView<const uint8> Datagram = Batch[i];
+		EMultiplexType Type;
+		if (!ReadMultiplexHeader(Datagram, Type))
+		{
+			continue;
+		}
+
+		uint32 AckedId;
+		if (Type == EMultiplexType::Data)
+		{
+			OutPayloads.Add(Datagram.Slice(MultiplexHeaderSize, Datagram.Num() - MultiplexHeaderSize));
+		}
+		else if (ReadHandshake(Datagram, EMultiplexType::Ack, AckedId) && AckedId == ConnectionId)
+		{
+			bAcknowledged = true;
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+	// Inworld.Net.SocketBenchmark [Seconds] [DatagramsPerSecond] [DatagramSize]
+	void RunSocketBenchmark(const TArray<FString>& Args)
+	{
+		const int32 Seconds = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 5;
+		const int32 Rate = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 10000;
+		const int32 Size = Args.Num() > 2 ? FMath::Clamp(FCString::Atoi(*Args[2]), 1, 1400) : 512;
+
+		Async(EAsyncExecution::Thread, [Seconds, Rate, Size]()
+		{
+			Inworld::FSocketSettings Settings;
+			Settings.IpAddr = TEXT("127.0.0.1");
+			Settings.Port = 0;
+			Settings.BufferSize = 2 * 1024 * 1024;
+			Settings.Name = TEXT("Inworld Benchmark Receive");
+
+			Inworld::FSocketReceive Receive;
+			if (!Receive.Initialize(Settings))
+			{
+				return;
+			}
+
+			Settings.Port = Receive.GetPortNo();
+			Settings.Name = TEXT("Inworld Benchmark Send");
+			Inworld::FSocketSend Send;
+			if (!Send.Initialize(Settings))
+			{
+				Receive.Deinitialize();
+				return;
+			}
+
+			TArray<uint8> Datagram;
+			Datagram.SetNumZeroed(Size);
+			Inworld::FDatagramBatch Batch;
+			uint64 Sent = 0;
+			uint64 Received = 0;
+			uint64 Drains = 0;
+
+			// The consumer drains once a millisecond, like a game thread running at a high frame rate would per frame.
+			FPlatformTime::GetCPUTime();
+			const double Start = FPlatformTime::Seconds();
+			double Now = Start;
+			while (Now - Start < Seconds)
+			{
+				const uint64 Due = static_cast<uint64>((Now - Start) * Rate);
+				for (; Sent < Due; Sent++)
+				{
+					Send.ProcessData(Datagram);
+				}
+				if (Receive.DrainAll(Batch))
+				{
+					Received += Batch.Num();
+					Drains++;
+				}
+				FPlatformProcess::Sleep(0.001f);
+				Now = FPlatformTime::Seconds();
+			}
+			FPlatformProcess::Sleep(0.1f);
+			if (Receive.DrainAll(Batch))
+			{
+				Received += Batch.Num();
+				Drains++;
+			}
+			const FCPUTime CPUTime = FPlatformTime::GetCPUTime();
+			const Inworld::FSocketReceiveStats Stats = Receive.GetStats();
+
+			Send.Deinitialize();
+			Receive.Deinitialize();
+
+			const double Elapsed = Now - Start;
+			UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld socket benchmark: %llu datagrams of %d bytes sent, %llu received in %.1fs (%.0f/s), %llu drains, %.1f datagrams per receiver batch"),
+				Sent, Size, Received, Elapsed, Received / Elapsed, Drains, Stats.Batches > 0 ? double(Stats.Datagrams) / Stats.Batches : 0.0);
+			UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld socket benchmark: %llu buffer allocations (%.2f/s), process CPU %.1f%%"),
+				Stats.Allocations, Stats.Allocations / Elapsed, CPUTime.CPUTimePct);
+		});
+	}
+}
+
+static FAutoConsoleCommand CmdSocketBenchmark(
+	TEXT("Inworld.Net.SocketBenchmark"),
+	TEXT("Push datagrams through a loopback FSocketReceive and log throughput, CPU and allocations. Args: [Seconds=5] [DatagramsPerSecond=10000] [DatagramSize=512]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunSocketBenchmark)
+);
+#endif
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+	// Inworld.Net.MultiplexLoopbackTest [Clients] [DatagramsPerClient] [DatagramSize]
+	void RunMultiplexLoopbackTest(const TArray<FString>& Args)
+	{
+		const int32 NumClients = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 64;
+		const int32 NumDatagrams = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 100;
+		const int32 Size = Args.Num() > 2 ? FMath::Clamp(FCString::Atoi(*Args[2]), 8, 1400) : 1024;
+
+		Async(EAsyncExecution::Thread, [NumClients, NumDatagrams, Size]()
+		{
+			Inworld::FSocketMultiplexSettings Settings;
+			Settings.Name = TEXT("Inworld Multiplex Test Server");
+			Settings.Port = 0;
+			Settings.BufferSize = 4 * 1024 * 1024;
+			Settings.PacingBytesPerSecond = 1024 * 1024;
+			Settings.MaxQueuedBytes = NumDatagrams * (Size + 64);
+
+			Inworld::FSocketMultiplexServer Server;
+			if (!Server.Initialize(Settings))
+			{
+				return;
+			}
+
+			TSharedRef<FInternetAddr> ServerAddr = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+			ServerAddr->SetLoopbackAddress();
+			ServerAddr->SetPort(Server.GetPortNo());
+
+			struct FClient
+			{
+				Inworld::FSocketMultiplexClient Socket;
+				int32 Received = 0;
+				int32 Misrouted = 0;
+				int32 Reordered = 0;
+				int32 Corrupted = 0;
+			};
+			TArray<TUniquePtr<FClient>> Clients;
+			for (int32 i = 0; i < NumClients; i++)
+			{
+				TUniquePtr<FClient>& Client = Clients.Add_GetRef(MakeUnique<FClient>());
+				const uint32 ConnectionId = 1000 + i;
+				if (!Client->Socket.Initialize(FString::Printf(TEXT("Inworld Multiplex Test Client %d"), i), *ServerAddr, ConnectionId, Server.Authorize(ConnectionId), 256 * 1024))
+				{
+					Clients.Pop();
+				}
+			}
+
+			// Knows the first client's id but not its token, it must not take the stream over.
+			Inworld::FSocketMultiplexClient Spoofer;
+			int32 Hijacked = 0;
+			if (Clients.Num() > 0)
+			{
+				Spoofer.Initialize(TEXT("Inworld Multiplex Test Spoofer"), *ServerAddr, Clients[0]->Socket.GetConnectionId(), Clients[0]->Socket.GetToken() + 1, 64 * 1024);
+			}
+
+			TArray<TArrayView<const uint8>> Payloads;
+			auto ReceiveAll = [&Clients, &Payloads, &Spoofer, &Hijacked]()
+			{
+				Spoofer.Receive(Payloads);
+				Hijacked += Payloads.Num();
+
+				for (TUniquePtr<FClient>& Client : Clients)
+				{
+					Client->Socket.Receive(Payloads);
+					for (const TArrayView<const uint8>& Payload : Payloads)
+					{
+						if (Payload.Num() < 8)
+						{
+							Client->Corrupted++;
+							continue;
+						}
+						if (ReadUint32(Payload.GetData()) != Client->Socket.GetConnectionId())
+						{
+							Client->Misrouted++;
+							continue;
+						}
+						Client->Reordered += ReadUint32(Payload.GetData() + 4) != static_cast<uint32>(Client->Received) ? 1 : 0;
+						Client->Received++;
+					}
+				}
+			};
+
+			const double Start = FPlatformTime::Seconds();
+			bool bConnected = false;
+			while (!bConnected && FPlatformTime::Seconds() - Start < 5.0)
+			{
+				Server.Tick();
+				ReceiveAll();
+				bConnected = Server.GetStats().Connections == Clients.Num()
+					&& Algo::AllOf(Clients, [](const TUniquePtr<FClient>& Client) { return Client->Socket.IsAcknowledged(); });
+				FPlatformProcess::Sleep(0.001f);
+			}
+			const double HandshakeTime = FPlatformTime::Seconds() - Start;
+
+			TArray<uint8> Datagram;
+			Datagram.SetNumZeroed(Size);
+			const double SendStart = FPlatformTime::Seconds();
+
+			// The first datagram after startup is the start of the first utterance, none of it may be dropped.
+			for (const TUniquePtr<FClient>& Client : Clients)
+			{
+				WriteUint32(Datagram.GetData(), Client->Socket.GetConnectionId());
+				WriteUint32(Datagram.GetData() + 4, 0);
+				Server.Send(Client->Socket.GetConnectionId(), Datagram);
+			}
+			const uint64 FirstDropped = Server.GetStats().DroppedDatagrams;
+			auto AllReceivedFirst = [&Clients]()
+			{
+				return Algo::AllOf(Clients, [](const TUniquePtr<FClient>& Client) { return Client->Received > 0; });
+			};
+			while (!AllReceivedFirst() && FPlatformTime::Seconds() - SendStart < 5.0)
+			{
+				Server.Tick();
+				ReceiveAll();
+				FPlatformProcess::Sleep(0.001f);
+			}
+			const bool bFirstDelivered = FirstDropped == 0 && AllReceivedFirst();
+
+			// A datagram per client every millisecond, well over the pacing rate, so the send queues fill up.
+			for (int32 Sequence = 1; Sequence < NumDatagrams; Sequence++)
+			{
+				for (const TUniquePtr<FClient>& Client : Clients)
+				{
+					WriteUint32(Datagram.GetData(), Client->Socket.GetConnectionId());
+					WriteUint32(Datagram.GetData() + 4, Sequence);
+					Server.Send(Client->Socket.GetConnectionId(), Datagram);
+				}
+				Server.Tick();
+				ReceiveAll();
+				FPlatformProcess::Sleep(0.001f);
+			}
+
+			const int32 Expected = Clients.Num() * NumDatagrams;
+			auto TotalReceived = [&Clients]()
+			{
+				int32 Total = 0;
+				for (const TUniquePtr<FClient>& Client : Clients)
+				{
+					Total += Client->Received;
+				}
+				return Total;
+			};
+			while (TotalReceived() < Expected && FPlatformTime::Seconds() - SendStart < 10.0)
+			{
+				Server.Tick();
+				ReceiveAll();
+				FPlatformProcess::Sleep(0.001f);
+			}
+			const double SendTime = FPlatformTime::Seconds() - SendStart;
+			const Inworld::FSocketMultiplexStats Stats = Server.GetStats();
+
+			int32 MinReceived = MAX_int32, MaxReceived = 0, Misrouted = 0, Reordered = 0, Corrupted = 0;
+			for (TUniquePtr<FClient>& Client : Clients)
+			{
+				MinReceived = FMath::Min(MinReceived, Client->Received);
+				MaxReceived = FMath::Max(MaxReceived, Client->Received);
+				Misrouted += Client->Misrouted;
+				Reordered += Client->Reordered;
+				Corrupted += Client->Corrupted;
+				Client->Socket.Deinitialize();
+			}
+			const bool bSpooferAcknowledged = Spoofer.IsAcknowledged();
+			Spoofer.Deinitialize();
+			Server.Deinitialize();
+
+			const bool bPassed = bConnected && Clients.Num() == NumClients && TotalReceived() == Expected && Misrouted == 0 && Corrupted == 0
+				&& Hijacked == 0 && !bSpooferAcknowledged && bFirstDelivered;
+			UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld multiplex loopback test: %d clients on one server socket, handshake %.0fms, %d/%d datagrams of %d bytes in %.2fs, per client %d-%d"),
+				Clients.Num(), HandshakeTime * 1000.0, TotalReceived(), Expected, Size, SendTime, MinReceived, MaxReceived);
+			UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld multiplex loopback test: %d misrouted, %d reordered, %d corrupted, %llu dropped by the server, %.0f KB/s per connection paced"),
+				Misrouted, Reordered, Corrupted, Stats.DroppedDatagrams, SendTime > 0.0 ? double(Stats.SentBytes) / Clients.Num() / SendTime / 1024.0 : 0.0);
+			UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld multiplex loopback test: first datagram after startup %s"),
+				bFirstDelivered ? TEXT("delivered to every client") : TEXT("dropped"));
+			UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld multiplex loopback test: spoofed hellos %s, %d datagrams hijacked, %llu hellos rejected"),
+				bSpooferAcknowledged ? TEXT("acknowledged") : TEXT("ignored"), Hijacked, Stats.RejectedHellos);
+			if (bPassed)
+			{
+				UE_LOG(LogInworldAIIntegration, Log, TEXT("Inworld multiplex loopback test: PASSED"));
+			}
+			else
+			{
+				UE_LOG(LogInworldAIIntegration, Error, TEXT("Inworld multiplex loopback test: FAILED"));
+			}
+		});
+	}
+}
+
+static FAutoConsoleCommand CmdMultiplexLoopbackTest(
+	TEXT("Inworld.Net.MultiplexLoopbackTest"),
+	TEXT("Run simulated client connections against one multiplexed server socket on loopback and check every datagram reaches its own client. Args: [Clients=64] [DatagramsPerClient=100] [DatagramSize=1024]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunMultiplexLoopbackTest)
+);
+#endif
@@ -19,6 +19,7 @@ namespace Inworld
 {
 	class ICharacterComponent;
 	class IPlayerComponent;
+	class ReconnectBackoff;
 }
 class USoundWave;
 class UInworldAudioRepl;
@@ -106,6 +107,16 @@ public:
 
 	void UpdateCharacterComponentRegistrationOnClient(Inworld::ICharacterComponent* Component, const FString& NewAgentId, const FString& OldAgentId);
 
+    /**
+     * Possess the registered character component of the brain with its agent, if it isn't yet
+     * with bPossessAgentsOnDemand components are possessed the first time they are targeted, sent to or heard from
+     * @return true if the component is possessed
+     */
+    bool PossessCharacterComponent(const FString& BrainName);
+
+    /** True if the scene has an agent for the brain, so its component can be targeted before it is possessed */
+    bool CanPossessCharacterComponent(const FString& BrainName) const { return bCharactersInitialized && AgentInfoByBrain.Contains(BrainName); }
+
 public:
     /** Send text to agent */
 	UFUNCTION(BlueprintCallable, Category = "Messages")
@@ -181,6 +192,9 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Multiplayer")
     void StartAudioReplication();
 
+    /** On clients, from the server over the player's game connection */
+    void SetAudioReplToken(uint64 Token);
+
     /** Subsystem interface */
     virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
@@ -201,6 +215,14 @@ public:
 private:
 	void DispatchPacket(TSharedPtr<FInworldPacket> InworldPacket);
 
+	Inworld::ICharacterComponent* GetCharacterComponentByHandle(int32 Handle) const
+	{
+		return CharacterComponentByHandle.IsValidIndex(Handle) ? CharacterComponentByHandle[Handle] : nullptr;
+	}
+	void SetCharacterComponentByAgentId(const FString& AgentId, Inworld::ICharacterComponent* Component);
+	void BindCharacterComponent(Inworld::ICharacterComponent* Component, const FInworldAgentInfo& AgentInfo);
+	Inworld::ICharacterComponent* FindOrPossessCharacterComponentByHandle(int32 Handle);
+
     virtual void Visit(const FInworldChangeSceneEvent& Event) override;
 
     UPROPERTY(EditAnywhere, config, Category = "Connection")
@@ -218,7 +240,20 @@ private:
     UPROPERTY(EditAnywhere, config, Category = "Connection")
     float MaxRetryConnectionTime = 5.0f;
 
-    float CurrentRetryConnectionTime = 1.0f;
+    /** Part of each retry delay taken off at random, so clients dropped together don't retry together, 0 to 1 */
+    UPROPERTY(EditAnywhere, config, Category = "Connection")
+    float RetryConnectionJitter = 0.5f;
+
+    /**
+     * Scenes may have many more characters than a session talks to, their components are possessed when first needed rather than on scene load
+     * until then their AgentId and GivenName are empty and OnPossessed hasn't fired, so code looking characters up by AgentId should possess them first
+     */
+    UPROPERTY(EditAnywhere, config, Category = "Characters")
+    bool bPossessAgentsOnDemand = false;
+
+    /** First retry is immediate, then from RetryConnectionIntervalTime doubling up to MaxRetryConnectionTime */
+    TSharedPtr<Inworld::ReconnectBackoff> ReconnectBackoff;
+    double DisconnectedTime = 0.0;
 
     UPROPERTY()
     UInworldAudioRepl* AudioRepl;
@@ -226,13 +261,20 @@ private:
     FTimerHandle RetryConnectionTimerHandle;
 
     TMap<FString, Inworld::ICharacterComponent*> CharacterComponentByBrainName;
-    TMap<FString, Inworld::ICharacterComponent*> CharacterComponentByAgentId;
+    // Indexed by the agent handles of the client, see FInworldAgentHandles.
+    TArray<Inworld::ICharacterComponent*> CharacterComponentByHandle;
     TArray<Inworld::ICharacterComponent*> CharacterComponentRegistry;
     TMap<FString, FInworldAgentInfo> AgentInfoByBrain;
+    // Indexed by agent handle, to possess components on demand.
+    TArray<FString> BrainNameByHandle;
 
     TSharedPtr<FInworldClient> Client;
 
 	bool bCharactersInitialized = false;
 
 	friend class FInworldGameplayDebuggerCategory;
+	friend class FInworldMetricsCollector;
+#if !UE_BUILD_SHIPPING
+	friend class FInworldSceneLoadBenchmark;
+#endif
 };
@@ -9,7 +9,7 @@
 #include "InworldAudioRepl.generated.h"
 
 struct FInworldAudioDataEvent;
-namespace Inworld { class FSocketBase; }
+class UInworldPlayerComponent;
 
 UCLASS()
 class INWORLDAIINTEGRATION_API UInworldAudioRepl : public UObject, public FTickableGameObject
@@ -25,10 +25,33 @@ public:
 	
 	void ReplicateAudioEvent(FInworldAudioDataEvent& Event);
 
-private:
-	void ListenAudioSocket();
+	// False until the server socket is open.
+	bool GetServerStats(Inworld::FSocketMultiplexStats& OutStats) const;
 
-	Inworld::FSocketBase& GetAudioSocket(const FInternetAddr& IpAddr);
+	// On clients, the token the server authorized this player's audio connection with.
+	void SetClientToken(uint64 Token) { ClientToken = Token; }
 
-	TMap<FString, TUniquePtr<Inworld::FSocketBase>> AudioSockets;
+private:
+	void ListenAudioSocket();
+	// Sends every player connection its token over the game connection, forgets the ones that left.
+	void AuthorizeConnections();
+
+	// One socket for every connection, on the game port plus Inworld.AudioRepl.PortOffset.
+	Inworld::FSocketMultiplexServer* GetServerSocket();
+	// Connected to the server's audio socket as the local player.
+	Inworld::FSocketMultiplexClient* GetClientSocket(const FInternetAddr& ServerAddr, uint32 ConnectionId, uint64 Token);
+
+	TUniquePtr<Inworld::FSocketMultiplexServer> ServerSocket;
+	TUniquePtr<Inworld::FSocketMultiplexClient> ClientSocket;
+	// Not retried every event if the port is taken.
+	bool bServerSocketFailed = false;
+
+	// Server, by connection id, the player component the connection's token was sent through.
+	TMap<uint32, TWeakObjectPtr<UInworldPlayerComponent>> TokenSentTo;
+	double NextAuthorizeTime = 0.0;
+	// Client, 0 until the server sent it.
+	uint64 ClientToken = 0;
+
+	// Reused across ticks.
+	TArray<TArrayView<const uint8>> ReceivedPayloads;
 };
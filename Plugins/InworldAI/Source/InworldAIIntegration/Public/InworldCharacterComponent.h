@@ -32,6 +32,14 @@ public:
 	UInworldCharacterComponent();
 
 	virtual void InitializeComponent() override;
+	virtual void OnRegister() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnInworldCharacterBrainNameSet, UInworldCharacterComponent*);
+	/** Outside of PIE, when a component is registered or its brain name is set, edited or undone */
+	static FOnInworldCharacterBrainNameSet OnBrainNameSetInEditor;
+#endif
 
 	DECLARE_MULTICAST_DELEGATE(FOnInworldCharacterPossessed);
 	FOnInworldCharacterPossessed OnPossessed;
@@ -185,6 +193,10 @@ protected:
 
 private:
 
+	// Agents are possessed when first needed, see UInworldApiSubsystem::bPossessAgentsOnDemand.
+	// The subsystem does the possessing, it sets the component's agent id.
+	bool EnsurePossessed() const;
+
 	virtual void Visit(const FInworldTextEvent& Event) override;
 	virtual void Visit(const FInworldAudioDataEvent& Event) override;
 	virtual void Visit(const FInworldSilenceEvent& Event) override;
@@ -248,4 +260,5 @@ private:
 	FString GivenName;
 
 	friend class FInworldGameplayDebuggerCategory;
+	friend class FInworldPipelineBenchmark;
 };
@@ -42,41 +42,71 @@ struct FInworldCharacterInteraction
 // END ORIGINS MODIFY
 };
 
+UENUM(BlueprintType)
+enum class EInworldCharacterInteractionChange : uint8
+{
+	Added,
+	Updated,
+	// Canceled by an interrupt.
+	Removed,
+	// Pushed out by a newer one when the history is full.
+	Evicted,
+};
+
+// Last MaxEntries interactions, oldest first. Entries live in a fixed size ring indexed by utterance id,
+// so adding, updating and evicting don't move the others.
 USTRUCT(BlueprintType)
 struct FInworldCharacterInteractionHistory
 {
 	GENERATED_BODY();
 
-	void Add(const FCharacterMessagePlayerTalk& Message) { Add(Message.InteractionId, Message.UtteranceId, Message.Text, true
+	// Called for every entry a change touches, evicted entries before the one that replaces them.
+	using FOnChange = TFunctionRef<void(const FInworldCharacterInteraction& Interaction, EInworldCharacterInteractionChange Change)>;
+
+	void Add(const FCharacterMessagePlayerTalk& Message, FOnChange OnChange = [](const auto&, auto) {}) { Add(Message.InteractionId, Message.UtteranceId, Message.Text, true
 		// ORIGINS MODIFY
 		, Message.bTextFinal
 		// END ORIGINS MODIFY
-		);
+		, OnChange);
 	}
-	void Add(const FCharacterMessageUtterance& Message) { Add(Message.InteractionId, Message.UtteranceId, Message.Text, false
+	void Add(const FCharacterMessageUtterance& Message, FOnChange OnChange = [](const auto&, auto) {}) { Add(Message.InteractionId, Message.UtteranceId, Message.Text, false
 		// ORIGINS MODIFY
 		, Message.bTextFinal
 		// END ORIGINS MODIFY
-		);
+		, OnChange);
 	}
 	void Add(const FString& InInteractionId, const FString& InUtteranceId, const FString& InText, bool bInPlayerInteraction
 		// ORIGINS MODIFY
 		, bool bInTextFinal
 		// END ORIGINS MODIFY
+		, FOnChange OnChange = [](const auto&, auto) {}
 	);
 	void Clear();
 
 	void SetMaxEntries(uint32 Val);
 
-	TArray<FInworldCharacterInteraction>& GetInteractions() { return Interactions; }
+	int32 Num() const { return Count; }
+	const FInworldCharacterInteraction* Find(const FString& UtteranceId) const;
+
+	// Oldest first. Copied out of the ring when it changed since the last call, prefer the change callbacks.
+	const TArray<FInworldCharacterInteraction>& GetInteractions() const;
 
-	void CancelUtterance(const FString& InteractionId, const FString& UtteranceId);
+	void CancelUtterance(const FString& InteractionId, const FString& UtteranceId, FOnChange OnChange = [](const auto&, auto) {});
 	bool IsInteractionCanceled(const FString& InteractionId) const;
 	void ClearCanceledInteraction(const FString& InteractionId);
 
 private:
-	TArray<FInworldCharacterInteraction> Interactions;
-	TArray<FString> CanceledInteractions;
+	int32 GetSlot(int32 Index) const { return (First + Index) % MaxEntries; }
+
+	// Grows up to MaxEntries, then wraps around.
+	TArray<FInworldCharacterInteraction> Entries;
+	int32 First = 0;
+	int32 Count = 0;
+	TMap<FString, int32> SlotByUtteranceId;
+	TSet<FString> CanceledInteractions;
+
+	mutable TArray<FInworldCharacterInteraction> Ordered;
+	mutable bool bOrderedDirty = false;
 
 	int32 MaxEntries = 50;
 };
@@ -87,10 +117,15 @@ class INWORLDAIINTEGRATION_API UInworldCharacterPlaybackHistory : public UInworl
 	GENERATED_BODY()
 
 public:
+	// Whole history on every change, only copied out when bound. Prefer OnInteractionChanged.
 	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnInworldCharacterInteractionsChanged, const TArray<FInworldCharacterInteraction>&, Interactions);
 	UPROPERTY(BlueprintAssignable, Category = "EventDispatchers")
 	FOnInworldCharacterInteractionsChanged OnInteractionsChanged;
 
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnInworldCharacterInteractionChanged, const FInworldCharacterInteraction&, Interaction, EInworldCharacterInteractionChange, Change);
+	UPROPERTY(BlueprintAssignable, Category = "EventDispatchers")
+	FOnInworldCharacterInteractionChanged OnInteractionChanged;
+
 	UFUNCTION(BlueprintPure, Category = "Interactions")
 	const TArray<FInworldCharacterInteraction>& GetInteractions() { return InteractionHistory.GetInteractions(); }
 
@@ -105,6 +140,10 @@ private:
 	virtual void OnCharacterPlayerTalk_Implementation(const FCharacterMessagePlayerTalk& Message) override;
 	virtual void OnCharacterInteractionEnd_Implementation(const FCharacterMessageInteractionEnd& Message) override;
 
+	void BroadcastChange(const FInworldCharacterInteraction& Interaction, EInworldCharacterInteractionChange Change);
+	void BroadcastInteractions();
+
+	bool bInteractionsChanged = false;
 	FInworldCharacterInteractionHistory InteractionHistory;
 };
 
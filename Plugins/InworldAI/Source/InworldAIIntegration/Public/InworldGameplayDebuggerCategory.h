@@ -5,6 +5,7 @@
 #ifdef WITH_GAMEPLAY_DEBUGGER
 
 #include "GameplayDebuggerCategory.h"
+#include "InworldMetricsCollector.h"
 
 class FInworldGameplayDebuggerCategory : public FGameplayDebuggerCategory
 {
@@ -33,6 +34,8 @@ protected:
 
 		bool bPendingRepAudioEvent = false;
 
+		FInworldTimeToFirstAudioStats TimeToFirstAudio;
+
 		void Serialize(FArchive& Ar);
 	};
 
@@ -55,10 +58,16 @@ protected:
 		FString SessionError;
 		int32 ErrorCode;
 
+		// Time to first audio is with the characters.
+		FInworldMetrics Metrics;
+
 		void Serialize(FArchive& Ar);
 	};
 
 	FRepData DataPack;
+
+	FInworldMetricsCollector MetricsCollector;
+	double LastMetricsTime = 0.0;
 };
 
 #endif // WITH_GAMEPLAY_DEBUGGER
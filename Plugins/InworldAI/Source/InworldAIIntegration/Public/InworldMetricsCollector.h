@@ -0,0 +1,63 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InworldClient.h"
+
+namespace Inworld
+{
+	template<size_t NumCounters>
+	class RateMeter;
+}
+
+class UWorld;
+
+struct INWORLDAIINTEGRATION_API FInworldMetrics
+{
+	double PacketsReceivedPerSecond = 0.0;
+	double PacketsSentPerSecond = 0.0;
+	double BytesReceivedPerSecond = 0.0;
+	double BytesSentPerSecond = 0.0;
+	int32 WriteQueueDepth = 0;
+
+	// Captured audio not sent yet, of the player furthest behind.
+	float AudioCaptureBufferedMs = 0.f;
+
+	// Unreliable voice of every player, on the server.
+	uint64 VoiceFramesReceived = 0;
+	uint64 VoiceFramesLost = 0;
+	uint64 VoiceFramesLate = 0;
+	uint64 VoiceFramesRecovered = 0;
+	// Of the player with the most.
+	double VoiceJitterMs = 0.0;
+
+	// Audio replicated to the clients, on the server.
+	int32 AudioReplConnections = 0;
+	uint64 AudioReplDroppedDatagrams = 0;
+	int32 AudioReplQueuedBytes = 0;
+
+	// By agent id.
+	TMap<FString, FInworldTimeToFirstAudioStats> TimeToFirstAudio;
+};
+
+// Samples the Inworld subsystem of a world and the player components in it. Reads counters and queue sizes only,
+// cheap enough to run a few times a second in development builds. Rates are over the last couple of seconds.
+// Needs no viewport, runs on dedicated servers and headless. Game thread only.
+class INWORLDAIINTEGRATION_API FInworldMetricsCollector
+{
+public:
+	FInworldMetricsCollector();
+	~FInworldMetricsCollector();
+
+	void Collect(UWorld* World);
+
+	const FInworldMetrics& GetMetrics() const { return Metrics; }
+
+	// One line per metric and per agent.
+	void LogMetrics() const;
+
+private:
+	TUniquePtr<Inworld::RateMeter<4>> TransportRates;
+	FInworldMetrics Metrics;
+};
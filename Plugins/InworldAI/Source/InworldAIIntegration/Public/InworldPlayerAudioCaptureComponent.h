@@ -27,6 +27,35 @@ struct FPlayerVoiceCaptureInfoRep
 	TArray<uint8> OutputSoundData;
 };
 
+// Audio payload only, 100ms chunks of microphone audio, plus playback audio when echo cancellation is on.
+USTRUCT(BlueprintType)
+struct FInworldVoiceActivityStats
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Audio")
+    int64 CapturedChunks = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Audio")
+    int64 SentChunks = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Audio")
+    int64 SuppressedChunks = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Audio")
+    int64 SuppressedBytes = 0;
+};
+
+// Unreliable voice, as received on the server.
+struct FInworldVoiceTransportStats
+{
+    uint64 Received = 0;
+    uint64 Lost = 0;
+    uint64 Late = 0;
+    uint64 Recovered = 0;
+    double JitterMs = 0.0;
+};
+
 struct FInworldAudioCapture
 {
 public:
@@ -75,6 +104,15 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Devices")
     void SetCaptureDeviceById(const FString& DeviceId);
 
+    // Chunks suppressed by voice activity detection on the locally controlled player.
+    UFUNCTION(BlueprintPure, Category = "Audio")
+    FInworldVoiceActivityStats GetVoiceActivityStats() const { return VoiceActivityStats; }
+
+    // Captured audio waiting to be sent, in ms.
+    float GetCaptureBufferedMs();
+    // False unless voice is sent unreliably.
+    bool GetVoiceTransportStats(FInworldVoiceTransportStats& OutStats) const;
+
 private:
     void StartCapture();
     void StopCapture();
@@ -82,10 +120,45 @@ private:
     UFUNCTION(Server, Reliable)
     void Server_ProcessVoiceCaptureChunk(FPlayerVoiceCaptureInfoRep PlayerVoiceCaptureInfo);
 
+    // Unreliable transport, a frame is the microphone data followed by the playback data.
+    UFUNCTION(Server, Unreliable)
+    void Server_ProcessVoiceCaptureFrame(uint32 Sequence, const TArray<uint8>& Frame);
+    UFUNCTION(Server, Unreliable)
+    void Server_ProcessVoiceCaptureParity(uint32 Group, const TArray<uint8>& Parity);
+
+    void SendVoiceCaptureChunk(FPlayerVoiceCaptureInfoRep&& VoiceCaptureInfoRep);
+    void ProcessVoiceCaptureChunk(const FPlayerVoiceCaptureInfoRep& PlayerVoiceCaptureInfo);
+    void ReleaseVoiceCaptureFrames(bool bFlush);
+
 protected:
     UPROPERTY(EditDefaultsOnly, Category = "Filter")
 	bool bEnableAEC = false;
 
+    // Silent chunks are neither replicated to the server nor streamed to Inworld.
+    UPROPERTY(EditDefaultsOnly, Category = "Filter")
+    bool bEnableVAD = true;
+
+    // How long chunks keep being sent after speech ends, short pauses within an utterance are sent as well.
+    UPROPERTY(EditDefaultsOnly, Category = "Filter", meta = (EditCondition = "bEnableVAD", ClampMin = "0", Units = "ms"))
+    int32 VADHangoverMs = 600;
+
+    // How much audio before detected speech is sent with it, so the start of the utterance is not cut.
+    UPROPERTY(EditDefaultsOnly, Category = "Filter", meta = (EditCondition = "bEnableVAD", ClampMin = "0", Units = "ms"))
+    int32 VADPreRollMs = 200;
+
+    // Voice chunks are sent unreliably with a sequence number and put back in order on the server.
+    // A chunk that is late is dropped instead of holding back the ones behind it.
+    UPROPERTY(EditDefaultsOnly, Category = "Network")
+    bool bUnreliableVoice = false;
+
+    // A parity chunk is sent for every group of this many chunks, a single lost chunk of the group is rebuilt from it. 0 to disable.
+    UPROPERTY(EditDefaultsOnly, Category = "Network", meta = (EditCondition = "bUnreliableVoice", ClampMin = "0", ClampMax = "32"))
+    int32 VoiceFecGroupSize = 4;
+
+    // How long the server waits for a missing chunk before skipping it.
+    UPROPERTY(EditDefaultsOnly, Category = "Network", meta = (EditCondition = "bUnreliableVoice", ClampMin = "0", Units = "ms"))
+    int32 VoiceJitterBufferMs = 200;
+
     UPROPERTY(EditDefaultsOnly, Category = "Pixel Stream")
     bool bPixelStream = false;
 
@@ -113,6 +186,13 @@ private:
     FAudioBuffer InputBuffer;
     FAudioBuffer OutputBuffer;
 
+    // Game thread only.
+    TSharedPtr<struct FInworldVoiceActivityGate> VoiceActivityGate;
+    FInworldVoiceActivityStats VoiceActivityStats;
+
+    TSharedPtr<struct FInworldVoiceTransport> VoiceTransport;
+    FTimerHandle VoiceTransportTimerHandle;
+
     bool bMuted = false;
 
     void OnPlayerTargetSet(UInworldCharacterComponent* Target);
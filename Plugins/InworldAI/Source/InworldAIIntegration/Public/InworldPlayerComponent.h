@@ -62,6 +62,10 @@ public:
     void SendAudioDataMessageToTarget(const TArray<uint8>& Data);
     void SendAudioDataMessageWithAECToTarget(const TArray<uint8>& InputData, const TArray<uint8>& OutputData);
 
+    /** Token this player's connection says hello to the audio replication socket with, see UInworldAudioRepl */
+    UFUNCTION(Client, Reliable)
+    void ClientSetAudioReplToken(uint64 Token);
+
 private:
 	UFUNCTION()
 	void OnRep_TargetCharacterAgentId(FString OldAgentId);
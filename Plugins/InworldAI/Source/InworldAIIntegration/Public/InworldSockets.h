@@ -4,10 +4,11 @@
 
 #include "CoreMinimal.h"
 
-#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
 
 class FSocket;
-class FUdpSocketReceiver;
+class FRunnableThread;
+class FInternetAddr;
 
 namespace Inworld
 {
@@ -19,6 +20,38 @@ namespace Inworld
 		uint32 BufferSize;
 	};
 
+	// Datagrams received back to back in one buffer.
+	struct INWORLDAIINTEGRATION_API FDatagramBatch
+	{
+		int32 Num() const { return Ends.Num(); }
+		bool IsEmpty() const { return Ends.Num() == 0; }
+		TArrayView<const uint8> operator[](int32 Index) const
+		{
+			const int32 Start = Index == 0 ? 0 : Ends[Index - 1];
+			return TArrayView<const uint8>(Data.GetData() + Start, Ends[Index] - Start);
+		}
+
+		// Keeps the allocations.
+		void Reset()
+		{
+			Data.Reset();
+			Ends.Reset();
+		}
+
+		TArray<uint8> Data;
+		TArray<int32> Ends;
+	};
+
+	struct INWORLDAIINTEGRATION_API FSocketReceiveStats
+	{
+		uint64 Datagrams = 0;
+		uint64 Bytes = 0;
+		// Times the receiver handed a batch over.
+		uint64 Batches = 0;
+		// Times a batch buffer had to grow, once the buffers are warm datagrams are received without allocating.
+		uint64 Allocations = 0;
+	};
+
 	class INWORLDAIINTEGRATION_API FSocketBase
 	{
 	public:
@@ -29,9 +62,9 @@ namespace Inworld
 		virtual bool ProcessData(TArray<uint8>& Data) = 0;
 
 	protected:
-		FSocket* Socket;
-	}; 
-	
+		FSocket* Socket = nullptr;
+	};
+
 	class INWORLDAIINTEGRATION_API FSocketSend : public FSocketBase
 	{
 	public:
@@ -42,18 +75,148 @@ namespace Inworld
 		virtual bool ProcessData(TArray<uint8>& Data) override;
 	};
 
-	class INWORLDAIINTEGRATION_API FSocketReceive : public FSocketBase
+	// Datagrams are received on a dedicated thread, every wake up drains the socket into one batch buffer.
+	// The consumer swaps its batch with the pending one, the two buffers are reused for the lifetime of the socket.
+	class INWORLDAIINTEGRATION_API FSocketReceive : public FSocketBase, public FRunnable
 	{
 	public:
-		virtual ~FSocketReceive() = default;
+		virtual ~FSocketReceive();
 
 		virtual bool Initialize(const FSocketSettings& Settings) override;
 		virtual bool Deinitialize() override;
+		// One datagram at a time, prefer DrainAll.
 		virtual bool ProcessData(TArray<uint8>& Data) override;
 
+		// Replaces OutBatch with every datagram received since the last call, returns false if there are none.
+		// Single consumer.
+		bool DrainAll(FDatagramBatch& OutBatch);
+
+		// From the receiving socket, so replies come back to it.
+		bool SendTo(TArrayView<const uint8> Data, const FInternetAddr& Addr);
+
+		// Bound port, useful when the settings asked for any.
+		int32 GetPortNo() const;
+		FSocketReceiveStats GetStats() const;
+
+		virtual uint32 Run() override;
+		virtual void Stop() override;
+
+	private:
+		void Publish();
+
+		TUniquePtr<FRunnableThread> Thread;
+		TAtomic<bool> bStopping { false };
+
+		// Receiver thread only.
+		FDatagramBatch ReceiveBatch;
+
+		mutable FCriticalSection PendingLock;
+		FDatagramBatch PendingBatch;
+		FSocketReceiveStats Stats;
+
+		// Consumer only, for ProcessData.
+		FDatagramBatch ReadBatch;
+		int32 ReadIndex = 0;
+	};
+
+	struct INWORLDAIINTEGRATION_API FSocketMultiplexSettings
+	{
+		FString Name;
+		uint32 Port = 0;
+		uint32 BufferSize = 4 * 1024 * 1024;
+		// Per connection.
+		uint32 PacingBytesPerSecond = 512 * 1024;
+		uint32 MaxQueuedBytes = 256 * 1024;
+		// Connections that didn't say hello for this long are dropped, clients say it every few seconds.
+		double ConnectionTimeout = 15.0;
+	};
+
+	struct INWORLDAIINTEGRATION_API FSocketMultiplexStats
+	{
+		int32 Connections = 0;
+		uint64 SentDatagrams = 0;
+		uint64 SentBytes = 0;
+		// Sent before the connection said hello, or pushed out of a full send queue.
+		uint64 DroppedDatagrams = 0;
+		// Hellos for unknown connections or with the wrong token.
+		uint64 RejectedHellos = 0;
+		int32 QueuedBytes = 0;
+	};
+
+	// One UDP socket per server for every connection. Clients say hello with their connection id and the token the
+	// server authorized it with, sent to them over the game connection. The server acknowledges and from then on
+	// sends that connection's datagrams to the address the hello came from. Hellos without the connection's token
+	// are ignored, so the id alone can't redirect someone else's stream. Datagrams are queued per connection and
+	// paced. Game thread only.
+	class INWORLDAIINTEGRATION_API FSocketMultiplexServer
+	{
+	public:
+		~FSocketMultiplexServer();
+
+		bool Initialize(const FSocketMultiplexSettings& Settings);
+		void Deinitialize();
+
+		// Returns the token the connection has to say hello with, a new random one the first time.
+		uint64 Authorize(uint32 ConnectionId);
+		// Forgets the token and drops the connection.
+		void Revoke(uint32 ConnectionId);
+
+		// Dropped if the connection didn't say hello yet.
+		bool Send(uint32 ConnectionId, TArrayView<const uint8> Data);
+		// Answers hellos, sends what the pacing allows and drops connections that timed out.
+		void Tick();
+
+		bool IsConnected(uint32 ConnectionId) const { return Connections.Contains(ConnectionId); }
+		int32 GetPortNo() const;
+		FSocketMultiplexStats GetStats() const;
+
+	private:
+		struct FConnection
+		{
+			TSharedPtr<FInternetAddr> Addr;
+			double LastHello = 0.0;
+			double Tokens = 0.0;
+			double LastRefill = 0.0;
+			TArray<TArray<uint8>> Queue;
+			int32 QueueHead = 0;
+			int32 QueuedBytes = 0;
+		};
+
+		void ReceiveHellos(double Now);
+		void Flush(FConnection& Connection, double Now);
+		void PopFront(FConnection& Connection);
+
+		FSocketMultiplexSettings Settings;
+		FSocket* Socket = nullptr;
+		TMap<uint32, FConnection> Connections;
+		FSocketMultiplexStats Stats;
+		TArray<uint8> ReceiveBuffer;
+		TMap<uint32, uint64> Tokens;
+	};
+
+	// Client end of FSocketMultiplexServer.
+	class INWORLDAIINTEGRATION_API FSocketMultiplexClient
+	{
+	public:
+		// Token as given by FSocketMultiplexServer::Authorize.
+		bool Initialize(const FString& Name, const FInternetAddr& ServerAddr, uint32 ConnectionId, uint64 Token, uint32 BufferSize);
+		void Deinitialize();
+
+		// Says hello until acknowledged, then keeps the registration alive. OutPayloads view the datagrams
+		// received since the last call and stay valid until the next one.
+		void Receive(TArray<TArrayView<const uint8>>& OutPayloads);
+
+		bool IsAcknowledged() const { return bAcknowledged; }
+		uint32 GetConnectionId() const { return ConnectionId; }
+		uint64 GetToken() const { return Token; }
+
 	private:
-		FUdpSocketReceiver* Receiver;
-		
-		TQueue<TArray<uint8>> DataQueue;
+		FSocketReceive Socket;
+		TSharedPtr<FInternetAddr> ServerAddr;
+		uint32 ConnectionId = 0;
+		uint64 Token = 0;
+		bool bAcknowledged = false;
+		double LastHello = 0.0;
+		FDatagramBatch Batch;
 	};
 }
@@ -123,6 +123,8 @@ public class InworldAINdk : ModuleRules
 
         if (Target.Platform == UnrealTargetPlatform.Win64)
         {
+            // System SSL root certificates are read from the Windows certificate store.
+            PublicSystemLibraries.Add("crypt32.lib");
             PublicAdditionalLibraries.Add(Path.Combine(ThirdPartyLibrariesDirectory, "webrtc_aec_plugin.dll.lib"));
             RuntimeDependencies.Add(Path.Combine("$(BinaryOutputDir)", "webrtc_aec_plugin.dll"), Path.Combine(ThirdPartyLibrariesDirectory, "webrtc_aec_plugin.dll"));
         }
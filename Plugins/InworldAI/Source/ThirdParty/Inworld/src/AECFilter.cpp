@@ -8,34 +8,129 @@
 #include "AECFilter.h"
 #include "webrtc/aec.h"
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 
 Inworld::AECFilter::AECFilter()
 #ifdef INWORLD_AEC
-	: AecHandle(WebRtcAec3_Create(16000))
+	: _AecHandle(WebRtcAec3_Create(16000))
 #endif // INWORLD_AEC
-{}
+{
+	_NearCarry.reserve(FrameSize);
+}
 
 Inworld::AECFilter::~AECFilter()
 {
 #ifdef INWORLD_AEC
-	WebRtcAec3_Free(AecHandle);
+	WebRtcAec3_Free(_AecHandle);
 #endif // INWORLD_AEC
 }
 
-std::vector<int16_t> Inworld::AECFilter::FilterAudio(const std::vector<int16_t>& InputData, const std::vector<int16_t>& OutputData)
+void Inworld::AECFilter::ProcessFrame(const int16_t* Near, int16_t* Out)
 {
+	// A far end frame per near end frame, without playback the near end is processed alone.
+	const bool bFarFrame = _Far.size() - _FarOffset >= FrameSize;
 #ifdef INWORLD_AEC
-	std::vector<int16_t> FilteredAudio = InputData;
-	constexpr int32_t NumSamples = 160;
-	const int32_t MaxSamples = std::min(InputData.size(), OutputData.size()) / NumSamples * NumSamples;
-
-	for (int32_t i = 0; i < MaxSamples; i += NumSamples)
+	if (bFarFrame)
+	{
+		WebRtcAec3_BufferFarend(_AecHandle, _Far.data() + _FarOffset);
+	}
+	if (Near == Out)
 	{
-		WebRtcAec3_BufferFarend(AecHandle, OutputData.data() + i);
-		WebRtcAec3_Process(AecHandle, InputData.data() + i, FilteredAudio.data() + i);
+		int16_t Frame[FrameSize];
+		std::memcpy(Frame, Near, sizeof(Frame));
+		WebRtcAec3_Process(_AecHandle, Frame, Out);
+	}
+	else
+	{
+		WebRtcAec3_Process(_AecHandle, Near, Out);
 	}
-	return FilteredAudio;
 #else
-	return InputData;
+	if (Near != Out)
+	{
+		std::memcpy(Out, Near, FrameSize * sizeof(int16_t));
+	}
 #endif // INWORLD_AEC
+	if (bFarFrame)
+	{
+		_FarOffset += FrameSize;
+	}
+	_Stats.Frames++;
+}
+
+size_t Inworld::AECFilter::Process(const int16_t* Near, size_t NumNear, const int16_t* Far, size_t NumFar, int16_t* Out)
+{
+	const auto Start = std::chrono::steady_clock::now();
+
+	// Consumed far end samples are compacted once per call.
+	_Far.erase(_Far.begin(), _Far.begin() + _FarOffset);
+	_FarOffset = 0;
+	_Far.insert(_Far.end(), Far, Far + NumFar);
+	if (_Far.size() > MaxFarSamples)
+	{
+		_Far.erase(_Far.begin(), _Far.end() - MaxFarSamples);
+	}
+
+	size_t NumOut = 0;
+	size_t NearIdx = 0;
+	if (!_NearCarry.empty())
+	{
+		const size_t NumFill = std::min(FrameSize - _NearCarry.size(), NumNear);
+		_NearCarry.insert(_NearCarry.end(), Near, Near + NumFill);
+		NearIdx = NumFill;
+		if (_NearCarry.size() == FrameSize)
+		{
+			ProcessFrame(_NearCarry.data(), Out);
+			_NearCarry.clear();
+			NumOut = FrameSize;
+		}
+	}
+
+	for (; NearIdx + FrameSize <= NumNear; NearIdx += FrameSize)
+	{
+		ProcessFrame(Near + NearIdx, Out + NumOut);
+		NumOut += FrameSize;
+	}
+
+	_NearCarry.insert(_NearCarry.end(), Near + NearIdx, Near + NumNear);
+
+	const int64_t CallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count();
+	_Stats.Calls++;
+	_Stats.LastCallNs = CallNs;
+	_Stats.MaxCallNs = std::max(_Stats.MaxCallNs, CallNs);
+	_Stats.TotalCallNs += CallNs;
+
+	return NumOut;
+}
+
+void Inworld::AECFilter::Process(std::vector<int16_t>& Data, const std::vector<int16_t>& Far)
+{
+	// With the carried over samples moved in front frames are written where they are read from.
+	Data.insert(Data.begin(), _NearCarry.begin(), _NearCarry.end());
+	_NearCarry.clear();
+	const size_t NumOut = Process(Data.data(), Data.size(), Far.data(), Far.size(), Data.data());
+	Data.resize(NumOut);
+}
+
+size_t Inworld::AECFilter::Flush(int16_t* Out)
+{
+	const size_t NumCarry = _NearCarry.size();
+	if (NumCarry == 0)
+	{
+		return 0;
+	}
+
+	int16_t Frame[FrameSize];
+	_NearCarry.resize(FrameSize, 0);
+	ProcessFrame(_NearCarry.data(), Frame);
+	std::memcpy(Out, Frame, NumCarry * sizeof(int16_t));
+	_NearCarry.clear();
+	return NumCarry;
+}
+
+void Inworld::AECFilter::Reset()
+{
+	_NearCarry.clear();
+	_Far.clear();
+	_FarOffset = 0;
 }
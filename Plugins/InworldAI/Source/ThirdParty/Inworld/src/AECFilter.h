@@ -8,19 +8,61 @@
 #pragma once
 #include "Define.h"
 #include <vector>
+#include <cstdint>
+#include <cstddef>
 
 namespace Inworld
 {
+	// Streaming echo cancellation of 16kHz mono audio. The filter works on 10ms frames, samples that do not
+	// complete a frame are carried over to the next call, for the near end (microphone) as well as the
+	// far end (playback). Without INWORLD_AEC samples are passed through unchanged, with the same framing.
 	class INWORLD_EXPORT AECFilter
 	{
 	public:
+		static constexpr size_t FrameSize = 160;
+		// Far end samples not matched by near end frames are dropped above this, oldest first.
+		static constexpr size_t MaxFarSamples = 16000;
+
+		struct Stats
+		{
+			uint64_t Calls = 0;
+			uint64_t Frames = 0;
+			int64_t LastCallNs = 0;
+			int64_t MaxCallNs = 0;
+			int64_t TotalCallNs = 0;
+		};
+
 		AECFilter();
 		~AECFilter();
 
-		std::vector<int16_t> FilterAudio(const std::vector<int16_t>& InputData, const std::vector<int16_t>& OutputData);
+		AECFilter(const AECFilter&) = delete;
+		AECFilter& operator=(const AECFilter&) = delete;
+
+		// Upper bound of the samples a call with NumNear samples writes.
+		size_t GetMaxOutputSize(size_t NumNear) const { return NumNear + _NearCarry.size(); }
+
+		// Writes the filtered samples of the frames completed by this call to Out and returns their number.
+		// Out must fit GetMaxOutputSize(NumNear) samples. It may be Near when nothing is carried over,
+		// otherwise it must not overlap Near.
+		size_t Process(const int16_t* Near, size_t NumNear, const int16_t* Far, size_t NumFar, int16_t* Out);
+		// In place, Data is replaced with the filtered samples of the frames completed by this call.
+		void Process(std::vector<int16_t>& Data, const std::vector<int16_t>& Far);
+
+		// Filters the carried over near end samples padded to a frame, writes at most FrameSize - 1 samples.
+		size_t Flush(int16_t* Out);
+		// Drops carried over samples, e.g. when a new audio session starts.
+		void Reset();
+
+		const Stats& GetStats() const { return _Stats; }
+		void ResetStats() { _Stats = Stats(); }
 
 	private:
-		void* AecHandle = nullptr;
+		void ProcessFrame(const int16_t* Near, int16_t* Out);
+
+		void* _AecHandle = nullptr;
+		std::vector<int16_t> _NearCarry;
+		std::vector<int16_t> _Far;
+		size_t _FarOffset = 0;
+		Stats _Stats;
 	};
 }
-
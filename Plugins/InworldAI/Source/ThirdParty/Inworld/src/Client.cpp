@@ -7,6 +7,7 @@
 
 #include "Client.h"
 #include "RunnableCommand.h"
+#include "ReplayReaderWriter.h"
 #include "Utils/Utils.h"
 #include "Utils/Log.h"
 #include "base64/Base64.h"
@@ -25,7 +26,45 @@
 
 
 
+namespace
+{
+	class RunnableTask : public Inworld::Runnable
+	{
+	public:
+		RunnableTask(std::function<void()> Task)
+			: _Task(Task)
+		{}
+
+		virtual void Run() override
+		{
+			_Task();
+			_IsDone = true;
+		}
+
+	private:
+		std::function<void()> _Task;
+	};
+}
+
+Inworld::PacketReplayBuffer<std::shared_ptr<Inworld::Packet>>::Settings Inworld::ClientBase::SentPacketReplaySettings()
+{
+	PacketReplayBuffer<std::shared_ptr<Inworld::Packet>>::Settings Settings;
+	// Player input, text, audio, triggers or a session start, must not reach the server twice. Cancelling a
+	// response or ending an audio session again changes nothing.
+	Settings.IsReplaySafe = [](const std::shared_ptr<Inworld::Packet>& Packet)
+	{
+		if (dynamic_cast<const Inworld::CancelResponseEvent*>(Packet.get()))
+		{
+			return true;
+		}
+		const auto* Control = dynamic_cast<const Inworld::ControlEvent*>(Packet.get());
+		return Control && Control->GetControlAction() == ai::inworld::packets::ControlEvent_Action_AUDIO_SESSION_END;
+	};
+	return Settings;
+}
+
 constexpr int64_t gMaxTokenLifespan = 60 * 45; // 45 minutes
+constexpr int64_t gTokenRefreshMargin = 60 * 2; // a token this close to expiring is refreshed before resuming
 
 const std::string DefaultTargetUrl = "api-engine.inworld.ai:443";
 
@@ -69,6 +108,7 @@ void Inworld::ClientBase::SetOptions(const ClientOptions& options)
 void Inworld::ClientBase::SendPacket(std::shared_ptr<Inworld::Packet> Packet)
 {
 	_OutgoingPackets.PushBack(Packet);
+	_SentCounters.SetQueueDepth(_OutgoingPackets.Size());
 
 	TryToStartWriteTask();
 }
@@ -85,6 +125,8 @@ std::shared_ptr<Inworld::DataEvent> Inworld::ClientBase::SendSoundMessage(const
 {
 	auto Packet = std::make_shared<AudioDataEvent>(Data, Routing::Player2Agent(AgentId));
 	SendPacket(Packet);
+	_AudioChunksSentMetric.Add();
+	_AudioBytesSentMetric.Add(Data.size());
 #ifdef INWORLD_AUDIO_DUMP
 	if(bDumpAudio)
 		_AudioChunksToDump.PushBack(Data);
@@ -94,7 +136,12 @@ std::shared_ptr<Inworld::DataEvent> Inworld::ClientBase::SendSoundMessage(const
 
 std::shared_ptr<Inworld::DataEvent> Inworld::ClientBase::SendSoundMessageWithAEC(const std::string& AgentId, const std::vector<int16_t>& InputData, const std::vector<int16_t>& OutputData)
 {
-	std::vector<int16_t> FilteredData = _EchoFilter.FilterAudio(InputData, OutputData);
+	std::vector<int16_t> FilteredData = InputData;
+	_EchoFilter.Process(FilteredData, OutputData);
+	if (FilteredData.empty())
+	{
+		return nullptr;
+	}
 
 	std::string Data;
 	Data.resize(FilteredData.size() * sizeof(int16_t));
@@ -143,12 +190,22 @@ void Inworld::ClientBase::SetAudioDumpEnabled(bool bEnabled, const std::string&
 
 void Inworld::ClientBase::StartAudioSession(const std::string& AgentId)
 {
+	_EchoFilter.Reset();
+
 	auto Packet = std::make_shared<Inworld::ControlEvent>(ai::inworld::packets::ControlEvent_Action_AUDIO_SESSION_START, Inworld::Routing::Player2Agent(AgentId));
 	SendPacket(Packet);
 }
 
 void Inworld::ClientBase::StopAudioSession(const std::string& AgentId)
 {
+	// Samples waiting for a whole echo cancellation frame.
+	std::vector<int16_t> Remainder(AECFilter::FrameSize);
+	Remainder.resize(_EchoFilter.Flush(Remainder.data()));
+	if (!Remainder.empty())
+	{
+		SendSoundMessage(AgentId, std::string(reinterpret_cast<const char*>(Remainder.data()), Remainder.size() * sizeof(int16_t)));
+	}
+
 	auto Packet = std::make_shared<Inworld::ControlEvent>(ai::inworld::packets::ControlEvent_Action_AUDIO_SESSION_END, Inworld::Routing::Player2Agent(AgentId));
 	SendPacket(Packet);
 }
@@ -188,6 +245,7 @@ void Inworld::ClientBase::GenerateToken(std::function<void()> GenerateTokenCallb
 
 				AddTaskToMainThread([this, Status]()
 				{
+					_bRefreshingToken = false;
 					if (!Status.ok())
 					{
 						_ErrorMessage = std::string(Status.error_message().c_str());
@@ -240,19 +298,82 @@ void Inworld::ClientBase::StartClient(const ClientOptions& Options, const Sessio
 
 	SetConnectionState(ConnectionState::Connecting);
 
+	_StartTime = std::chrono::steady_clock::now();
+	const uint32_t Generation = ++_StartGeneration;
+	if (!_ClientOptions.PacketReplayPath.empty())
+	{
+		StartReplay();
+		return;
+	}
+	if (!_ClientOptions.PacketRecordingPath.empty())
+	{
+		_PacketRecorder.Open(_ClientOptions.PacketRecordingPath);
+	}
+
+	_PendingSceneLoadSteps = 1;
+	if (_ClientOptions.bRestoreSessionSnapshot && _SessionInfo.SessionSavedState.empty() && !_ClientOptions.SessionSnapshotPath.empty())
+	{
+		_PendingSceneLoadSteps++;
+		LoadSessionSnapshot();
+	}
+
 	if (!_SessionInfo.IsValid())
 	{
-		GenerateToken([this]()
+		GenerateToken([this, Generation]()
 		{
-			LoadScene();
+			OnSceneLoadStepDone(Generation);
 		});
 	}
 	else
+	{
+		OnSceneLoadStepDone(Generation);
+	}
+}
+
+void Inworld::ClientBase::OnSceneLoadStepDone(uint32_t Generation)
+{
+	if (Generation != _StartGeneration || _ConnectionState != ConnectionState::Connecting || _PendingSceneLoadSteps == 0)
+	{
+		return;
+	}
+
+	if (--_PendingSceneLoadSteps == 0)
 	{
 		LoadScene();
 	}
 }
 
+void Inworld::ClientBase::LoadSessionSnapshot()
+{
+	const uint32_t Generation = _StartGeneration;
+	const SessionSnapshotStore Store = GetSessionSnapshotStore();
+	const std::string SceneName = _ClientOptions.SceneName;
+	_AsyncSessionSnapshotTask->Start(
+		"InworldLoadSessionSnapshot",
+		std::make_unique<RunnableTask>(
+			[this, Generation, Store, SceneName]()
+			{
+				auto Snapshot = std::make_shared<SessionSnapshot>();
+				const bool bLoaded = Store.Load(*Snapshot) && Snapshot->SceneName == SceneName;
+				AddTaskToMainThread([this, Generation, Snapshot, bLoaded]()
+				{
+					if (bLoaded && Generation == _StartGeneration && _SessionInfo.SessionSavedState.empty())
+					{
+						Inworld::Log("Restoring session state saved %d s ago", static_cast<int32_t>(std::time(0) - Snapshot->SavedAt));
+						_SessionInfo.SessionSavedState = std::move(Snapshot->State);
+					}
+					OnSceneLoadStepDone(Generation);
+				});
+			}
+		)
+	);
+}
+
+Inworld::SessionSnapshotStore Inworld::ClientBase::GetSessionSnapshotStore() const
+{
+	return SessionSnapshotStore(_ClientOptions.SessionSnapshotPath, _ClientOptions.SceneName + "|" + _ClientOptions.UserId);
+}
+
 void Inworld::ClientBase::PauseClient()
 {
 	if (_ConnectionState != ConnectionState::Connected)
@@ -274,14 +395,16 @@ void Inworld::ClientBase::ResumeClient()
 
 	SetConnectionState(ConnectionState::Reconnecting);
 
-	if (!_SessionInfo.IsValid())
+	// The channel and the session stay, only the stream is reopened.
+	if (_bRefreshingToken)
 	{
-		GenerateToken([this]()
-		{
-			auto Session = static_cast<RunnableLoadScene*>(_AsyncLoadSceneTask->GetRunnable());
-			Session->SetToken(_SessionInfo.Token);
-			StartReaderWriter();
-		});
+		// Resumes once the token arrives.
+		return;
+	}
+
+	if (_ClientOptions.PacketReplayPath.empty() && (!_SessionInfo.IsValid() || IsTokenExpiring()))
+	{
+		RefreshToken();
 	}
 	else
 	{
@@ -297,11 +420,17 @@ void Inworld::ClientBase::StopClient()
 	}
 
 	StopReaderWriter();
+	_PacketRecorder.Close();
 	_AsyncLoadSceneTask->Stop();
 	_AsyncGenerateTokenTask->Stop();
 	_AsyncGetSessionState->Stop();
+	_AsyncSessionSnapshotTask->Stop();
+	_PendingSceneLoadSteps = 0;
 	_ClientOptions = ClientOptions();
 	_SessionInfo = SessionInfo();
+	_SentPackets.Reset();
+	_bRefreshingToken = false;
+	_bMeasuringReconnect = false;
 	SetConnectionState(ConnectionState::Idle);
 	Inworld::LogClearSessionId();
 }
@@ -330,13 +459,16 @@ void Inworld::ClientBase::SaveSessionState(std::function<void(std::string, bool)
 	}
 
 	const std::string SessionName = _ClientOptions.SceneName.substr(0, Pos) + "sessions/" + _SessionInfo.SessionId;
+	const bool bSaveSnapshot = !_ClientOptions.SessionSnapshotPath.empty();
+	const SessionSnapshotStore Store = GetSessionSnapshotStore();
+	const std::string SceneName = _ClientOptions.SceneName;
 	_AsyncGetSessionState->Start(
 		"InworldSaveSession",
 		std::make_unique<RunnableGetSessionState>(
 			_ClientOptions.ServerUrl,
 			_SessionInfo.Token,
 			SessionName,
-			[this, Callback](const grpc::Status& Status, const InworldEngineV1::SessionState& State)
+			[this, Callback, bSaveSnapshot, Store, SceneName](const grpc::Status& Status, const InworldEngineV1::SessionState& State)
 			{
 				AddTaskToMainThread([this, Status, State, Callback]() {
 					if (!Status.ok())
@@ -348,6 +480,16 @@ void Inworld::ClientBase::SaveSessionState(std::function<void(std::string, bool)
 
 					Callback(State.state(), true);
 				});
+
+				// Written on this thread once the state is handed over.
+				if (Status.ok() && bSaveSnapshot)
+				{
+					SessionSnapshot Snapshot;
+					Snapshot.SceneName = SceneName;
+					Snapshot.State = State.state();
+					Snapshot.SavedAt = std::time(0);
+					Store.Save(Snapshot);
+				}
 			}
 		));
 }
@@ -359,6 +501,17 @@ bool Inworld::ClientBase::GetConnectionError(std::string& OutErrorMessage, int32
 	return _ErrorCode != grpc::StatusCode::OK;
 }
 
+Inworld::ClientBase::TransportStats Inworld::ClientBase::GetTransportStats() const
+{
+	TransportStats Stats;
+	Stats.PacketsReceived = _ReceivedCounters.Packets.load(std::memory_order_relaxed);
+	Stats.BytesReceived = _ReceivedCounters.Bytes.load(std::memory_order_relaxed);
+	Stats.PacketsSent = _SentCounters.Packets.load(std::memory_order_relaxed);
+	Stats.BytesSent = _SentCounters.Bytes.load(std::memory_order_relaxed);
+	Stats.WriteQueueDepth = static_cast<uint32_t>(_OutgoingPackets.Size());
+	return Stats;
+}
+
 void Inworld::ClientBase::SetConnectionState(ConnectionState State)
 {
 	if (_ConnectionState == State)
@@ -366,6 +519,7 @@ void Inworld::ClientBase::SetConnectionState(ConnectionState State)
 		return;
 	}
 
+	const ConnectionState PrevState = _ConnectionState;
 	_ConnectionState = State;
 
 	if (_ConnectionState == ConnectionState::Connected || _ConnectionState == ConnectionState::Idle)
@@ -374,6 +528,29 @@ void Inworld::ClientBase::SetConnectionState(ConnectionState State)
 		_ErrorCode = grpc::StatusCode::OK;
 	}
 
+	if (_ConnectionState == ConnectionState::Disconnected)
+	{
+		if (PrevState == ConnectionState::Connected)
+		{
+			_bMeasuringReconnect = true;
+			_DisconnectTime = std::chrono::steady_clock::now();
+		}
+		// Fetched while the resume waits for its turn, rather than after.
+		if (IsTokenExpiring())
+		{
+			RefreshToken();
+		}
+	}
+	else if (_ConnectionState == ConnectionState::Connected && _bMeasuringReconnect)
+	{
+		_bMeasuringReconnect = false;
+		const uint32_t Ms = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _DisconnectTime).count());
+		_ReconnectStats.Reconnects++;
+		_ReconnectStats.LastReconnectMs = Ms;
+		_ReconnectStats.MaxReconnectMs = std::max(_ReconnectStats.MaxReconnectMs, Ms);
+		Inworld::Log("Reconnected in %d ms, %d packets replayed so far", Ms, static_cast<int32_t>(_ReconnectStats.ReplayedPackets));
+	}
+
 	if (_OnConnectionStateChangedCallback)
 	{
 		_OnConnectionStateChangedCallback(_ConnectionState);
@@ -429,26 +606,26 @@ void Inworld::ClientBase::OnSceneLoaded(const grpc::Status& Status, const Inworl
 		return;
 	}
 
-	Inworld::Log("Load scene SUCCESS. Session Id: %s", ARG_STR(_SessionInfo.SessionId));
+	_PacketRecorder.Record(RecordedPacketKind::Scene, Response);
+
+	const int32_t StartMs = static_cast<int32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _StartTime).count());
+	// Characters are logged as they are possessed, scenes may have hundreds.
+	Inworld::Log("Load scene SUCCESS in %d ms%s, %d characters. Session Id: %s", StartMs, _SessionInfo.SessionSavedState.empty() ? "" : ", state restored", Response.agents_size(), ARG_STR(_SessionInfo.SessionId));
 
 	std::vector<AgentInfo> AgentInfos;
-	AgentInfos.reserve(Response.agents_size());
-	for (int32_t i = 0; i < Response.agents_size(); i++)
+	AgentInfos.reserve(Response.agents_size() + 1);
+	for (const auto& Agent : Response.agents())
 	{
-		AgentInfo Info;
-		Info.BrainName = Response.agents(i).brain_name().c_str();
-		Info.AgentId = Response.agents(i).agent_id().c_str();
-		Info.GivenName = Response.agents(i).given_name().c_str();
-		AgentInfos.push_back(Info);
-
-		Inworld::Log("Character registered: %s, Id: %s, GivenName: %s", ARG_STR(Info.BrainName), ARG_STR(Info.AgentId), ARG_STR(Info.GivenName));
+		AgentInfo& Info = AgentInfos.emplace_back();
+		Info.BrainName = Agent.brain_name();
+		Info.AgentId = Agent.agent_id();
+		Info.GivenName = Agent.given_name();
 	}
 
-	AgentInfo Info;
+	AgentInfo& Info = AgentInfos.emplace_back();
 	Info.BrainName = "__DUMMY__";
 	Info.AgentId = "__DUMMY__";
 	Info.GivenName = "__DUMMY__";
-	AgentInfos.push_back(Info);
 
 	_OnLoadSceneCallback(AgentInfos);
 	_OnLoadSceneCallback = nullptr;
@@ -457,6 +634,22 @@ void Inworld::ClientBase::OnSceneLoaded(const grpc::Status& Status, const Inworl
 	StartReaderWriter();
 }
 
+void Inworld::ClientBase::StartReplay()
+{
+	InworldEngine::LoadSceneResponse Scene;
+	ReplayReaderWriter Recording;
+	if (!Recording.Open(_ClientOptions.PacketReplayPath, &Scene))
+	{
+		_ErrorMessage = "Can't replay " + _ClientOptions.PacketReplayPath;
+		_ErrorCode = grpc::StatusCode::NOT_FOUND;
+		SetConnectionState(ConnectionState::Failed);
+		return;
+	}
+
+	Inworld::Log("Replaying %s, speed %.1f", ARG_STR(_ClientOptions.PacketReplayPath), _ClientOptions.PacketReplaySpeed);
+	OnSceneLoaded(grpc::Status::OK, Scene);
+}
+
 void Inworld::ClientBase::StartReaderWriter()
 {
 	const bool bHasPendingWriteTask = _AsyncWriteTask->IsValid() && !_AsyncWriteTask->IsDone();
@@ -465,8 +658,36 @@ void Inworld::ClientBase::StartReaderWriter()
 	{
 		_ErrorMessage = std::string();
 		_ErrorCode = grpc::StatusCode::OK;
-		_ReaderWriter = static_cast<RunnableLoadScene*>(_AsyncLoadSceneTask->GetRunnable())->Session();
+		if (_ClientOptions.PacketReplayPath.empty())
+		{
+			_ReaderWriter = static_cast<RunnableLoadScene*>(_AsyncLoadSceneTask->GetRunnable())->Session();
+			_ReplayReaderWriter = nullptr;
+		}
+		else
+		{
+			// Failing to reopen it ends the replay at the first read, as a dropped stream would.
+			auto Recording = std::make_unique<ReplayReaderWriter>(_ClientOptions.PacketReplaySpeed);
+			Recording->Open(_ClientOptions.PacketReplayPath);
+			_ReplayReaderWriter = Recording.get();
+			_ReaderWriter = std::move(Recording);
+		}
 		_bHasReaderWriterFinished = false;
+
+		// Packets the previous stream may have lost go first.
+		const uint64_t DiscardedBefore = _SentPackets.GetStats().Discarded;
+		auto Replay = _SentPackets.TakeUnacknowledged(std::chrono::steady_clock::now());
+		const uint64_t Discarded = _SentPackets.GetStats().Discarded - DiscardedBefore;
+		if (Discarded > 0)
+		{
+			_ReconnectStats.DiscardedPackets += Discarded;
+			Inworld::LogWarning("%d packets sent before the stream dropped may not have reached the server, not replayed", static_cast<int32_t>(Discarded));
+		}
+		if (!Replay.empty())
+		{
+			_ReconnectStats.ReplayedPackets += Replay.size();
+			_OutgoingPackets.PushFront(std::move(Replay));
+		}
+
 		TryToStartReadTask();
 		TryToStartWriteTask();
 	}
@@ -475,6 +696,10 @@ void Inworld::ClientBase::StartReaderWriter()
 void Inworld::ClientBase::StopReaderWriter()
 {
 	_bHasReaderWriterFinished = true;
+	if (_ReplayReaderWriter)
+	{
+		_ReplayReaderWriter->Cancel();
+	}
 	auto* Task = static_cast<RunnableLoadScene*>(_AsyncLoadSceneTask->GetRunnable());
 	if (Task)
 	{
@@ -486,6 +711,7 @@ void Inworld::ClientBase::StopReaderWriter()
 	}
 	_AsyncReadTask->Stop();
 	_AsyncWriteTask->Stop();
+	_ReplayReaderWriter = nullptr;
 	_ReaderWriter.reset();
 }
 
@@ -507,6 +733,7 @@ void Inworld::ClientBase::TryToStartReadTask()
 				_IncomingPackets,
 				[this](const std::shared_ptr<Inworld::Packet> InPacket)
 				{
+					_SentPackets.OnReceived();
 					if (!_bPendingIncomingPacketFlush)
 					{
 						_bPendingIncomingPacketFlush = true;
@@ -525,6 +752,7 @@ void Inworld::ClientBase::TryToStartReadTask()
 										}
 									}
 								}
+								_ReceivedCounters.SetQueueDepth(_IncomingPackets.Size());
 								_bPendingIncomingPacketFlush = false;
 							});
 					}
@@ -539,6 +767,21 @@ void Inworld::ClientBase::TryToStartReadTask()
 				},
 				[this](const grpc::Status& Status)
 				{
+					// The end of a recording is where the replay stops, resuming it would start over.
+					if (_ReplayReaderWriter && Status.error_code() == grpc::StatusCode::OUT_OF_RANGE)
+					{
+						Inworld::Log("%s", ARG_STR(Status.error_message()));
+						AddTaskToMainThread(
+							[this, Replay = _ReplayReaderWriter]()
+							{
+								if (_ReplayReaderWriter == Replay)
+								{
+									StopClient();
+								}
+							});
+						return;
+					}
+
 					_ErrorMessage = std::string(Status.error_message().c_str());
 					_ErrorCode = Status.error_code();
 					Inworld::LogError("Message READ failed: %s. Code: %d", ARG_STR(_ErrorMessage), _ErrorCode);
@@ -547,7 +790,9 @@ void Inworld::ClientBase::TryToStartReadTask()
 						{
 							SetConnectionState(ConnectionState::Disconnected);
 						});
-				}
+				},
+				&_ReceivedCounters,
+				&_PacketRecorder
 			)
 		);
 	}
@@ -574,6 +819,7 @@ void Inworld::ClientBase::TryToStartWriteTask()
 					_OutgoingPackets,
 					[this](const std::shared_ptr<Inworld::Packet> InPacket)
 					{
+						_SentPackets.OnWritten(InPacket, std::chrono::steady_clock::now());
 						if (_ConnectionState != ConnectionState::Connected)
 						{
 							AddTaskToMainThread([this]() {
@@ -589,13 +835,42 @@ void Inworld::ClientBase::TryToStartWriteTask()
 						AddTaskToMainThread([this]() {
 							SetConnectionState(ConnectionState::Disconnected);
 						});
-					}
+					},
+					&_SentCounters,
+					&_PacketRecorder
 				)
 			);
 		}
 	}
 }
 
+void Inworld::ClientBase::RefreshToken()
+{
+	if (_bRefreshingToken)
+	{
+		return;
+	}
+
+	_bRefreshingToken = true;
+	GenerateToken([this]()
+	{
+		auto* Session = static_cast<RunnableLoadScene*>(_AsyncLoadSceneTask->GetRunnable());
+		if (Session)
+		{
+			Session->SetToken(_SessionInfo.Token);
+		}
+		if (_ConnectionState == ConnectionState::Reconnecting)
+		{
+			StartReaderWriter();
+		}
+	});
+}
+
+bool Inworld::ClientBase::IsTokenExpiring() const
+{
+	return !_SessionInfo.SessionId.empty() && _SessionInfo.ExpirationTime - std::time(0) < gTokenRefreshMargin;
+}
+
 void Inworld::Client::Update()
 {
 	ExecutePendingTasks();
@@ -19,11 +19,15 @@
 #include "AECFilter.h"
 #include "RunnableCommand.h"
 #include "Utils/PerceivedLatencyTracker.h"
+#include "Utils/PacketReplayBuffer.h"
+#include "Utils/SessionSnapshotStore.h"
 
 using PacketQueue = Inworld::SharedQueue<std::shared_ptr<Inworld::Packet>>;
 
 namespace Inworld
 {	
+	class ReplayReaderWriter;
+
 	struct INWORLD_EXPORT ClientOptions
 	{
 		std::string ServerUrl;
@@ -36,6 +40,16 @@ namespace Inworld
 		std::string UserId;
 		CapabilitySet Capabilities;
 		UserSettings UserSettings;
+		// Saved session states are also written here when not empty.
+		std::string SessionSnapshotPath;
+		// Restores the state saved at SessionSnapshotPath when started without one. Read while the token is generated.
+		bool bRestoreSessionSnapshot = false;
+		// Every packet of the session stream, and the scene it started with, is recorded here when not empty.
+		std::string PacketRecordingPath;
+		// Replays this packet recording instead of connecting, no network is used. Resuming replays it from the start.
+		std::string PacketReplayPath;
+		// 2 replays twice as fast as recorded, 0 as fast as packets are handled.
+		float PacketReplaySpeed = 1.f;
 	};
 
 	class INWORLD_EXPORT ClientBase
@@ -52,6 +66,28 @@ namespace Inworld
 			Reconnecting
 		};
 
+		struct ReconnectStats
+		{
+			uint32_t Reconnects = 0;
+			// From the stream dropping to the new one working.
+			uint32_t LastReconnectMs = 0;
+			uint32_t MaxReconnectMs = 0;
+			uint64_t ReplayedPackets = 0;
+			// Player input written before a stream dropped without an answer, not replayed in case the server got it.
+			uint64_t DiscardedPackets = 0;
+		};
+
+		// Counted over the lifetime of the client, across sessions and reconnects.
+		struct TransportStats
+		{
+			uint64_t PacketsReceived = 0;
+			uint64_t BytesReceived = 0;
+			uint64_t PacketsSent = 0;
+			uint64_t BytesSent = 0;
+			// Packets waiting to be written to the stream.
+			uint32_t WriteQueueDepth = 0;
+		};
+
 		ClientBase() = default;
 		virtual ~ClientBase() = default;
 		
@@ -59,6 +95,7 @@ namespace Inworld
 
 		virtual std::shared_ptr<TextEvent> SendTextMessage(const std::string& AgentId, const std::string& Text);
 		virtual std::shared_ptr<DataEvent> SendSoundMessage(const std::string& AgentId, const std::string& Data);
+		// Nullptr when all samples are held back to complete an echo cancellation frame.
 		virtual std::shared_ptr<DataEvent> SendSoundMessageWithAEC(const std::string& AgentId, const std::vector<int16_t>& InputData, const std::vector<int16_t>& OutputData);
 		virtual std::shared_ptr<CustomEvent> SendCustomEvent(std::string AgentId, const std::string& Name, const std::unordered_map<std::string, std::string>& Params);
 		
@@ -84,11 +121,16 @@ namespace Inworld
 		
 		ConnectionState GetConnectionState() const { return _ConnectionState; }
 		bool GetConnectionError(std::string& OutErrorMessage, int32_t& OutErrorCode) const;
+		const ReconnectStats& GetReconnectStats() const { return _ReconnectStats; }
+		// Safe to call from any thread.
+		TransportStats GetTransportStats() const;
 		
 		virtual void Update() {}
 
 		void SetPerceivedLatencyTrackerCallback(PerceivedLatencyCallback Cb) { _LatencyTracker.SetCallback(Cb); }
 		void ClearPerceivedLatencyTrackerCallback() { _LatencyTracker.ClearCallback(); }
+		PerceivedLatencySnapshot GetPerceivedLatencySnapshot() const { return _LatencyTracker.GetSnapshot(); }
+		const PerceivedLatencyTracker& GetPerceivedLatencyTracker() const { return _LatencyTracker; }
 		
 		const SessionInfo& GetSessionInfo() const;
 		void SetOptions(const ClientOptions& options);		
@@ -104,12 +146,14 @@ namespace Inworld
 			_AsyncLoadSceneTask = std::make_unique<TAsyncRoutine>();
 			_AsyncGenerateTokenTask = std::make_unique<TAsyncRoutine>();
 			_AsyncGetSessionState = std::make_unique<TAsyncRoutine>();
+			_AsyncSessionSnapshotTask = std::make_unique<TAsyncRoutine>();
 #ifdef  INWORLD_AUDIO_DUMP
 			_AsyncAudioDumper = std::make_unique<TAsyncRoutine>();
 #endif			
 		}
 		std::function<void(std::shared_ptr<Inworld::Packet>)> _OnPacketCallback;
 		std::unique_ptr<IAsyncRoutine> _AsyncLoadSceneTask;
+		void StartReplay();
 		void StartReaderWriter();
 		void StopReaderWriter();
 		void SetConnectionState(ConnectionState State);
@@ -119,9 +163,16 @@ namespace Inworld
 		std::string _ClientVer;
 	private:
 		void LoadScene();
+		void LoadSessionSnapshot();
+		// The scene is loaded once the token and the snapshot, if any, are there.
+		void OnSceneLoadStepDone(uint32_t Generation);
+		SessionSnapshotStore GetSessionSnapshotStore() const;
 		void OnSceneLoaded(const grpc::Status& Status, const InworldEngine::LoadSceneResponse& Response);		
 		void TryToStartReadTask();
 		void TryToStartWriteTask();
+		// Keeps the session id, the token is swapped on the open channel.
+		void RefreshToken();
+		bool IsTokenExpiring() const;
 
 #ifdef INWORLD_AUDIO_DUMP
 		std::unique_ptr<IAsyncRoutine> _AsyncAudioDumper;
@@ -135,18 +186,37 @@ namespace Inworld
 		std::function<void(ConnectionState)> _OnConnectionStateChangedCallback;
 
 		std::unique_ptr<ReaderWriter> _ReaderWriter;
+		// _ReaderWriter when replaying, SetOptions may change the replay path during the session.
+		ReplayReaderWriter* _ReplayReaderWriter = nullptr;
 		std::atomic<bool> _bHasReaderWriterFinished = false;
 
 		std::unique_ptr<IAsyncRoutine> _AsyncReadTask;
 		std::unique_ptr<IAsyncRoutine> _AsyncWriteTask;
 		std::unique_ptr<IAsyncRoutine> _AsyncGenerateTokenTask;		
 		std::unique_ptr<IAsyncRoutine> _AsyncGetSessionState;
+		std::unique_ptr<IAsyncRoutine> _AsyncSessionSnapshotTask;
+
+		uint32_t _StartGeneration = 0;
+		uint32_t _PendingSceneLoadSteps = 0;
+		std::chrono::steady_clock::time_point _StartTime;
 
 		PacketQueue _IncomingPackets;
 		PacketQueue _OutgoingPackets;
+		TransportCounters _ReceivedCounters { "received" };
+		TransportCounters _SentCounters { "sent" };
+		PacketRecorder _PacketRecorder;
+		MetricsRegistry::Counter _AudioChunksSentMetric = GetMetricsRegistry().RegisterCounter("inworld.audio.sent.chunks");
+		MetricsRegistry::Counter _AudioBytesSentMetric = GetMetricsRegistry().RegisterCounter("inworld.audio.sent.bytes");
 
 		std::atomic<bool> _bPendingIncomingPacketFlush = false;
 
+		static PacketReplayBuffer<std::shared_ptr<Inworld::Packet>>::Settings SentPacketReplaySettings();
+		PacketReplayBuffer<std::shared_ptr<Inworld::Packet>> _SentPackets { SentPacketReplaySettings() };
+		bool _bRefreshingToken = false;
+		bool _bMeasuringReconnect = false;
+		std::chrono::steady_clock::time_point _DisconnectTime;
+		ReconnectStats _ReconnectStats;
+
 		ConnectionState _ConnectionState = ConnectionState::Idle;
 		std::string _ErrorMessage = std::string();
 		int32_t _ErrorCode = grpc::StatusCode::OK;
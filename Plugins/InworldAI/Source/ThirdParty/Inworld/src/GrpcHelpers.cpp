@@ -6,9 +6,71 @@
  */
 
 #include "GrpcHelpers.h"
+#include "Utils/Utils.h"
+#include "Utils/Log.h"
+
+#include <mutex>
+#include <unordered_map>
+#include "grpcpp/create_channel.h"
+#include "grpcpp/security/credentials.h"
 
 Inworld::GrpcHelper::CharacterInfo Inworld::GrpcHelper::CreateCharacterInfo(const InworldV1alpha::Character& GrpcCharacter)
 {
 	Inworld::GrpcHelper::CharacterInfo Info(GrpcCharacter);
 	return Info;
 }
+
+std::shared_ptr<grpc::ChannelCredentials> Inworld::GrpcHelper::GetSslCredentials()
+{
+	static std::mutex Mutex;
+	static std::shared_ptr<grpc::ChannelCredentials> Credentials;
+	static Utils::SslRootCertsSource CredentialsSource = Utils::SslRootCertsSource::Bundled;
+
+	const Utils::SslRootCertsSource Source = Utils::GetSslRootCertsSource();
+
+	std::lock_guard<std::mutex> Lock(Mutex);
+	if (Credentials && CredentialsSource == Source)
+	{
+		return Credentials;
+	}
+
+	grpc::SslCredentialsOptions SslCredentialsOptions;
+	if (Source == Utils::SslRootCertsSource::System)
+	{
+		SslCredentialsOptions.pem_root_certs = Utils::LoadSystemSslRootCerts();
+		if (SslCredentialsOptions.pem_root_certs.empty())
+		{
+			Inworld::LogWarning("System SSL root certificates not found, using bundled ones");
+		}
+	}
+	if (SslCredentialsOptions.pem_root_certs.empty())
+	{
+		SslCredentialsOptions.pem_root_certs = Utils::GetSslRootCerts();
+	}
+
+	Credentials = grpc::SslCredentials(SslCredentialsOptions);
+	CredentialsSource = Source;
+	return Credentials;
+}
+
+std::shared_ptr<grpc::Channel> Inworld::GrpcHelper::GetChannel(const std::string& ServerUrl)
+{
+	struct CachedChannel
+	{
+		std::shared_ptr<grpc::Channel> Channel;
+		std::shared_ptr<grpc::ChannelCredentials> Credentials;
+	};
+	static std::mutex Mutex;
+	static std::unordered_map<std::string, CachedChannel> Channels;
+
+	const std::shared_ptr<grpc::ChannelCredentials> Credentials = GetSslCredentials();
+
+	std::lock_guard<std::mutex> Lock(Mutex);
+	CachedChannel& Cached = Channels[ServerUrl];
+	if (!Cached.Channel || Cached.Credentials != Credentials)
+	{
+		Cached.Channel = grpc::CreateChannel(ServerUrl, Credentials);
+		Cached.Credentials = Credentials;
+	}
+	return Cached.Channel;
+}
@@ -10,8 +10,15 @@
 #include "ai/inworld/studio/v1alpha/characters.pb.h"
 
 #include <string>
+#include <memory>
 #include "Define.h"
 
+namespace grpc
+{
+	class Channel;
+	class ChannelCredentials;
+}
+
 namespace InworldV1alpha = ai::inworld::studio::v1alpha;
 
 namespace Inworld
@@ -41,6 +48,12 @@ namespace Inworld
 		};
 
 		INWORLD_EXPORT CharacterInfo CreateCharacterInfo(const InworldV1alpha::Character& GrpcCharacter);
-		
+
+		// Shared by all channels, rebuilt only when the root certificates source changes.
+		INWORLD_EXPORT std::shared_ptr<grpc::ChannelCredentials> GetSslCredentials();
+
+		// One channel per server, so requests after the first one skip the connection and TLS handshake.
+		INWORLD_EXPORT std::shared_ptr<grpc::Channel> GetChannel(const std::string& ServerUrl);
+
 	}
 }
\ No newline at end of file
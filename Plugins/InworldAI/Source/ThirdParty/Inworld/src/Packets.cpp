@@ -31,6 +31,18 @@ namespace Inworld {
         return Result;
     }
 
+    std::chrono::system_clock::time_point TimestampFromProto(const google::protobuf_inworld::Timestamp& Timestamp)
+    {
+        const auto SinceEpoch = std::chrono::seconds(Timestamp.seconds()) + std::chrono::nanoseconds(Timestamp.nanos());
+        return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(SinceEpoch));
+    }
+
+    google::protobuf_inworld::Timestamp TimestampToProto(std::chrono::system_clock::time_point Timestamp)
+    {
+        const auto SinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(Timestamp.time_since_epoch()).count();
+        return ::google::protobuf_inworld::util::TimeUtil::NanosecondsToTimestamp(SinceEpoch);
+    }
+
     InworldPakets::Actor Actor::ToProto() const
     {
         InworldPakets::Actor actor;
@@ -65,8 +77,7 @@ namespace Inworld {
         InworldPakets::InworldPacket Proto;
         *Proto.mutable_packet_id() = _PacketId.ToProto();
         *Proto.mutable_routing() = _Routing.ToProto();
-        *Proto.mutable_timestamp() = 
-            ::google::protobuf_inworld::util::TimeUtil::TimeTToTimestamp(std::chrono::duration_cast<std::chrono::seconds>(_Timestamp.time_since_epoch()).count());
+        *Proto.mutable_timestamp() = TimestampToProto(_Timestamp);
         ToProtoInternal(Proto);
         return Proto;
     }
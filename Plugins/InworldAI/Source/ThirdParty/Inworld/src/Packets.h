@@ -17,6 +17,7 @@
 #include <vector>
 #include <unordered_map>
 #include <chrono>
+#include <memory>
 
 namespace InworldPakets = ai::inworld::packets;
 
@@ -118,6 +119,10 @@ namespace Inworld {
 
 	struct EmotionalState;
 
+	// Protobuf timestamps carry nanoseconds, conversions keep the full precision of the system clock.
+	INWORLD_EXPORT std::chrono::system_clock::time_point TimestampFromProto(const google::protobuf_inworld::Timestamp& Timestamp);
+	INWORLD_EXPORT google::protobuf_inworld::Timestamp TimestampToProto(std::chrono::system_clock::time_point Timestamp);
+
 	// Base class for all Inworld protocol packets
 	class INWORLD_EXPORT Packet
     {
@@ -126,7 +131,7 @@ namespace Inworld {
 		Packet(const InworldPakets::InworldPacket& GrpcPacket) 
 			: _PacketId(GrpcPacket.packet_id())
 			, _Routing(GrpcPacket.routing())
-			, _Timestamp(std::chrono::system_clock::time_point(std::chrono::seconds(google::protobuf_inworld::util::TimeUtil::TimestampToTimeT(GrpcPacket.timestamp()))))
+			, _Timestamp(TimestampFromProto(GrpcPacket.timestamp()))
 		{}
         Packet(const Routing& Routing) 
 			: _Routing(Routing)
@@ -145,7 +150,29 @@ namespace Inworld {
 	public:
         PacketId _PacketId;
         Routing _Routing;
+		// Wall clock time set by the sender, nanosecond precision.
 		std::chrono::system_clock::time_point _Timestamp = std::chrono::system_clock::now();
+		// Local monotonic time the packet was created or received, never sent.
+		std::chrono::steady_clock::time_point _LocalTimestamp = std::chrono::steady_clock::now();
+	};
+
+	// Strict weak ordering of packets by sender timestamp.
+	// Packets with equal timestamps are ordered by local monotonic arrival time.
+	struct INWORLD_EXPORT PacketTimestampOrder
+	{
+		bool operator()(const Packet& A, const Packet& B) const
+		{
+			if (A._Timestamp != B._Timestamp)
+			{
+				return A._Timestamp < B._Timestamp;
+			}
+			return A._LocalTimestamp < B._LocalTimestamp;
+		}
+
+		bool operator()(const std::shared_ptr<Packet>& A, const std::shared_ptr<Packet>& B) const
+		{
+			return (*this)(*A, *B);
+		}
 	};
 
 	class INWORLD_EXPORT TextEvent : public Packet
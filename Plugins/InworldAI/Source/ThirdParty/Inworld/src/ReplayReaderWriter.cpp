@@ -0,0 +1,99 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#include "ReplayReaderWriter.h"
+#include "Utils/Log.h"
+
+bool Inworld::ReplayReaderWriter::Open(const std::string& Path, InworldEngine::LoadSceneResponse* OutScene)
+{
+	if (!_Reader.Open(Path))
+	{
+		return false;
+	}
+
+	// The stream opens once the scene is loaded, replay time is counted from there.
+	_bPending = _Reader.Next(_Pending);
+	if (_bPending && _Pending.Kind == RecordedPacketKind::Scene)
+	{
+		_Origin = _Pending.Time;
+		if (OutScene && !OutScene->ParseFromString(_Pending.Data))
+		{
+			Inworld::LogError("ReplayReaderWriter. Can't parse the scene of %s", ARG_STR(Path));
+			return false;
+		}
+		_bPending = false;
+	}
+
+	_Start = std::chrono::steady_clock::now();
+	return true;
+}
+
+void Inworld::ReplayReaderWriter::Cancel()
+{
+	{
+		std::lock_guard<std::mutex> Lock(_Mutex);
+		_bCancelled = true;
+	}
+	_CancelCondition.notify_all();
+}
+
+grpc::Status Inworld::ReplayReaderWriter::Finish()
+{
+	std::lock_guard<std::mutex> Lock(_Mutex);
+	return _bCancelled ? grpc::Status::CANCELLED : grpc::Status(grpc::StatusCode::OUT_OF_RANGE, "Packet recording replayed");
+}
+
+bool Inworld::ReplayReaderWriter::NextMessageSize(uint32_t* Size)
+{
+	*Size = static_cast<uint32_t>(_bPending ? _Pending.Data.size() : 64 * 1024 * 1024);
+	return true;
+}
+
+bool Inworld::ReplayReaderWriter::Read(InworldPackets::InworldPacket* Packet)
+{
+	while (true)
+	{
+		if (!_bPending && !_Reader.Next(_Pending))
+		{
+			return false;
+		}
+		_bPending = false;
+
+		if (_Pending.Kind != RecordedPacketKind::Incoming)
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> Lock(_Mutex);
+		if (_Speed > 0.f)
+		{
+			const auto SinceOrigin = std::chrono::duration<double, std::micro>(_Pending.Time - _Origin) / _Speed;
+			const auto Due = _Start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(SinceOrigin);
+			_CancelCondition.wait_until(Lock, Due, [this]() { return _bCancelled; });
+		}
+		if (_bCancelled)
+		{
+			return false;
+		}
+		Lock.unlock();
+
+		if (!Packet->ParseFromString(_Pending.Data))
+		{
+			Inworld::LogError("ReplayReaderWriter. Can't parse a recorded packet");
+			return false;
+		}
+		_NumRead.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+}
+
+bool Inworld::ReplayReaderWriter::Write(const InworldPackets::InworldPacket& Packet, grpc::WriteOptions Options)
+{
+	_NumWritten.fetch_add(1, std::memory_order_relaxed);
+	std::lock_guard<std::mutex> Lock(_Mutex);
+	return !_bCancelled;
+}
@@ -0,0 +1,58 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#pragma once
+
+#include "RunnableCommand.h"
+#include "Utils/PacketRecording.h"
+
+#include <condition_variable>
+
+namespace Inworld
+{
+	// Session stream fed from a packet recording instead of the network, for RunnableRead and RunnableWrite.
+	// Incoming packets are read back at their recorded time divided by Speed, counted from the scene load,
+	// or as fast as they are read with a Speed of 0. Outgoing packets of the recording are skipped,
+	// packets written are accepted and counted.
+	class INWORLD_EXPORT ReplayReaderWriter : public ReaderWriter
+	{
+	public:
+		explicit ReplayReaderWriter(float InSpeed = 1.f) : _Speed(InSpeed) {}
+		virtual ~ReplayReaderWriter() = default;
+
+		// Replay time starts now. OutScene is left empty when the recording has no scene.
+		bool Open(const std::string& Path, InworldEngine::LoadSceneResponse* OutScene = nullptr);
+		// Wakes up a pending Read, which then fails.
+		void Cancel();
+
+		uint64_t GetNumRead() const { return _NumRead.load(std::memory_order_relaxed); }
+		uint64_t GetNumWritten() const { return _NumWritten.load(std::memory_order_relaxed); }
+
+		virtual void WaitForInitialMetadata() override {}
+		virtual bool WritesDone() override { return true; }
+		virtual grpc::Status Finish() override;
+		virtual bool NextMessageSize(uint32_t* Size) override;
+		virtual bool Read(InworldPackets::InworldPacket* Packet) override;
+		using ReaderWriter::Write;
+		virtual bool Write(const InworldPackets::InworldPacket& Packet, grpc::WriteOptions Options) override;
+
+	private:
+		const float _Speed;
+		PacketRecordingReader _Reader;
+		RecordedPacket _Pending;
+		bool _bPending = false;
+		std::chrono::microseconds _Origin { 0 };
+		std::chrono::steady_clock::time_point _Start;
+
+		std::mutex _Mutex;
+		std::condition_variable _CancelCondition;
+		bool _bCancelled = false;
+
+		std::atomic<uint64_t> _NumRead = 0;
+		std::atomic<uint64_t> _NumWritten = 0;
+	};
+}
@@ -38,6 +38,15 @@ void Inworld::RunnableRead::Run()
 			return;
 		}
 
+		if (_Counters)
+		{
+			_Counters->Add(IncomingPacket.ByteSizeLong());
+		}
+		if (_Recorder)
+		{
+			_Recorder->Record(RecordedPacketKind::Incoming, IncomingPacket);
+		}
+
 		std::shared_ptr<Inworld::Packet> Packet;
 		// Text event
 		if (IncomingPacket.has_text())
@@ -75,6 +84,10 @@ void Inworld::RunnableRead::Run()
 		}
 
 		_Packets.PushBack(Packet);
+		if (_Counters)
+		{
+			_Counters->SetQueueDepth(_Packets.Size());
+		}
 
 		_ProcessedCallback(Packet);
 	}
@@ -103,6 +116,16 @@ void Inworld::RunnableWrite::Run()
 
 		_Packets.PopFront();
 
+		if (_Counters)
+		{
+			_Counters->Add(Event.ByteSizeLong());
+			_Counters->SetQueueDepth(_Packets.Size());
+		}
+		if (_Recorder)
+		{
+			_Recorder->Record(RecordedPacketKind::Outgoing, Event);
+		}
+
 		_ProcessedCallback(Packet);
 	}
 
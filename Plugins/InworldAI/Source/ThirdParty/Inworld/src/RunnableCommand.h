@@ -27,6 +27,9 @@
 #include "grpc-stub/platform-public/src/main/proto/ai/inworld/engine/v1/state_serialization.grpc.pb.h"
 
 #include "Utils/Utils.h"
+#include "Utils/MetricsRegistry.h"
+#include "Utils/PacketRecording.h"
+#include "GrpcHelpers.h"
 #include "Utils/SharedQueue.h"
 #include "Define.h"
 #include "Packets.h"
@@ -46,7 +49,8 @@ using grpc::Status;
 
 namespace Inworld
 {
-	using ReaderWriter = ::grpc::ClientReaderWriter< InworldPackets::InworldPacket, InworldPackets::InworldPacket>;
+	// The session stream, or a recording of one replayed, see ReplayReaderWriter.
+	using ReaderWriter = ::grpc::ClientReaderWriterInterface< InworldPackets::InworldPacket, InworldPackets::InworldPacket>;
 
 	class INWORLD_EXPORT Runnable
 	{
@@ -63,15 +67,46 @@ namespace Inworld
 		std::atomic<bool> _IsDone = false;
 	};
 
+	// Packets and serialized bytes through one direction of the stream. Written by its task, read from anywhere.
+	// Also published to the metrics registry as inworld.transport.<Direction>.packets, .bytes and .queue, summed over clients.
+	struct TransportCounters
+	{
+		explicit TransportCounters(const std::string& Direction)
+			: PacketsMetric(GetMetricsRegistry().RegisterCounter("inworld.transport." + Direction + ".packets"))
+			, BytesMetric(GetMetricsRegistry().RegisterCounter("inworld.transport." + Direction + ".bytes"))
+			, QueueMetric(GetMetricsRegistry().RegisterGauge("inworld.transport." + Direction + ".queue"))
+		{}
+
+		std::atomic<uint64_t> Packets = 0;
+		std::atomic<uint64_t> Bytes = 0;
+
+		void Add(size_t Size)
+		{
+			Packets.fetch_add(1, std::memory_order_relaxed);
+			Bytes.fetch_add(Size, std::memory_order_relaxed);
+			PacketsMetric.Add();
+			BytesMetric.Add(Size);
+		}
+
+		// Packets waiting in the queue of this direction.
+		void SetQueueDepth(size_t Depth) { QueueMetric.Set(static_cast<int64_t>(Depth)); }
+
+		MetricsRegistry::Counter PacketsMetric;
+		MetricsRegistry::Counter BytesMetric;
+		MetricsRegistry::Gauge QueueMetric;
+	};
+
 	class INWORLD_EXPORT RunnableMessaging : public Runnable
 	{
 	public:
-		RunnableMessaging(ReaderWriter& ReaderWriter, std::atomic<bool>& bInHasReaderWriterFinished, SharedQueue<std::shared_ptr<Inworld::Packet>>& Packets, std::function<void(const std::shared_ptr<Inworld::Packet>)> ProcessedCallback = nullptr, std::function<void(const grpc::Status&)> InErrorCallback = nullptr)
+		RunnableMessaging(ReaderWriter& ReaderWriter, std::atomic<bool>& bInHasReaderWriterFinished, SharedQueue<std::shared_ptr<Inworld::Packet>>& Packets, std::function<void(const std::shared_ptr<Inworld::Packet>)> ProcessedCallback = nullptr, std::function<void(const grpc::Status&)> InErrorCallback = nullptr, TransportCounters* InCounters = nullptr, PacketRecorder* InRecorder = nullptr)
 			: _ReaderWriter(ReaderWriter)
 			, _HasReaderWriterFinished(bInHasReaderWriterFinished)
 			, _Packets(Packets)
 			, _ProcessedCallback(ProcessedCallback)
 			, _ErrorCallback(InErrorCallback)
+			, _Counters(InCounters)
+			, _Recorder(InRecorder)
 		{}
 		virtual ~RunnableMessaging() = default;
 
@@ -82,13 +117,15 @@ namespace Inworld
 		SharedQueue<std::shared_ptr<Inworld::Packet>>& _Packets;
 		std::function<void(const std::shared_ptr<Inworld::Packet>)> _ProcessedCallback;
 		std::function<void(const grpc::Status&)> _ErrorCallback;
+		TransportCounters* _Counters;
+		PacketRecorder* _Recorder;
 	};
 
 	class INWORLD_EXPORT RunnableRead : public RunnableMessaging
 	{
 	public:
-		RunnableRead(ReaderWriter& ReaderWriter, std::atomic<bool>& bHasReaderWriterFinished, SharedQueue<std::shared_ptr<Inworld::Packet>>& Packets, std::function<void(const std::shared_ptr<Inworld::Packet>)> ProcessedCallback = nullptr, std::function<void(const grpc::Status&)> ErrorCallback = nullptr)
-			: RunnableMessaging(ReaderWriter, bHasReaderWriterFinished, Packets, ProcessedCallback, ErrorCallback)
+		RunnableRead(ReaderWriter& ReaderWriter, std::atomic<bool>& bHasReaderWriterFinished, SharedQueue<std::shared_ptr<Inworld::Packet>>& Packets, std::function<void(const std::shared_ptr<Inworld::Packet>)> ProcessedCallback = nullptr, std::function<void(const grpc::Status&)> ErrorCallback = nullptr, TransportCounters* Counters = nullptr, PacketRecorder* Recorder = nullptr)
+			: RunnableMessaging(ReaderWriter, bHasReaderWriterFinished, Packets, ProcessedCallback, ErrorCallback, Counters, Recorder)
 		{}
 		virtual ~RunnableRead() = default;
 
@@ -98,8 +135,8 @@ namespace Inworld
 	class INWORLD_EXPORT RunnableWrite : public RunnableMessaging
 	{
 	public:
-		RunnableWrite(ReaderWriter& ReaderWriter, std::atomic<bool>& bHasReaderWriterFinished, SharedQueue<std::shared_ptr<Inworld::Packet>>& Packets, std::function<void(const std::shared_ptr<Inworld::Packet>)> ProcessedCallback = nullptr, std::function<void(const grpc::Status&)> ErrorCallback = nullptr)
-			: RunnableMessaging(ReaderWriter, bHasReaderWriterFinished, Packets, ProcessedCallback, ErrorCallback)
+		RunnableWrite(ReaderWriter& ReaderWriter, std::atomic<bool>& bHasReaderWriterFinished, SharedQueue<std::shared_ptr<Inworld::Packet>>& Packets, std::function<void(const std::shared_ptr<Inworld::Packet>)> ProcessedCallback = nullptr, std::function<void(const grpc::Status&)> ErrorCallback = nullptr, TransportCounters* Counters = nullptr, PacketRecorder* Recorder = nullptr)
+			: RunnableMessaging(ReaderWriter, bHasReaderWriterFinished, Packets, ProcessedCallback, ErrorCallback, Counters, Recorder)
 		{}
 		virtual ~RunnableWrite() = default;
 
@@ -151,9 +188,7 @@ namespace Inworld
 
 		std::unique_ptr<typename TService::Stub>& CreateStub()
 		{
-            grpc::SslCredentialsOptions SslCredentialsOptions;
-            SslCredentialsOptions.pem_root_certs = Utils::GetSslRootCerts();
-			_Stub = TService::NewStub(grpc::CreateChannel(_ServerUrl, grpc::SslCredentials(SslCredentialsOptions)));
+			_Stub = TService::NewStub(GrpcHelper::GetChannel(_ServerUrl));
 			return _Stub;
 		}
 
@@ -0,0 +1,705 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#include "Studio.h"
+#include "GrpcHelpers.h"
+#include "Utils/Log.h"
+
+#include <unordered_set>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include "grpcpp/create_channel.h"
+#include "ai/inworld/studio/v1alpha/users.grpc.pb.h"
+#include "ai/inworld/studio/v1alpha/workspaces.grpc.pb.h"
+#include "ai/inworld/studio/v1alpha/scenes.grpc.pb.h"
+#include "ai/inworld/studio/v1alpha/characters.grpc.pb.h"
+#include "ai/inworld/studio/v1alpha/apikeys.grpc.pb.h"
+
+struct Inworld::GrpcStudioService::Stubs
+{
+	std::unique_ptr<InworldV1alpha::Users::Stub> _Users;
+	std::unique_ptr<InworldV1alpha::Workspaces::Stub> _Workspaces;
+	std::unique_ptr<InworldV1alpha::Scenes::Stub> _Scenes;
+	std::unique_ptr<InworldV1alpha::Characters::Stub> _Characters;
+	std::unique_ptr<InworldV1alpha::ApiKeys::Stub> _ApiKeys;
+
+	std::mutex _ContextsMutex;
+	std::unordered_set<grpc::ClientContext*> _Contexts;
+
+	template<typename TCall>
+	grpc::Status Call(const std::string& BearerType, const std::string& Token, TCall Rpc)
+	{
+		grpc::ClientContext Context;
+		Context.AddMetadata("x-authorization-bearer-type", BearerType);
+		Context.AddMetadata("authorization", std::string("Bearer ") + Token);
+
+		{
+			std::lock_guard<std::mutex> Lock(_ContextsMutex);
+			_Contexts.insert(&Context);
+		}
+
+		grpc::Status Status = Rpc(&Context);
+
+		std::lock_guard<std::mutex> Lock(_ContextsMutex);
+		_Contexts.erase(&Context);
+		return Status;
+	}
+};
+
+Inworld::GrpcStudioService::GrpcStudioService(const std::string& ServerUrl)
+	: _Stubs(std::make_unique<Stubs>())
+{
+	// All stubs share a single channel, requests are multiplexed over one connection.
+	auto Channel = grpc::CreateChannel(ServerUrl, GrpcHelper::GetSslCredentials());
+	_Stubs->_Users = InworldV1alpha::Users::NewStub(Channel);
+	_Stubs->_Workspaces = InworldV1alpha::Workspaces::NewStub(Channel);
+	_Stubs->_Scenes = InworldV1alpha::Scenes::NewStub(Channel);
+	_Stubs->_Characters = InworldV1alpha::Characters::NewStub(Channel);
+	_Stubs->_ApiKeys = InworldV1alpha::ApiKeys::NewStub(Channel);
+}
+
+Inworld::GrpcStudioService::~GrpcStudioService() = default;
+
+grpc::Status Inworld::GrpcStudioService::GenerateUserToken(const std::string& ExchangeToken, InworldV1alpha::GenerateTokenUserResponse& Response)
+{
+	InworldV1alpha::GenerateTokenUserRequest Request;
+	Request.set_type(InworldV1alpha::AuthType::AUTH_TYPE_FIREBASE);
+	Request.set_token(ExchangeToken);
+
+	return _Stubs->Call("firebase", ExchangeToken, [&](grpc::ClientContext* Context)
+		{
+			return _Stubs->_Users->GenerateTokenUser(Context, Request, &Response);
+		});
+}
+
+grpc::Status Inworld::GrpcStudioService::ListWorkspaces(const std::string& Token, const std::string& PageToken, InworldV1alpha::ListWorkspacesResponse& Response)
+{
+	InworldV1alpha::ListWorkspacesRequest Request;
+	Request.set_page_token(PageToken);
+
+	return _Stubs->Call("inworld", Token, [&](grpc::ClientContext* Context)
+		{
+			return _Stubs->_Workspaces->ListWorkspaces(Context, Request, &Response);
+		});
+}
+
+grpc::Status Inworld::GrpcStudioService::ListScenes(const std::string& Token, const std::string& Workspace, const std::string& PageToken, InworldV1alpha::ListScenesResponse& Response)
+{
+	InworldV1alpha::ListScenesRequest Request;
+	Request.set_parent(Workspace);
+	Request.set_page_token(PageToken);
+
+	return _Stubs->Call("inworld", Token, [&](grpc::ClientContext* Context)
+		{
+			return _Stubs->_Scenes->ListScenes(Context, Request, &Response);
+		});
+}
+
+grpc::Status Inworld::GrpcStudioService::ListCharacters(const std::string& Token, const std::string& Workspace, const std::string& PageToken, InworldV1alpha::ListCharactersResponse& Response)
+{
+	InworldV1alpha::ListCharactersRequest Request;
+	Request.set_parent(Workspace);
+	Request.set_view(InworldV1alpha::CharacterView::CHARACTER_VIEW_DEFAULT);
+	Request.set_page_token(PageToken);
+
+	return _Stubs->Call("inworld", Token, [&](grpc::ClientContext* Context)
+		{
+			return _Stubs->_Characters->ListCharacters(Context, Request, &Response);
+		});
+}
+
+grpc::Status Inworld::GrpcStudioService::ListApiKeys(const std::string& Token, const std::string& Workspace, const std::string& PageToken, InworldV1alpha::ListApiKeysResponse& Response)
+{
+	InworldV1alpha::ListApiKeysRequest Request;
+	Request.set_parent(Workspace);
+	Request.set_page_token(PageToken);
+
+	return _Stubs->Call("inworld", Token, [&](grpc::ClientContext* Context)
+		{
+			return _Stubs->_ApiKeys->ListApiKeys(Context, Request, &Response);
+		});
+}
+
+void Inworld::GrpcStudioService::Cancel()
+{
+	std::lock_guard<std::mutex> Lock(_Stubs->_ContextsMutex);
+	for (auto* Context : _Stubs->_Contexts)
+	{
+		Context->TryCancel();
+	}
+}
+
+Inworld::TaskPool::TaskPool(uint32_t NumThreads)
+{
+	NumThreads = NumThreads == 0 ? 1 : NumThreads;
+	_Threads.reserve(NumThreads);
+	for (uint32_t i = 0; i < NumThreads; i++)
+	{
+		_Threads.emplace_back(&TaskPool::Work, this);
+	}
+}
+
+Inworld::TaskPool::~TaskPool()
+{
+	Stop();
+}
+
+void Inworld::TaskPool::Push(std::function<void()> Task)
+{
+	{
+		std::lock_guard<std::mutex> Lock(_Mutex);
+		if (_bStopped)
+		{
+			return;
+		}
+		_Tasks.emplace_back(std::move(Task));
+	}
+	_Condition.notify_one();
+}
+
+void Inworld::TaskPool::Clear()
+{
+	std::lock_guard<std::mutex> Lock(_Mutex);
+	_Tasks.clear();
+	if (_RunningTasks == 0)
+	{
+		_IdleCondition.notify_all();
+	}
+}
+
+void Inworld::TaskPool::Wait()
+{
+	std::unique_lock<std::mutex> Lock(_Mutex);
+	_IdleCondition.wait(Lock, [this]() { return _Tasks.empty() && _RunningTasks == 0; });
+}
+
+void Inworld::TaskPool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> Lock(_Mutex);
+		_bStopped = true;
+		_Tasks.clear();
+	}
+	_Condition.notify_all();
+
+	for (auto& Thread : _Threads)
+	{
+		if (Thread.joinable())
+		{
+			Thread.join();
+		}
+	}
+	_Threads.clear();
+}
+
+void Inworld::TaskPool::Work()
+{
+	while (true)
+	{
+		std::function<void()> Task;
+		{
+			std::unique_lock<std::mutex> Lock(_Mutex);
+			_Condition.wait(Lock, [this]() { return _bStopped || !_Tasks.empty(); });
+			if (_bStopped)
+			{
+				return;
+			}
+			Task = std::move(_Tasks.front());
+			_Tasks.pop_front();
+			_RunningTasks++;
+		}
+
+		Task();
+
+		std::lock_guard<std::mutex> Lock(_Mutex);
+		_RunningTasks--;
+		if (_RunningTasks == 0 && _Tasks.empty())
+		{
+			_IdleCondition.notify_all();
+		}
+	}
+}
+
+Inworld::StudioFetcher::StudioFetcher(std::shared_ptr<StudioService> Service, uint32_t MaxConcurrentRequests)
+	: _Service(Service)
+	, _Pool(MaxConcurrentRequests)
+{}
+
+Inworld::StudioFetcher::~StudioFetcher()
+{
+	Cancel();
+	// Tasks reference members declared after the pool.
+	_Pool.Stop();
+}
+
+void Inworld::StudioFetcher::Fetch(const std::string& ExchangeToken, FetchCallback Callback)
+{
+	Cancel();
+
+	auto State = std::make_shared<FetchState>();
+	State->ExchangeToken = ExchangeToken;
+	State->Callback = Callback;
+	{
+		std::lock_guard<std::mutex> Lock(_FinishMutex);
+		State->Generation = ++_Generation;
+		_bInProgress = true;
+	}
+
+	_Pool.Push([this, State]() { FetchWorkspaces(State); });
+}
+
+void Inworld::StudioFetcher::Cancel()
+{
+	{
+		std::lock_guard<std::mutex> Lock(_FinishMutex);
+		if (!_bInProgress)
+		{
+			return;
+		}
+		++_Generation;
+		_bInProgress = false;
+	}
+
+	_Pool.Clear();
+	_Service->Cancel();
+}
+
+template<typename TResponse, typename TCall, typename TAppend>
+grpc::Status Inworld::StudioFetcher::FetchAllPages(const FetchState& State, TCall Call, TAppend Append)
+{
+	std::string PageToken;
+	do
+	{
+		if (IsCancelled(State))
+		{
+			return grpc::Status(grpc::StatusCode::CANCELLED, "Cancelled");
+		}
+
+		TResponse Response;
+		grpc::Status Status = Call(PageToken, Response);
+		if (!Status.ok())
+		{
+			return Status;
+		}
+
+		Append(Response);
+
+		if (Response.next_page_token() == PageToken)
+		{
+			Inworld::LogWarning("StudioFetcher. Page token repeated, stop paging: %s", ARG_STR(PageToken));
+			break;
+		}
+		PageToken = Response.next_page_token();
+	} while (!PageToken.empty());
+
+	return grpc::Status();
+}
+
+static std::string StatusToString(const char* Request, const grpc::Status& Status)
+{
+	return std::string(Request) + " FALURE! " + Status.error_message() + ", Code: " + std::to_string(static_cast<int32_t>(Status.error_code()));
+}
+
+void Inworld::StudioFetcher::FetchWorkspaces(const std::shared_ptr<FetchState>& State)
+{
+	InworldV1alpha::GenerateTokenUserResponse TokenResponse;
+	grpc::Status Status = _Service->GenerateUserToken(State->ExchangeToken, TokenResponse);
+	if (!Status.ok())
+	{
+		Finish(*State, false, StatusToString("GenerateUserToken", Status));
+		return;
+	}
+	State->Token = TokenResponse.token();
+
+	Status = FetchAllPages<InworldV1alpha::ListWorkspacesResponse>(*State,
+		[this, &State](const std::string& PageToken, InworldV1alpha::ListWorkspacesResponse& Response)
+		{
+			return _Service->ListWorkspaces(State->Token, PageToken, Response);
+		},
+		[&State](const InworldV1alpha::ListWorkspacesResponse& Response)
+		{
+			for (const auto& Workspace : Response.workspaces())
+			{
+				State->Data._Workspaces.emplace_back();
+				State->Data._Workspaces.back()._Name = Workspace.name();
+			}
+		});
+	if (!Status.ok())
+	{
+		Finish(*State, false, StatusToString("ListWorkspaces", Status));
+		return;
+	}
+
+	if (State->Data._Workspaces.empty())
+	{
+		Finish(*State, true, {});
+		return;
+	}
+
+	// Workspaces vector is not resized from here on, each request writes its own field.
+	constexpr uint32_t RequestsPerWorkspace = 3;
+	State->PendingRequests = static_cast<uint32_t>(State->Data._Workspaces.size()) * RequestsPerWorkspace;
+	for (size_t i = 0; i < State->Data._Workspaces.size(); i++)
+	{
+		FetchWorkspace(State, i);
+	}
+}
+
+void Inworld::StudioFetcher::FetchWorkspace(const std::shared_ptr<FetchState>& State, size_t Idx)
+{
+	auto OnError = [State, Idx](const char* Request, const grpc::Status& Status)
+	{
+		if (Status.ok())
+		{
+			return;
+		}
+
+		auto& Workspace = State->Data._Workspaces[Idx];
+		const std::string Error = StatusToString(Request, Status);
+		Inworld::LogError("StudioFetcher. Workspace %s: %s", ARG_STR(Workspace._Name), ARG_STR(Error));
+
+		std::lock_guard<std::mutex> Lock(State->ErrorMutex);
+		Workspace._Error += Workspace._Error.empty() ? Error : "\n" + Error;
+	};
+
+	_Pool.Push([this, State, Idx, OnError]()
+		{
+			auto& Workspace = State->Data._Workspaces[Idx];
+			OnError("ListScenes", FetchAllPages<InworldV1alpha::ListScenesResponse>(*State,
+				[this, &State, &Workspace](const std::string& PageToken, InworldV1alpha::ListScenesResponse& Response)
+				{
+					return _Service->ListScenes(State->Token, Workspace._Name, PageToken, Response);
+				},
+				[&Workspace](const InworldV1alpha::ListScenesResponse& Response)
+				{
+					Workspace._Scenes.insert(Workspace._Scenes.end(), Response.scenes().begin(), Response.scenes().end());
+				}));
+			OnWorkspaceRequestDone(*State);
+		});
+
+	_Pool.Push([this, State, Idx, OnError]()
+		{
+			auto& Workspace = State->Data._Workspaces[Idx];
+			OnError("ListCharacters", FetchAllPages<InworldV1alpha::ListCharactersResponse>(*State,
+				[this, &State, &Workspace](const std::string& PageToken, InworldV1alpha::ListCharactersResponse& Response)
+				{
+					return _Service->ListCharacters(State->Token, Workspace._Name, PageToken, Response);
+				},
+				[&Workspace](const InworldV1alpha::ListCharactersResponse& Response)
+				{
+					Workspace._Characters.insert(Workspace._Characters.end(), Response.characters().begin(), Response.characters().end());
+				}));
+			OnWorkspaceRequestDone(*State);
+		});
+
+	_Pool.Push([this, State, Idx, OnError]()
+		{
+			auto& Workspace = State->Data._Workspaces[Idx];
+			OnError("ListApiKeys", FetchAllPages<InworldV1alpha::ListApiKeysResponse>(*State,
+				[this, &State, &Workspace](const std::string& PageToken, InworldV1alpha::ListApiKeysResponse& Response)
+				{
+					return _Service->ListApiKeys(State->Token, Workspace._Name, PageToken, Response);
+				},
+				[&Workspace](const InworldV1alpha::ListApiKeysResponse& Response)
+				{
+					Workspace._ApiKeys.insert(Workspace._ApiKeys.end(), Response.api_keys().begin(), Response.api_keys().end());
+				}));
+			OnWorkspaceRequestDone(*State);
+		});
+}
+
+void Inworld::StudioFetcher::OnWorkspaceRequestDone(FetchState& State)
+{
+	if (--State.PendingRequests != 0)
+	{
+		return;
+	}
+
+	std::string Error;
+	for (const auto& Workspace : State.Data._Workspaces)
+	{
+		if (!Workspace._Error.empty())
+		{
+			Error += Error.empty() ? Workspace._Error : "\n" + Workspace._Error;
+		}
+	}
+	// Partial failures are reported along with the data that was fetched.
+	Finish(State, true, Error);
+}
+
+void Inworld::StudioFetcher::Finish(FetchState& State, bool bSuccess, const std::string& Error)
+{
+	{
+		std::lock_guard<std::mutex> Lock(_FinishMutex);
+		if (IsCancelled(State))
+		{
+			return;
+		}
+		_Data = std::move(State.Data);
+		_bInProgress = false;
+	}
+
+	if (State.Callback)
+	{
+		State.Callback(bSuccess, Error);
+	}
+}
+
+namespace
+{
+	constexpr char StudioCacheMagic[4] = { 'I', 'W', 'S', 'C' };
+
+	struct StudioCacheHeader
+	{
+		char Magic[4];
+		uint32_t Version;
+		uint64_t KeyHash;
+		uint64_t PayloadHash;
+		uint64_t PayloadSize;
+	};
+
+	void WriteUInt32(std::string& Out, uint32_t Value)
+	{
+		Out.append(reinterpret_cast<const char*>(&Value), sizeof(Value));
+	}
+
+	void WriteString(std::string& Out, const std::string& Str)
+	{
+		WriteUInt32(Out, static_cast<uint32_t>(Str.size()));
+		Out.append(Str);
+	}
+
+	template<typename TMessage>
+	void WriteMessages(std::string& Out, const std::vector<TMessage>& Messages)
+	{
+		WriteUInt32(Out, static_cast<uint32_t>(Messages.size()));
+		for (const auto& Message : Messages)
+		{
+			WriteString(Out, Message.SerializeAsString());
+		}
+	}
+
+	void WriteApiKeys(std::string& Out, const std::vector<InworldV1alpha::ApiKey>& ApiKeys)
+	{
+		WriteUInt32(Out, static_cast<uint32_t>(ApiKeys.size()));
+		for (const auto& ApiKey : ApiKeys)
+		{
+			InworldV1alpha::ApiKey Public = ApiKey;
+			Public.clear_secret();
+			WriteString(Out, Public.SerializeAsString());
+		}
+	}
+
+	class PayloadReader
+	{
+	public:
+		PayloadReader(const std::string& Payload)
+			: _Payload(Payload)
+		{}
+
+		bool ReadUInt32(uint32_t& Value)
+		{
+			if (_Payload.size() - _Offset < sizeof(Value))
+			{
+				return false;
+			}
+			std::memcpy(&Value, _Payload.data() + _Offset, sizeof(Value));
+			_Offset += sizeof(Value);
+			return true;
+		}
+
+		bool ReadString(std::string& Str)
+		{
+			uint32_t Size;
+			if (!ReadUInt32(Size) || _Payload.size() - _Offset < Size)
+			{
+				return false;
+			}
+			Str.assign(_Payload, _Offset, Size);
+			_Offset += Size;
+			return true;
+		}
+
+		template<typename TMessage>
+		bool ReadMessages(std::vector<TMessage>& Messages)
+		{
+			uint32_t Num;
+			if (!ReadUInt32(Num) || Num > _Payload.size() - _Offset)
+			{
+				return false;
+			}
+
+			Messages.resize(Num);
+			std::string Buffer;
+			for (auto& Message : Messages)
+			{
+				if (!ReadString(Buffer) || !Message.ParseFromString(Buffer))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool IsEnd() const { return _Offset == _Payload.size(); }
+
+	private:
+		const std::string& _Payload;
+		size_t _Offset = 0;
+	};
+}
+
+uint64_t Inworld::StudioCache::HashString(const std::string& Str, uint64_t Seed)
+{
+	// FNV-1a, stable across platforms and runs.
+	uint64_t Hash = Seed;
+	for (const char C : Str)
+	{
+		Hash ^= static_cast<uint8_t>(C);
+		Hash *= 1099511628211ull;
+	}
+	return Hash;
+}
+
+std::string Inworld::StudioCache::Serialize(const StudioUserData& Data)
+{
+	std::string Payload;
+	WriteUInt32(Payload, static_cast<uint32_t>(Data._Workspaces.size()));
+	for (const auto& Workspace : Data._Workspaces)
+	{
+		WriteString(Payload, Workspace._Name);
+		WriteMessages(Payload, Workspace._Scenes);
+		WriteMessages(Payload, Workspace._Characters);
+		WriteApiKeys(Payload, Workspace._ApiKeys);
+	}
+	return Payload;
+}
+
+bool Inworld::StudioCache::Deserialize(const std::string& Payload, StudioUserData& Data)
+{
+	PayloadReader Reader(Payload);
+
+	uint32_t NumWorkspaces;
+	if (!Reader.ReadUInt32(NumWorkspaces) || NumWorkspaces > Payload.size())
+	{
+		return false;
+	}
+
+	Data._Workspaces.resize(NumWorkspaces);
+	for (auto& Workspace : Data._Workspaces)
+	{
+		if (!Reader.ReadString(Workspace._Name) ||
+			!Reader.ReadMessages(Workspace._Scenes) ||
+			!Reader.ReadMessages(Workspace._Characters) ||
+			!Reader.ReadMessages(Workspace._ApiKeys))
+		{
+			return false;
+		}
+	}
+	return Reader.IsEnd();
+}
+
+uint64_t Inworld::StudioCache::Hash(const StudioUserData& Data)
+{
+	return HashString(Serialize(Data));
+}
+
+bool Inworld::StudioCache::Load(StudioUserData& Data) const
+{
+	std::ifstream File(_FilePath, std::ios::binary);
+	if (!File)
+	{
+		return false;
+	}
+
+	StudioCacheHeader Header;
+	if (!File.read(reinterpret_cast<char*>(&Header), sizeof(Header)) ||
+		std::memcmp(Header.Magic, StudioCacheMagic, sizeof(StudioCacheMagic)) != 0)
+	{
+		Inworld::LogWarning("StudioCache. Invalid header, removing %s", ARG_STR(_FilePath));
+		File.close();
+		Remove();
+		return false;
+	}
+
+	if (Header.Version != Version)
+	{
+		Inworld::LogWarning("StudioCache. Version %d, removing %s", static_cast<int32_t>(Header.Version), ARG_STR(_FilePath));
+		File.close();
+		Remove();
+		return false;
+	}
+
+	if (Header.KeyHash != _KeyHash)
+	{
+		return false;
+	}
+
+	std::string Payload(Header.PayloadSize <= (1ull << 30) ? Header.PayloadSize : 0, '\0');
+	if (Payload.size() != Header.PayloadSize ||
+		!File.read(&Payload[0], Payload.size()) ||
+		File.peek() != std::char_traits<char>::eof() ||
+		HashString(Payload) != Header.PayloadHash)
+	{
+		Inworld::LogWarning("StudioCache. Corrupted payload, removing %s", ARG_STR(_FilePath));
+		File.close();
+		Remove();
+		return false;
+	}
+
+	StudioUserData Loaded;
+	if (!Deserialize(Payload, Loaded))
+	{
+		Inworld::LogWarning("StudioCache. Malformed payload, removing %s", ARG_STR(_FilePath));
+		File.close();
+		Remove();
+		return false;
+	}
+
+	Data = std::move(Loaded);
+	return true;
+}
+
+bool Inworld::StudioCache::Save(const StudioUserData& Data) const
+{
+	const std::string Payload = Serialize(Data);
+
+	StudioCacheHeader Header;
+	std::memcpy(Header.Magic, StudioCacheMagic, sizeof(StudioCacheMagic));
+	Header.Version = Version;
+	Header.KeyHash = _KeyHash;
+	Header.PayloadHash = HashString(Payload);
+	Header.PayloadSize = Payload.size();
+
+	const std::string TmpFilePath = _FilePath + ".tmp";
+	{
+		std::ofstream File(TmpFilePath, std::ios::binary | std::ios::trunc);
+		if (!File ||
+			!File.write(reinterpret_cast<const char*>(&Header), sizeof(Header)) ||
+			!File.write(Payload.data(), Payload.size()))
+		{
+			Inworld::LogError("StudioCache. Couldn't write %s", ARG_STR(TmpFilePath));
+			return false;
+		}
+	}
+
+	// std::rename doesn't replace an existing file on Windows.
+	std::remove(_FilePath.c_str());
+	if (std::rename(TmpFilePath.c_str(), _FilePath.c_str()) != 0)
+	{
+		Inworld::LogError("StudioCache. Couldn't rename %s", ARG_STR(TmpFilePath));
+		std::remove(TmpFilePath.c_str());
+		return false;
+	}
+	return true;
+}
+
+void Inworld::StudioCache::Remove() const
+{
+	std::remove(_FilePath.c_str());
+}
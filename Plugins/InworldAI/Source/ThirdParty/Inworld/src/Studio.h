@@ -0,0 +1,195 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#pragma once
+
+#include "proto/ProtoDisableWarning.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+#include "grpcpp/impl/codegen/status.h"
+#include "ai/inworld/studio/v1alpha/users.pb.h"
+#include "ai/inworld/studio/v1alpha/workspaces.pb.h"
+#include "ai/inworld/studio/v1alpha/scenes.pb.h"
+#include "ai/inworld/studio/v1alpha/characters.pb.h"
+#include "ai/inworld/studio/v1alpha/apikeys.pb.h"
+
+#include "Define.h"
+
+namespace InworldV1alpha = ai::inworld::studio::v1alpha;
+
+namespace Inworld
+{
+	struct INWORLD_EXPORT StudioWorkspaceData
+	{
+		std::string _Name;
+		std::vector<InworldV1alpha::Scene> _Scenes;
+		std::vector<InworldV1alpha::Character> _Characters;
+		std::vector<InworldV1alpha::ApiKey> _ApiKeys;
+		// Non empty if any of the workspace requests failed, the rest of the data is still valid.
+		std::string _Error;
+	};
+
+	struct INWORLD_EXPORT StudioUserData
+	{
+		std::vector<StudioWorkspaceData> _Workspaces;
+	};
+
+	// Versioned binary file of StudioUserData, bound to a key (e.g. server and account) that is stored hashed.
+	// Studio list responses carry no etag or update time, revalidation compares content hashes instead.
+	// API key secrets are neither written nor hashed, loaded keys have an empty secret until refetched.
+	class INWORLD_EXPORT StudioCache
+	{
+	public:
+		// 1 stored API key secrets in plain text.
+		static constexpr uint32_t Version = 2;
+
+		StudioCache(const std::string& FilePath, const std::string& Key)
+			: _FilePath(FilePath)
+			, _KeyHash(HashString(Key))
+		{}
+
+		// False if the file is missing, of another version or key, or corrupted. Corrupted files and files of
+		// another version are removed.
+		bool Load(StudioUserData& Data) const;
+		// Written to a temporary file and renamed, a crash never leaves a partial cache behind.
+		bool Save(const StudioUserData& Data) const;
+		void Remove() const;
+
+		static uint64_t Hash(const StudioUserData& Data);
+
+	private:
+		static uint64_t HashString(const std::string& Str, uint64_t Seed = 14695981039346656037ull);
+		static std::string Serialize(const StudioUserData& Data);
+		static bool Deserialize(const std::string& Payload, StudioUserData& Data);
+
+		std::string _FilePath;
+		uint64_t _KeyHash;
+	};
+
+	// One call per page, PageToken is empty for the first page.
+	class INWORLD_EXPORT StudioService
+	{
+	public:
+		virtual ~StudioService() = default;
+
+		virtual grpc::Status GenerateUserToken(const std::string& ExchangeToken, InworldV1alpha::GenerateTokenUserResponse& Response) = 0;
+		virtual grpc::Status ListWorkspaces(const std::string& Token, const std::string& PageToken, InworldV1alpha::ListWorkspacesResponse& Response) = 0;
+		virtual grpc::Status ListScenes(const std::string& Token, const std::string& Workspace, const std::string& PageToken, InworldV1alpha::ListScenesResponse& Response) = 0;
+		virtual grpc::Status ListCharacters(const std::string& Token, const std::string& Workspace, const std::string& PageToken, InworldV1alpha::ListCharactersResponse& Response) = 0;
+		virtual grpc::Status ListApiKeys(const std::string& Token, const std::string& Workspace, const std::string& PageToken, InworldV1alpha::ListApiKeysResponse& Response) = 0;
+
+		// Called from any thread, must interrupt calls in flight.
+		virtual void Cancel() {}
+	};
+
+	class INWORLD_EXPORT GrpcStudioService : public StudioService
+	{
+	public:
+		GrpcStudioService(const std::string& ServerUrl);
+		virtual ~GrpcStudioService();
+
+		virtual grpc::Status GenerateUserToken(const std::string& ExchangeToken, InworldV1alpha::GenerateTokenUserResponse& Response) override;
+		virtual grpc::Status ListWorkspaces(const std::string& Token, const std::string& PageToken, InworldV1alpha::ListWorkspacesResponse& Response) override;
+		virtual grpc::Status ListScenes(const std::string& Token, const std::string& Workspace, const std::string& PageToken, InworldV1alpha::ListScenesResponse& Response) override;
+		virtual grpc::Status ListCharacters(const std::string& Token, const std::string& Workspace, const std::string& PageToken, InworldV1alpha::ListCharactersResponse& Response) override;
+		virtual grpc::Status ListApiKeys(const std::string& Token, const std::string& Workspace, const std::string& PageToken, InworldV1alpha::ListApiKeysResponse& Response) override;
+
+		virtual void Cancel() override;
+
+	private:
+		struct Stubs;
+		std::unique_ptr<Stubs> _Stubs;
+	};
+
+	// Fixed number of worker threads executing tasks in push order.
+	class INWORLD_EXPORT TaskPool
+	{
+	public:
+		TaskPool(uint32_t NumThreads);
+		~TaskPool();
+
+		void Push(std::function<void()> Task);
+		// Drops queued tasks, running tasks are completed.
+		void Clear();
+		// Blocks until there are no queued or running tasks, must not be called from a task.
+		void Wait();
+		// Drops queued tasks and joins the workers.
+		void Stop();
+
+	private:
+		void Work();
+
+		std::vector<std::thread> _Threads;
+		std::deque<std::function<void()>> _Tasks;
+		std::mutex _Mutex;
+		std::condition_variable _Condition;
+		std::condition_variable _IdleCondition;
+		uint32_t _RunningTasks = 0;
+		bool _bStopped = false;
+	};
+
+	// Fetches Studio user data fanning out per-workspace requests on a bounded pool.
+	// Pages are requested in sequence per list, results keep the order returned by the service
+	// regardless of the order requests complete in.
+	class INWORLD_EXPORT StudioFetcher
+	{
+	public:
+		using FetchCallback = std::function<void(bool bSuccess, const std::string& Error)>;
+
+		StudioFetcher(std::shared_ptr<StudioService> Service, uint32_t MaxConcurrentRequests = 8);
+		~StudioFetcher();
+
+		// Callback is called once from a pool thread, unless cancelled.
+		// Requests of a cancelled fetch unwind in the background, their results are dropped.
+		void Fetch(const std::string& ExchangeToken, FetchCallback Callback);
+		void Cancel();
+
+		bool IsInProgress() const { return _bInProgress; }
+		// Valid once the callback was called.
+		const StudioUserData& GetData() const { return _Data; }
+
+	private:
+		// State of one fetch, owned by its tasks so a cancelled fetch can't touch the next one.
+		struct FetchState
+		{
+			uint32_t Generation = 0;
+			FetchCallback Callback;
+			std::string ExchangeToken;
+			std::string Token;
+			StudioUserData Data;
+			std::mutex ErrorMutex;
+			std::atomic<uint32_t> PendingRequests = { 0 };
+		};
+
+		void FetchWorkspaces(const std::shared_ptr<FetchState>& State);
+		void FetchWorkspace(const std::shared_ptr<FetchState>& State, size_t Idx);
+		void OnWorkspaceRequestDone(FetchState& State);
+		void Finish(FetchState& State, bool bSuccess, const std::string& Error);
+		bool IsCancelled(const FetchState& State) const { return State.Generation != _Generation; }
+
+		template<typename TResponse, typename TCall, typename TAppend>
+		grpc::Status FetchAllPages(const FetchState& State, TCall Call, TAppend Append);
+
+		std::shared_ptr<StudioService> _Service;
+		TaskPool _Pool;
+
+		StudioUserData _Data;
+		std::mutex _FinishMutex;
+
+		std::atomic<uint32_t> _Generation = { 0 };
+		std::atomic<bool> _bInProgress = { false };
+	};
+}
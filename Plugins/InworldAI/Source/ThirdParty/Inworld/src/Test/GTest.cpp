@@ -8,15 +8,86 @@
 #ifndef INWORLD_UNREAL
 
 #include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <numeric>
+#include <functional>
+#include <deque>
 
 #include "gtest/gtest.h"
 #include "Utils/Utils.h"
+#include "Packets.h"
+#include "Utils/PerceivedLatencyTracker.h"
+#include "Studio.h"
+#include "AECFilter.h"
+#include "Utils/VoiceActivityDetector.h"
+#include "Utils/VoiceJitterBuffer.h"
+#include "Utils/Histogram.h"
+#include "Utils/ReconnectBackoff.h"
+#include "Utils/PacketReplayBuffer.h"
+#include "Utils/SessionSnapshotStore.h"
+#include "Utils/RateMeter.h"
+#include "Utils/MetricsRegistry.h"
+#include "Utils/PacketRecording.h"
+#include "ReplayReaderWriter.h"
+#include <sstream>
+#include <thread>
 
 TEST(Utils, SslRootSerts)
 {
     EXPECT_NE(Inworld::Utils::GetSslRootCerts(), "");
 }
 
+TEST(Utils, SslRootSertsCached)
+{
+	const std::string& First = Inworld::Utils::GetSslRootCerts();
+	ASSERT_NE(First.find("-----BEGIN CERTIFICATE-----"), std::string::npos);
+
+	constexpr int Iterations = 1000;
+	const auto Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < Iterations; i++)
+	{
+		EXPECT_EQ(&Inworld::Utils::GetSslRootCerts(), &First);
+	}
+	const auto Us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - Start).count();
+	std::cout << "GetSslRootCerts: " << Iterations << " calls in " << Us << "us, bundle " << First.size() << " bytes" << std::endl;
+}
+
+namespace Phonemes
+{
+	using Inworld::Utils::Viseme;
+
+	static const std::vector<std::pair<std::string, Viseme>> Table = {
+		// Consonants
+		{ "b", Viseme::PP }, { "d", Viseme::DD }, { "d\u0361\u0292", Viseme::CH }, { "\u00F0", Viseme::TH }, { "f", Viseme::FF }, { "\u0261", Viseme::Kk },
+		{ "h", Viseme::Kk }, { "j", Viseme::I }, { "k", Viseme::Kk }, { "l", Viseme::Nn }, { "m", Viseme::PP }, { "n", Viseme::Nn },
+		{ "\u014B", Viseme::Kk }, { "p", Viseme::PP }, { "\u0279", Viseme::RR }, { "s", Viseme::SS }, { "\u0283", Viseme::CH }, { "t", Viseme::DD },
+		{ "t\u0361\u0283", Viseme::CH }, { "\u03B8", Viseme::TH }, { "v", Viseme::FF }, { "w", Viseme::U }, { "z", Viseme::SS }, { "\u0292", Viseme::CH },
+		// Vowels
+		{ "\u0259", Viseme::E }, { "\u025A", Viseme::E }, { "\u00E6", Viseme::Aa }, { "a\u026A", Viseme::Aa }, { "a\u028A", Viseme::Aa }, { "\u0251", Viseme::Aa },
+		{ "e\u026A", Viseme::E }, { "\u025D", Viseme::E }, { "\u025B", Viseme::E }, { "i", Viseme::I }, { "\u026A", Viseme::I }, { "o\u028A", Viseme::O },
+		{ "\u0254", Viseme::O }, { "\u0254\u026A", Viseme::O }, { "u", Viseme::U }, { "\u028A", Viseme::U }, { "\u028C", Viseme::E },
+		// Additional Symbols
+		{ "\u02C8", Viseme::STOP }, { "\u02CC", Viseme::STOP }, { ".", Viseme::STOP },
+	};
+
+	static std::shared_ptr<Inworld::AudioDataEvent> MakeAudioEvent(const std::vector<std::string>& Codes)
+	{
+		InworldPakets::InworldPacket Proto;
+		float Timestamp = 0.f;
+		for (const auto& Code : Codes)
+		{
+			auto* Info = Proto.mutable_data_chunk()->add_additional_phoneme_info();
+			Info->set_phoneme(Code);
+			Info->mutable_start_offset()->set_nanos(static_cast<int32_t>(Timestamp * 1000000000));
+			Timestamp += 0.05f;
+		}
+		return std::make_shared<Inworld::AudioDataEvent>(Proto);
+	}
+}
+
 TEST(Utils, PhonemeToViseme)
 {
 	EXPECT_EQ(Inworld::Utils::PhonemeToViseme("b"), "PP");
@@ -24,6 +95,251 @@ TEST(Utils, PhonemeToViseme)
 	EXPECT_EQ(Inworld::Utils::PhonemeToViseme("j"), "I");
 }
 
+TEST(Utils, PhonemeToVisemeFullTable)
+{
+	for (const auto& Entry : Phonemes::Table)
+	{
+		EXPECT_EQ(Inworld::Utils::PhonemeToVisemeCode(Entry.first), Entry.second) << Entry.first;
+		EXPECT_EQ(Inworld::Utils::PhonemeToViseme(Entry.first), Inworld::Utils::VisemeToString(Entry.second)) << Entry.first;
+	}
+
+	for (const std::string Unknown : { "", "x", "bb", "\u0283\u0283", "t\u0361\u0283\u0283", "\u02C8\u02C8\u02C8\u02C8" })
+	{
+		EXPECT_EQ(Inworld::Utils::PhonemeToVisemeCode(Unknown), Inworld::Utils::Viseme::None) << Unknown;
+		EXPECT_EQ(Inworld::Utils::PhonemeToViseme(Unknown), "") << Unknown;
+	}
+
+	// Not null terminated views.
+	const std::string Padded = "t\u0361\u0283xyz";
+	EXPECT_EQ(Inworld::Utils::PhonemeToVisemeCode(std::string_view(Padded).substr(0, Padded.size() - 3)), Inworld::Utils::Viseme::CH);
+}
+
+TEST(Utils, PhonemesToVisemes)
+{
+	const auto Event = Phonemes::MakeAudioEvent({ "h", "\u0259", "l", "x", "o\u028A", "." });
+
+	std::vector<Inworld::Utils::VisemeInfo> Visemes;
+	Inworld::Utils::PhonemesToVisemes(*Event, Visemes);
+
+	ASSERT_EQ(Visemes.size(), 5);
+	EXPECT_EQ(Visemes[0].Code, Inworld::Utils::Viseme::Kk);
+	EXPECT_EQ(Visemes[1].Code, Inworld::Utils::Viseme::E);
+	EXPECT_EQ(Visemes[2].Code, Inworld::Utils::Viseme::Nn);
+	EXPECT_EQ(Visemes[3].Code, Inworld::Utils::Viseme::O);
+	EXPECT_EQ(Visemes[4].Code, Inworld::Utils::Viseme::STOP);
+	for (size_t i = 0; i < Visemes.size(); i++)
+	{
+		EXPECT_EQ(Visemes[i].Timestamp, Event->GetPhonemeInfos()[i < 3 ? i : i + 1].Timestamp);
+	}
+}
+
+TEST(Utils, PhonemeToVisemeBenchmark)
+{
+	std::vector<std::string> Codes;
+	for (int i = 0; i < 100; i++)
+	{
+		Codes.push_back(Phonemes::Table[(i * 7) % Phonemes::Table.size()].first);
+	}
+	const auto Event = Phonemes::MakeAudioEvent(Codes);
+
+	constexpr int Iterations = 10000;
+	std::vector<Inworld::Utils::VisemeInfo> Visemes;
+	Visemes.reserve(Codes.size());
+
+	size_t Mapped = 0;
+	auto Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < Iterations; i++)
+	{
+		for (const auto& Phoneme : Event->GetPhonemeInfos())
+		{
+			Mapped += Inworld::Utils::PhonemeToViseme(Phoneme.Code).size();
+		}
+	}
+	const auto StringUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - Start).count();
+
+	Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < Iterations; i++)
+	{
+		Visemes.clear();
+		Inworld::Utils::PhonemesToVisemes(*Event, Visemes);
+		Mapped += Visemes.size();
+	}
+	const auto BulkUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - Start).count();
+
+	EXPECT_EQ(Visemes.size(), Codes.size());
+	EXPECT_GT(Mapped, 0);
+	std::cout << "PhonemeToViseme: " << Iterations << " x " << Codes.size() << " phonemes, string " << StringUs << "us, bulk " << BulkUs << "us" << std::endl;
+}
+
+TEST(Utils, VisemeCodecRoundTrip)
+{
+	constexpr float Bound = 0.5f / Inworld::Utils::VisemeTicksPerSecond + 1e-6f;
+
+	// Every phoneme, at offsets that aren't whole ticks, with a step back that needs the zigzag sign.
+	std::mt19937 Random(7);
+	std::uniform_real_distribution<float> Step(0.f, 0.2f);
+	std::vector<Inworld::Utils::VisemeInfo> Visemes;
+	float Timestamp = 0.0123456f;
+	for (const auto& Entry : Phonemes::Table)
+	{
+		Visemes.push_back({ Entry.second, Timestamp });
+		Timestamp += Step(Random);
+	}
+	Visemes.push_back({ Inworld::Utils::Viseme::PP, Timestamp - 1.f });
+	Visemes.push_back({ Inworld::Utils::Viseme::STOP, 3600.f });
+
+	std::string Encoded;
+	Inworld::Utils::EncodeVisemes(Visemes, Encoded);
+	std::vector<Inworld::Utils::VisemeInfo> Decoded;
+	ASSERT_TRUE(Inworld::Utils::DecodeVisemes(Encoded, Decoded));
+	ASSERT_EQ(Decoded.size(), Visemes.size());
+	for (size_t i = 0; i < Visemes.size(); i++)
+	{
+		EXPECT_EQ(Decoded[i].Code, Visemes[i].Code) << i;
+		EXPECT_LE(std::abs(Decoded[i].Timestamp - Visemes[i].Timestamp), Bound) << i;
+		EXPECT_EQ(Decoded[i].Timestamp, Inworld::Utils::QuantizeVisemeTimestamp(Visemes[i].Timestamp)) << i;
+	}
+
+	// Quantized timestamps round trip exactly.
+	std::string Reencoded;
+	Inworld::Utils::EncodeVisemes(Decoded, Reencoded);
+	EXPECT_EQ(Reencoded, Encoded);
+	std::vector<Inworld::Utils::VisemeInfo> Redecoded;
+	ASSERT_TRUE(Inworld::Utils::DecodeVisemes(Reencoded, Redecoded));
+	for (size_t i = 0; i < Decoded.size(); i++)
+	{
+		EXPECT_EQ(Redecoded[i].Timestamp, Decoded[i].Timestamp) << i;
+	}
+
+	// Malformed data.
+	std::vector<Inworld::Utils::VisemeInfo> Invalid;
+	EXPECT_FALSE(Inworld::Utils::DecodeVisemes(std::string_view(Encoded).substr(0, Encoded.size() - 1), Invalid));
+	EXPECT_FALSE(Inworld::Utils::DecodeVisemes(Encoded + "x", Invalid));
+	EXPECT_FALSE(Inworld::Utils::DecodeVisemes(std::string("\xff\xff\xff\xff\x0f", 5), Invalid));
+	ASSERT_TRUE(Inworld::Utils::DecodeVisemes(std::string("\x01\xc8\x02", 3), Invalid));
+	EXPECT_EQ(Invalid[0].Code, Inworld::Utils::Viseme::STOP);
+	EXPECT_EQ(Invalid[0].Timestamp, 0.001f);
+}
+
+TEST(Utils, VisemeCodecMonotonic)
+{
+	// Steps down to a fraction of a tick, quantizing may merge timestamps but never reorders them.
+	std::mt19937 Random(11);
+	std::uniform_real_distribution<float> Step(0.f, 3.f / Inworld::Utils::VisemeTicksPerSecond);
+	std::vector<Inworld::Utils::VisemeInfo> Visemes;
+	float Timestamp = 0.f;
+	for (int i = 0; i < 10000; i++)
+	{
+		Visemes.push_back({ static_cast<Inworld::Utils::Viseme>(i % 15), Timestamp });
+		Timestamp += Step(Random);
+	}
+
+	std::string Encoded;
+	Inworld::Utils::EncodeVisemes(Visemes, Encoded);
+	std::vector<Inworld::Utils::VisemeInfo> Decoded;
+	ASSERT_TRUE(Inworld::Utils::DecodeVisemes(Encoded, Decoded));
+	ASSERT_EQ(Decoded.size(), Visemes.size());
+	for (size_t i = 1; i < Decoded.size(); i++)
+	{
+		EXPECT_GE(Decoded[i].Timestamp, Decoded[i - 1].Timestamp) << i;
+	}
+}
+
+namespace VisemeSizes
+{
+	// As FInworldVisemeInfo was replicated before: an int32 count, then per viseme an int32 length,
+	// the UTF-16 code and a float timestamp.
+	static size_t LegacySize(const std::vector<Inworld::Utils::VisemeInfo>& Visemes)
+	{
+		size_t Size = sizeof(int32_t);
+		for (const auto& Info : Visemes)
+		{
+			Size += sizeof(int32_t) + std::strlen(Inworld::Utils::VisemeToString(Info.Code)) * sizeof(char16_t) + sizeof(float);
+		}
+		return Size;
+	}
+
+	// Utterances as the service sends them, a chunk of audio per few words with the phonemes it covers.
+	static void RecordSession(const std::string& Path)
+	{
+		Inworld::PacketRecorder Recorder;
+		ASSERT_TRUE(Recorder.Open(Path));
+		std::mt19937 Random(3);
+		std::uniform_int_distribution<size_t> Phoneme(0, Phonemes::Table.size() - 1);
+		std::uniform_int_distribution<int32_t> Duration(40000000, 120000000);
+		const auto Start = std::chrono::steady_clock::now();
+		for (int Chunk = 0; Chunk < 200; Chunk++)
+		{
+			InworldPakets::InworldPacket Packet;
+			Packet.mutable_data_chunk()->set_chunk(std::string(8000, '\0'));
+			int32_t Nanos = 0;
+			for (int i = 0; i < 20; i++)
+			{
+				auto* Info = Packet.mutable_data_chunk()->add_additional_phoneme_info();
+				Info->set_phoneme(Phonemes::Table[Phoneme(Random)].first);
+				Info->mutable_start_offset()->set_seconds(Nanos / 1000000000);
+				Info->mutable_start_offset()->set_nanos(Nanos % 1000000000);
+				Nanos += Duration(Random);
+			}
+			Recorder.Record(Inworld::RecordedPacketKind::Incoming, Packet.SerializeAsString(), Start + std::chrono::milliseconds(Chunk * 250));
+		}
+	}
+}
+
+// Bytes of replicated visemes before and after the compact layout, on the recording at INWORLD_RECORDING
+// (e.g. one written with Inworld.Debug.RecordPackets) or on a generated one.
+TEST(Utils, VisemeSizesOnRecording)
+{
+	const char* RecordingPath = std::getenv("INWORLD_RECORDING");
+	std::string Path = RecordingPath ? RecordingPath : "";
+	if (Path.empty())
+	{
+		Path = "VisemeSizesTest.iwpr";
+		VisemeSizes::RecordSession(Path);
+	}
+
+	Inworld::PacketRecordingReader Reader;
+	ASSERT_TRUE(Reader.Open(Path)) << Path;
+
+	size_t NumEvents = 0, NumVisemes = 0, Before = 0, After = 0;
+	Inworld::RecordedPacket Record;
+	while (Reader.Next(Record))
+	{
+		InworldPakets::InworldPacket Packet;
+		if (Record.Kind != Inworld::RecordedPacketKind::Incoming || !Packet.ParseFromString(Record.Data) ||
+			Packet.data_chunk().additional_phoneme_info_size() == 0)
+		{
+			continue;
+		}
+
+		std::vector<Inworld::Utils::VisemeInfo> Visemes;
+		Inworld::Utils::PhonemesToVisemes(Inworld::AudioDataEvent(Packet), Visemes);
+		std::string Encoded;
+		Inworld::Utils::EncodeVisemes(Visemes, Encoded);
+
+		std::vector<Inworld::Utils::VisemeInfo> Decoded;
+		ASSERT_TRUE(Inworld::Utils::DecodeVisemes(Encoded, Decoded));
+		ASSERT_EQ(Decoded.size(), Visemes.size());
+
+		NumEvents++;
+		NumVisemes += Visemes.size();
+		Before += VisemeSizes::LegacySize(Visemes);
+		After += Encoded.size();
+	}
+
+	if (!RecordingPath || !*RecordingPath)
+	{
+		std::remove(Path.c_str());
+		EXPECT_EQ(NumEvents, 200);
+	}
+	if (NumVisemes > 0)
+	{
+		EXPECT_LT(After, Before);
+	}
+	std::cout << "Visemes on " << Path << ": " << NumEvents << " audio events, " << NumVisemes << " visemes, before " << Before
+		<< " bytes, after " << After << " bytes (" << (Before ? After * 100 / Before : 0) << "%)" << std::endl;
+}
+
 static std::vector<uint8_t> StrToVec(const std::string& Data)
 {
 	std::vector<uint8_t> Res;
@@ -43,4 +359,1933 @@ TEST(Utils, HmacSha256)
 	EXPECT_EQ(ExpectedRes, Res);
 }
 
+namespace LatencyTimeline
+{
+	using namespace std::chrono;
+
+	static const Inworld::Routing AgentToPlayer(Inworld::Actor(InworldPakets::Actor_Type_AGENT, "agent"), Inworld::Actor(InworldPakets::Actor_Type_PLAYER, ""));
+
+	template<typename TPacket>
+	static std::shared_ptr<TPacket> InInteraction(std::shared_ptr<TPacket> Packet, const std::string& Interaction)
+	{
+		Packet->_PacketId._InteractionId = Interaction;
+		return Packet;
+	}
+
+	static std::shared_ptr<Inworld::Packet> PlayerText(const std::string& Interaction)
+	{
+		return InInteraction(std::make_shared<Inworld::TextEvent>("hello", Inworld::Routing::Player2Agent("agent")), Interaction);
+	}
+
+	static std::shared_ptr<Inworld::Packet> AgentText(const std::string& Interaction)
+	{
+		return InInteraction(std::make_shared<Inworld::TextEvent>("hi", AgentToPlayer), Interaction);
+	}
+
+	static std::shared_ptr<Inworld::Packet> AgentAudio(const std::string& Interaction)
+	{
+		return InInteraction(std::make_shared<Inworld::AudioDataEvent>(std::string(320, 0), AgentToPlayer), Interaction);
+	}
+
+	static std::shared_ptr<Inworld::Packet> InteractionEnd(const std::string& Interaction)
+	{
+		return InInteraction(std::make_shared<Inworld::ControlEvent>(InworldPakets::ControlEvent_Action_INTERACTION_END, AgentToPlayer), Interaction);
+	}
+}
+
+TEST(PerceivedLatencyTracker, ScriptedTimeline)
+{
+	using namespace LatencyTimeline;
+
+	Inworld::PerceivedLatencyTracker Tracker;
+	Tracker.TrackAudioReplies(true);
+
+	std::vector<std::pair<std::string, uint32_t>> Reported;
+	Tracker.SetCallback([&Reported](const std::string& Interaction, uint32_t Ms) { Reported.emplace_back(Interaction, Ms); });
+
+	const auto T0 = steady_clock::now();
+	auto At = [T0](int32_t Ms) { return T0 + milliseconds(Ms); };
+
+	// First text at 200ms, audio chunks at 300, 400, 550, 600ms, end at 700ms.
+	Tracker.HandlePacket(PlayerText("a"), At(0));
+	Tracker.HandlePacket(AgentText("a"), At(200));
+	Tracker.HandlePacket(AgentAudio("a"), At(300));
+	Tracker.HandlePacket(AgentText("a"), At(350));
+	Tracker.HandlePacket(AgentAudio("a"), At(400));
+	Tracker.HandlePacket(AgentAudio("a"), At(550));
+	Tracker.HandlePacket(AgentAudio("a"), At(600));
+	Tracker.HandlePacket(InteractionEnd("a"), At(700));
+
+	ASSERT_EQ(Reported.size(), 1);
+	EXPECT_EQ(Reported[0].first, "a");
+	EXPECT_EQ(Reported[0].second, 300);
+
+	const auto Snapshot = Tracker.GetSnapshot();
+	EXPECT_EQ(Snapshot.TimeToFirstText.Count, 1);
+	EXPECT_NEAR(Snapshot.TimeToFirstText.P50, 200.0, 200.0 / 32);
+	EXPECT_EQ(Snapshot.TimeToFirstAudio.Count, 1);
+	EXPECT_NEAR(Snapshot.TimeToFirstAudio.P99, 300.0, 300.0 / 32);
+	EXPECT_EQ(Snapshot.TimeToInteractionEnd.Count, 1);
+	EXPECT_NEAR(Snapshot.TimeToInteractionEnd.Max, 700.0, 0.001);
+	// Gaps are 100, 150 and 50ms.
+	EXPECT_EQ(Snapshot.ChunkJitter.Count, 2);
+	EXPECT_NEAR(Snapshot.ChunkJitter.Min, 50.0, 0.001);
+	EXPECT_NEAR(Snapshot.ChunkJitter.Max, 100.0, 0.001);
+	EXPECT_EQ(Snapshot.TrackedInteractions, 0);
+	EXPECT_EQ(Snapshot.AbandonedInteractions, 0);
+}
+
+TEST(PerceivedLatencyTracker, Percentiles)
+{
+	using namespace LatencyTimeline;
+
+	Inworld::PerceivedLatencyTracker Tracker;
+
+	const auto T0 = steady_clock::now();
+	for (int32_t i = 1; i <= 100; i++)
+	{
+		const std::string Interaction = std::to_string(i);
+		const auto Start = T0 + seconds(i);
+		Tracker.HandlePacket(PlayerText(Interaction), Start);
+		Tracker.HandlePacket(AgentText(Interaction), Start + milliseconds(i * 10));
+		Tracker.HandlePacket(InteractionEnd(Interaction), Start + milliseconds(i * 20));
+	}
+
+	const auto Snapshot = Tracker.GetSnapshot();
+	EXPECT_EQ(Snapshot.TimeToFirstText.Count, 100);
+	EXPECT_NEAR(Snapshot.TimeToFirstText.P50, 500.0, 500.0 / 32);
+	EXPECT_NEAR(Snapshot.TimeToFirstText.P95, 950.0, 950.0 / 32);
+	EXPECT_NEAR(Snapshot.TimeToFirstText.P99, 990.0, 990.0 / 32);
+	EXPECT_NEAR(Snapshot.TimeToFirstText.Mean, 505.0, 0.001);
+	EXPECT_NEAR(Snapshot.TimeToInteractionEnd.P50, 1000.0, 1000.0 / 32);
+	EXPECT_EQ(Snapshot.TimeToFirstAudio.Count, 0);
+}
+
+TEST(PerceivedLatencyTracker, AbandonedInteractionsAreBounded)
+{
+	using namespace LatencyTimeline;
+
+	Inworld::PerceivedLatencyTracker Tracker;
+	Tracker.SetInteractionLimits(8, seconds(10));
+
+	const auto T0 = steady_clock::now();
+	for (int32_t i = 0; i < 1000; i++)
+	{
+		Tracker.HandlePacket(PlayerText(std::to_string(i)), T0 + milliseconds(i));
+	}
+	EXPECT_LE(Tracker.GetSnapshot().TrackedInteractions, 8);
+	EXPECT_EQ(Tracker.GetSnapshot().AbandonedInteractions, 1000 - 8);
+
+	// Replies for evicted interactions are ignored.
+	Tracker.HandlePacket(AgentText("0"), T0 + milliseconds(1000));
+	EXPECT_EQ(Tracker.GetSnapshot().TimeToFirstText.Count, 0);
+
+	// Remaining ones time out.
+	Tracker.HandlePacket(PlayerText("late"), T0 + seconds(30));
+	EXPECT_EQ(Tracker.GetSnapshot().TrackedInteractions, 1);
+	EXPECT_EQ(Tracker.GetSnapshot().AbandonedInteractions, 1000);
+}
+
+TEST(PerceivedLatencyTracker, TimeToFirstAudioByAgent)
+{
+	using namespace LatencyTimeline;
+
+	Inworld::PerceivedLatencyTracker Tracker;
+	const Inworld::Routing OtherToPlayer(Inworld::Actor(InworldPakets::Actor_Type_AGENT, "other"), Inworld::Actor(InworldPakets::Actor_Type_PLAYER, ""));
+
+	// "agent" answers in 200, 400, ... 2000ms, "other" in 3s.
+	const auto T0 = steady_clock::now();
+	for (int32_t i = 1; i <= 10; i++)
+	{
+		const std::string Interaction = std::to_string(i);
+		const auto Start = T0 + seconds(i * 10);
+		Tracker.HandlePacket(PlayerText(Interaction), Start);
+		Tracker.HandlePacket(AgentAudio(Interaction), Start + milliseconds(i * 200));
+		Tracker.HandlePacket(AgentAudio(Interaction), Start + milliseconds(i * 200 + 100));
+		Tracker.HandlePacket(InteractionEnd(Interaction), Start + seconds(5));
+	}
+	Tracker.HandlePacket(PlayerText("other"), T0 + seconds(200));
+	Tracker.HandlePacket(InInteraction(std::make_shared<Inworld::AudioDataEvent>(std::string(320, 0), OtherToPlayer), "other"), T0 + seconds(203));
+
+	const auto& ByAgent = Tracker.GetTimeToFirstAudioByAgent();
+	ASSERT_EQ(ByAgent.size(), 2);
+	const Inworld::LatencyHistogram& Agent = ByAgent.at("agent");
+	EXPECT_EQ(Agent.GetCount(), 10);
+	EXPECT_NEAR(Agent.GetStats(1000.0).Max, 2000.0, 0.001);
+	// Buckets are exact at powers of two, 2^19us is about 524ms.
+	EXPECT_EQ(Agent.CountBelow(uint64_t(1) << 19), 2);
+	EXPECT_EQ(Agent.CountBelow(Inworld::LatencyHistogram::MaxValue), 10);
+	EXPECT_EQ(ByAgent.at("other").GetCount(), 1);
+	EXPECT_NEAR(ByAgent.at("other").GetStats(1000.0).P50, 3000.0, 3000.0 / 32);
+	EXPECT_EQ(Tracker.GetSnapshot().TimeToFirstAudio.Count, 11);
+
+	Tracker.ResetStats();
+	EXPECT_TRUE(Tracker.GetTimeToFirstAudioByAgent().empty());
+}
+
+TEST(Packets, TimestampRoundTrip)
+{
+	using namespace std::chrono;
+
+	// Multiple of 100ns, the coarsest system clock resolution among supported platforms.
+	const auto Timestamp = system_clock::time_point(duration_cast<system_clock::duration>(seconds(1700000000) + nanoseconds(123456700)));
+
+	Inworld::TextEvent Event("hello", Inworld::Routing::Player2Agent("agent"));
+	Event._Timestamp = Timestamp;
+
+	const auto Proto = Event.ToProto();
+	EXPECT_EQ(Proto.timestamp().seconds(), 1700000000);
+	EXPECT_EQ(Proto.timestamp().nanos(), 123456700);
+
+	const Inworld::TextEvent Restored(Proto);
+	EXPECT_EQ(Restored._Timestamp, Timestamp);
+	EXPECT_EQ(Restored.ToProto().timestamp().SerializeAsString(), Proto.timestamp().SerializeAsString());
+}
+
+TEST(Packets, TimestampFromProto)
+{
+	InworldPakets::InworldPacket Proto;
+	Proto.mutable_timestamp()->set_seconds(1700000001);
+	Proto.mutable_timestamp()->set_nanos(999999900);
+	Proto.mutable_control()->set_action(InworldPakets::ControlEvent_Action_INTERACTION_END);
+
+	const Inworld::ControlEvent Event(Proto);
+	const auto Nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(Event._Timestamp.time_since_epoch()).count();
+	EXPECT_EQ(Nanos, 1700000001999999900ll);
+	EXPECT_EQ(Event.ToProto().timestamp().nanos(), 999999900);
+}
+
+TEST(Packets, TimestampOrder)
+{
+	using namespace std::chrono;
+
+	const auto Base = system_clock::now();
+	std::vector<std::shared_ptr<Inworld::Packet>> Packets;
+	for (int32_t i = 0; i < 8; i++)
+	{
+		auto Packet = std::make_shared<Inworld::TextEvent>(std::to_string(i), Inworld::Routing::Player2Agent("agent"));
+		// Pairs share a sender timestamp, local arrival breaks the tie.
+		Packet->_Timestamp = Base + microseconds(i / 2);
+		Packet->_LocalTimestamp = steady_clock::time_point(nanoseconds(i));
+		Packets.push_back(Packet);
+	}
+
+	auto Shuffled = Packets;
+	std::reverse(Shuffled.begin(), Shuffled.end());
+	std::swap(Shuffled[1], Shuffled[5]);
+	std::sort(Shuffled.begin(), Shuffled.end(), Inworld::PacketTimestampOrder());
+
+	EXPECT_EQ(Shuffled, Packets);
+}
+
+namespace StudioMock
+{
+	// In-process Studio service with injected latency and page size.
+	class Service : public Inworld::StudioService
+	{
+	public:
+		std::chrono::milliseconds Latency = std::chrono::milliseconds(20);
+		int32_t PageSize = 2;
+		int32_t NumWorkspaces = 6;
+		int32_t ItemsPerWorkspace = 5;
+		std::string FailingWorkspace;
+
+		std::atomic<int32_t> Calls = { 0 };
+		std::atomic<int32_t> Concurrent = { 0 };
+		std::atomic<int32_t> MaxConcurrent = { 0 };
+
+		virtual grpc::Status GenerateUserToken(const std::string& ExchangeToken, InworldV1alpha::GenerateTokenUserResponse& Response) override
+		{
+			Simulate();
+			Response.set_token("token:" + ExchangeToken);
+			return grpc::Status();
+		}
+
+		virtual grpc::Status ListWorkspaces(const std::string& Token, const std::string& PageToken, InworldV1alpha::ListWorkspacesResponse& Response) override
+		{
+			Simulate();
+			const int32_t Start = Page(PageToken, NumWorkspaces, Response);
+			for (int32_t i = Start; i < Start + PageSize && i < NumWorkspaces; i++)
+			{
+				Response.add_workspaces()->set_name("workspaces/" + std::to_string(i));
+			}
+			return grpc::Status();
+		}
+
+		virtual grpc::Status ListScenes(const std::string& Token, const std::string& Workspace, const std::string& PageToken, InworldV1alpha::ListScenesResponse& Response) override
+		{
+			Simulate();
+			const int32_t Start = Page(PageToken, ItemsPerWorkspace, Response);
+			for (int32_t i = Start; i < Start + PageSize && i < ItemsPerWorkspace; i++)
+			{
+				Response.add_scenes()->set_name(Workspace + "/scenes/" + std::to_string(i));
+			}
+			return grpc::Status();
+		}
+
+		virtual grpc::Status ListCharacters(const std::string& Token, const std::string& Workspace, const std::string& PageToken, InworldV1alpha::ListCharactersResponse& Response) override
+		{
+			Simulate();
+			if (Workspace == FailingWorkspace && !PageToken.empty())
+			{
+				return grpc::Status(grpc::StatusCode::UNAVAILABLE, "injected");
+			}
+			const int32_t Start = Page(PageToken, ItemsPerWorkspace, Response);
+			for (int32_t i = Start; i < Start + PageSize && i < ItemsPerWorkspace; i++)
+			{
+				Response.add_characters()->set_name(Workspace + "/characters/" + std::to_string(i));
+			}
+			return grpc::Status();
+		}
+
+		virtual grpc::Status ListApiKeys(const std::string& Token, const std::string& Workspace, const std::string& PageToken, InworldV1alpha::ListApiKeysResponse& Response) override
+		{
+			Simulate();
+			const int32_t Start = Page(PageToken, ItemsPerWorkspace, Response);
+			for (int32_t i = Start; i < Start + PageSize && i < ItemsPerWorkspace; i++)
+			{
+				Response.add_api_keys()->set_name(Workspace + "/apikeys/" + std::to_string(i));
+			}
+			return grpc::Status();
+		}
+
+	private:
+		void Simulate()
+		{
+			Calls++;
+			const int32_t Current = ++Concurrent;
+			int32_t Max = MaxConcurrent;
+			while (Current > Max && !MaxConcurrent.compare_exchange_weak(Max, Current)) {}
+			std::this_thread::sleep_for(Latency);
+			Concurrent--;
+		}
+
+		template<typename TResponse>
+		int32_t Page(const std::string& PageToken, int32_t Total, TResponse& Response)
+		{
+			const int32_t Start = PageToken.empty() ? 0 : std::stoi(PageToken);
+			if (Start + PageSize < Total)
+			{
+				Response.set_next_page_token(std::to_string(Start + PageSize));
+			}
+			return Start;
+		}
+	};
+
+	bool Fetch(Inworld::StudioFetcher& Fetcher, std::string& Error)
+	{
+		std::mutex Mutex;
+		std::condition_variable Condition;
+		bool bDone = false;
+		bool bResult = false;
+		Fetcher.Fetch("exchange", [&](bool bSuccess, const std::string& InError)
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				bResult = bSuccess;
+				Error = InError;
+				bDone = true;
+				Condition.notify_one();
+			});
+
+		std::unique_lock<std::mutex> Lock(Mutex);
+		Condition.wait(Lock, [&]() { return bDone; });
+		return bResult;
+	}
+}
+
+TEST(Studio, ParallelFetch)
+{
+	auto Service = std::make_shared<StudioMock::Service>();
+	constexpr uint32_t PoolSize = 4;
+	Inworld::StudioFetcher Fetcher(Service, PoolSize);
+
+	const auto Start = std::chrono::steady_clock::now();
+	std::string Error;
+	ASSERT_TRUE(StudioMock::Fetch(Fetcher, Error));
+	const auto Elapsed = std::chrono::steady_clock::now() - Start;
+	EXPECT_TRUE(Error.empty());
+
+	// Token, 3 workspace pages and 3 pages for each of the 3 lists of 6 workspaces.
+	const int32_t ExpectedCalls = 1 + 3 + 6 * 3 * 3;
+	EXPECT_EQ(Service->Calls, ExpectedCalls);
+	EXPECT_LE(Service->MaxConcurrent, static_cast<int32_t>(PoolSize));
+	EXPECT_GT(Service->MaxConcurrent, 1);
+	EXPECT_LT(Elapsed, Service->Latency * ExpectedCalls / 2);
+
+	const auto& Data = Fetcher.GetData();
+	ASSERT_EQ(Data._Workspaces.size(), 6);
+	for (int32_t i = 0; i < 6; i++)
+	{
+		const auto& Workspace = Data._Workspaces[i];
+		EXPECT_EQ(Workspace._Name, "workspaces/" + std::to_string(i));
+		ASSERT_EQ(Workspace._Scenes.size(), 5);
+		ASSERT_EQ(Workspace._Characters.size(), 5);
+		ASSERT_EQ(Workspace._ApiKeys.size(), 5);
+		for (int32_t j = 0; j < 5; j++)
+		{
+			EXPECT_EQ(Workspace._Scenes[j].name(), Workspace._Name + "/scenes/" + std::to_string(j));
+			EXPECT_EQ(Workspace._Characters[j].name(), Workspace._Name + "/characters/" + std::to_string(j));
+			EXPECT_EQ(Workspace._ApiKeys[j].name(), Workspace._Name + "/apikeys/" + std::to_string(j));
+		}
+	}
+
+	std::cout << "StudioFetcher: " << ExpectedCalls << " calls of " << Service->Latency.count() << "ms in "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(Elapsed).count() << "ms, pool " << PoolSize << std::endl;
+}
+
+TEST(Studio, PartialFailure)
+{
+	auto Service = std::make_shared<StudioMock::Service>();
+	Service->Latency = std::chrono::milliseconds(1);
+	Service->FailingWorkspace = "workspaces/2";
+	Inworld::StudioFetcher Fetcher(Service, 3);
+
+	std::string Error;
+	ASSERT_TRUE(StudioMock::Fetch(Fetcher, Error));
+	EXPECT_NE(Error.find("ListCharacters"), std::string::npos);
+
+	const auto& Data = Fetcher.GetData();
+	ASSERT_EQ(Data._Workspaces.size(), 6);
+	for (const auto& Workspace : Data._Workspaces)
+	{
+		const bool bFailing = Workspace._Name == Service->FailingWorkspace;
+		EXPECT_EQ(Workspace._Error.empty(), !bFailing);
+		EXPECT_EQ(Workspace._Scenes.size(), 5);
+		EXPECT_EQ(Workspace._ApiKeys.size(), 5);
+		// First page arrived before the failure.
+		EXPECT_EQ(Workspace._Characters.size(), bFailing ? 2 : 5);
+	}
+
+	// Fetcher is reusable after a completed fetch.
+	Service->FailingWorkspace.clear();
+	ASSERT_TRUE(StudioMock::Fetch(Fetcher, Error));
+	EXPECT_TRUE(Error.empty());
+	EXPECT_EQ(Fetcher.GetData()._Workspaces[2]._Characters.size(), 5);
+}
+
+TEST(Studio, RefetchDropsStaleResults)
+{
+	auto Service = std::make_shared<StudioMock::Service>();
+	Inworld::StudioFetcher Fetcher(Service, 4);
+
+	std::atomic<int32_t> StaleCallbacks = { 0 };
+	Fetcher.Fetch("stale", [&StaleCallbacks](bool bSuccess, const std::string& Error) { StaleCallbacks++; });
+	// The first fetch has requests in flight, the mock service doesn't cancel them.
+	std::this_thread::sleep_for(Service->Latency * 2);
+
+	std::mutex Mutex;
+	std::condition_variable Condition;
+	bool bDone = false;
+	const auto Start = std::chrono::steady_clock::now();
+	Fetcher.Fetch("exchange", [&](bool bSuccess, const std::string& Error)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			bDone = true;
+			Condition.notify_one();
+		});
+	const auto Elapsed = std::chrono::steady_clock::now() - Start;
+	EXPECT_LT(Elapsed, Service->Latency);
+
+	{
+		std::unique_lock<std::mutex> Lock(Mutex);
+		Condition.wait(Lock, [&]() { return bDone; });
+	}
+	EXPECT_EQ(StaleCallbacks, 0);
+	EXPECT_EQ(Fetcher.GetData()._Workspaces.size(), 6);
+	EXPECT_EQ(Fetcher.GetData()._Workspaces[5]._Characters.size(), 5);
+}
+
+TEST(Studio, CacheHitAndRevalidation)
+{
+	const std::string FilePath = testing::TempDir() + "StudioCacheHit.bin";
+	const Inworld::StudioCache Cache(FilePath, "server|account");
+	Cache.Remove();
+
+	auto Service = std::make_shared<StudioMock::Service>();
+	Service->Latency = std::chrono::milliseconds(0);
+	Inworld::StudioFetcher Fetcher(Service, 4);
+
+	std::string Error;
+	ASSERT_TRUE(StudioMock::Fetch(Fetcher, Error));
+	Inworld::StudioUserData Cached;
+	EXPECT_FALSE(Cache.Load(Cached));
+	ASSERT_TRUE(Cache.Save(Fetcher.GetData()));
+
+	ASSERT_TRUE(Cache.Load(Cached));
+	ASSERT_EQ(Cached._Workspaces.size(), Fetcher.GetData()._Workspaces.size());
+	EXPECT_EQ(Cached._Workspaces[3]._Characters[4].name(), "workspaces/3/characters/4");
+	EXPECT_EQ(Cached._Workspaces[5]._ApiKeys[0].name(), "workspaces/5/apikeys/0");
+	const uint64_t CachedHash = Inworld::StudioCache::Hash(Cached);
+	EXPECT_EQ(CachedHash, Inworld::StudioCache::Hash(Fetcher.GetData()));
+
+	// Unchanged Studio data revalidates the cache.
+	ASSERT_TRUE(StudioMock::Fetch(Fetcher, Error));
+	EXPECT_EQ(Inworld::StudioCache::Hash(Fetcher.GetData()), CachedHash);
+
+	// Changed Studio data doesn't.
+	Service->ItemsPerWorkspace = 6;
+	ASSERT_TRUE(StudioMock::Fetch(Fetcher, Error));
+	EXPECT_NE(Inworld::StudioCache::Hash(Fetcher.GetData()), CachedHash);
+
+	// Another account doesn't see the cache.
+	const Inworld::StudioCache OtherCache(FilePath, "server|other");
+	EXPECT_FALSE(OtherCache.Load(Cached));
+
+	Cache.Remove();
+}
+
+TEST(Studio, CacheCorruptedFileRecovery)
+{
+	const std::string FilePath = testing::TempDir() + "StudioCacheCorrupted.bin";
+	const Inworld::StudioCache Cache(FilePath, "key");
+
+	Inworld::StudioUserData Data;
+	Data._Workspaces.resize(2);
+	Data._Workspaces[0]._Name = "workspaces/a";
+	Data._Workspaces[1]._Name = "workspaces/b";
+	Data._Workspaces[1]._Scenes.resize(1);
+	Data._Workspaces[1]._Scenes[0].set_name("workspaces/b/scenes/s");
+
+	auto ReadFile = [&FilePath]()
+	{
+		std::ifstream File(FilePath, std::ios::binary);
+		return std::string((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+	};
+	auto WriteFile = [&FilePath](const std::string& Content)
+	{
+		std::ofstream File(FilePath, std::ios::binary | std::ios::trunc);
+		File << Content;
+	};
+
+	ASSERT_TRUE(Cache.Save(Data));
+	const std::string Valid = ReadFile();
+
+	std::string Corrupted = Valid;
+	Corrupted[Corrupted.size() - 3] ^= 0x5a;
+	const std::vector<std::string> Files = { Corrupted, Valid.substr(0, Valid.size() - 1), Valid.substr(0, 10), Valid + "x", "garbage" };
+	for (const auto& File : Files)
+	{
+		WriteFile(File);
+		Inworld::StudioUserData Loaded;
+		EXPECT_FALSE(Cache.Load(Loaded));
+		EXPECT_TRUE(Loaded._Workspaces.empty());
+		EXPECT_TRUE(ReadFile().empty());
+	}
+
+	ASSERT_TRUE(Cache.Save(Data));
+	Inworld::StudioUserData Loaded;
+	ASSERT_TRUE(Cache.Load(Loaded));
+	EXPECT_EQ(Loaded._Workspaces[1]._Scenes[0].name(), "workspaces/b/scenes/s");
+
+	Cache.Remove();
+}
+
+TEST(Studio, CacheLeavesOutApiKeySecrets)
+{
+	const std::string FilePath = testing::TempDir() + "StudioCacheSecrets.bin";
+	const Inworld::StudioCache Cache(FilePath, "key");
+
+	Inworld::StudioUserData Data;
+	Data._Workspaces.resize(1);
+	Data._Workspaces[0]._Name = "workspaces/a";
+	Data._Workspaces[0]._ApiKeys.resize(1);
+	Data._Workspaces[0]._ApiKeys[0].set_name("workspaces/a/apikeys/0");
+	Data._Workspaces[0]._ApiKeys[0].set_key("PublicKeyValue");
+	Data._Workspaces[0]._ApiKeys[0].set_secret("SecretKeyValue");
+
+	ASSERT_TRUE(Cache.Save(Data));
+	std::ifstream File(FilePath, std::ios::binary);
+	const std::string Content((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+	File.close();
+	EXPECT_NE(Content.find("PublicKeyValue"), std::string::npos);
+	EXPECT_EQ(Content.find("SecretKeyValue"), std::string::npos);
+
+	Inworld::StudioUserData Loaded;
+	ASSERT_TRUE(Cache.Load(Loaded));
+	EXPECT_EQ(Loaded._Workspaces[0]._ApiKeys[0].key(), "PublicKeyValue");
+	EXPECT_TRUE(Loaded._Workspaces[0]._ApiKeys[0].secret().empty());
+	// Secrets aren't hashed either, a refetch with them revalidates the cache.
+	EXPECT_EQ(Inworld::StudioCache::Hash(Loaded), Inworld::StudioCache::Hash(Data));
+
+	// Files of the previous version may hold secrets, they are removed.
+	std::string Previous = Content;
+	const uint32_t PreviousVersion = 1;
+	std::memcpy(&Previous[4], &PreviousVersion, sizeof(PreviousVersion));
+	{
+		std::ofstream Out(FilePath, std::ios::binary | std::ios::trunc);
+		Out << Previous;
+	}
+	EXPECT_FALSE(Cache.Load(Loaded));
+	EXPECT_FALSE(std::ifstream(FilePath).good());
+}
+
+namespace AEC
+{
+	static std::vector<int16_t> Ramp(size_t Num)
+	{
+		std::vector<int16_t> Samples(Num);
+		for (size_t i = 0; i < Num; i++)
+		{
+			Samples[i] = static_cast<int16_t>(i % 30000);
+		}
+		return Samples;
+	}
+}
+
+// Without INWORLD_AEC frames pass through, the output must be the input in order.
+TEST(AECFilter, OddChunksNoSamplesLost)
+{
+	const std::vector<int16_t> Input = AEC::Ramp(16050);
+	const std::vector<int16_t> Far = AEC::Ramp(16050);
+	const size_t ChunkSizes[] = { 1, 159, 161, 37, 320, 1000, 7, 160, 479 };
+
+	Inworld::AECFilter Filter;
+	std::vector<int16_t> Output;
+	std::vector<int16_t> Out;
+	size_t Offset = 0;
+	for (size_t i = 0; Offset < Input.size(); i++)
+	{
+		const size_t Num = std::min(ChunkSizes[i % (sizeof(ChunkSizes) / sizeof(ChunkSizes[0]))], Input.size() - Offset);
+		Out.resize(Filter.GetMaxOutputSize(Num));
+		const size_t NumOut = Filter.Process(Input.data() + Offset, Num, Far.data() + Offset, Num, Out.data());
+		EXPECT_EQ(NumOut % Inworld::AECFilter::FrameSize, 0);
+		Output.insert(Output.end(), Out.begin(), Out.begin() + NumOut);
+		Offset += Num;
+	}
+
+	Out.resize(Inworld::AECFilter::FrameSize);
+	Out.resize(Filter.Flush(Out.data()));
+	Output.insert(Output.end(), Out.begin(), Out.end());
+
+	EXPECT_EQ(Output, Input);
+	EXPECT_EQ(Filter.GetStats().Frames, Input.size() / Inworld::AECFilter::FrameSize + 1);
+	EXPECT_GT(Filter.GetStats().Calls, 0);
+}
+
+TEST(AECFilter, InPlace)
+{
+	const std::vector<int16_t> Input = AEC::Ramp(5000);
+
+	Inworld::AECFilter Filter;
+	std::vector<int16_t> Output;
+	size_t Offset = 0;
+	for (size_t Num : { 100, 333, 160, 1, 2000, 77, 2329 })
+	{
+		std::vector<int16_t> Data(Input.begin() + Offset, Input.begin() + Offset + Num);
+		Filter.Process(Data, {});
+		EXPECT_EQ(Data.size() % Inworld::AECFilter::FrameSize, 0);
+		Output.insert(Output.end(), Data.begin(), Data.end());
+		Offset += Num;
+	}
+	ASSERT_EQ(Offset, Input.size());
+
+	std::vector<int16_t> Remainder(Inworld::AECFilter::FrameSize);
+	Remainder.resize(Filter.Flush(Remainder.data()));
+	EXPECT_EQ(Remainder.size(), Input.size() % Inworld::AECFilter::FrameSize);
+	Output.insert(Output.end(), Remainder.begin(), Remainder.end());
+
+	EXPECT_EQ(Output, Input);
+}
+
+TEST(AECFilter, Reset)
+{
+	Inworld::AECFilter Filter;
+	std::vector<int16_t> Data = AEC::Ramp(100);
+	Filter.Process(Data, AEC::Ramp(100));
+	EXPECT_TRUE(Data.empty());
+
+	Filter.Reset();
+	int16_t Out[Inworld::AECFilter::FrameSize];
+	EXPECT_EQ(Filter.Flush(Out), 0);
+	EXPECT_EQ(Filter.GetMaxOutputSize(10), 10);
+}
+
+TEST(AECFilter, Throughput)
+{
+	// 100ms capture chunks, as the audio capture component sends them.
+	constexpr size_t ChunkSize = 1600;
+	constexpr size_t NumChunks = 600;
+	const std::vector<int16_t> Near = AEC::Ramp(ChunkSize);
+	const std::vector<int16_t> Far = AEC::Ramp(ChunkSize);
+
+	Inworld::AECFilter Filter;
+	std::vector<int16_t> Data;
+	for (size_t i = 0; i < NumChunks; i++)
+	{
+		Data = Near;
+		Filter.Process(Data, Far);
+	}
+
+	const auto& Stats = Filter.GetStats();
+	EXPECT_EQ(Stats.Calls, NumChunks);
+	EXPECT_EQ(Stats.Frames, NumChunks * ChunkSize / Inworld::AECFilter::FrameSize);
+	const double AudioSeconds = NumChunks * ChunkSize / 16000.0;
+	const double ProcessSeconds = Stats.TotalCallNs / 1e9;
+	std::cout << "AECFilter: " << AudioSeconds << "s of audio in " << ProcessSeconds * 1000.0 << "ms, max call " << Stats.MaxCallNs / 1000 << "us" << std::endl;
+}
+
+namespace VAD
+{
+	constexpr uint32_t SampleRate = 16000;
+	// As the audio capture component sends them.
+	constexpr size_t ChunkSize = 1600;
+
+	struct Corpus
+	{
+		std::vector<int16_t> Samples;
+		// Per chunk, true if any of it is speech.
+		std::vector<bool> Labels;
+	};
+
+	// Voiced speech: a harmonic series with a falling pitch and a syllable rate envelope, over background noise.
+	// Utterances and pauses alternate, lengths in ms.
+	static Corpus Generate(float SpeechDbfs, float NoiseDbfs, const std::vector<std::pair<uint32_t, uint32_t>>& Script, uint32_t Seed)
+	{
+		const double Pi = std::acos(-1.0);
+		std::mt19937 Rng(Seed);
+		std::normal_distribution<double> Noise(0.0, std::pow(10.0, NoiseDbfs / 20.0));
+		const double SpeechAmplitude = std::pow(10.0, SpeechDbfs / 20.0) * std::sqrt(2.0);
+
+		Corpus Result;
+		std::vector<bool> SampleLabels;
+		for (const auto& Entry : Script)
+		{
+			const uint32_t SpeechSamples = Entry.first * SampleRate / 1000;
+			const double F0 = 100.0 + Rng() % 120;
+			double Phase = 0.0;
+			for (uint32_t i = 0; i < SpeechSamples; i++)
+			{
+				const double t = static_cast<double>(i) / SampleRate;
+				Phase += 2.0 * Pi * F0 * (1.0 - 0.2 * t) / SampleRate;
+				double Voiced = 0.0;
+				for (int32_t Harmonic = 1; Harmonic <= 20; Harmonic++)
+				{
+					Voiced += std::sin(Harmonic * Phase) / Harmonic;
+				}
+				// 4 syllables a second, never fully closed.
+				const double Envelope = 0.6 + 0.4 * std::sin(2.0 * Pi * 4.0 * t);
+				Result.Samples.push_back(static_cast<int16_t>(std::clamp((SpeechAmplitude * Envelope * Voiced + Noise(Rng)) * 32767.0, -32768.0, 32767.0)));
+				SampleLabels.push_back(true);
+			}
+
+			const uint32_t SilenceSamples = Entry.second * SampleRate / 1000;
+			for (uint32_t i = 0; i < SilenceSamples; i++)
+			{
+				Result.Samples.push_back(static_cast<int16_t>(std::clamp(Noise(Rng) * 32767.0, -32768.0, 32767.0)));
+				SampleLabels.push_back(false);
+			}
+		}
+
+		for (size_t Start = 0; Start + ChunkSize <= SampleLabels.size(); Start += ChunkSize)
+		{
+			Result.Labels.push_back(std::find(SampleLabels.begin() + Start, SampleLabels.begin() + Start + ChunkSize, true) != SampleLabels.begin() + Start + ChunkSize);
+		}
+		return Result;
+	}
+
+	struct GateResult
+	{
+		size_t SpeechChunks = 0;
+		size_t SpeechChunksSent = 0;
+		size_t SilenceChunks = 0;
+		size_t SilenceChunksSent = 0;
+		std::vector<size_t> Sent;
+	};
+
+	static GateResult RunGate(const Corpus& Input)
+	{
+		Inworld::VoiceActivityDetector Detector;
+		Inworld::VoiceActivityGate<size_t> Gate(2);
+		GateResult Result;
+		for (size_t Chunk = 0; Chunk < Input.Labels.size(); Chunk++)
+		{
+			const bool bActive = Detector.Process(Input.Samples.data() + Chunk * ChunkSize, ChunkSize);
+			Gate.Push(size_t(Chunk), bActive, [&Result](size_t&& Sent) { Result.Sent.push_back(Sent); });
+		}
+
+		for (size_t Chunk = 0; Chunk < Input.Labels.size(); Chunk++)
+		{
+			const bool bSent = std::find(Result.Sent.begin(), Result.Sent.end(), Chunk) != Result.Sent.end();
+			(Input.Labels[Chunk] ? Result.SpeechChunks : Result.SilenceChunks)++;
+			(Input.Labels[Chunk] ? Result.SpeechChunksSent : Result.SilenceChunksSent) += bSent ? 1 : 0;
+		}
+
+		EXPECT_EQ(Gate.GetStats().Chunks, Input.Labels.size());
+		EXPECT_EQ(Gate.GetStats().SentChunks + Gate.GetStats().SuppressedChunks + Gate.GetNumHeld(), Input.Labels.size());
+		EXPECT_TRUE(std::is_sorted(Result.Sent.begin(), Result.Sent.end()));
+
+		std::cout << "VoiceActivityGate: speech " << Result.SpeechChunksSent << "/" << Result.SpeechChunks
+			<< " sent, silence " << Result.SilenceChunks - Result.SilenceChunksSent << "/" << Result.SilenceChunks
+			<< " suppressed, " << Gate.GetStats().SuppressedChunks * ChunkSize * sizeof(int16_t) << " bytes saved" << std::endl;
+		return Result;
+	}
+
+	static const std::vector<std::pair<uint32_t, uint32_t>> Script = {
+		{ 0, 3000 }, { 1200, 2500 }, { 600, 4000 }, { 2500, 3000 }, { 900, 2000 }, { 1800, 5000 },
+	};
+}
+
+TEST(VoiceActivityDetector, QuietRoom)
+{
+	const VAD::Corpus Corpus = VAD::Generate(-22.f, -65.f, VAD::Script, 1);
+	const VAD::GateResult Result = VAD::RunGate(Corpus);
+	EXPECT_EQ(Result.SpeechChunksSent, Result.SpeechChunks);
+	EXPECT_GE(Result.SilenceChunks - Result.SilenceChunksSent, Result.SilenceChunks * 7 / 10);
+}
+
+TEST(VoiceActivityDetector, NoisyRoom)
+{
+	const VAD::Corpus Corpus = VAD::Generate(-25.f, -42.f, VAD::Script, 2);
+	const VAD::GateResult Result = VAD::RunGate(Corpus);
+	EXPECT_GE(Result.SpeechChunksSent * 100, Result.SpeechChunks * 98);
+	EXPECT_GE(Result.SilenceChunks - Result.SilenceChunksSent, Result.SilenceChunks * 6 / 10);
+}
+
+TEST(VoiceActivityDetector, SilenceAndNoiseAreInactive)
+{
+	Inworld::VoiceActivityDetector Detector;
+	const std::vector<int16_t> Zeros(VAD::ChunkSize * 10);
+	EXPECT_FALSE(Detector.Process(Zeros.data(), Zeros.size()));
+
+	// Steady broadband noise well above the initial floor is learnt, not taken for speech for long.
+	const VAD::Corpus Noise = VAD::Generate(0.f, -35.f, { { 0, 10000 } }, 3);
+	size_t ActiveChunks = 0;
+	for (size_t Chunk = 0; Chunk < Noise.Labels.size(); Chunk++)
+	{
+		ActiveChunks += Detector.Process(Noise.Samples.data() + Chunk * VAD::ChunkSize, VAD::ChunkSize) ? 1 : 0;
+	}
+	EXPECT_LT(ActiveChunks, Noise.Labels.size() / 2);
+	EXPECT_FALSE(Detector.IsActive());
+	EXPECT_NEAR(Detector.GetNoiseFloorDb(), -35.f, 3.f);
+}
+
+TEST(VoiceActivityDetector, HangoverAndCarryOver)
+{
+	Inworld::VoiceActivityDetector::Settings Settings;
+	Settings.HangoverMs = 300;
+	Inworld::VoiceActivityDetector Detector(Settings);
+
+	const VAD::Corpus Corpus = VAD::Generate(-20.f, -70.f, { { 0, 1000 }, { 500, 1000 } }, 4);
+	const size_t SpeechEnd = 1500 * VAD::SampleRate / 1000;
+
+	// Odd sized calls, samples are carried over between them.
+	size_t Offset = 0;
+	size_t LastActive = 0;
+	for (size_t i = 0; Offset < Corpus.Samples.size(); i++)
+	{
+		const size_t Num = std::min<size_t>(i % 2 ? 37 : 411, Corpus.Samples.size() - Offset);
+		Offset += Num;
+		if (Detector.Process(Corpus.Samples.data() + Offset - Num, Num))
+		{
+			LastActive = Offset;
+		}
+	}
+
+	EXPECT_EQ(Detector.GetStats().Frames, Corpus.Samples.size() / Inworld::VoiceActivityDetector::FrameSize);
+	EXPECT_GT(Detector.GetStats().SpeechFrames, 0);
+	EXPECT_GE(LastActive, SpeechEnd + 250 * VAD::SampleRate / 1000);
+	EXPECT_LE(LastActive, SpeechEnd + 400 * VAD::SampleRate / 1000 + 411);
+	EXPECT_FALSE(Detector.IsActive());
+
+	Detector.Reset();
+	EXPECT_FALSE(Detector.IsActive());
+}
+
+TEST(VoiceActivityGate, PreRollOrder)
+{
+	Inworld::VoiceActivityGate<int> Gate(2);
+	std::vector<int> Sent;
+	auto Send = [&Sent](int&& Chunk) { Sent.push_back(Chunk); };
+
+	for (int Chunk = 0; Chunk < 5; Chunk++)
+	{
+		Gate.Push(int(Chunk), false, Send);
+	}
+	EXPECT_TRUE(Sent.empty());
+	EXPECT_EQ(Gate.GetNumHeld(), 2);
+
+	Gate.Push(5, true, Send);
+	Gate.Push(6, true, Send);
+	Gate.Push(7, false, Send);
+	EXPECT_EQ(Sent, std::vector<int>({ 3, 4, 5, 6 }));
+
+	Gate.Reset();
+	EXPECT_EQ(Gate.GetNumHeld(), 0);
+	EXPECT_EQ(Gate.GetStats().Chunks, 8);
+	EXPECT_EQ(Gate.GetStats().SentChunks, 4);
+	EXPECT_EQ(Gate.GetStats().SuppressedChunks, 4);
+}
+
+namespace Jitter
+{
+	using namespace std::chrono;
+	using Clock = Inworld::VoiceJitterBuffer::Clock;
+
+	static Clock::time_point At(int64_t Ms)
+	{
+		return Clock::time_point(milliseconds(Ms));
+	}
+
+	static Inworld::VoiceFrameData Frame(uint32_t Sequence, size_t Size = 3200)
+	{
+		Inworld::VoiceFrameData Data(Size);
+		for (size_t i = 0; i < Size; i++)
+		{
+			Data[i] = static_cast<uint8_t>(Sequence * 31 + i);
+		}
+		return Data;
+	}
+
+	struct Link
+	{
+		int64_t DelayMs = 50;
+		int64_t JitterMs = 60;
+		double Loss = 0.05;
+		// Share of datagrams held back by ReorderMs, arriving after later ones.
+		double Reorder = 0.05;
+		int64_t ReorderMs = 150;
+		// Chance per datagram of a burst dropping everything sent within BurstMs.
+		double BurstChance = 0.0;
+		int64_t BurstMs = 0;
+	};
+
+	class Channel
+	{
+	public:
+		Channel(const Link& InSettings, uint32_t Seed) : Settings(InSettings), Rng(Seed) {}
+
+		bool Drop(int64_t SentMs)
+		{
+			if (SentMs < BurstUntilMs)
+			{
+				return true;
+			}
+			if (Unit(Rng) < Settings.BurstChance)
+			{
+				BurstUntilMs = SentMs + Settings.BurstMs;
+				return true;
+			}
+			return Unit(Rng) < Settings.Loss;
+		}
+
+		int64_t Delay()
+		{
+			const int64_t DelayMs = Settings.DelayMs + static_cast<int64_t>(Unit(Rng) * Settings.JitterMs);
+			return DelayMs + (Unit(Rng) < Settings.Reorder ? Settings.ReorderMs : 0);
+		}
+
+		const Link Settings;
+
+	private:
+		std::mt19937 Rng;
+		std::uniform_real_distribution<double> Unit { 0.0, 1.0 };
+		int64_t BurstUntilMs = 0;
+	};
+
+	struct LoopbackResult
+	{
+		Inworld::LatencyHistogram Latency;
+		Inworld::VoiceJitterBuffer::Stats Stats;
+		bool bInOrder = true;
+		bool bIntact = true;
+	};
+
+	// 100ms frames over a lossy link into the jitter buffer, released as datagrams arrive and on a 10ms server tick.
+	static LoopbackResult RunLoopback(const Link& Settings, uint32_t FecGroupSize, uint32_t NumFrames, uint32_t Seed)
+	{
+		struct Datagram
+		{
+			int64_t ArrivalMs;
+			bool bParity;
+			uint32_t Sequence;
+			Inworld::VoiceFrameData Data;
+		};
+
+		Channel Network(Settings, Seed);
+		std::vector<Datagram> InFlight;
+		auto Send = [&](int64_t SentMs, bool bParity, uint32_t Sequence, Inworld::VoiceFrameData&& Data)
+		{
+			if (!Network.Drop(SentMs))
+			{
+				InFlight.push_back({ SentMs + Network.Delay(), bParity, Sequence, std::move(Data) });
+			}
+		};
+
+		Inworld::VoiceFecEncoder Encoder(FecGroupSize);
+		for (uint32_t Sequence = 0; Sequence < NumFrames; Sequence++)
+		{
+			Inworld::VoiceFrameData Data = Frame(Sequence);
+			Inworld::VoiceFrameData Parity;
+			const bool bParity = Encoder.Add(Sequence, Data, Parity);
+			Send(Sequence * 100, false, Sequence, std::move(Data));
+			if (bParity)
+			{
+				Send(Sequence * 100, true, Sequence / FecGroupSize, std::move(Parity));
+			}
+		}
+		std::stable_sort(InFlight.begin(), InFlight.end(), [](const Datagram& A, const Datagram& B) { return A.ArrivalMs < B.ArrivalMs; });
+
+		Inworld::VoiceJitterBuffer::Settings BufferSettings;
+		BufferSettings.FecGroupSize = FecGroupSize;
+		Inworld::VoiceJitterBuffer Buffer(BufferSettings);
+
+		LoopbackResult Result;
+		int64_t NowMs = 0;
+		int64_t LastSequence = -1;
+		auto OnRelease = [&](uint32_t Sequence, Inworld::VoiceFrameData&& Data)
+		{
+			Result.Latency.Record(NowMs - Sequence * 100);
+			Result.bInOrder &= static_cast<int64_t>(Sequence) > LastSequence;
+			Result.bIntact &= Data == Frame(Sequence);
+			LastSequence = Sequence;
+		};
+
+		size_t Next = 0;
+		const int64_t EndMs = NumFrames * 100 + 1000;
+		for (; NowMs <= EndMs; NowMs++)
+		{
+			bool bRelease = NowMs % 10 == 0;
+			for (; Next < InFlight.size() && InFlight[Next].ArrivalMs <= NowMs; Next++)
+			{
+				Datagram& Entry = InFlight[Next];
+				if (Entry.bParity)
+				{
+					Buffer.PushParity(Entry.Sequence, std::move(Entry.Data), At(NowMs));
+				}
+				else
+				{
+					Buffer.PushFrame(Entry.Sequence, std::move(Entry.Data), At(NowMs));
+				}
+				bRelease = true;
+			}
+			if (bRelease)
+			{
+				Buffer.Release(At(NowMs), OnRelease);
+			}
+		}
+		Buffer.Flush(OnRelease);
+
+		Result.Stats = Buffer.GetStats();
+		return Result;
+	}
+
+	// A reliable channel over the same link, lost datagrams are resent a round trip later and hold back the ones behind.
+	static Inworld::LatencyHistogram ReliableLatency(const Link& Settings, uint32_t NumFrames, uint32_t Seed)
+	{
+		Channel Network(Settings, Seed);
+		Inworld::LatencyHistogram Latency;
+		int64_t LastDeliveredMs = 0;
+		for (uint32_t Sequence = 0; Sequence < NumFrames; Sequence++)
+		{
+			int64_t SentMs = Sequence * 100;
+			while (Network.Drop(SentMs))
+			{
+				SentMs += Network.Delay() + Settings.DelayMs;
+			}
+			LastDeliveredMs = std::max(LastDeliveredMs, SentMs + Network.Delay());
+			Latency.Record(LastDeliveredMs - Sequence * 100);
+		}
+		return Latency;
+	}
+
+	static void Print(const char* Name, const Inworld::HistogramStats& Stats)
+	{
+		std::cout << Name << ": p50 " << Stats.P50 << "ms, p95 " << Stats.P95 << "ms, p99 " << Stats.P99 << "ms, max " << Stats.Max << "ms, " << Stats.Count << " frames" << std::endl;
+	}
+}
+
+TEST(VoiceJitterBuffer, ReorderAndLate)
+{
+	using namespace Jitter;
+
+	Inworld::VoiceJitterBuffer Buffer;
+	std::vector<uint32_t> Released;
+	auto OnRelease = [&Released](uint32_t Sequence, Inworld::VoiceFrameData&& Data) { Released.push_back(Sequence); };
+
+	Buffer.PushFrame(10, Frame(10), At(0));
+	Buffer.PushFrame(12, Frame(12), At(100));
+	Buffer.Release(At(100), OnRelease);
+	EXPECT_EQ(Released, std::vector<uint32_t>({ 10 }));
+
+	// 11 arrives within the wait, 12 follows it.
+	Buffer.PushFrame(11, Frame(11), At(150));
+	Buffer.Release(At(150), OnRelease);
+	EXPECT_EQ(Released, std::vector<uint32_t>({ 10, 11, 12 }));
+
+	// 13 never arrives, 14 is released once it waited long enough, 13 is then late.
+	Buffer.PushFrame(14, Frame(14), At(300));
+	Buffer.Release(At(499), OnRelease);
+	EXPECT_EQ(Released.size(), 3);
+	Buffer.Release(At(500), OnRelease);
+	EXPECT_EQ(Released.back(), 14);
+	Buffer.PushFrame(13, Frame(13), At(510));
+	Buffer.PushFrame(14, Frame(14), At(510));
+	Buffer.Release(At(510), OnRelease);
+	EXPECT_EQ(Released.back(), 14);
+
+	Buffer.PushFrame(15, Frame(15), At(600));
+	Buffer.PushFrame(15, Frame(15), At(600));
+	Buffer.Flush(OnRelease);
+	EXPECT_EQ(Released, std::vector<uint32_t>({ 10, 11, 12, 14, 15 }));
+
+	const auto& Stats = Buffer.GetStats();
+	EXPECT_EQ(Stats.Received, 8);
+	EXPECT_EQ(Stats.Released, 5);
+	EXPECT_EQ(Stats.Lost, 1);
+	EXPECT_EQ(Stats.Late, 2);
+	EXPECT_EQ(Stats.Duplicates, 1);
+}
+
+TEST(VoiceJitterBuffer, FecRecoversSingleLoss)
+{
+	using namespace Jitter;
+
+	constexpr uint32_t GroupSize = 4;
+	Inworld::VoiceFecEncoder Encoder(GroupSize);
+	Inworld::VoiceJitterBuffer::Settings Settings;
+	Settings.FecGroupSize = GroupSize;
+	Inworld::VoiceJitterBuffer Buffer(Settings);
+
+	std::vector<std::pair<uint32_t, Inworld::VoiceFrameData>> Released;
+	auto OnRelease = [&Released](uint32_t Sequence, Inworld::VoiceFrameData&& Data) { Released.emplace_back(Sequence, std::move(Data)); };
+
+	// Frames of different sizes, 5 is lost in the second group, 9 and 10 in the third.
+	for (uint32_t Sequence = 4; Sequence < 12; Sequence++)
+	{
+		Inworld::VoiceFrameData Data = Frame(Sequence, 100 + Sequence * 7);
+		Inworld::VoiceFrameData Parity;
+		const bool bParity = Encoder.Add(Sequence, Data, Parity);
+		if (Sequence != 5 && Sequence != 9 && Sequence != 10)
+		{
+			Buffer.PushFrame(Sequence, std::move(Data), At(Sequence * 100));
+		}
+		if (bParity)
+		{
+			Buffer.PushParity(Sequence / GroupSize, std::move(Parity), At(Sequence * 100));
+		}
+	}
+	Buffer.Flush(OnRelease);
+
+	ASSERT_EQ(Released.size(), 6);
+	EXPECT_EQ(Released[1].first, 5);
+	EXPECT_EQ(Released[1].second, Frame(5, 135));
+	EXPECT_EQ(Released[4].first, 8);
+	EXPECT_EQ(Buffer.GetStats().Recovered, 1);
+	EXPECT_EQ(Buffer.GetStats().Lost, 2);
+}
+
+TEST(VoiceJitterBuffer, LoopbackLossAndReorder)
+{
+	using namespace Jitter;
+
+	constexpr uint32_t NumFrames = 3000;
+	Link Lossy;
+	Link Bursts;
+	Bursts.Loss = 0.01;
+	Bursts.BurstChance = 0.01;
+	Bursts.BurstMs = 1000;
+
+	for (const Link& Settings : { Lossy, Bursts })
+	{
+		const LoopbackResult Plain = RunLoopback(Settings, 0, NumFrames, 1);
+		const LoopbackResult WithFec = RunLoopback(Settings, 4, NumFrames, 1);
+		const Inworld::LatencyHistogram Reliable = ReliableLatency(Settings, NumFrames, 1);
+
+		std::cout << "Loss " << Settings.Loss * 100 << "%, bursts of " << Settings.BurstMs << "ms:" << std::endl;
+		Print("  Reliable", Reliable.GetStats());
+		Print("  Unreliable", Plain.Latency.GetStats());
+		Print("  Unreliable + FEC", WithFec.Latency.GetStats());
+		std::cout << "  Lost frames: " << Plain.Stats.Lost << " without FEC, " << WithFec.Stats.Lost << " with FEC (" << WithFec.Stats.Recovered << " recovered)" << std::endl;
+
+		for (const LoopbackResult* Result : { &Plain, &WithFec })
+		{
+			EXPECT_TRUE(Result->bInOrder);
+			EXPECT_TRUE(Result->bIntact);
+			// Only frames lost at the very end are not counted.
+			EXPECT_LE(Result->Stats.Released + Result->Stats.Lost, NumFrames);
+			EXPECT_GE(Result->Stats.Released + Result->Stats.Lost, NumFrames - 10);
+			// Late frames are discarded instead of holding back the ones behind them.
+			EXPECT_LE(Result->Latency.GetStats().Max, Settings.DelayMs + Settings.JitterMs + Settings.ReorderMs + 200 + 10);
+		}
+
+		EXPECT_GT(WithFec.Stats.Recovered, 0);
+		// Parity covers isolated losses, bursts take out whole groups.
+		if (Settings.BurstChance == 0.0)
+		{
+			EXPECT_LT(WithFec.Stats.Lost, Plain.Stats.Lost / 2);
+		}
+	}
+
+	// Every burst stalls a reliable channel for its whole length.
+	EXPECT_LT(RunLoopback(Bursts, 4, NumFrames, 1).Latency.GetStats().P99, ReliableLatency(Bursts, NumFrames, 1).GetStats().P99);
+}
+
+TEST(VoiceJitterBuffer, JitterEstimate)
+{
+	using namespace Jitter;
+
+	Inworld::VoiceJitterBuffer::Settings Settings;
+	Settings.FrameInterval = milliseconds(100);
+	Inworld::VoiceJitterBuffer Buffer(Settings);
+	auto OnRelease = [](uint32_t Sequence, Inworld::VoiceFrameData&& Data) {};
+
+	// Arrivals on the frame clock have no jitter, however late they all are.
+	for (uint32_t i = 0; i < 100; i++)
+	{
+		Buffer.PushFrame(i, Frame(i, 16), At(5000 + i * 100));
+		Buffer.Release(At(5000 + i * 100), OnRelease);
+	}
+	EXPECT_NEAR(Buffer.GetStats().JitterMs, 0.0, 0.001);
+
+	// Every other frame 20ms late, the transit changes by 20ms every frame.
+	for (uint32_t i = 100; i < 300; i++)
+	{
+		Buffer.PushFrame(i, Frame(i, 16), At(5000 + i * 100 + (i % 2) * 20));
+		Buffer.Release(At(5000 + i * 100 + (i % 2) * 20), OnRelease);
+	}
+	EXPECT_NEAR(Buffer.GetStats().JitterMs, 20.0, 0.1);
+
+	Buffer.ResetStats();
+	EXPECT_EQ(Buffer.GetStats().JitterMs, 0.0);
+}
+
+TEST(ReconnectBackoff, JitteredAndCapped)
+{
+	Inworld::ReconnectBackoff::Settings Settings;
+	Settings.BaseDelay = 0.25f;
+	Settings.MaxDelay = 5.f;
+	Settings.Jitter = 0.5f;
+	Inworld::ReconnectBackoff Backoff(Settings, 1);
+	Inworld::ReconnectBackoff Other(Settings, 2);
+
+	EXPECT_EQ(Backoff.NextDelay(), 0.f);
+	Other.NextDelay();
+	bool bJittered = false;
+	for (uint32_t Attempt = 1; Attempt < 40; Attempt++)
+	{
+		const float Cap = std::min(Settings.MaxDelay, Settings.BaseDelay * std::pow(2.f, Attempt - 1.f));
+		const float Delay = Backoff.NextDelay();
+		EXPECT_LE(Delay, Cap);
+		EXPECT_GE(Delay, Cap * (1.f - Settings.Jitter));
+		bJittered |= Delay != Other.NextDelay();
+	}
+	EXPECT_TRUE(bJittered);
+	EXPECT_EQ(Backoff.GetAttempts(), 40);
+
+	Backoff.Reset();
+	EXPECT_EQ(Backoff.NextDelay(), 0.f);
+}
+
+TEST(PacketReplayBuffer, AcknowledgeAndExpire)
+{
+	using Buffer = Inworld::PacketReplayBuffer<int>;
+	const Buffer::Clock::time_point Start;
+	auto At = [Start](int Ms) { return Start + std::chrono::milliseconds(Ms); };
+
+	Buffer::Settings Settings;
+	Settings.MaxAge = std::chrono::milliseconds(1000);
+	Settings.MaxPackets = 3;
+	Buffer Replay(Settings);
+
+	Replay.OnWritten(1, At(0));
+	Replay.OnWritten(2, At(10));
+	Replay.OnReceived();
+	Replay.OnWritten(3, At(20));
+	Replay.OnWritten(4, At(30));
+	EXPECT_EQ(Replay.TakeUnacknowledged(At(100)), std::vector<int>({ 3, 4 }));
+	EXPECT_EQ(Replay.GetNumHeld(), 0);
+
+	for (int i = 5; i <= 8; i++)
+	{
+		Replay.OnWritten(i, At(i * 100));
+	}
+	EXPECT_EQ(Replay.TakeUnacknowledged(At(1650)), std::vector<int>({ 7, 8 }));
+
+	const Buffer::Stats Stats = Replay.GetStats();
+	EXPECT_EQ(Stats.Written, 8);
+	EXPECT_EQ(Stats.Acknowledged, 2);
+	EXPECT_EQ(Stats.Replayed, 4);
+	EXPECT_EQ(Stats.Expired, 2);
+}
+
+namespace Reconnect
+{
+	// Stands in for the engine's session stream. A write goes through while the stream is open, the server
+	// replies every few packets. Dropping the stream loses what was written since the last reply and refuses
+	// new streams for a while.
+	class MockServer
+	{
+	public:
+		explicit MockServer(uint32_t InReplyEvery) : ReplyEvery(InReplyEvery) {}
+
+		bool Open(uint64_t Now)
+		{
+			if (Now < DownUntil)
+			{
+				return false;
+			}
+			bOpen = true;
+			return true;
+		}
+
+		// Returns false when the stream is gone, true with bOutReply when the server sent something back.
+		bool Write(int Packet, bool& bOutReply)
+		{
+			bOutReply = false;
+			if (!bOpen)
+			{
+				return false;
+			}
+			InFlight.push_back(Packet);
+			if (InFlight.size() >= ReplyEvery)
+			{
+				Received.insert(Received.end(), InFlight.begin(), InFlight.end());
+				InFlight.clear();
+				bOutReply = true;
+			}
+			return true;
+		}
+
+		void DropStream(uint64_t Now, uint64_t DownMs)
+		{
+			bOpen = false;
+			InFlight.clear();
+			DownUntil = Now + DownMs;
+		}
+
+		// The server got what was written but the stream dropped before it replied.
+		void DropStreamAfterReceiving(uint64_t Now, uint64_t DownMs)
+		{
+			Received.insert(Received.end(), InFlight.begin(), InFlight.end());
+			DropStream(Now, DownMs);
+		}
+
+		// The server's end of the session is closed by the client.
+		void Finish()
+		{
+			Received.insert(Received.end(), InFlight.begin(), InFlight.end());
+			InFlight.clear();
+		}
+
+		std::vector<int> Received;
+
+	private:
+		uint32_t ReplyEvery;
+		bool bOpen = false;
+		uint64_t DownUntil = 0;
+		std::vector<int> InFlight;
+	};
+
+	struct Drop
+	{
+		uint64_t At;
+		uint64_t DownMs;
+	};
+
+	struct Result
+	{
+		std::vector<uint64_t> ReconnectMs;
+		std::vector<int> Received;
+		uint64_t Replayed = 0;
+	};
+
+	// Sends a packet every 20ms through a stream the server drops on command, reconnecting with NextDelay
+	// between attempts and replaying what may have been lost.
+	Result RunSession(const std::vector<Drop>& Drops, int NumPackets, const std::function<float()>& NextDelay, const std::function<void()>& OnConnected)
+	{
+		constexpr uint64_t StepMs = 5;
+		MockServer Server(4);
+		Inworld::PacketReplayBuffer<int> Replay;
+		std::deque<int> Outgoing;
+		Result Out;
+
+		bool bConnected = Server.Open(0);
+		uint64_t DisconnectedAt = 0;
+		uint64_t NextAttempt = 0;
+		size_t NextDrop = 0;
+		int NextPacket = 0;
+		for (uint64_t Now = 0; NextPacket < NumPackets || !Outgoing.empty() || !bConnected; Now += StepMs)
+		{
+			const auto Time = Inworld::PacketReplayBuffer<int>::Clock::time_point() + std::chrono::milliseconds(Now);
+			if (NextDrop < Drops.size() && Now >= Drops[NextDrop].At)
+			{
+				Server.DropStream(Now, Drops[NextDrop].DownMs);
+				NextDrop++;
+			}
+			if (Now % 20 == 0 && NextPacket < NumPackets)
+			{
+				Outgoing.push_back(NextPacket++);
+			}
+
+			if (!bConnected && Now >= NextAttempt)
+			{
+				if (Server.Open(Now))
+				{
+					bConnected = true;
+					Out.ReconnectMs.push_back(Now - DisconnectedAt);
+					OnConnected();
+					std::vector<int> Lost = Replay.TakeUnacknowledged(Time);
+					Out.Replayed += Lost.size();
+					Outgoing.insert(Outgoing.begin(), Lost.begin(), Lost.end());
+				}
+				else
+				{
+					NextAttempt = Now + static_cast<uint64_t>(NextDelay() * 1000.f);
+				}
+			}
+
+			while (bConnected && !Outgoing.empty())
+			{
+				bool bReply;
+				if (!Server.Write(Outgoing.front(), bReply))
+				{
+					bConnected = false;
+					DisconnectedAt = Now;
+					NextAttempt = Now + static_cast<uint64_t>(NextDelay() * 1000.f);
+					break;
+				}
+				Replay.OnWritten(Outgoing.front(), Time);
+				Outgoing.pop_front();
+				if (bReply)
+				{
+					Replay.OnReceived();
+				}
+			}
+		}
+
+		Server.Finish();
+		Out.Received = Server.Received;
+		return Out;
+	}
+}
+
+TEST(Reconnect, MockServerDropsStreams)
+{
+	using namespace Reconnect;
+
+	// A blip, an outage and a drop the server recovers from at once.
+	const std::vector<Drop> Drops = { { 2000, 300 }, { 5000, 3000 }, { 12000, 0 } };
+	constexpr int NumPackets = 1000;
+
+	Inworld::ReconnectBackoff Backoff(Inworld::ReconnectBackoff::Settings(), 7);
+	const Result New = RunSession(Drops, NumPackets, [&Backoff]() { return Backoff.NextDelay(); }, [&Backoff]() { Backoff.Reset(); });
+
+	// The previous schedule, 1s first and then roughly doubling.
+	float Current = 1.f;
+	const Result Old = RunSession(Drops, NumPackets,
+		[&Current]() { const float Delay = Current; Current += std::min(Current + 0.25f, 5.f); return Delay; },
+		[&Current]() { Current = 1.f; });
+
+	for (const Result* Sim : { &Old, &New })
+	{
+		std::cout << (Sim == &New ? "Jittered backoff" : "Previous backoff") << " reconnect ms:";
+		for (const uint64_t Ms : Sim->ReconnectMs)
+		{
+			std::cout << " " << Ms;
+		}
+		std::cout << ", " << Sim->Replayed << " packets replayed" << std::endl;
+	}
+
+	ASSERT_EQ(New.ReconnectMs.size(), Drops.size());
+	ASSERT_EQ(Old.ReconnectMs.size(), Drops.size());
+	for (size_t i = 0; i < Drops.size(); i++)
+	{
+		// Every delay is at most the time waited so far plus the base delay.
+		EXPECT_LE(New.ReconnectMs[i], 2 * Drops[i].DownMs + 250 + 10);
+	}
+	// Blips cost a fraction of the previous first delay, a server that is back at once is reached on the next step.
+	EXPECT_LT(New.ReconnectMs[0], Old.ReconnectMs[0]);
+	EXPECT_LE(New.ReconnectMs[2], 5);
+
+	// Nothing lost and in order, a packet is only seen twice when its reply was lost with the stream.
+	std::vector<int> Unique = New.Received;
+	Unique.erase(std::unique(Unique.begin(), Unique.end()), Unique.end());
+	std::vector<int> Expected(NumPackets);
+	std::iota(Expected.begin(), Expected.end(), 0);
+	EXPECT_EQ(Unique, Expected);
+	EXPECT_GT(New.Replayed, 0);
+	EXPECT_LE(New.Received.size() - NumPackets, New.Replayed);
+}
+
+TEST(PacketReplayBuffer, ReceivedButUnansweredNotDuplicated)
+{
+	using namespace Reconnect;
+	using Buffer = Inworld::PacketReplayBuffer<int>;
+	const Buffer::Clock::time_point Now;
+
+	// Player input below 100, idempotent control packets from 100.
+	Buffer::Settings Settings;
+	Settings.IsReplaySafe = [](const int& Packet) { return Packet >= 100; };
+	Buffer Replay(Settings);
+	MockServer Server(4);
+
+	auto Write = [&](const std::vector<int>& Packets)
+	{
+		for (const int Packet : Packets)
+		{
+			bool bReply;
+			ASSERT_TRUE(Server.Write(Packet, bReply));
+			Replay.OnWritten(Packet, Now);
+			if (bReply)
+			{
+				Replay.OnReceived();
+			}
+		}
+	};
+
+	ASSERT_TRUE(Server.Open(0));
+	Write({ 0, 1, 2, 3, 4, 100, 5 });
+	Server.DropStreamAfterReceiving(0, 0);
+
+	ASSERT_TRUE(Server.Open(0));
+	const std::vector<int> Replayed = Replay.TakeUnacknowledged(Now);
+	EXPECT_EQ(Replayed, std::vector<int>({ 100 }));
+	Write(Replayed);
+	Write({ 6, 7 });
+	Server.Finish();
+
+	// Every input reached the server once, the control packet twice.
+	for (int Packet = 0; Packet <= 7; Packet++)
+	{
+		EXPECT_EQ(std::count(Server.Received.begin(), Server.Received.end(), Packet), 1) << Packet;
+	}
+	EXPECT_EQ(std::count(Server.Received.begin(), Server.Received.end(), 100), 2);
+
+	const Buffer::Stats Stats = Replay.GetStats();
+	EXPECT_EQ(Stats.Acknowledged, 4);
+	EXPECT_EQ(Stats.Replayed, 1);
+	EXPECT_EQ(Stats.Discarded, 2);
+}
+
+TEST(SessionSnapshotStore, RoundTripAndVersioning)
+{
+	const std::string FilePath = testing::TempDir() + "SessionSnapshot.bin";
+	const Inworld::SessionSnapshotStore Store(FilePath, "workspaces/w/scenes/s|user");
+	Store.Remove();
+
+	auto ReadFile = [&FilePath]()
+	{
+		std::ifstream File(FilePath, std::ios::binary);
+		return std::string((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+	};
+	auto WriteFile = [&FilePath](const std::string& Content)
+	{
+		std::ofstream File(FilePath, std::ios::binary | std::ios::trunc);
+		File << Content;
+	};
+
+	// Session states are mostly repeated protobuf field names and text.
+	Inworld::SessionSnapshot Snapshot;
+	Snapshot.SceneName = "workspaces/w/scenes/s";
+	for (int32_t i = 0; Snapshot.State.size() < 256 * 1024; i++)
+	{
+		Snapshot.State += "interaction " + std::to_string(i) + ": the character said hello to the player again. ";
+	}
+	Snapshot.SavedAt = 1700000000;
+
+	Inworld::SessionSnapshot Loaded;
+	EXPECT_FALSE(Store.Load(Loaded));
+	ASSERT_TRUE(Store.Save(Snapshot));
+	const std::string Valid = ReadFile();
+	EXPECT_LT(Valid.size(), Snapshot.State.size() / 4);
+
+	ASSERT_TRUE(Store.Load(Loaded));
+	EXPECT_EQ(Loaded.SceneName, Snapshot.SceneName);
+	EXPECT_EQ(Loaded.State, Snapshot.State);
+	EXPECT_EQ(Loaded.SavedAt, Snapshot.SavedAt);
+
+	// Another scene or user doesn't see the snapshot.
+	EXPECT_FALSE(Inworld::SessionSnapshotStore(FilePath, "workspaces/w/scenes/s|other").Load(Loaded));
+
+	// Other versions are ignored but kept.
+	std::string OtherVersion = Valid;
+	OtherVersion[4]++;
+	WriteFile(OtherVersion);
+	EXPECT_FALSE(Store.Load(Loaded));
+	EXPECT_EQ(ReadFile(), OtherVersion);
+
+	// Corrupted files are removed.
+	std::string Corrupted = Valid;
+	Corrupted[Corrupted.size() - 3] ^= 0x5a;
+	for (const auto& File : { Corrupted, Valid.substr(0, Valid.size() - 1), Valid.substr(0, 10), Valid + "x" })
+	{
+		WriteFile(File);
+		EXPECT_FALSE(Store.Load(Loaded));
+		EXPECT_TRUE(ReadFile().empty());
+	}
+
+	// States that don't compress are stored as they are.
+	std::mt19937 Rng(3);
+	Snapshot.State.resize(4096);
+	for (char& C : Snapshot.State)
+	{
+		C = static_cast<char>(Rng());
+	}
+	ASSERT_TRUE(Store.Save(Snapshot));
+	EXPECT_GT(ReadFile().size(), Snapshot.State.size());
+	ASSERT_TRUE(Store.Load(Loaded));
+	EXPECT_EQ(Loaded.State, Snapshot.State);
+
+	Store.Remove();
+}
+
+TEST(RateMeter, SlidingWindowAndRestart)
+{
+	using namespace std::chrono;
+	using Meter = Inworld::RateMeter<2>;
+
+	// Packets and bytes of a transport sampled every 250ms, like the debugger does: 60 packets of 100 bytes a second
+	// for 5s, then 200 a second.
+	Meter Rates(seconds(2));
+	const auto T0 = Meter::Clock::now();
+	Meter::Counters Counters = { 0, 0 };
+	Rates.Sample(Counters, T0);
+	EXPECT_EQ(Rates.GetRate(0), 0.0);
+
+	int32_t Ms = 250;
+	auto Run = [&](int32_t UntilMs, uint64_t PacketsPerSecond)
+	{
+		for (; Ms <= UntilMs; Ms += 250)
+		{
+			Counters[0] += PacketsPerSecond / 4;
+			Counters[1] += PacketsPerSecond / 4 * 100;
+			Rates.Sample(Counters, T0 + milliseconds(Ms));
+		}
+	};
+
+	Run(5000, 60);
+	EXPECT_NEAR(Rates.GetRate(0), 60.0, 0.001);
+	EXPECT_NEAR(Rates.GetRate(1), 6000.0, 0.001);
+
+	// Half the window at the new rate.
+	Run(6000, 200);
+	EXPECT_NEAR(Rates.GetRate(0), 130.0, 0.001);
+
+	Run(8000, 200);
+	EXPECT_NEAR(Rates.GetRate(0), 200.0, 0.001);
+	EXPECT_NEAR(Rates.GetRate(1), 20000.0, 0.001);
+
+	// A new client counts from 0 again.
+	Rates.Sample({ 10, 1000 }, T0 + milliseconds(Ms));
+	EXPECT_EQ(Rates.GetRate(0), 0.0);
+	Rates.Sample({ 20, 2000 }, T0 + milliseconds(Ms + 1000));
+	EXPECT_NEAR(Rates.GetRate(0), 10.0, 0.001);
+	EXPECT_NEAR(Rates.GetRate(1), 1000.0, 0.001);
+}
+
+TEST(MetricsRegistry, ShardedUpdatesFromThreads)
+{
+	Inworld::MetricsRegistry Registry;
+	const auto Packets = Registry.RegisterCounter("packets");
+	const auto Latency = Registry.RegisterHistogram("latency_us");
+	const auto Queue = Registry.RegisterGauge("queue");
+
+	constexpr int NumThreads = 16;
+	constexpr int UpdatesPerThread = 20000;
+	std::vector<std::thread> Threads;
+	for (int t = 0; t < NumThreads; t++)
+	{
+		Threads.emplace_back([&, t]()
+		{
+			for (int i = 0; i < UpdatesPerThread; i++)
+			{
+				Packets.Add();
+				Latency.Record(100 + t);
+			}
+			Queue.Set(t);
+		});
+	}
+
+	// Snapshots taken while updating only ever see counts grow.
+	int64_t LastCount = 0;
+	for (int i = 0; i < 20; i++)
+	{
+		const int64_t Count = Registry.Snapshot().Find("packets")->Value;
+		EXPECT_GE(Count, LastCount);
+		LastCount = Count;
+	}
+
+	for (auto& Thread : Threads)
+	{
+		Thread.join();
+	}
+
+	const Inworld::MetricsSnapshot Snapshot = Registry.Snapshot();
+	ASSERT_EQ(Snapshot.Metrics.size(), 3);
+	EXPECT_EQ(Snapshot.Find("packets")->Value, NumThreads * UpdatesPerThread);
+	const Inworld::HistogramStats& Stats = Snapshot.Find("latency_us")->Histogram;
+	EXPECT_EQ(Stats.Count, NumThreads * UpdatesPerThread);
+	EXPECT_EQ(Stats.Min, 100.0);
+	EXPECT_EQ(Stats.Max, 100.0 + NumThreads - 1);
+	EXPECT_NEAR(Stats.Mean, 100.0 + (NumThreads - 1) / 2.0, 0.001);
+	EXPECT_NEAR(Stats.P50, 108.0, 108.0 / 8);
+	EXPECT_GE(Snapshot.Find("queue")->Value, 0);
+	EXPECT_LT(Snapshot.Find("queue")->Value, NumThreads);
+
+	Registry.Reset();
+	EXPECT_EQ(Registry.Snapshot().Find("packets")->Value, 0);
+	EXPECT_EQ(Registry.Snapshot().Find("latency_us")->Histogram.Count, 0);
+}
+
+TEST(MetricsRegistry, RegistrationAndLimits)
+{
+	Inworld::MetricsRegistry Registry(Inworld::MetricsRegistry::HistogramBuckets::BucketCount + 4);
+
+	// The same name is the same metric, so several clients add up.
+	const auto First = Registry.RegisterCounter("packets");
+	const auto Second = Registry.RegisterCounter("packets");
+	First.Add(2);
+	Second.Add(3);
+	EXPECT_EQ(Registry.Snapshot().Find("packets")->Value, 5);
+
+	// Another type under a taken name, or no room left, gives a handle that does nothing.
+	Registry.RegisterGauge("packets").Set(100);
+	Registry.RegisterHistogram("latency_us").Record(1);
+	Registry.RegisterHistogram("too_many_us").Record(1);
+	Registry.RegisterCounter("too_many").Add();
+
+	const Inworld::MetricsSnapshot Snapshot = Registry.Snapshot();
+	ASSERT_EQ(Snapshot.Metrics.size(), 2);
+	EXPECT_EQ(Snapshot.Find("packets")->Value, 5);
+	EXPECT_EQ(Snapshot.Find("latency_us")->Histogram.Count, 1);
+	EXPECT_EQ(Snapshot.Find("too_many_us"), nullptr);
+
+	Inworld::MetricsRegistry::Counter Invalid;
+	Invalid.Add();
+}
+
+TEST(MetricsRegistry, ExportCsvAndJson)
+{
+	Inworld::MetricsRegistry Registry;
+	Registry.RegisterCounter("inworld.transport.sent.packets").Add(42);
+	Registry.RegisterGauge("queue,with \"quotes\"").Set(-3);
+	const auto Latency = Registry.RegisterHistogram("latency_us");
+	// Exact below 2^3, the buckets are one wide there.
+	Latency.Record(2);
+	Latency.Record(6);
+
+	Inworld::MetricsSnapshot Snapshot = Registry.Snapshot();
+	Snapshot.Time = std::chrono::system_clock::time_point(std::chrono::milliseconds(1700000000123));
+
+	std::ostringstream Csv;
+	Inworld::MetricsRegistry::WriteCsv(Snapshot, Csv);
+	EXPECT_EQ(Csv.str(),
+		"time_ms,name,type,value,count,min,mean,p50,p95,p99,max\n"
+		"1700000000123,inworld.transport.sent.packets,counter,42,,,,,,,\n"
+		"1700000000123,\"queue,with \"\"quotes\"\"\",gauge,-3,,,,,,,\n"
+		"1700000000123,latency_us,histogram,,2,2,4,2,6,6,6\n");
+
+	std::ostringstream Json;
+	Inworld::MetricsRegistry::WriteJson(Snapshot, Json);
+	EXPECT_EQ(Json.str(),
+		"{\"time_ms\":1700000000123,\"metrics\":{"
+		"\"inworld.transport.sent.packets\":{\"type\":\"counter\",\"value\":42},"
+		"\"queue,with \\\"quotes\\\"\":{\"type\":\"gauge\",\"value\":-3},"
+		"\"latency_us\":{\"type\":\"histogram\",\"count\":2,\"min\":2,\"mean\":4,\"p50\":2,\"p95\":6,\"p99\":6,\"max\":6}}}\n");
+
+	// Appended snapshots share one CSV header.
+	const std::string Path = "MetricsRegistryTest.csv";
+	std::remove(Path.c_str());
+	ASSERT_TRUE(Inworld::MetricsRegistry::AppendToFile(Snapshot, Path));
+	ASSERT_TRUE(Inworld::MetricsRegistry::AppendToFile(Snapshot, Path));
+	std::ifstream File(Path);
+	std::string Line;
+	int NumLines = 0;
+	int NumHeaders = 0;
+	while (std::getline(File, Line))
+	{
+		NumLines++;
+		NumHeaders += Line.rfind("time_ms,", 0) == 0;
+	}
+	File.close();
+	std::remove(Path.c_str());
+	EXPECT_EQ(NumLines, 7);
+	EXPECT_EQ(NumHeaders, 1);
+}
+
+namespace PacketRecordings
+{
+	static std::string MakeTextPacket(const std::string& Text)
+	{
+		InworldPakets::InworldPacket Proto;
+		Proto.mutable_text()->set_text(Text);
+		Proto.mutable_text()->set_final(true);
+		Proto.mutable_routing()->mutable_source()->set_name("agent");
+		return Proto.SerializeAsString();
+	}
+
+	static std::string MakeScene(const std::string& AgentId)
+	{
+		InworldEngine::LoadSceneResponse Scene;
+		Scene.add_agents()->set_agent_id(AgentId);
+		return Scene.SerializeAsString();
+	}
+}
+
+TEST(PacketRecording, RoundTripAndTruncation)
+{
+	const std::string Path = "PacketRecordingTest.iwpr";
+	{
+		Inworld::PacketRecorder Recorder;
+		ASSERT_TRUE(Recorder.Open(Path));
+		const auto Start = std::chrono::steady_clock::now();
+		Recorder.Record(Inworld::RecordedPacketKind::Scene, PacketRecordings::MakeScene("agent"), Start + std::chrono::microseconds(10));
+		Recorder.Record(Inworld::RecordedPacketKind::Incoming, PacketRecordings::MakeTextPacket("hello"), Start + std::chrono::microseconds(1500));
+		// Out of order times are clamped to the previous record's.
+		Recorder.Record(Inworld::RecordedPacketKind::Outgoing, PacketRecordings::MakeTextPacket("hi"), Start + std::chrono::microseconds(1000));
+		Recorder.Record(Inworld::RecordedPacketKind::Incoming, std::string(300, 'x'), Start + std::chrono::seconds(2));
+	}
+
+	Inworld::PacketRecordingReader Reader;
+	ASSERT_TRUE(Reader.Open(Path));
+	std::vector<Inworld::RecordedPacket> Packets;
+	Inworld::RecordedPacket Packet;
+	while (Reader.Next(Packet))
+	{
+		Packets.push_back(Packet);
+	}
+	ASSERT_EQ(Packets.size(), 4);
+	EXPECT_EQ(Packets[0].Kind, Inworld::RecordedPacketKind::Scene);
+	EXPECT_EQ(Packets[1].Kind, Inworld::RecordedPacketKind::Incoming);
+	EXPECT_EQ(Packets[2].Kind, Inworld::RecordedPacketKind::Outgoing);
+	EXPECT_EQ(Packets[1].Data, PacketRecordings::MakeTextPacket("hello"));
+	EXPECT_EQ(Packets[3].Data, std::string(300, 'x'));
+	// Relative to when the recorder opened, which was after Start.
+	EXPECT_EQ((Packets[1].Time - Packets[0].Time).count(), 1490);
+	EXPECT_EQ(Packets[2].Time, Packets[1].Time);
+	EXPECT_EQ((Packets[3].Time - Packets[1].Time).count(), 2000000 - 1500);
+
+	// A recording cut short, as by a crash, reads up to the last whole record.
+	std::string Bytes;
+	{
+		std::ifstream File(Path, std::ios::binary);
+		Bytes.assign(std::istreambuf_iterator<char>(File), std::istreambuf_iterator<char>());
+	}
+	{
+		std::ofstream File(Path, std::ios::binary | std::ios::trunc);
+		File.write(Bytes.data(), Bytes.size() - 100);
+	}
+	Inworld::PacketRecordingReader Truncated;
+	ASSERT_TRUE(Truncated.Open(Path));
+	int NumRead = 0;
+	while (Truncated.Next(Packet))
+	{
+		NumRead++;
+	}
+	EXPECT_EQ(NumRead, 3);
+
+	{
+		std::ofstream File(Path, std::ios::binary | std::ios::trunc);
+		File << "not a recording";
+	}
+	Inworld::PacketRecordingReader Invalid;
+	EXPECT_FALSE(Invalid.Open(Path));
+	std::remove(Path.c_str());
+}
+
+TEST(ReplayReaderWriter, PacingAndCancel)
+{
+	const std::string Path = "ReplayReaderWriterTest.iwpr";
+	{
+		Inworld::PacketRecorder Recorder;
+		ASSERT_TRUE(Recorder.Open(Path));
+		const auto Start = std::chrono::steady_clock::now();
+		Recorder.Record(Inworld::RecordedPacketKind::Scene, PacketRecordings::MakeScene("agent"), Start + std::chrono::milliseconds(100));
+		Recorder.Record(Inworld::RecordedPacketKind::Incoming, PacketRecordings::MakeTextPacket("one"), Start + std::chrono::milliseconds(140));
+		Recorder.Record(Inworld::RecordedPacketKind::Outgoing, PacketRecordings::MakeTextPacket("skipped"), Start + std::chrono::milliseconds(150));
+		Recorder.Record(Inworld::RecordedPacketKind::Incoming, PacketRecordings::MakeTextPacket("two"), Start + std::chrono::milliseconds(180));
+		Recorder.Record(Inworld::RecordedPacketKind::Incoming, PacketRecordings::MakeTextPacket("late"), Start + std::chrono::seconds(60));
+	}
+
+	// Twice the speed, the packets are due 20 and 40ms after the scene.
+	Inworld::ReplayReaderWriter Replay(2.f);
+	InworldEngine::LoadSceneResponse Scene;
+	ASSERT_TRUE(Replay.Open(Path, &Scene));
+	ASSERT_EQ(Scene.agents_size(), 1);
+	EXPECT_EQ(Scene.agents(0).agent_id(), "agent");
+
+	const auto ReplayStart = std::chrono::steady_clock::now();
+	InworldPakets::InworldPacket Packet;
+	ASSERT_TRUE(Replay.Read(&Packet));
+	EXPECT_EQ(Packet.text().text(), "one");
+	EXPECT_GE(std::chrono::steady_clock::now() - ReplayStart, std::chrono::milliseconds(19));
+	ASSERT_TRUE(Replay.Read(&Packet));
+	EXPECT_EQ(Packet.text().text(), "two");
+	const auto Elapsed = std::chrono::steady_clock::now() - ReplayStart;
+	EXPECT_GE(Elapsed, std::chrono::milliseconds(39));
+	EXPECT_LT(Elapsed, std::chrono::seconds(1));
+
+	EXPECT_TRUE(Replay.Write(Packet, grpc::WriteOptions()));
+	EXPECT_EQ(Replay.GetNumWritten(), 1);
+
+	// The last packet is half a minute away, cancelling must not wait for it.
+	std::thread Canceller([&Replay]()
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			Replay.Cancel();
+		});
+	EXPECT_FALSE(Replay.Read(&Packet));
+	Canceller.join();
+	EXPECT_LT(std::chrono::steady_clock::now() - ReplayStart, std::chrono::seconds(5));
+	EXPECT_EQ(Replay.Finish().error_code(), grpc::StatusCode::CANCELLED);
+	EXPECT_FALSE(Replay.Write(Packet, grpc::WriteOptions()));
+	EXPECT_EQ(Replay.GetNumRead(), 2);
+
+	// At speed 0 the recording is read through without waiting and finishes out of range.
+	Inworld::ReplayReaderWriter Unpaced(0.f);
+	ASSERT_TRUE(Unpaced.Open(Path));
+	int NumRead = 0;
+	while (Unpaced.Read(&Packet))
+	{
+		NumRead++;
+	}
+	EXPECT_EQ(NumRead, 3);
+	EXPECT_EQ(Unpaced.Finish().error_code(), grpc::StatusCode::OUT_OF_RANGE);
+	std::remove(Path.c_str());
+}
+
+TEST(ReplayReaderWriter, RunnableReadThroughput)
+{
+	const std::string Path = "ReplayThroughputTest.iwpr";
+	constexpr int NumPackets = 20000;
+	{
+		Inworld::PacketRecorder Recorder;
+		ASSERT_TRUE(Recorder.Open(Path));
+		const auto Start = std::chrono::steady_clock::now();
+		Recorder.Record(Inworld::RecordedPacketKind::Scene, PacketRecordings::MakeScene("agent"), Start);
+		for (int32_t i = 0; i < NumPackets; i++)
+		{
+			Recorder.Record(Inworld::RecordedPacketKind::Incoming, PacketRecordings::MakeTextPacket("packet " + std::to_string(i)), Start + std::chrono::milliseconds(i));
+		}
+	}
+
+	// The read task parses and queues every packet as it does off the network, the main thread flush pops them.
+	Inworld::ReplayReaderWriter Replay(0.f);
+	ASSERT_TRUE(Replay.Open(Path));
+	std::atomic<bool> bFinished = false;
+	Inworld::SharedQueue<std::shared_ptr<Inworld::Packet>> Queue;
+	grpc::StatusCode FinishCode = grpc::StatusCode::OK;
+	Inworld::RunnableRead Read(Replay, bFinished, Queue, [](const std::shared_ptr<Inworld::Packet>) {}, [&FinishCode](const grpc::Status& Status) { FinishCode = Status.error_code(); });
+
+	const auto Start = std::chrono::steady_clock::now();
+	std::thread ReadThread([&Read]() { Read.Run(); });
+	int NumFlushed = 0;
+	std::shared_ptr<Inworld::Packet> Packet;
+	while (!Read.IsDone() || !Queue.IsEmpty())
+	{
+		while (Queue.PopFront(Packet))
+		{
+			NumFlushed++;
+		}
+		std::this_thread::yield();
+	}
+	ReadThread.join();
+	const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	std::remove(Path.c_str());
+
+	EXPECT_EQ(NumFlushed, NumPackets);
+	EXPECT_EQ(FinishCode, grpc::StatusCode::OUT_OF_RANGE);
+	std::cout << "Replayed " << NumPackets << " packets in " << Seconds * 1000.0 << "ms, " << NumPackets / Seconds << " packets/s" << std::endl;
+}
+
 #endif
@@ -0,0 +1,161 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace Inworld
+{
+	struct HistogramStats
+	{
+		uint64_t Count = 0;
+		double Min = 0.0;
+		double Max = 0.0;
+		double Mean = 0.0;
+		double P50 = 0.0;
+		double P95 = 0.0;
+		double P99 = 0.0;
+	};
+
+	// HDR-style log-linear histogram of unsigned integer values.
+	// Every power of two range is split into 2^SubBucketBits linear buckets,
+	// so the relative error of a reported value is below 2^-SubBucketBits.
+	// Record is O(1) and never allocates, storage is fixed at construction.
+	template<uint32_t SubBucketBits = 5, uint32_t MaxValueBits = 36>
+	class Histogram
+	{
+	public:
+		static constexpr uint32_t SubBucketCount = 1u << SubBucketBits;
+		static constexpr uint32_t BucketCount = (MaxValueBits - SubBucketBits + 1) * SubBucketCount;
+		static constexpr uint64_t MaxValue = (uint64_t(1) << MaxValueBits) - 1;
+
+		void Record(uint64_t Value)
+		{
+			if (Value > MaxValue)
+			{
+				Value = MaxValue;
+			}
+
+			_Counts[BucketIndex(Value)]++;
+			_Total++;
+			_Sum += Value;
+			_Min = Value < _Min ? Value : _Min;
+			_Max = Value > _Max ? Value : _Max;
+		}
+
+		void Reset()
+		{
+			_Counts.fill(0);
+			_Total = 0;
+			_Sum = 0;
+			_Min = UINT64_MAX;
+			_Max = 0;
+		}
+
+		uint64_t GetCount() const { return _Total; }
+
+		// Values recorded below Value, exact when Value is a bucket boundary, e.g. a power of two.
+		uint64_t CountBelow(uint64_t Value) const
+		{
+			const uint32_t End = BucketIndex(Value > MaxValue ? MaxValue : Value);
+			uint64_t Count = 0;
+			for (uint32_t i = 0; i < End; i++)
+			{
+				Count += _Counts[i];
+			}
+			return Count;
+		}
+
+		uint64_t ValueAtPercentile(double Percentile) const
+		{
+			if (_Total == 0)
+			{
+				return 0;
+			}
+
+			uint64_t Target = static_cast<uint64_t>(std::ceil(Percentile * 0.01 * _Total));
+			Target = Target == 0 ? 1 : Target;
+			uint64_t Accumulated = 0;
+			for (uint32_t i = 0; i < BucketCount; i++)
+			{
+				Accumulated += _Counts[i];
+				if (Accumulated >= Target)
+				{
+					const uint64_t Value = BucketMidpoint(i);
+					return Value < _Min ? _Min : (Value > _Max ? _Max : Value);
+				}
+			}
+			return _Max;
+		}
+
+		// Values are divided by Scale, e.g. 1000 to report microseconds as milliseconds.
+		HistogramStats GetStats(double Scale = 1.0) const
+		{
+			HistogramStats Stats;
+			Stats.Count = _Total;
+			if (_Total == 0)
+			{
+				return Stats;
+			}
+
+			Stats.Min = _Min / Scale;
+			Stats.Max = _Max / Scale;
+			Stats.Mean = (static_cast<double>(_Sum) / _Total) / Scale;
+			Stats.P50 = ValueAtPercentile(50.0) / Scale;
+			Stats.P95 = ValueAtPercentile(95.0) / Scale;
+			Stats.P99 = ValueAtPercentile(99.0) / Scale;
+			return Stats;
+		}
+
+		static uint32_t BucketIndex(uint64_t Value)
+		{
+			if (Value < SubBucketCount)
+			{
+				return static_cast<uint32_t>(Value);
+			}
+
+			uint32_t Msb = 0;
+			for (uint64_t V = Value; V > 1; V >>= 1)
+			{
+				Msb++;
+			}
+			const uint32_t Shift = Msb - SubBucketBits;
+			return ((Shift + 1) << SubBucketBits) + static_cast<uint32_t>((Value >> Shift) - SubBucketCount);
+		}
+
+		static uint64_t BucketLowerBound(uint32_t Index)
+		{
+			const uint32_t Group = Index >> SubBucketBits;
+			if (Group == 0)
+			{
+				return Index;
+			}
+
+			const uint64_t Sub = (Index & (SubBucketCount - 1)) + SubBucketCount;
+			return Sub << (Group - 1);
+		}
+
+		static uint64_t BucketMidpoint(uint32_t Index)
+		{
+			const uint32_t Group = Index >> SubBucketBits;
+			const uint64_t Width = Group == 0 ? 1 : (uint64_t(1) << (Group - 1));
+			return BucketLowerBound(Index) + Width / 2;
+		}
+
+	private:
+		std::array<uint32_t, BucketCount> _Counts = {};
+		uint64_t _Total = 0;
+		uint64_t _Sum = 0;
+		uint64_t _Min = UINT64_MAX;
+		uint64_t _Max = 0;
+	};
+
+	using LatencyHistogram = Histogram<>;
+}
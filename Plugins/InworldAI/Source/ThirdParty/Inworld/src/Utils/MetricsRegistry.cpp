@@ -0,0 +1,377 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#include "MetricsRegistry.h"
+#include "Log.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+namespace
+{
+	constexpr uint32_t SlotsPerCacheLine = 64 / sizeof(std::atomic<uint64_t>);
+	constexpr uint32_t InvalidSlot = UINT32_MAX;
+
+	using Buckets = Inworld::MetricsRegistry::HistogramBuckets;
+	// Histogram slots, after the buckets. The minimum is kept inverted, so every slot starts at 0 and only grows.
+	constexpr uint32_t SumOffset = Buckets::BucketCount;
+	constexpr uint32_t MaxOffset = Buckets::BucketCount + 1;
+	constexpr uint32_t InvertedMinOffset = Buckets::BucketCount + 2;
+	constexpr uint32_t HistogramSlots = Buckets::BucketCount + 3;
+
+	void AtomicMax(std::atomic<uint64_t>& Slot, uint64_t Value)
+	{
+		uint64_t Current = Slot.load(std::memory_order_relaxed);
+		while (Value > Current && !Slot.compare_exchange_weak(Current, Value, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	const char* TypeName(Inworld::MetricType Type)
+	{
+		switch (Type)
+		{
+		case Inworld::MetricType::Counter: return "counter";
+		case Inworld::MetricType::Gauge: return "gauge";
+		case Inworld::MetricType::Histogram: return "histogram";
+		}
+		return "unknown";
+	}
+
+	int64_t ToMilliseconds(std::chrono::system_clock::time_point Time)
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(Time.time_since_epoch()).count();
+	}
+
+	void WriteJsonString(std::ostream& Stream, const std::string& Str)
+	{
+		Stream << '"';
+		for (const char C : Str)
+		{
+			if (C == '"' || C == '\\')
+			{
+				Stream << '\\';
+			}
+			Stream << C;
+		}
+		Stream << '"';
+	}
+
+	void WriteCsvString(std::ostream& Stream, const std::string& Str)
+	{
+		if (Str.find_first_of(",\"\n") == std::string::npos)
+		{
+			Stream << Str;
+			return;
+		}
+
+		Stream << '"';
+		for (const char C : Str)
+		{
+			Stream << C;
+			if (C == '"')
+			{
+				Stream << '"';
+			}
+		}
+		Stream << '"';
+	}
+}
+
+const Inworld::MetricValue* Inworld::MetricsSnapshot::Find(const std::string& Name) const
+{
+	for (const auto& Metric : Metrics)
+	{
+		if (Metric.Name == Name)
+		{
+			return &Metric;
+		}
+	}
+	return nullptr;
+}
+
+void Inworld::MetricsRegistry::Counter::Add(uint64_t Value) const
+{
+	if (_Registry)
+	{
+		_Registry->GetShard(GetThreadShard())[_Slot].fetch_add(Value, std::memory_order_relaxed);
+	}
+}
+
+void Inworld::MetricsRegistry::Gauge::Set(int64_t Value) const
+{
+	if (_Registry)
+	{
+		_Registry->GetShard(0)[_Slot].store(static_cast<uint64_t>(Value), std::memory_order_relaxed);
+	}
+}
+
+void Inworld::MetricsRegistry::Histogram::Record(uint64_t Value) const
+{
+	if (!_Registry)
+	{
+		return;
+	}
+
+	Value = Value > Buckets::MaxValue ? Buckets::MaxValue : Value;
+	std::atomic<uint64_t>* Slots = _Registry->GetShard(GetThreadShard()) + _Slot;
+	Slots[Buckets::BucketIndex(Value)].fetch_add(1, std::memory_order_relaxed);
+	Slots[SumOffset].fetch_add(Value, std::memory_order_relaxed);
+	AtomicMax(Slots[MaxOffset], Value);
+	AtomicMax(Slots[InvertedMinOffset], ~Value);
+}
+
+Inworld::MetricsRegistry::MetricsRegistry(uint32_t InMaxSlots)
+	: _MaxSlots(InMaxSlots)
+	, _ShardStride((InMaxSlots + SlotsPerCacheLine - 1) / SlotsPerCacheLine * SlotsPerCacheLine)
+{
+	// One extra cache line to align the first shard.
+	const size_t Size = static_cast<size_t>(NumShards) * _ShardStride + SlotsPerCacheLine;
+	_Storage.reset(new std::atomic<uint64_t>[Size]);
+	const uintptr_t Address = reinterpret_cast<uintptr_t>(_Storage.get());
+	const uintptr_t Misalignment = Address % 64;
+	_Values = _Storage.get() + (Misalignment ? (64 - Misalignment) / sizeof(std::atomic<uint64_t>) : 0);
+	for (size_t i = 0; i < Size; i++)
+	{
+		_Storage[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+Inworld::MetricsRegistry::~MetricsRegistry() = default;
+
+Inworld::MetricsRegistry::Counter Inworld::MetricsRegistry::RegisterCounter(const std::string& Name)
+{
+	const uint32_t Slot = Register(Name, MetricType::Counter, 1);
+	return Slot != InvalidSlot ? Counter(this, Slot) : Counter();
+}
+
+Inworld::MetricsRegistry::Gauge Inworld::MetricsRegistry::RegisterGauge(const std::string& Name)
+{
+	const uint32_t Slot = Register(Name, MetricType::Gauge, 1);
+	return Slot != InvalidSlot ? Gauge(this, Slot) : Gauge();
+}
+
+Inworld::MetricsRegistry::Histogram Inworld::MetricsRegistry::RegisterHistogram(const std::string& Name)
+{
+	const uint32_t Slot = Register(Name, MetricType::Histogram, HistogramSlots);
+	return Slot != InvalidSlot ? Histogram(this, Slot) : Histogram();
+}
+
+uint32_t Inworld::MetricsRegistry::Register(const std::string& Name, MetricType Type, uint32_t NumSlots)
+{
+	std::lock_guard<std::mutex> Lock(_Mutex);
+	for (const auto& Metric : _Metrics)
+	{
+		if (Metric.Name == Name)
+		{
+			if (Metric.Type != Type)
+			{
+				Inworld::LogError("MetricsRegistry. %s is registered as a %s already", ARG_STR(Name), TypeName(Metric.Type));
+				return InvalidSlot;
+			}
+			return Metric.Slot;
+		}
+	}
+
+	if (_MaxSlots - _NumSlots < NumSlots)
+	{
+		Inworld::LogError("MetricsRegistry. No room for %s", ARG_STR(Name));
+		return InvalidSlot;
+	}
+
+	_Metrics.push_back({ Name, Type, _NumSlots });
+	_NumSlots += NumSlots;
+	return _Metrics.back().Slot;
+}
+
+uint32_t Inworld::MetricsRegistry::GetThreadShard()
+{
+	static std::atomic<uint32_t> NextShard = 0;
+	thread_local const uint32_t Shard = NextShard.fetch_add(1, std::memory_order_relaxed) % NumShards;
+	return Shard;
+}
+
+Inworld::MetricsSnapshot Inworld::MetricsRegistry::Snapshot() const
+{
+	MetricsSnapshot Result;
+	Result.Time = std::chrono::system_clock::now();
+
+	std::lock_guard<std::mutex> Lock(_Mutex);
+	Result.Metrics.reserve(_Metrics.size());
+	std::vector<uint64_t> Counts;
+	for (const auto& Metric : _Metrics)
+	{
+		MetricValue& Value = Result.Metrics.emplace_back();
+		Value.Name = Metric.Name;
+		Value.Type = Metric.Type;
+
+		if (Metric.Type == MetricType::Gauge)
+		{
+			Value.Value = static_cast<int64_t>(GetShard(0)[Metric.Slot].load(std::memory_order_relaxed));
+			continue;
+		}
+
+		if (Metric.Type == MetricType::Counter)
+		{
+			uint64_t Sum = 0;
+			for (uint32_t Shard = 0; Shard < NumShards; Shard++)
+			{
+				Sum += GetShard(Shard)[Metric.Slot].load(std::memory_order_relaxed);
+			}
+			Value.Value = static_cast<int64_t>(Sum);
+			continue;
+		}
+
+		Counts.assign(Buckets::BucketCount, 0);
+		uint64_t Total = 0;
+		uint64_t Sum = 0;
+		uint64_t Max = 0;
+		uint64_t InvertedMin = 0;
+		for (uint32_t Shard = 0; Shard < NumShards; Shard++)
+		{
+			const std::atomic<uint64_t>* Slots = GetShard(Shard) + Metric.Slot;
+			for (uint32_t i = 0; i < Buckets::BucketCount; i++)
+			{
+				const uint64_t Count = Slots[i].load(std::memory_order_relaxed);
+				Counts[i] += Count;
+				Total += Count;
+			}
+			Sum += Slots[SumOffset].load(std::memory_order_relaxed);
+			Max = std::max(Max, Slots[MaxOffset].load(std::memory_order_relaxed));
+			InvertedMin = std::max(InvertedMin, Slots[InvertedMinOffset].load(std::memory_order_relaxed));
+		}
+
+		HistogramStats& Stats = Value.Histogram;
+		Stats.Count = Total;
+		if (Total == 0)
+		{
+			continue;
+		}
+
+		const uint64_t Min = ~InvertedMin;
+		Stats.Min = static_cast<double>(Min);
+		Stats.Max = static_cast<double>(Max);
+		Stats.Mean = static_cast<double>(Sum) / Total;
+
+		// Same as Histogram::ValueAtPercentile.
+		const auto ValueAtPercentile = [&](double Percentile)
+		{
+			uint64_t Target = static_cast<uint64_t>(std::ceil(Percentile * 0.01 * Total));
+			Target = Target == 0 ? 1 : Target;
+			uint64_t Accumulated = 0;
+			for (uint32_t i = 0; i < Buckets::BucketCount; i++)
+			{
+				Accumulated += Counts[i];
+				if (Accumulated >= Target)
+				{
+					const uint64_t Midpoint = Buckets::BucketMidpoint(i);
+					return static_cast<double>(Midpoint < Min ? Min : (Midpoint > Max ? Max : Midpoint));
+				}
+			}
+			return static_cast<double>(Max);
+		};
+		Stats.P50 = ValueAtPercentile(50.0);
+		Stats.P95 = ValueAtPercentile(95.0);
+		Stats.P99 = ValueAtPercentile(99.0);
+	}
+	return Result;
+}
+
+void Inworld::MetricsRegistry::Reset()
+{
+	std::lock_guard<std::mutex> Lock(_Mutex);
+	for (uint32_t Shard = 0; Shard < NumShards; Shard++)
+	{
+		std::atomic<uint64_t>* Slots = GetShard(Shard);
+		for (uint32_t i = 0; i < _NumSlots; i++)
+		{
+			Slots[i].store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+void Inworld::MetricsRegistry::WriteCsv(const MetricsSnapshot& Snapshot, std::ostream& Stream, bool bHeader)
+{
+	if (bHeader)
+	{
+		Stream << "time_ms,name,type,value,count,min,mean,p50,p95,p99,max\n";
+	}
+
+	const int64_t TimeMs = ToMilliseconds(Snapshot.Time);
+	for (const auto& Metric : Snapshot.Metrics)
+	{
+		Stream << TimeMs << ',';
+		WriteCsvString(Stream, Metric.Name);
+		Stream << ',' << TypeName(Metric.Type) << ',';
+		if (Metric.Type == MetricType::Histogram)
+		{
+			const HistogramStats& Stats = Metric.Histogram;
+			Stream << ',' << Stats.Count << ',' << Stats.Min << ',' << Stats.Mean << ',' << Stats.P50 << ',' << Stats.P95 << ',' << Stats.P99 << ',' << Stats.Max << '\n';
+		}
+		else
+		{
+			Stream << Metric.Value << ",,,,,,,\n";
+		}
+	}
+}
+
+void Inworld::MetricsRegistry::WriteJson(const MetricsSnapshot& Snapshot, std::ostream& Stream)
+{
+	Stream << "{\"time_ms\":" << ToMilliseconds(Snapshot.Time) << ",\"metrics\":{";
+	bool bFirst = true;
+	for (const auto& Metric : Snapshot.Metrics)
+	{
+		Stream << (bFirst ? "" : ",");
+		bFirst = false;
+		WriteJsonString(Stream, Metric.Name);
+		Stream << ":{\"type\":\"" << TypeName(Metric.Type) << "\",";
+		if (Metric.Type == MetricType::Histogram)
+		{
+			const HistogramStats& Stats = Metric.Histogram;
+			Stream << "\"count\":" << Stats.Count << ",\"min\":" << Stats.Min << ",\"mean\":" << Stats.Mean
+				<< ",\"p50\":" << Stats.P50 << ",\"p95\":" << Stats.P95 << ",\"p99\":" << Stats.P99 << ",\"max\":" << Stats.Max << '}';
+		}
+		else
+		{
+			Stream << "\"value\":" << Metric.Value << '}';
+		}
+	}
+	Stream << "}}\n";
+}
+
+bool Inworld::MetricsRegistry::AppendToFile(const MetricsSnapshot& Snapshot, const std::string& Path)
+{
+	const auto EndsWith = [&Path](const std::string& Suffix)
+	{
+		return Path.size() >= Suffix.size() && Path.compare(Path.size() - Suffix.size(), Suffix.size(), Suffix) == 0;
+	};
+
+	std::ofstream File(Path, std::ios::app);
+	if (!File)
+	{
+		Inworld::LogError("MetricsRegistry. Can't open %s", ARG_STR(Path));
+		return false;
+	}
+
+	File << std::setprecision(10);
+	if (EndsWith(".json") || EndsWith(".jsonl"))
+	{
+		WriteJson(Snapshot, File);
+	}
+	else
+	{
+		WriteCsv(Snapshot, File, File.tellp() == 0);
+	}
+	return static_cast<bool>(File);
+}
+
+Inworld::MetricsRegistry& Inworld::GetMetricsRegistry()
+{
+	static MetricsRegistry Registry;
+	return Registry;
+}
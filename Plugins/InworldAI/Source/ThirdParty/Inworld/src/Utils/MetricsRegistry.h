@@ -0,0 +1,155 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#pragma once
+
+#include "../Define.h"
+#include "Histogram.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Inworld
+{
+	enum class MetricType : uint8_t
+	{
+		Counter,
+		Gauge,
+		Histogram,
+	};
+
+	struct MetricValue
+	{
+		std::string Name;
+		MetricType Type = MetricType::Counter;
+		// Counters and gauges.
+		int64_t Value = 0;
+		// Histograms, in recorded units.
+		HistogramStats Histogram;
+	};
+
+	struct MetricsSnapshot
+	{
+		std::chrono::system_clock::time_point Time;
+		// In registration order.
+		std::vector<MetricValue> Metrics;
+
+		const MetricValue* Find(const std::string& Name) const;
+	};
+
+	// Process wide counters, gauges and histograms. Registering takes a lock and may allocate, do it up front.
+	// Updating through the returned handles is lock-free and never allocates: every thread writes to one of
+	// NumShards copies of the values, picked once per thread, so threads rarely share a cache line.
+	// Snapshots sum the shards. Every value is read atomically, but values updated while the snapshot is
+	// taken may be in it or not, e.g. a histogram's count may be ahead of its sum by a few updates.
+	// Registering a name again returns the same metric, so several clients add up.
+	class INWORLD_EXPORT MetricsRegistry
+	{
+	public:
+		static constexpr uint32_t NumShards = 16;
+		// Log-linear buckets with a relative error below 1/8, up to 2^32, e.g. over an hour of microseconds.
+		using HistogramBuckets = Inworld::Histogram<3, 32>;
+
+		// Handles are cheap to copy. Default constructed handles, or handles of a full registry, do nothing.
+		class INWORLD_EXPORT Counter
+		{
+		public:
+			Counter() = default;
+			void Add(uint64_t Value = 1) const;
+
+		private:
+			friend class MetricsRegistry;
+			Counter(MetricsRegistry* InRegistry, uint32_t InSlot) : _Registry(InRegistry), _Slot(InSlot) {}
+
+			MetricsRegistry* _Registry = nullptr;
+			uint32_t _Slot = 0;
+		};
+
+		// Last value set wins, not sharded.
+		class INWORLD_EXPORT Gauge
+		{
+		public:
+			Gauge() = default;
+			void Set(int64_t Value) const;
+
+		private:
+			friend class MetricsRegistry;
+			Gauge(MetricsRegistry* InRegistry, uint32_t InSlot) : _Registry(InRegistry), _Slot(InSlot) {}
+
+			MetricsRegistry* _Registry = nullptr;
+			uint32_t _Slot = 0;
+		};
+
+		class INWORLD_EXPORT Histogram
+		{
+		public:
+			Histogram() = default;
+			void Record(uint64_t Value) const;
+
+		private:
+			friend class MetricsRegistry;
+			Histogram(MetricsRegistry* InRegistry, uint32_t InSlot) : _Registry(InRegistry), _Slot(InSlot) {}
+
+			MetricsRegistry* _Registry = nullptr;
+			uint32_t _Slot = 0;
+		};
+
+		// Counters and gauges take one slot, histograms HistogramBuckets::BucketCount + 3.
+		explicit MetricsRegistry(uint32_t InMaxSlots = 2048);
+		~MetricsRegistry();
+
+		MetricsRegistry(const MetricsRegistry&) = delete;
+		MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+		// Fail with an invalid handle when the name is registered with another type or the registry is full.
+		Counter RegisterCounter(const std::string& Name);
+		Gauge RegisterGauge(const std::string& Name);
+		Histogram RegisterHistogram(const std::string& Name);
+
+		MetricsSnapshot Snapshot() const;
+		// Zeroes every value, registrations and handles stay valid.
+		void Reset();
+
+		// One row per metric, with a header row when bHeader.
+		static void WriteCsv(const MetricsSnapshot& Snapshot, std::ostream& Stream, bool bHeader = true);
+		// One JSON object per line, so snapshots can be appended to a file.
+		static void WriteJson(const MetricsSnapshot& Snapshot, std::ostream& Stream);
+		// Appends the snapshot to the file, as JSON when it ends with .json or .jsonl, as CSV otherwise.
+		static bool AppendToFile(const MetricsSnapshot& Snapshot, const std::string& Path);
+
+	private:
+		struct Metric
+		{
+			std::string Name;
+			MetricType Type;
+			uint32_t Slot;
+		};
+
+		uint32_t Register(const std::string& Name, MetricType Type, uint32_t NumSlots);
+		std::atomic<uint64_t>* GetShard(uint32_t Shard) const { return _Values + static_cast<size_t>(Shard) * _ShardStride; }
+		static uint32_t GetThreadShard();
+
+		const uint32_t _MaxSlots;
+		// Rounded up to whole cache lines, so shards never share one.
+		const uint32_t _ShardStride;
+		std::unique_ptr<std::atomic<uint64_t>[]> _Storage;
+		// First shard, in _Storage.
+		std::atomic<uint64_t>* _Values = nullptr;
+
+		mutable std::mutex _Mutex;
+		std::vector<Metric> _Metrics;
+		uint32_t _NumSlots = 0;
+	};
+
+	// Shared by the NDK and the engine integration.
+	INWORLD_EXPORT MetricsRegistry& GetMetricsRegistry();
+}
@@ -0,0 +1,165 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#include "PacketRecording.h"
+#include "Log.h"
+
+#include <cstring>
+
+namespace
+{
+	constexpr char Magic[4] = { 'I', 'W', 'P', 'R' };
+	constexpr uint8_t Version = 1;
+	// Messages of the session stream are far smaller, anything bigger is a corrupt file.
+	constexpr uint64_t MaxRecordSize = 64 * 1024 * 1024;
+
+	void WriteVarint(std::ostream& Stream, uint64_t Value)
+	{
+		char Bytes[10];
+		size_t Size = 0;
+		do
+		{
+			Bytes[Size++] = static_cast<char>((Value & 0x7f) | (Value > 0x7f ? 0x80 : 0));
+			Value >>= 7;
+		} while (Value);
+		Stream.write(Bytes, Size);
+	}
+
+	bool ReadVarint(std::istream& Stream, uint64_t& OutValue)
+	{
+		OutValue = 0;
+		for (uint32_t Shift = 0; Shift < 64; Shift += 7)
+		{
+			const int Byte = Stream.get();
+			if (Byte == std::char_traits<char>::eof())
+			{
+				return false;
+			}
+			OutValue |= static_cast<uint64_t>(Byte & 0x7f) << Shift;
+			if (!(Byte & 0x80))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+bool Inworld::PacketRecorder::Open(const std::string& Path)
+{
+	std::lock_guard<std::mutex> Lock(_Mutex);
+	if (_File.is_open())
+	{
+		_File.close();
+	}
+
+	_File.open(Path, std::ios::binary | std::ios::trunc);
+	if (!_File)
+	{
+		Inworld::LogError("PacketRecorder. Can't open %s", ARG_STR(Path));
+		_bOpen = false;
+		return false;
+	}
+
+	_File.write(Magic, sizeof(Magic));
+	_File.put(static_cast<char>(Version));
+	_Start = std::chrono::steady_clock::now();
+	_Last = _Start;
+	_bOpen = true;
+	Inworld::Log("PacketRecorder. Recording to %s", ARG_STR(Path));
+	return true;
+}
+
+void Inworld::PacketRecorder::Close()
+{
+	std::lock_guard<std::mutex> Lock(_Mutex);
+	_bOpen = false;
+	if (_File.is_open())
+	{
+		_File.close();
+	}
+}
+
+void Inworld::PacketRecorder::Record(RecordedPacketKind Kind, const google::protobuf_inworld::MessageLite& Message)
+{
+	if (!IsOpen())
+	{
+		return;
+	}
+
+	const auto Now = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> Lock(_Mutex);
+	// Cleared by SerializeToString, the capacity stays.
+	if (_bOpen && Message.SerializeToString(&_Buffer))
+	{
+		WriteRecord(Kind, _Buffer.data(), _Buffer.size(), Now);
+	}
+}
+
+void Inworld::PacketRecorder::Record(RecordedPacketKind Kind, const std::string& Data, std::chrono::steady_clock::time_point Time)
+{
+	std::lock_guard<std::mutex> Lock(_Mutex);
+	if (_bOpen)
+	{
+		WriteRecord(Kind, Data.data(), Data.size(), Time);
+	}
+}
+
+void Inworld::PacketRecorder::WriteRecord(RecordedPacketKind Kind, const char* Data, size_t Size, std::chrono::steady_clock::time_point Time)
+{
+	Time = Time < _Last ? _Last : Time;
+	const auto Delta = std::chrono::duration_cast<std::chrono::microseconds>(Time - _Last);
+	// Only whole microseconds are recorded, the remainder is carried to the next record.
+	_Last += Delta;
+
+	WriteVarint(_File, static_cast<uint64_t>(Kind));
+	WriteVarint(_File, static_cast<uint64_t>(Delta.count()));
+	WriteVarint(_File, Size);
+	_File.write(Data, Size);
+	if (!_File)
+	{
+		Inworld::LogError("PacketRecorder. Write failed, recording stopped");
+		_bOpen = false;
+		_File.close();
+	}
+}
+
+bool Inworld::PacketRecordingReader::Open(const std::string& Path)
+{
+	_File.open(Path, std::ios::binary);
+	_Time = std::chrono::microseconds(0);
+
+	char Header[sizeof(Magic) + 1];
+	if (!_File.read(Header, sizeof(Header)) || std::memcmp(Header, Magic, sizeof(Magic)) != 0 || static_cast<uint8_t>(Header[sizeof(Magic)]) != Version)
+	{
+		Inworld::LogError("PacketRecordingReader. %s is not a packet recording", ARG_STR(Path));
+		_File.close();
+		return false;
+	}
+	return true;
+}
+
+bool Inworld::PacketRecordingReader::Next(RecordedPacket& OutPacket)
+{
+	uint64_t Kind, Delta, Size;
+	if (!_File.is_open() || !ReadVarint(_File, Kind) || !ReadVarint(_File, Delta) || !ReadVarint(_File, Size) ||
+		Kind > static_cast<uint64_t>(RecordedPacketKind::Outgoing) || Size > MaxRecordSize)
+	{
+		return false;
+	}
+
+	OutPacket.Data.resize(Size);
+	if (!_File.read(&OutPacket.Data[0], Size))
+	{
+		return false;
+	}
+
+	_Time += std::chrono::microseconds(Delta);
+	OutPacket.Kind = static_cast<RecordedPacketKind>(Kind);
+	OutPacket.Time = _Time;
+	return true;
+}
@@ -0,0 +1,80 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#pragma once
+
+#include "../Define.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include "google/protobuf/message_lite.h"
+
+namespace Inworld
+{
+	enum class RecordedPacketKind : uint8_t
+	{
+		// LoadSceneResponse the session started with.
+		Scene = 0,
+		Incoming = 1,
+		Outgoing = 2,
+	};
+
+	struct RecordedPacket
+	{
+		RecordedPacketKind Kind = RecordedPacketKind::Incoming;
+		// Since the recording was opened.
+		std::chrono::microseconds Time { 0 };
+		// Serialized InworldPacket, or LoadSceneResponse for scenes.
+		std::string Data;
+	};
+
+	// Records the packets of a session stream with the time they went through it, see ReplayReaderWriter.
+	// The file is a header followed by length-delimited records: the kind, the microseconds since the previous
+	// record and the size as varints, then the serialized message.
+	// Thread safe, the read and write tasks record at the same time.
+	class INWORLD_EXPORT PacketRecorder
+	{
+	public:
+		~PacketRecorder() { Close(); }
+
+		// Truncates the file.
+		bool Open(const std::string& Path);
+		void Close();
+		bool IsOpen() const { return _bOpen.load(std::memory_order_relaxed); }
+
+		// Does nothing when not open. Serializing reuses one buffer, no allocation once it is big enough.
+		void Record(RecordedPacketKind Kind, const google::protobuf_inworld::MessageLite& Message);
+		// Times before the previous record's are recorded as that.
+		void Record(RecordedPacketKind Kind, const std::string& Data, std::chrono::steady_clock::time_point Time);
+
+	private:
+		void WriteRecord(RecordedPacketKind Kind, const char* Data, size_t Size, std::chrono::steady_clock::time_point Time);
+
+		std::mutex _Mutex;
+		std::ofstream _File;
+		std::atomic<bool> _bOpen = false;
+		std::chrono::steady_clock::time_point _Start;
+		std::chrono::steady_clock::time_point _Last;
+		std::string _Buffer;
+	};
+
+	class INWORLD_EXPORT PacketRecordingReader
+	{
+	public:
+		// Fails on a missing file or an unknown header.
+		bool Open(const std::string& Path);
+		// False at the end of the recording, or where it is truncated.
+		bool Next(RecordedPacket& OutPacket);
+
+	private:
+		std::ifstream _File;
+		std::chrono::microseconds _Time { 0 };
+	};
+}
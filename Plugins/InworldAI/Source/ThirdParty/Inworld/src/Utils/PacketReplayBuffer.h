@@ -0,0 +1,127 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace Inworld
+{
+	// Outgoing packets written to a stream that may still be lost with it. The stream has no acknowledgements,
+	// a packet counts as delivered once the server sent anything after it was written. When the stream drops
+	// the rest is replayed on the next one, unless older than MaxAge. The server may have received packets it
+	// didn't answer yet, so only packets IsReplaySafe accepts are replayed, the rest are discarded rather than
+	// risk the server seeing them twice. Written and read from different threads.
+	template<typename T>
+	class PacketReplayBuffer
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		struct Settings
+		{
+			std::chrono::milliseconds MaxAge { 10000 };
+			// The oldest are dropped above this.
+			size_t MaxPackets = 256;
+			// Packets the server can see twice without harm. Unset replays every packet.
+			std::function<bool(const T&)> IsReplaySafe;
+		};
+
+		struct Stats
+		{
+			uint64_t Written = 0;
+			uint64_t Acknowledged = 0;
+			uint64_t Replayed = 0;
+			uint64_t Expired = 0;
+			// Unacknowledged and not safe to replay, the server may or may not have them.
+			uint64_t Discarded = 0;
+		};
+
+		PacketReplayBuffer() : PacketReplayBuffer(Settings()) {}
+		explicit PacketReplayBuffer(const Settings& InSettings) : _Settings(InSettings) {}
+
+		void OnWritten(const T& Packet, Clock::time_point Now)
+		{
+			std::lock_guard<std::mutex> Lock(_Mutex);
+			_Stats.Written++;
+			_Packets.push_back({ Packet, Now });
+			while (_Packets.size() > _Settings.MaxPackets)
+			{
+				_Packets.pop_front();
+				_Stats.Expired++;
+			}
+		}
+
+		void OnReceived()
+		{
+			std::lock_guard<std::mutex> Lock(_Mutex);
+			_Stats.Acknowledged += _Packets.size();
+			_Packets.clear();
+		}
+
+		// Unacknowledged packets safe to replay in write order, the buffer is emptied.
+		std::vector<T> TakeUnacknowledged(Clock::time_point Now)
+		{
+			std::lock_guard<std::mutex> Lock(_Mutex);
+			std::vector<T> Result;
+			Result.reserve(_Packets.size());
+			for (auto& Entry : _Packets)
+			{
+				if (Now - Entry.Written > _Settings.MaxAge)
+				{
+					_Stats.Expired++;
+					continue;
+				}
+				if (_Settings.IsReplaySafe && !_Settings.IsReplaySafe(Entry.Packet))
+				{
+					_Stats.Discarded++;
+					continue;
+				}
+				Result.push_back(std::move(Entry.Packet));
+			}
+			_Packets.clear();
+			_Stats.Replayed += Result.size();
+			return Result;
+		}
+
+		void Reset()
+		{
+			std::lock_guard<std::mutex> Lock(_Mutex);
+			_Packets.clear();
+		}
+
+		size_t GetNumHeld() const
+		{
+			std::lock_guard<std::mutex> Lock(_Mutex);
+			return _Packets.size();
+		}
+
+		Stats GetStats() const
+		{
+			std::lock_guard<std::mutex> Lock(_Mutex);
+			return _Stats;
+		}
+
+	private:
+		struct Entry
+		{
+			T Packet;
+			Clock::time_point Written;
+		};
+
+		Settings _Settings;
+		mutable std::mutex _Mutex;
+		std::deque<Entry> _Packets;
+		Stats _Stats;
+	};
+}
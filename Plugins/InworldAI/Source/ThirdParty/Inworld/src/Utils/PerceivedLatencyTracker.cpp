@@ -8,10 +8,22 @@
 #include "PerceivedLatencyTracker.h"
 #include "Log.h"
 
+static int64_t ToMicroseconds(std::chrono::steady_clock::duration Duration)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(Duration).count();
+}
+
 void Inworld::PerceivedLatencyTracker::HandlePacket(std::shared_ptr<Inworld::Packet> Packet)
+{
+	HandlePacket(Packet, std::chrono::steady_clock::now());
+}
+
+void Inworld::PerceivedLatencyTracker::HandlePacket(std::shared_ptr<Inworld::Packet> Packet, TimeStamp Now)
 {
 	if (Packet)
 	{
+		_Now = Now;
+		ExpireInteractions();
 		Packet->Accept(*this);
 	}
 }
@@ -27,39 +39,76 @@ void Inworld::PerceivedLatencyTracker::Visit(const Inworld::TextEvent& Event)
 		}
 		else
 		{
-			_InteractionTimeMap.emplace(Interaction, std::chrono::system_clock::now());
+			InteractionTiming Timing;
+			Timing.Start = _Now;
+			_InteractionTimeMap.emplace(Interaction, Timing);
+			_InteractionOrder.emplace_back(Interaction, _Now);
+			ExpireInteractions();
 		}
 	}
-	else if (Event._Routing._Source._Type == InworldPakets::Actor_Type_AGENT && !_TrackAudioReplies)
+	else if (Event._Routing._Source._Type == InworldPakets::Actor_Type_AGENT)
 	{
-		VisitReply(Event);
+		VisitReply(Event, false);
 	}
 }
 
 void Inworld::PerceivedLatencyTracker::Visit(const Inworld::AudioDataEvent& Event)
 {
-	if (_TrackAudioReplies)
-	{
-		VisitReply(Event);
-	}
+	VisitReply(Event, true);
 }
 
-void Inworld::PerceivedLatencyTracker::VisitReply(const Inworld::Packet& Event)
+void Inworld::PerceivedLatencyTracker::VisitReply(const Inworld::Packet& Event, bool bAudio)
 {
 	const auto& Interaction = Event._PacketId._InteractionId;
 	const auto It = _InteractionTimeMap.find(Interaction);
-	if (It != _InteractionTimeMap.end())
+	if (It == _InteractionTimeMap.end())
 	{
-		const auto Duration = std::chrono::system_clock::now() - It->second;
-		_InteractionTimeMap.erase(It);
+		return;
+	}
 
-		const int32_t Ms = std::chrono::duration_cast<std::chrono::milliseconds>(Duration).count();
-		Inworld::Log("PerceivedLatencyTracker. Latency is %dms, Interaction: %s", Ms, ARG_STR(Interaction));
+	auto& Timing = It->second;
+	const int64_t SinceStartUs = ToMicroseconds(_Now - Timing.Start);
+	if (!bAudio && !Timing.bFirstText)
+	{
+		Timing.bFirstText = true;
+		_TimeToFirstText.Record(SinceStartUs);
+		_TimeToFirstTextMetric.Record(SinceStartUs);
+	}
+	if (bAudio && !Timing.bFirstAudio)
+	{
+		Timing.bFirstAudio = true;
+		_TimeToFirstAudio.Record(SinceStartUs);
+		_TimeToFirstAudioMetric.Record(SinceStartUs);
+		_TimeToFirstAudioByAgent[Event._Routing._Source._Name].Record(SinceStartUs);
+	}
 
-		if (_Callback)
+	if (bAudio != _TrackAudioReplies)
+	{
+		return;
+	}
+
+	// Jitter is measured on the reply stream that drives perceived latency.
+	if (Timing.bReported)
+	{
+		const auto Gap = std::chrono::duration_cast<std::chrono::microseconds>(_Now - Timing.LastChunk);
+		if (Timing.LastGap.count() >= 0)
 		{
-			_Callback(Interaction, Ms);
+			_ChunkJitter.Record(std::abs((Gap - Timing.LastGap).count()));
 		}
+		Timing.LastGap = Gap;
+		Timing.LastChunk = _Now;
+		return;
+	}
+
+	Timing.bReported = true;
+	Timing.LastChunk = _Now;
+
+	const int32_t Ms = static_cast<int32_t>(SinceStartUs / 1000);
+	Inworld::Log("PerceivedLatencyTracker. Latency is %dms, Interaction: %s", Ms, ARG_STR(Interaction));
+
+	if (_Callback)
+	{
+		_Callback(Interaction, Ms);
 	}
 }
 
@@ -74,7 +123,55 @@ void Inworld::PerceivedLatencyTracker::Visit(const Inworld::ControlEvent& Event)
 	const auto It = _InteractionTimeMap.find(Interaction);
 	if (It != _InteractionTimeMap.end())
 	{
-		Inworld::LogError("PerceivedLatencyTracker visit ControlEvent INTERACTION_END. Text timestamp is still in the map, Interaction: %s", ARG_STR(Interaction));
+		const int64_t SinceStartUs = ToMicroseconds(_Now - It->second.Start);
+		_TimeToInteractionEnd.Record(SinceStartUs);
+		_TimeToInteractionEndMetric.Record(SinceStartUs);
 		_InteractionTimeMap.erase(It);
 	}
 }
+
+void Inworld::PerceivedLatencyTracker::ExpireInteractions()
+{
+	while (!_InteractionOrder.empty())
+	{
+		const auto& Oldest = _InteractionOrder.front();
+		const bool bExpired = _Now - Oldest.second > _InteractionTimeout;
+		if (!bExpired && _InteractionOrder.size() <= _MaxTrackedInteractions)
+		{
+			break;
+		}
+
+		const auto It = _InteractionTimeMap.find(Oldest.first);
+		if (It != _InteractionTimeMap.end() && It->second.Start == Oldest.second)
+		{
+			Inworld::LogWarning("PerceivedLatencyTracker. Interaction abandoned: %s", ARG_STR(Oldest.first));
+			_InteractionTimeMap.erase(It);
+			_AbandonedInteractions++;
+		}
+		_InteractionOrder.pop_front();
+	}
+}
+
+Inworld::PerceivedLatencySnapshot Inworld::PerceivedLatencyTracker::GetSnapshot() const
+{
+	constexpr double UsToMs = 1000.0;
+
+	PerceivedLatencySnapshot Snapshot;
+	Snapshot.TimeToFirstText = _TimeToFirstText.GetStats(UsToMs);
+	Snapshot.TimeToFirstAudio = _TimeToFirstAudio.GetStats(UsToMs);
+	Snapshot.TimeToInteractionEnd = _TimeToInteractionEnd.GetStats(UsToMs);
+	Snapshot.ChunkJitter = _ChunkJitter.GetStats(UsToMs);
+	Snapshot.TrackedInteractions = static_cast<uint32_t>(_InteractionTimeMap.size());
+	Snapshot.AbandonedInteractions = _AbandonedInteractions;
+	return Snapshot;
+}
+
+void Inworld::PerceivedLatencyTracker::ResetStats()
+{
+	_TimeToFirstText.Reset();
+	_TimeToFirstAudio.Reset();
+	_TimeToInteractionEnd.Reset();
+	_ChunkJitter.Reset();
+	_TimeToFirstAudioByAgent.clear();
+	_AbandonedInteractions = 0;
+}
@@ -10,12 +10,29 @@
 #include <functional>
 #include <memory>
 #include <chrono>
+#include <deque>
+#include <unordered_map>
 #include "../Packets.h"
+#include "Histogram.h"
+#include "MetricsRegistry.h"
 
 namespace Inworld {
 
 	using PerceivedLatencyCallback = std::function<void(const std::string& InteractionId, uint32_t LatancyMs)>;
-	using TimeStamp = std::chrono::system_clock::time_point;
+	using TimeStamp = std::chrono::steady_clock::time_point;
+
+	// All durations are in milliseconds.
+	struct PerceivedLatencySnapshot
+	{
+		HistogramStats TimeToFirstText;
+		HistogramStats TimeToFirstAudio;
+		HistogramStats TimeToInteractionEnd;
+		// Absolute difference between consecutive reply chunk inter-arrival gaps.
+		HistogramStats ChunkJitter;
+
+		uint32_t TrackedInteractions = 0;
+		uint64_t AbandonedInteractions = 0;
+	};
 
 	class PerceivedLatencyTracker : Inworld::PacketVisitor
 	{
@@ -27,6 +44,7 @@ namespace Inworld {
 		bool HasCallback() const { return _Callback != nullptr; }
 
 		void HandlePacket(std::shared_ptr<Inworld::Packet> Packet);
+		void HandlePacket(std::shared_ptr<Inworld::Packet> Packet, TimeStamp Now);
 
 		virtual void Visit(const Inworld::TextEvent& Event) override;
 		virtual void Visit(const Inworld::AudioDataEvent& Event) override;
@@ -34,10 +52,47 @@ namespace Inworld {
 
 		void TrackAudioReplies(bool bVal) { _TrackAudioReplies = bVal; }
 
+		// Interactions that don't finish within the timeout, or are pushed out by newer ones, are dropped as abandoned.
+		void SetInteractionLimits(uint32_t MaxTracked, std::chrono::milliseconds Timeout) { _MaxTrackedInteractions = MaxTracked; _InteractionTimeout = Timeout; }
+
+		PerceivedLatencySnapshot GetSnapshot() const;
+		// In microseconds, by the id of the agent replying. Only agents that replied with audio are there.
+		const std::unordered_map<std::string, LatencyHistogram>& GetTimeToFirstAudioByAgent() const { return _TimeToFirstAudioByAgent; }
+		void ResetStats();
+
 	private:
-		void VisitReply(const Inworld::Packet& Event);
+		struct InteractionTiming
+		{
+			TimeStamp Start;
+			TimeStamp LastChunk;
+			std::chrono::microseconds LastGap = std::chrono::microseconds(-1);
+			bool bFirstText = false;
+			bool bFirstAudio = false;
+			bool bReported = false;
+		};
+
+		void VisitReply(const Inworld::Packet& Event, bool bAudio);
+		void ExpireInteractions();
+
+		std::unordered_map<std::string, InteractionTiming> _InteractionTimeMap;
+		// Interactions in start order, used to drop abandoned ones in amortized O(1).
+		std::deque<std::pair<std::string, TimeStamp>> _InteractionOrder;
+		uint32_t _MaxTrackedInteractions = 256;
+		std::chrono::milliseconds _InteractionTimeout = std::chrono::seconds(60);
+		uint64_t _AbandonedInteractions = 0;
+
+		LatencyHistogram _TimeToFirstText;
+		LatencyHistogram _TimeToFirstAudio;
+		LatencyHistogram _TimeToInteractionEnd;
+		LatencyHistogram _ChunkJitter;
+		std::unordered_map<std::string, LatencyHistogram> _TimeToFirstAudioByAgent;
+
+		// The same durations in microseconds, summed over clients.
+		MetricsRegistry::Histogram _TimeToFirstTextMetric = GetMetricsRegistry().RegisterHistogram("inworld.latency.first_text_us");
+		MetricsRegistry::Histogram _TimeToFirstAudioMetric = GetMetricsRegistry().RegisterHistogram("inworld.latency.first_audio_us");
+		MetricsRegistry::Histogram _TimeToInteractionEndMetric = GetMetricsRegistry().RegisterHistogram("inworld.latency.interaction_end_us");
 
-		std::unordered_map<std::string, TimeStamp> _InteractionTimeMap;
+		TimeStamp _Now;
 		PerceivedLatencyCallback _Callback = nullptr;
 		bool _TrackAudioReplies = false;
 	};
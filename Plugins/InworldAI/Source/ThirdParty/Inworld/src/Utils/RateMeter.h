@@ -0,0 +1,75 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+namespace Inworld
+{
+	// Per second rates of cumulative counters, e.g. packets and bytes sent, over a sliding window.
+	// Sampling is amortized O(1). A counter going backwards, e.g. after the client was recreated, restarts the window.
+	template<size_t NumCounters>
+	class RateMeter
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+		using Counters = std::array<uint64_t, NumCounters>;
+
+		explicit RateMeter(std::chrono::milliseconds InWindow = std::chrono::seconds(2))
+			: _Window(InWindow)
+		{}
+
+		void Sample(const Counters& Values, Clock::time_point Now)
+		{
+			if (!_Samples.empty())
+			{
+				for (size_t i = 0; i < NumCounters; i++)
+				{
+					if (Values[i] < _Samples.back().second[i])
+					{
+						_Samples.clear();
+						break;
+					}
+				}
+			}
+
+			_Samples.emplace_back(Now, Values);
+
+			// The newest sample at or before the start of the window is kept, rates span the whole window.
+			while (_Samples.size() > 2 && _Samples[1].first <= Now - _Window)
+			{
+				_Samples.pop_front();
+			}
+		}
+
+		// 0 until two samples apart in time are taken.
+		double GetRate(size_t Index) const
+		{
+			if (_Samples.size() < 2)
+			{
+				return 0.0;
+			}
+
+			const auto& Oldest = _Samples.front();
+			const auto& Newest = _Samples.back();
+			const double Seconds = std::chrono::duration<double>(Newest.first - Oldest.first).count();
+			return Seconds > 0.0 ? (Newest.second[Index] - Oldest.second[Index]) / Seconds : 0.0;
+		}
+
+		void Reset() { _Samples.clear(); }
+
+	private:
+		std::chrono::milliseconds _Window;
+		std::deque<std::pair<Clock::time_point, Counters>> _Samples;
+	};
+}
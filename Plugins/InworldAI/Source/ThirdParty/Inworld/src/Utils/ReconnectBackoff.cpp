@@ -0,0 +1,40 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#include "ReconnectBackoff.h"
+#include <algorithm>
+#include <cmath>
+
+Inworld::ReconnectBackoff::ReconnectBackoff(const Settings& InSettings, uint32_t Seed)
+	: _Random(Seed)
+{
+	SetSettings(InSettings);
+}
+
+float Inworld::ReconnectBackoff::NextDelay()
+{
+	const uint32_t Attempt = _Attempts++;
+	if (Attempt == 0)
+	{
+		return 0.f;
+	}
+
+	// Capped before it can overflow, the cap is reached long before.
+	const float Exponent = static_cast<float>(std::min<uint32_t>(Attempt - 1, 32));
+	const float Delay = std::min(_Settings.MaxDelay, _Settings.BaseDelay * std::pow(_Settings.Multiplier, Exponent));
+	std::uniform_real_distribution<float> Distribution(0.f, _Settings.Jitter);
+	return Delay * (1.f - Distribution(_Random));
+}
+
+void Inworld::ReconnectBackoff::SetSettings(const Settings& InSettings)
+{
+	_Settings = InSettings;
+	_Settings.BaseDelay = std::max(_Settings.BaseDelay, 0.f);
+	_Settings.MaxDelay = std::max(_Settings.MaxDelay, _Settings.BaseDelay);
+	_Settings.Multiplier = std::max(_Settings.Multiplier, 1.f);
+	_Settings.Jitter = std::min(std::max(_Settings.Jitter, 0.f), 1.f);
+}
@@ -0,0 +1,48 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#pragma once
+
+#include "../Define.h"
+#include <cstdint>
+#include <random>
+
+namespace Inworld
+{
+	// Delays between reconnect attempts. The first attempt is immediate, most drops are short blips,
+	// then the delay grows exponentially from BaseDelay up to MaxDelay. Every delay is shortened by a random
+	// part of up to Jitter of it, so clients dropped together don't come back in lockstep.
+	class INWORLD_EXPORT ReconnectBackoff
+	{
+	public:
+		struct Settings
+		{
+			float BaseDelay = 0.25f;
+			float MaxDelay = 5.f;
+			float Multiplier = 2.f;
+			// 0 to 1.
+			float Jitter = 0.5f;
+		};
+
+		ReconnectBackoff() : ReconnectBackoff(Settings()) {}
+		explicit ReconnectBackoff(const Settings& InSettings, uint32_t Seed = std::random_device()());
+
+		// Seconds to wait before the next attempt.
+		float NextDelay();
+		// After a successful connection.
+		void Reset() { _Attempts = 0; }
+
+		uint32_t GetAttempts() const { return _Attempts; }
+		const Settings& GetSettings() const { return _Settings; }
+		void SetSettings(const Settings& InSettings);
+
+	private:
+		Settings _Settings;
+		uint32_t _Attempts = 0;
+		std::mt19937 _Random;
+	};
+}
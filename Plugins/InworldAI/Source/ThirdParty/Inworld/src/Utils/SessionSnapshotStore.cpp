@@ -0,0 +1,252 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#include "SessionSnapshotStore.h"
+#include "Log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "zlib.h"
+
+namespace
+{
+	constexpr char SnapshotMagic[4] = { 'I', 'W', 'S', 'S' };
+	constexpr uint32_t FlagCompressed = 1;
+	// Session states are a few KB to a few hundred KB, anything past this is not a snapshot.
+	constexpr uint64_t MaxStateSize = 64ull << 20;
+
+	struct SnapshotHeader
+	{
+		char Magic[4];
+		uint32_t Version;
+		uint32_t Flags;
+		uint32_t Reserved;
+		uint64_t KeyHash;
+		uint64_t PayloadHash;
+		uint64_t PayloadSize;
+		// Before compression.
+		uint64_t RawSize;
+	};
+
+	uint64_t HashString(const std::string& Str)
+	{
+		// FNV-1a, stable across platforms and runs.
+		uint64_t Hash = 14695981039346656037ull;
+		for (const char C : Str)
+		{
+			Hash ^= static_cast<uint8_t>(C);
+			Hash *= 1099511628211ull;
+		}
+		return Hash;
+	}
+
+	template<typename T>
+	void WriteValue(std::string& Out, T Value)
+	{
+		Out.append(reinterpret_cast<const char*>(&Value), sizeof(Value));
+	}
+
+	void WriteString(std::string& Out, const std::string& Str)
+	{
+		WriteValue(Out, static_cast<uint32_t>(Str.size()));
+		Out.append(Str);
+	}
+
+	class PayloadReader
+	{
+	public:
+		PayloadReader(const std::string& Payload)
+			: _Payload(Payload)
+		{}
+
+		template<typename T>
+		bool ReadValue(T& Value)
+		{
+			if (_Payload.size() - _Offset < sizeof(Value))
+			{
+				return false;
+			}
+			std::memcpy(&Value, _Payload.data() + _Offset, sizeof(Value));
+			_Offset += sizeof(Value);
+			return true;
+		}
+
+		bool ReadString(std::string& Str)
+		{
+			uint32_t Size;
+			if (!ReadValue(Size) || _Payload.size() - _Offset < Size)
+			{
+				return false;
+			}
+			Str.assign(_Payload, _Offset, Size);
+			_Offset += Size;
+			return true;
+		}
+
+		bool IsEnd() const { return _Offset == _Payload.size(); }
+
+	private:
+		const std::string& _Payload;
+		size_t _Offset = 0;
+	};
+}
+
+Inworld::SessionSnapshotStore::SessionSnapshotStore(const std::string& FilePath, const std::string& Key)
+	: _FilePath(FilePath)
+	, _KeyHash(HashString(Key))
+{}
+
+bool Inworld::SessionSnapshotStore::Compress(const std::string& Data, std::string& OutCompressed)
+{
+	uLongf Size = compressBound(static_cast<uLong>(Data.size()));
+	OutCompressed.resize(Size);
+	if (compress2(reinterpret_cast<Bytef*>(&OutCompressed[0]), &Size, reinterpret_cast<const Bytef*>(Data.data()), static_cast<uLong>(Data.size()), Z_BEST_SPEED) != Z_OK)
+	{
+		OutCompressed.clear();
+		return false;
+	}
+	OutCompressed.resize(Size);
+	return true;
+}
+
+bool Inworld::SessionSnapshotStore::Decompress(const std::string& Compressed, size_t Size, std::string& OutData)
+{
+	OutData.resize(Size);
+	uLongf DecompressedSize = static_cast<uLongf>(Size);
+	if (uncompress(reinterpret_cast<Bytef*>(&OutData[0]), &DecompressedSize, reinterpret_cast<const Bytef*>(Compressed.data()), static_cast<uLong>(Compressed.size())) != Z_OK ||
+		DecompressedSize != Size)
+	{
+		OutData.clear();
+		return false;
+	}
+	return true;
+}
+
+bool Inworld::SessionSnapshotStore::Load(SessionSnapshot& Snapshot) const
+{
+	std::ifstream File(_FilePath, std::ios::binary);
+	if (!File)
+	{
+		return false;
+	}
+
+	SnapshotHeader Header;
+	if (!File.read(reinterpret_cast<char*>(&Header), sizeof(Header)) ||
+		std::memcmp(Header.Magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0)
+	{
+		Inworld::LogWarning("SessionSnapshotStore. Invalid header, removing %s", ARG_STR(_FilePath));
+		File.close();
+		Remove();
+		return false;
+	}
+
+	if (Header.Version != Version || Header.KeyHash != _KeyHash)
+	{
+		return false;
+	}
+
+	std::string Payload(Header.PayloadSize <= MaxStateSize && Header.RawSize <= MaxStateSize ? Header.PayloadSize : 0, '\0');
+	if (Payload.size() != Header.PayloadSize ||
+		!File.read(&Payload[0], Payload.size()) ||
+		File.peek() != std::char_traits<char>::eof() ||
+		HashString(Payload) != Header.PayloadHash)
+	{
+		Inworld::LogWarning("SessionSnapshotStore. Corrupted payload, removing %s", ARG_STR(_FilePath));
+		File.close();
+		Remove();
+		return false;
+	}
+
+	std::string Raw;
+	if (Header.Flags & FlagCompressed)
+	{
+		if (!Decompress(Payload, Header.RawSize, Raw))
+		{
+			Inworld::LogWarning("SessionSnapshotStore. Couldn't decompress, removing %s", ARG_STR(_FilePath));
+			File.close();
+			Remove();
+			return false;
+		}
+	}
+	else
+	{
+		Raw = std::move(Payload);
+	}
+
+	PayloadReader Reader(Raw);
+	SessionSnapshot Loaded;
+	if (!Reader.ReadString(Loaded.SceneName) ||
+		!Reader.ReadString(Loaded.State) ||
+		!Reader.ReadValue(Loaded.SavedAt) ||
+		!Reader.IsEnd())
+	{
+		Inworld::LogWarning("SessionSnapshotStore. Malformed payload, removing %s", ARG_STR(_FilePath));
+		File.close();
+		Remove();
+		return false;
+	}
+
+	Snapshot = std::move(Loaded);
+	return true;
+}
+
+bool Inworld::SessionSnapshotStore::Save(const SessionSnapshot& Snapshot) const
+{
+	std::string Raw;
+	Raw.reserve(Snapshot.SceneName.size() + Snapshot.State.size() + 16);
+	WriteString(Raw, Snapshot.SceneName);
+	WriteString(Raw, Snapshot.State);
+	WriteValue(Raw, Snapshot.SavedAt);
+	if (Raw.size() > MaxStateSize)
+	{
+		Inworld::LogError("SessionSnapshotStore. State of %d bytes is too large", static_cast<int32_t>(Raw.size()));
+		return false;
+	}
+
+	SnapshotHeader Header;
+	std::memcpy(Header.Magic, SnapshotMagic, sizeof(SnapshotMagic));
+	Header.Version = Version;
+	Header.Flags = 0;
+	Header.Reserved = 0;
+	Header.KeyHash = _KeyHash;
+	Header.RawSize = Raw.size();
+
+	std::string Compressed;
+	const bool bCompressed = Compress(Raw, Compressed) && Compressed.size() < Raw.size();
+	const std::string& Payload = bCompressed ? Compressed : Raw;
+	Header.Flags |= bCompressed ? FlagCompressed : 0;
+	Header.PayloadHash = HashString(Payload);
+	Header.PayloadSize = Payload.size();
+
+	const std::string TmpFilePath = _FilePath + ".tmp";
+	{
+		std::ofstream File(TmpFilePath, std::ios::binary | std::ios::trunc);
+		if (!File ||
+			!File.write(reinterpret_cast<const char*>(&Header), sizeof(Header)) ||
+			!File.write(Payload.data(), Payload.size()))
+		{
+			Inworld::LogError("SessionSnapshotStore. Couldn't write %s", ARG_STR(TmpFilePath));
+			return false;
+		}
+	}
+
+	// std::rename doesn't replace an existing file on Windows.
+	std::remove(_FilePath.c_str());
+	if (std::rename(TmpFilePath.c_str(), _FilePath.c_str()) != 0)
+	{
+		Inworld::LogError("SessionSnapshotStore. Couldn't rename %s", ARG_STR(TmpFilePath));
+		std::remove(TmpFilePath.c_str());
+		return false;
+	}
+	return true;
+}
+
+void Inworld::SessionSnapshotStore::Remove() const
+{
+	std::remove(_FilePath.c_str());
+}
@@ -0,0 +1,51 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#pragma once
+
+#include "../Define.h"
+#include <cstdint>
+#include <string>
+
+namespace Inworld
+{
+	struct SessionSnapshot
+	{
+		std::string SceneName;
+		// Serialized by the engine, see state_serialization.proto.
+		std::string State;
+		// Seconds since epoch.
+		int64_t SavedAt = 0;
+	};
+
+	// Last saved state of a session on disk, so it can be restored without asking the engine for it first.
+	// The payload is zlib compressed when that makes it smaller. Files of another version or key are ignored
+	// and overwritten by the next save.
+	class INWORLD_EXPORT SessionSnapshotStore
+	{
+	public:
+		static constexpr uint32_t Version = 1;
+
+		// Key tells snapshots of different scenes and users apart when they share a file.
+		SessionSnapshotStore(const std::string& FilePath, const std::string& Key);
+
+		// False if the file is missing, of another version or key, or corrupted. Corrupted files are removed.
+		bool Load(SessionSnapshot& Snapshot) const;
+		// Written to a temporary file and renamed, a crash never leaves a partial snapshot behind.
+		bool Save(const SessionSnapshot& Snapshot) const;
+		void Remove() const;
+
+		const std::string& GetFilePath() const { return _FilePath; }
+
+		static bool Compress(const std::string& Data, std::string& OutCompressed);
+		static bool Decompress(const std::string& Compressed, size_t Size, std::string& OutData);
+
+	private:
+		std::string _FilePath;
+		uint64_t _KeyHash;
+	};
+}
@@ -10,6 +10,7 @@
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 namespace Inworld
 {
@@ -26,13 +27,15 @@ namespace Inworld
 
 		void PushBack(const T& Item);
 		void PushBack(T&& Item);
+		// Items end up in front in their order, e.g. to resend them first.
+		void PushFront(std::vector<T>&& Items);
 
-		int Size();
-		bool IsEmpty();
+		int Size() const;
+		bool IsEmpty() const;
 
 	private:
 		std::deque<T> _Queue;
-		std::mutex _Mutex;
+		mutable std::mutex _Mutex;
 	};
 
 	template <typename T>
@@ -85,7 +88,14 @@ namespace Inworld
 	}
 
 	template <typename T>
-	int SharedQueue<T>::Size()
+	void SharedQueue<T>::PushFront(std::vector<T>&& Items)
+	{
+		std::unique_lock<std::mutex> Lock(_Mutex);
+		_Queue.insert(_Queue.begin(), std::make_move_iterator(Items.begin()), std::make_move_iterator(Items.end()));
+	}
+
+	template <typename T>
+	int SharedQueue<T>::Size() const
 	{
 		std::unique_lock<std::mutex> Lock(_Mutex);
 		int Size = _Queue.size();
@@ -93,7 +103,7 @@ namespace Inworld
 	}
 
 	template <typename T>
-	bool Inworld::SharedQueue<T>::IsEmpty()
+	bool Inworld::SharedQueue<T>::IsEmpty() const
 	{
 		return Size() == 0;
 	}
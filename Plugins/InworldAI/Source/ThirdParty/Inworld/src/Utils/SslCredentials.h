@@ -7,10 +7,8 @@
 
 #pragma once
 
-#include <vector>
-#include <string>
-
-static std::vector<std::string> SslRootsFileContents = {
+// Split in several literals to stay below compiler string literal limits.
+static const char* const SslRootsFileContents[] = {
 R"(# Operating CA: DigiCert
 # Issuer: CN=Baltimore CyberTrust Root O=Baltimore OU=CyberTrust
 # Subject: CN=Baltimore CyberTrust Root O=Baltimore OU=CyberTrust
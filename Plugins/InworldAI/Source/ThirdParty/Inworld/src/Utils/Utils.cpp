@@ -7,43 +7,322 @@
 
 #include "Utils.h"
 #include "SslCredentials.h"
+#include "Packets.h"
+#include "Log.h"
 
-#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <sstream>
 #include "../ThirdParty/HmacSha256/hmac_sha256.h"
 
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <wincrypt.h>
+#endif
 
-std::string Inworld::Utils::GetSslRootCerts()
+static std::atomic<Inworld::Utils::SslRootCertsSource> g_SslRootCertsSource = { Inworld::Utils::SslRootCertsSource::Bundled };
+
+void Inworld::Utils::SetSslRootCertsSource(SslRootCertsSource Source)
+{
+	g_SslRootCertsSource = Source;
+}
+
+Inworld::Utils::SslRootCertsSource Inworld::Utils::GetSslRootCertsSource()
+{
+	return g_SslRootCertsSource;
+}
+
+const std::string& Inworld::Utils::GetSslRootCerts()
 {
-    std::string SslRootCerts;
+	static const std::string SslRootCerts = []()
+	{
+		size_t Size = 0;
+		for (const char* Str : SslRootsFileContents)
+		{
+			Size += std::char_traits<char>::length(Str);
+		}
+
+		std::string Result;
+		Result.reserve(Size);
+		for (const char* Str : SslRootsFileContents)
+		{
+			Result += Str;
+		}
+		return Result;
+	}();
+
+	return SslRootCerts;
+}
+
+std::string Inworld::Utils::LoadSystemSslRootCerts()
+{
+#ifdef _WIN32
+	// Windows keeps no PEM file, the ROOT store of the machine and user is exported instead.
+	HCERTSTORE Store = CertOpenSystemStoreW(0, L"ROOT");
+	if (!Store)
+	{
+		Inworld::LogError("Can't open the Windows ROOT certificate store: %d", static_cast<int32_t>(GetLastError()));
+		return {};
+	}
+
+	std::string Result;
+	std::string Pem;
+	PCCERT_CONTEXT Cert = nullptr;
+	while ((Cert = CertEnumCertificatesInStore(Store, Cert)) != nullptr)
+	{
+		if ((Cert->dwCertEncodingType & X509_ASN_ENCODING) == 0)
+		{
+			continue;
+		}
+
+		DWORD Size = 0;
+		if (!CryptBinaryToStringA(Cert->pbCertEncoded, Cert->cbCertEncoded, CRYPT_STRING_BASE64HEADER, nullptr, &Size))
+		{
+			continue;
+		}
+		Pem.resize(Size);
+		if (CryptBinaryToStringA(Cert->pbCertEncoded, Cert->cbCertEncoded, CRYPT_STRING_BASE64HEADER, &Pem[0], &Size))
+		{
+			Result.append(Pem.data(), Size);
+		}
+	}
+	CertCloseStore(Store, 0);
+	return Result;
+#else
+	static const char* const TrustStorePaths[] = {
+		"/etc/ssl/certs/ca-certificates.crt",
+		"/etc/pki/tls/certs/ca-bundle.crt",
+		"/etc/ssl/ca-bundle.pem",
+		"/etc/pki/ca-trust/extracted/pem/tls-ca-bundle.pem",
+		"/etc/ssl/cert.pem",
+		"/usr/local/etc/openssl/cert.pem",
+		"/system/etc/security/cacerts.pem",
+	};
 
-	for (auto& Str : SslRootsFileContents)
+	for (const char* Path : TrustStorePaths)
 	{
-        SslRootCerts += Str;
+		std::ifstream File(Path, std::ios::binary);
+		if (File)
+		{
+			std::stringstream Stream;
+			Stream << File.rdbuf();
+			return Stream.str();
+		}
 	}
 
-    return SslRootCerts;
+	return {};
+#endif
+}
+
+static constexpr uint64_t PhonemeKey(std::string_view Phoneme)
+{
+	// Packed with the size, unique for up to 7 bytes.
+	uint64_t Key = Phoneme.size();
+	for (const char C : Phoneme)
+	{
+		Key = (Key << 8) | static_cast<uint8_t>(C);
+	}
+	return Key;
+}
+
+Inworld::Utils::Viseme Inworld::Utils::PhonemeToVisemeCode(std::string_view Phoneme)
+{
+	if (Phoneme.size() > 7)
+	{
+		return Viseme::None;
+	}
+
+	switch (PhonemeKey(Phoneme))
+	{
+	// Consonants
+	case PhonemeKey("b"): return Viseme::PP;
+	case PhonemeKey("d"): return Viseme::DD;
+	case PhonemeKey("d\xCD\xA1\xCA\x92"): return Viseme::CH; // d͡ʒ
+	case PhonemeKey("\xC3\xB0"): return Viseme::TH; // ð
+	case PhonemeKey("f"): return Viseme::FF;
+	case PhonemeKey("\xC9\xA1"): return Viseme::Kk; // ɡ
+	case PhonemeKey("h"): return Viseme::Kk;
+	case PhonemeKey("j"): return Viseme::I;
+	case PhonemeKey("k"): return Viseme::Kk;
+	case PhonemeKey("l"): return Viseme::Nn;
+	case PhonemeKey("m"): return Viseme::PP;
+	case PhonemeKey("n"): return Viseme::Nn;
+	case PhonemeKey("\xC5\x8B"): return Viseme::Kk; // ŋ
+	case PhonemeKey("p"): return Viseme::PP;
+	case PhonemeKey("\xC9\xB9"): return Viseme::RR; // ɹ
+	case PhonemeKey("s"): return Viseme::SS;
+	case PhonemeKey("\xCA\x83"): return Viseme::CH; // ʃ
+	case PhonemeKey("t"): return Viseme::DD;
+	case PhonemeKey("t\xCD\xA1\xCA\x83"): return Viseme::CH; // t͡ʃ
+	case PhonemeKey("\xCE\xB8"): return Viseme::TH; // θ
+	case PhonemeKey("v"): return Viseme::FF;
+	case PhonemeKey("w"): return Viseme::U;
+	case PhonemeKey("z"): return Viseme::SS;
+	case PhonemeKey("\xCA\x92"): return Viseme::CH; // ʒ
+	// Vowels
+	case PhonemeKey("\xC9\x99"): return Viseme::E; // ə
+	case PhonemeKey("\xC9\x9A"): return Viseme::E; // ɚ
+	case PhonemeKey("\xC3\xA6"): return Viseme::Aa; // æ
+	case PhonemeKey("a\xC9\xAA"): return Viseme::Aa; // aɪ
+	case PhonemeKey("a\xCA\x8A"): return Viseme::Aa; // aʊ
+	case PhonemeKey("\xC9\x91"): return Viseme::Aa; // ɑ
+	case PhonemeKey("e\xC9\xAA"): return Viseme::E; // eɪ
+	case PhonemeKey("\xC9\x9D"): return Viseme::E; // ɝ
+	case PhonemeKey("\xC9\x9B"): return Viseme::E; // ɛ
+	case PhonemeKey("i"): return Viseme::I;
+	case PhonemeKey("\xC9\xAA"): return Viseme::I; // ɪ
+	case PhonemeKey("o\xCA\x8A"): return Viseme::O; // oʊ
+	case PhonemeKey("\xC9\x94"): return Viseme::O; // ɔ
+	case PhonemeKey("\xC9\x94\xC9\xAA"): return Viseme::O; // ɔɪ
+	case PhonemeKey("u"): return Viseme::U;
+	case PhonemeKey("\xCA\x8A"): return Viseme::U; // ʊ
+	case PhonemeKey("\xCA\x8C"): return Viseme::E; // ʌ
+	// Additional Symbols
+	case PhonemeKey("\xCB\x88"): return Viseme::STOP; // ˈ
+	case PhonemeKey("\xCB\x8C"): return Viseme::STOP; // ˌ
+	case PhonemeKey("."): return Viseme::STOP;
+	default: return Viseme::None;
+	}
+}
+
+const char* Inworld::Utils::VisemeToString(Viseme Code)
+{
+	switch (Code)
+	{
+	case Viseme::PP: return "PP";
+	case Viseme::FF: return "FF";
+	case Viseme::TH: return "TH";
+	case Viseme::DD: return "DD";
+	case Viseme::Kk: return "Kk";
+	case Viseme::CH: return "CH";
+	case Viseme::SS: return "SS";
+	case Viseme::Nn: return "Nn";
+	case Viseme::RR: return "RR";
+	case Viseme::Aa: return "Aa";
+	case Viseme::E: return "E";
+	case Viseme::I: return "I";
+	case Viseme::O: return "O";
+	case Viseme::U: return "U";
+	case Viseme::STOP: return "STOP";
+	default: return "";
+	}
 }
 
 std::string Inworld::Utils::PhonemeToViseme(const std::string& Phoneme)
 {
-    static std::unordered_map<std::string, std::string> PhonemeToVisemeMap = {
-        // Consonants
-        {"b" , "PP"}, {"d" , "DD"}, {"d\u0361\u0292" , "CH"}, {"\xF0" , "TH"}, {"f" , "FF"}, {"\u0261" , "Kk"},
-        {"h" , "Kk"}, {"j" , "I"}, {"k" , "Kk"}, {"" , "Nn"}, {"m" , "PP"}, {"n" , "Nn"},
-        {"\u014B" , "Kk"}, {"p" , "PP"}, {"\u0279" , "RR"}, {"s" , "SS"}, {"\u0283" , "CH"}, {"t" , "DD"},
-        {"t\u0361\u0283" , "CH"}, {"\u03B8" , "TH"}, {"v" , "FF"}, {"w" , "U"}, {"z" , "SS"}, {"\u0292" , "CH"},
-        // Vowels
-        {"\u0259" , "E"}, {"\u025A" , "E"}, {"\xE6" , "Aa"}, {"a\u026A" , "Aa"}, {"a\u028A" , "Aa"}, {"\u0251" , "Aa"},
-        {"e\u026A" , "E"}, {"\u025D" , "E"}, {"\u025B" , "E"}, {"i" , "I"}, {"\u026A" , "I"}, {"o\u028A" , "O"},
-        {"\u0254" , "O"}, {"\u0254\u026A", "O"}, {"u" , "U"}, {"\u028A" , "U"}, {"\u028C" , "E"},
-        //Additional Symbols
-        {"\u02C8" , "STOP"}, {"\u02CC" , "STOP"}, {"." , "STOP"},
-    };
-    if (PhonemeToVisemeMap.find(Phoneme) != PhonemeToVisemeMap.end())
-    {
-        return PhonemeToVisemeMap[Phoneme];
-    }
-    return "";
+	return VisemeToString(PhonemeToVisemeCode(Phoneme));
+}
+
+void Inworld::Utils::PhonemesToVisemes(const AudioDataEvent& Event, std::vector<VisemeInfo>& OutVisemes)
+{
+	const auto& Phonemes = Event.GetPhonemeInfos();
+	OutVisemes.reserve(OutVisemes.size() + Phonemes.size());
+	for (const auto& Phoneme : Phonemes)
+	{
+		const Viseme Code = PhonemeToVisemeCode(Phoneme.Code);
+		if (Code != Viseme::None)
+		{
+			OutVisemes.push_back({ Code, Phoneme.Timestamp });
+		}
+	}
+}
+
+namespace
+{
+	int32_t VisemeTimestampToTicks(float Timestamp)
+	{
+		return static_cast<int32_t>(std::lround(Timestamp * Inworld::Utils::VisemeTicksPerSecond));
+	}
+
+	float VisemeTicksToTimestamp(int32_t Ticks)
+	{
+		return Ticks / static_cast<float>(Inworld::Utils::VisemeTicksPerSecond);
+	}
+
+	void AppendVarint(std::string& Out, uint32_t Value)
+	{
+		do
+		{
+			Out.push_back(static_cast<char>((Value & 0x7f) | (Value > 0x7f ? 0x80 : 0)));
+			Value >>= 7;
+		} while (Value);
+	}
+
+	bool ReadVarint(std::string_view Data, size_t& Offset, uint32_t& OutValue)
+	{
+		OutValue = 0;
+		for (uint32_t Shift = 0; Shift < 32 && Offset < Data.size(); Shift += 7)
+		{
+			const uint8_t Byte = static_cast<uint8_t>(Data[Offset++]);
+			OutValue |= static_cast<uint32_t>(Byte & 0x7f) << Shift;
+			if (!(Byte & 0x80))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+float Inworld::Utils::QuantizeVisemeTimestamp(float Timestamp)
+{
+	return VisemeTicksToTimestamp(VisemeTimestampToTicks(Timestamp));
+}
+
+void Inworld::Utils::EncodeVisemes(const std::vector<VisemeInfo>& Visemes, std::string& Out)
+{
+	AppendVarint(Out, static_cast<uint32_t>(Visemes.size()));
+	int32_t PrevTicks = 0;
+	for (const VisemeInfo& Info : Visemes)
+	{
+		Out.push_back(static_cast<char>(Info.Code));
+
+		// Zigzag coded, timestamps increase within an utterance but it is not relied on.
+		const int32_t Ticks = VisemeTimestampToTicks(Info.Timestamp);
+		const uint32_t Delta = static_cast<uint32_t>(Ticks) - static_cast<uint32_t>(PrevTicks);
+		AppendVarint(Out, (Delta << 1) ^ (0u - (Delta >> 31)));
+		PrevTicks = Ticks;
+	}
+}
+
+bool Inworld::Utils::DecodeVisemes(std::string_view Data, std::vector<VisemeInfo>& OutVisemes)
+{
+	size_t Offset = 0;
+	uint32_t Num;
+	// At least two bytes per viseme.
+	if (!ReadVarint(Data, Offset, Num) || Num > (Data.size() - Offset) / 2)
+	{
+		return false;
+	}
+
+	OutVisemes.resize(Num);
+	uint32_t Ticks = 0;
+	for (VisemeInfo& Info : OutVisemes)
+	{
+		uint32_t ZigZag;
+		if (Offset == Data.size())
+		{
+			return false;
+		}
+		const uint8_t Code = static_cast<uint8_t>(Data[Offset++]);
+		if (!ReadVarint(Data, Offset, ZigZag))
+		{
+			return false;
+		}
+
+		Info.Code = static_cast<Viseme>(std::min(Code, static_cast<uint8_t>(Viseme::STOP)));
+		Ticks += (ZigZag >> 1) ^ (0u - (ZigZag & 1));
+		Info.Timestamp = VisemeTicksToTimestamp(static_cast<int32_t>(Ticks));
+	}
+	return Offset == Data.size();
 }
 
 std::vector<uint8_t> Inworld::Utils::HmacSha256(const std::vector<uint8_t>& Data, const std::vector<uint8_t>& Key)
@@ -9,15 +9,77 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstdint>
 
 #include "Define.h"
 
 namespace Inworld
 {
+	class AudioDataEvent;
+
 	namespace Utils
 	{
-		INWORLD_EXPORT std::string GetSslRootCerts();
+		enum class SslRootCertsSource : uint8_t
+		{
+			// PEM bundle compiled into the library.
+			Bundled,
+			// Platform trust store, the ROOT store on Windows and a PEM file elsewhere.
+			// Falls back to the bundle when not found.
+			System
+		};
+
+		INWORLD_EXPORT void SetSslRootCertsSource(SslRootCertsSource Source);
+		INWORLD_EXPORT SslRootCertsSource GetSslRootCertsSource();
+
+		// Assembled once on first use, the reference stays valid for the lifetime of the process.
+		INWORLD_EXPORT const std::string& GetSslRootCerts();
+		INWORLD_EXPORT std::string LoadSystemSslRootCerts();
+
+		// Same order as the Unreal viseme blends.
+		enum class Viseme : uint8_t
+		{
+			PP,
+			FF,
+			TH,
+			DD,
+			Kk,
+			CH,
+			SS,
+			Nn,
+			RR,
+			Aa,
+			E,
+			I,
+			O,
+			U,
+			STOP,
+			// Phoneme without a viseme.
+			None
+		};
+
+		struct VisemeInfo
+		{
+			Viseme Code;
+			float Timestamp;
+		};
+
+		// Phonemes are IPA symbols in UTF-8, does not allocate.
+		INWORLD_EXPORT Viseme PhonemeToVisemeCode(std::string_view Phoneme);
+		// Empty for Viseme::None.
+		INWORLD_EXPORT const char* VisemeToString(Viseme Code);
 		INWORLD_EXPORT std::string PhonemeToViseme(const std::string& Phoneme);
+		// Appends the visemes of all phonemes of the event, phonemes without a viseme are skipped.
+		INWORLD_EXPORT void PhonemesToVisemes(const AudioDataEvent& Event, std::vector<VisemeInfo>& OutVisemes);
+
+		// Viseme timestamps are replicated in whole ticks, quantizing them when received keeps the round trip lossless.
+		constexpr int32_t VisemeTicksPerSecond = 1000;
+		INWORLD_EXPORT float QuantizeVisemeTimestamp(float Timestamp);
+		// A varint count, then per viseme the code byte and the zigzag varint delta of its timestamp in ticks.
+		// Appends to Out, timestamps are quantized.
+		INWORLD_EXPORT void EncodeVisemes(const std::vector<VisemeInfo>& Visemes, std::string& Out);
+		// False on malformed or trailing data. Codes past STOP are read as STOP.
+		INWORLD_EXPORT bool DecodeVisemes(std::string_view Data, std::vector<VisemeInfo>& OutVisemes);
 
 		std::vector<uint8_t> HmacSha256(const std::vector<uint8_t>& Data, const std::vector<uint8_t>& Key);
 		std::string ToHex(const std::vector<uint8_t>& Data);
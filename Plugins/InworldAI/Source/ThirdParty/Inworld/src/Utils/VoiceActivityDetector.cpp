@@ -0,0 +1,225 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#include "VoiceActivityDetector.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+
+namespace
+{
+	constexpr size_t FftSize = 256;
+	constexpr size_t FftLog2 = 8;
+	constexpr uint32_t SampleRate = 16000;
+	constexpr uint32_t FrameMs = 10;
+
+	// 62.5Hz per bin.
+	constexpr size_t FirstBandBin = 300 * FftSize / SampleRate;
+	constexpr size_t LastBandBin = 4000 * FftSize / SampleRate;
+
+	constexpr float SilenceDb = -100.f;
+	// Noise floor tracking per frame, it follows quiet frames quickly and rises slowly, in proportion to the gap
+	// so a jump in the background level (e.g. after muting) is learnt within a couple of seconds.
+	// Frames that look like speech barely raise it so long utterances do not.
+	constexpr float FloorFallRate = 0.2f;
+	constexpr float FloorRiseRate = 0.02f;
+	constexpr float FloorRiseDb = 0.05f;
+	constexpr float FloorRiseSpeechDb = 0.005f;
+
+	struct FftTables
+	{
+		std::array<float, Inworld::VoiceActivityDetector::FrameSize> Window;
+		std::array<std::complex<float>, FftSize / 2> Twiddles;
+		std::array<uint16_t, FftSize> BitReverse;
+
+		FftTables()
+		{
+			const double Pi = std::acos(-1.0);
+			for (size_t i = 0; i < Window.size(); i++)
+			{
+				Window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * Pi * i / (Window.size() - 1)));
+			}
+			for (size_t i = 0; i < Twiddles.size(); i++)
+			{
+				Twiddles[i] = std::polar(1.f, static_cast<float>(-2.0 * Pi * i / FftSize));
+			}
+			for (size_t i = 0; i < FftSize; i++)
+			{
+				uint16_t Reversed = 0;
+				for (size_t Bit = 0; Bit < FftLog2; Bit++)
+				{
+					Reversed |= ((i >> Bit) & 1) << (FftLog2 - 1 - Bit);
+				}
+				BitReverse[i] = Reversed;
+			}
+		}
+	};
+
+	const FftTables& GetFftTables()
+	{
+		static const FftTables Tables;
+		return Tables;
+	}
+
+	void Fft(std::array<std::complex<float>, FftSize>& Data)
+	{
+		const FftTables& Tables = GetFftTables();
+		for (size_t i = 0; i < FftSize; i++)
+		{
+			const size_t j = Tables.BitReverse[i];
+			if (i < j)
+			{
+				std::swap(Data[i], Data[j]);
+			}
+		}
+
+		for (size_t Size = 2; Size <= FftSize; Size <<= 1)
+		{
+			const size_t Half = Size / 2;
+			const size_t Step = FftSize / Size;
+			for (size_t Start = 0; Start < FftSize; Start += Size)
+			{
+				for (size_t k = 0; k < Half; k++)
+				{
+					const std::complex<float> Odd = Tables.Twiddles[k * Step] * Data[Start + k + Half];
+					Data[Start + k + Half] = Data[Start + k] - Odd;
+					Data[Start + k] += Odd;
+				}
+			}
+		}
+	}
+}
+
+Inworld::VoiceActivityDetector::VoiceActivityDetector(const Settings& InSettings)
+	: _Settings(InSettings)
+{
+	_Carry.reserve(FrameSize);
+}
+
+bool Inworld::VoiceActivityDetector::Process(const int16_t* Samples, size_t Num)
+{
+	bool bAnyActive = false;
+	bool bAnyFrame = false;
+
+	if (!_Carry.empty())
+	{
+		const size_t Missing = std::min(FrameSize - _Carry.size(), Num);
+		_Carry.insert(_Carry.end(), Samples, Samples + Missing);
+		Samples += Missing;
+		Num -= Missing;
+		if (_Carry.size() < FrameSize)
+		{
+			return _bActive;
+		}
+		bAnyActive |= ProcessFrame(_Carry.data());
+		bAnyFrame = true;
+		_Carry.clear();
+	}
+
+	for (; Num >= FrameSize; Samples += FrameSize, Num -= FrameSize)
+	{
+		bAnyActive |= ProcessFrame(Samples);
+		bAnyFrame = true;
+	}
+
+	_Carry.insert(_Carry.end(), Samples, Samples + Num);
+	return bAnyFrame ? bAnyActive : _bActive;
+}
+
+void Inworld::VoiceActivityDetector::Reset()
+{
+	_Carry.clear();
+	_NoiseFloorDb = 0.f;
+	_bHasNoiseFloor = false;
+	_HangoverFrames = 0;
+	_bActive = false;
+}
+
+bool Inworld::VoiceActivityDetector::ProcessFrame(const int16_t* Frame)
+{
+	const float EnergyDb = FrameEnergyDb(Frame);
+	if (!_bHasNoiseFloor)
+	{
+		_NoiseFloorDb = EnergyDb;
+		_bHasNoiseFloor = true;
+	}
+
+	// The spectrum is only computed for frames loud enough to be speech.
+	bool bSpeech = false;
+	bool bHarmonic = false;
+	if (EnergyDb > _Settings.MinSpeechDbfs && EnergyDb > _NoiseFloorDb + _Settings.SpeechMarginDb)
+	{
+		bHarmonic = SpectralFlatness(Frame) < _Settings.MaxSpeechFlatness;
+		bSpeech = bHarmonic || EnergyDb > _NoiseFloorDb + _Settings.LoudSpeechMarginDb;
+	}
+
+	if (EnergyDb < _NoiseFloorDb)
+	{
+		_NoiseFloorDb += (EnergyDb - _NoiseFloorDb) * FloorFallRate;
+	}
+	else
+	{
+		const float Rise = bHarmonic ? FloorRiseSpeechDb : std::max(FloorRiseDb, (EnergyDb - _NoiseFloorDb) * FloorRiseRate);
+		_NoiseFloorDb = std::min(EnergyDb, _NoiseFloorDb + Rise);
+	}
+
+	if (bSpeech)
+	{
+		_HangoverFrames = _Settings.HangoverMs / FrameMs;
+		_bActive = true;
+	}
+	else if (_HangoverFrames > 0)
+	{
+		_HangoverFrames--;
+		_bActive = true;
+	}
+	else
+	{
+		_bActive = false;
+	}
+
+	_Stats.Frames++;
+	_Stats.SpeechFrames += bSpeech ? 1 : 0;
+	_Stats.ActiveFrames += _bActive ? 1 : 0;
+	return _bActive;
+}
+
+float Inworld::VoiceActivityDetector::FrameEnergyDb(const int16_t* Frame)
+{
+	double Sum = 0.0;
+	for (size_t i = 0; i < FrameSize; i++)
+	{
+		const double Sample = Frame[i] / 32768.0;
+		Sum += Sample * Sample;
+	}
+	const double Mean = Sum / FrameSize;
+	return Mean > 0.0 ? std::max(SilenceDb, static_cast<float>(10.0 * std::log10(Mean))) : SilenceDb;
+}
+
+float Inworld::VoiceActivityDetector::SpectralFlatness(const int16_t* Frame)
+{
+	const FftTables& Tables = GetFftTables();
+	std::array<std::complex<float>, FftSize> Spectrum {};
+	for (size_t i = 0; i < FrameSize; i++)
+	{
+		Spectrum[i] = Frame[i] / 32768.f * Tables.Window[i];
+	}
+	Fft(Spectrum);
+
+	constexpr float Epsilon = 1e-12f;
+	double LogSum = 0.0;
+	double Sum = 0.0;
+	for (size_t Bin = FirstBandBin; Bin <= LastBandBin; Bin++)
+	{
+		const float Power = std::norm(Spectrum[Bin]) + Epsilon;
+		LogSum += std::log(Power);
+		Sum += Power;
+	}
+	constexpr size_t NumBins = LastBandBin - FirstBandBin + 1;
+	return static_cast<float>(std::exp(LogSum / NumBins) / (Sum / NumBins));
+}
@@ -0,0 +1,140 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#pragma once
+
+#include "../Define.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace Inworld
+{
+	// Voice activity detection of 16kHz mono audio on 10ms frames. A frame is speech when its energy is well above
+	// the tracked noise floor, or moderately above it with a harmonic (not flat) spectrum, which keeps steady
+	// broadband noise out. Activity is held for the hangover after the last speech frame so trailing consonants
+	// and short pauses are not cut. Samples that do not complete a frame are carried over to the next call.
+	class INWORLD_EXPORT VoiceActivityDetector
+	{
+	public:
+		static constexpr size_t FrameSize = 160;
+
+		struct Settings
+		{
+			uint32_t HangoverMs = 600;
+			// Frames quieter than this are never speech.
+			float MinSpeechDbfs = -55.f;
+			float SpeechMarginDb = 8.f;
+			// Frames this far above the noise floor are speech regardless of their spectrum.
+			float LoudSpeechMarginDb = 20.f;
+			// Spectral flatness is 0 for a pure tone and close to 1 for white noise.
+			float MaxSpeechFlatness = 0.35f;
+		};
+
+		struct Stats
+		{
+			uint64_t Frames = 0;
+			uint64_t SpeechFrames = 0;
+			uint64_t ActiveFrames = 0;
+		};
+
+		VoiceActivityDetector() : VoiceActivityDetector(Settings()) {}
+		explicit VoiceActivityDetector(const Settings& InSettings);
+
+		// Returns true if any frame completed by this call is active, speech or hangover.
+		// When no frame is completed returns the state of the last one.
+		bool Process(const int16_t* Samples, size_t Num);
+		bool IsActive() const { return _bActive; }
+
+		// Drops carried over samples, the hangover and the noise floor.
+		void Reset();
+
+		float GetNoiseFloorDb() const { return _NoiseFloorDb; }
+		const Settings& GetSettings() const { return _Settings; }
+		void SetSettings(const Settings& InSettings) { _Settings = InSettings; }
+
+		const Stats& GetStats() const { return _Stats; }
+		void ResetStats() { _Stats = Stats(); }
+
+		// Mean power relative to full scale.
+		static float FrameEnergyDb(const int16_t* Frame);
+		// Over the 300Hz - 4kHz band, where voiced speech has its harmonics.
+		static float SpectralFlatness(const int16_t* Frame);
+
+	private:
+		bool ProcessFrame(const int16_t* Frame);
+
+		Settings _Settings;
+		std::vector<int16_t> _Carry;
+		float _NoiseFloorDb = 0.f;
+		bool _bHasNoiseFloor = false;
+		uint32_t _HangoverFrames = 0;
+		bool _bActive = false;
+		Stats _Stats;
+	};
+
+	// Holds back inactive chunks so the start of an utterance, which the detector only confirms a few frames in,
+	// is sent along with it. Chunks older than the pre-roll are suppressed, the rest are sent in capture order.
+	template<typename TChunk>
+	class VoiceActivityGate
+	{
+	public:
+		struct Stats
+		{
+			uint64_t Chunks = 0;
+			uint64_t SentChunks = 0;
+			uint64_t SuppressedChunks = 0;
+		};
+
+		explicit VoiceActivityGate(size_t InPreRollChunks = 2) : _PreRollChunks(InPreRollChunks) {}
+
+		template<typename TSend>
+		void Push(TChunk&& Chunk, bool bActive, TSend&& Send)
+		{
+			_Stats.Chunks++;
+			if (!bActive)
+			{
+				_PreRoll.push_back(std::move(Chunk));
+				while (_PreRoll.size() > _PreRollChunks)
+				{
+					_PreRoll.pop_front();
+					_Stats.SuppressedChunks++;
+				}
+				return;
+			}
+
+			while (!_PreRoll.empty())
+			{
+				Send(std::move(_PreRoll.front()));
+				_PreRoll.pop_front();
+				_Stats.SentChunks++;
+			}
+			Send(std::move(Chunk));
+			_Stats.SentChunks++;
+		}
+
+		// Held chunks are suppressed.
+		void Reset()
+		{
+			_Stats.SuppressedChunks += _PreRoll.size();
+			_PreRoll.clear();
+		}
+
+		void SetPreRollChunks(size_t InPreRollChunks) { _PreRollChunks = InPreRollChunks; }
+		size_t GetNumHeld() const { return _PreRoll.size(); }
+
+		const Stats& GetStats() const { return _Stats; }
+		void ResetStats() { _Stats = Stats(); }
+
+	private:
+		size_t _PreRollChunks;
+		std::deque<TChunk> _PreRoll;
+		Stats _Stats;
+	};
+}
@@ -0,0 +1,310 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#include "VoiceJitterBuffer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr size_t SizeHeader = sizeof(uint32_t);
+
+	void XorBytes(Inworld::VoiceFrameData& Into, const uint8_t* Data, size_t Size, size_t Offset = 0)
+	{
+		if (Into.size() < Offset + Size)
+		{
+			Into.resize(Offset + Size, 0);
+		}
+		for (size_t i = 0; i < Size; i++)
+		{
+			Into[Offset + i] ^= Data[i];
+		}
+	}
+
+	// Frames are XORed with their size in front, so frames of different sizes can be rebuilt.
+	void XorFrame(Inworld::VoiceFrameData& Into, const Inworld::VoiceFrameData& Frame)
+	{
+		const uint32_t Size = static_cast<uint32_t>(Frame.size());
+		const uint8_t Header[SizeHeader] = {
+			static_cast<uint8_t>(Size), static_cast<uint8_t>(Size >> 8), static_cast<uint8_t>(Size >> 16), static_cast<uint8_t>(Size >> 24)
+		};
+		XorBytes(Into, Header, SizeHeader);
+		XorBytes(Into, Frame.data(), Frame.size(), SizeHeader);
+	}
+
+	bool DecodeFrame(const Inworld::VoiceFrameData& Xor, Inworld::VoiceFrameData& OutFrame)
+	{
+		if (Xor.size() < SizeHeader)
+		{
+			return false;
+		}
+
+		const uint32_t Size = Xor[0] | (Xor[1] << 8) | (Xor[2] << 16) | (static_cast<uint32_t>(Xor[3]) << 24);
+		if (Size > Xor.size() - SizeHeader)
+		{
+			return false;
+		}
+
+		OutFrame.assign(Xor.begin() + SizeHeader, Xor.begin() + SizeHeader + Size);
+		return true;
+	}
+
+	uint32_t FullGroupMask(uint32_t GroupSize)
+	{
+		return GroupSize >= 32 ? ~0u : (1u << GroupSize) - 1;
+	}
+}
+
+Inworld::VoiceFecEncoder::VoiceFecEncoder(uint32_t InGroupSize)
+	: _GroupSize(std::min(InGroupSize, MaxGroupSize))
+{}
+
+bool Inworld::VoiceFecEncoder::Add(uint32_t Sequence, const VoiceFrameData& Frame, VoiceFrameData& OutParity)
+{
+	if (_GroupSize < 2)
+	{
+		return false;
+	}
+
+	// Groups the encoder joined midway are not complete, they get no parity.
+	const uint32_t Index = Sequence % _GroupSize;
+	if (Index == 0)
+	{
+		_Parity.clear();
+		_NumAdded = 0;
+	}
+	else if (_NumAdded == 0 || Sequence != _LastSequence + 1)
+	{
+		_NumAdded = 0;
+		_LastSequence = Sequence;
+		return false;
+	}
+
+	XorFrame(_Parity, Frame);
+	_NumAdded++;
+	_LastSequence = Sequence;
+
+	if (Index != _GroupSize - 1)
+	{
+		return false;
+	}
+
+	OutParity = std::move(_Parity);
+	_Parity.clear();
+	_NumAdded = 0;
+	return true;
+}
+
+void Inworld::VoiceFecEncoder::Reset()
+{
+	_Parity.clear();
+	_NumAdded = 0;
+	_LastSequence = 0;
+}
+
+Inworld::VoiceJitterBuffer::VoiceJitterBuffer(const Settings& InSettings)
+	: _Settings(InSettings)
+{
+	_Settings.FecGroupSize = std::min(_Settings.FecGroupSize, VoiceFecEncoder::MaxGroupSize);
+	if (_Settings.FecGroupSize < 2)
+	{
+		_Settings.FecGroupSize = 0;
+	}
+}
+
+void Inworld::VoiceJitterBuffer::PushFrame(uint32_t Sequence, VoiceFrameData&& Frame, Clock::time_point Now)
+{
+	_Stats.Received++;
+	UpdateJitter(Sequence, Now);
+
+	if (!_bStarted)
+	{
+		_Next = Sequence;
+		_bStarted = true;
+	}
+	else if (!_bReleased && Sequence < _Next)
+	{
+		// Reordered before anything was released, nothing is late yet.
+		_Next = Sequence;
+	}
+
+	const uint32_t GroupIndex = _Settings.FecGroupSize ? Sequence / _Settings.FecGroupSize : 0;
+	if (Sequence < _Next)
+	{
+		// Too late to be released, but it may still complete its group for a frame that is not.
+		_Stats.Late++;
+		if (_Settings.FecGroupSize && _Groups.count(GroupIndex) && AddToGroup(Sequence, Frame))
+		{
+			TryRecover(GroupIndex, Now);
+		}
+		return;
+	}
+
+	if (_Frames.count(Sequence) || (_Settings.FecGroupSize && !AddToGroup(Sequence, Frame)))
+	{
+		_Stats.Duplicates++;
+		return;
+	}
+
+	_Frames.emplace(Sequence, Entry{ std::move(Frame), Now });
+	if (_Settings.FecGroupSize)
+	{
+		TryRecover(GroupIndex, Now);
+	}
+}
+
+void Inworld::VoiceJitterBuffer::PushParity(uint32_t GroupIndex, VoiceFrameData&& Parity, Clock::time_point Now)
+{
+	if (!_Settings.FecGroupSize)
+	{
+		return;
+	}
+
+	// Parity of released groups is of no use, parity far ahead of the held frames is bogus.
+	const uint64_t GroupStart = static_cast<uint64_t>(GroupIndex) * _Settings.FecGroupSize;
+	const uint64_t GroupEnd = GroupStart + _Settings.FecGroupSize;
+	if ((_bReleased && GroupEnd <= _Next) || (_bStarted && GroupStart > static_cast<uint64_t>(_Next) + _Settings.MaxFrames + _Settings.FecGroupSize))
+	{
+		return;
+	}
+
+	Group& Parities = _Groups[GroupIndex];
+	if (Parities.bParity)
+	{
+		return;
+	}
+
+	XorBytes(Parities.Xor, Parity.data(), Parity.size());
+	Parities.bParity = true;
+	TryRecover(GroupIndex, Now);
+}
+
+void Inworld::VoiceJitterBuffer::Release(Clock::time_point Now, const ReleaseCallback& Callback)
+{
+	while (!_Frames.empty())
+	{
+		const auto It = _Frames.begin();
+		if (It->first != _Next)
+		{
+			// The wait starts with the first frame held behind the gap, not the one now in front of it,
+			// frames arriving out of order would extend it otherwise.
+			const auto Oldest = std::min_element(_Frames.begin(), _Frames.end(),
+				[](const auto& A, const auto& B) { return A.second.Arrival < B.second.Arrival; });
+			if (_Frames.size() <= _Settings.MaxFrames && Now - Oldest->second.Arrival < _Settings.MaxWait)
+			{
+				break;
+			}
+			_Stats.Lost += It->first - _Next;
+			_Next = It->first;
+		}
+		ReleaseFront(Callback);
+	}
+	PruneGroups();
+}
+
+void Inworld::VoiceJitterBuffer::Flush(const ReleaseCallback& Callback)
+{
+	while (!_Frames.empty())
+	{
+		const uint32_t Sequence = _Frames.begin()->first;
+		_Stats.Lost += Sequence - _Next;
+		_Next = Sequence;
+		ReleaseFront(Callback);
+	}
+	PruneGroups();
+}
+
+void Inworld::VoiceJitterBuffer::Reset()
+{
+	_Frames.clear();
+	_Groups.clear();
+	_Next = 0;
+	_bStarted = false;
+	_bReleased = false;
+	_bHasTransit = false;
+}
+
+void Inworld::VoiceJitterBuffer::UpdateJitter(uint32_t Sequence, Clock::time_point Now)
+{
+	const double TransitMs = std::chrono::duration<double, std::milli>(Now.time_since_epoch()).count()
+		- static_cast<double>(Sequence) * _Settings.FrameInterval.count();
+	if (_bHasTransit)
+	{
+		_Stats.JitterMs += (std::abs(TransitMs - _LastTransitMs) - _Stats.JitterMs) / 16.0;
+	}
+	_LastTransitMs = TransitMs;
+	_bHasTransit = true;
+}
+
+bool Inworld::VoiceJitterBuffer::AddToGroup(uint32_t Sequence, const VoiceFrameData& Frame)
+{
+	Group& Members = _Groups[Sequence / _Settings.FecGroupSize];
+	const uint32_t Bit = 1u << (Sequence % _Settings.FecGroupSize);
+	if (Members.ReceivedMask & Bit)
+	{
+		return false;
+	}
+
+	XorFrame(Members.Xor, Frame);
+	Members.ReceivedMask |= Bit;
+	return true;
+}
+
+void Inworld::VoiceJitterBuffer::TryRecover(uint32_t GroupIndex, Clock::time_point Now)
+{
+	const auto It = _Groups.find(GroupIndex);
+	if (It == _Groups.end() || !It->second.bParity)
+	{
+		return;
+	}
+
+	Group& Members = It->second;
+	const uint32_t Missing = FullGroupMask(_Settings.FecGroupSize) & ~Members.ReceivedMask;
+	if (Missing == 0 || (Missing & (Missing - 1)) != 0)
+	{
+		return;
+	}
+
+	uint32_t Index = 0;
+	while (!(Missing & (1u << Index)))
+	{
+		Index++;
+	}
+	Members.ReceivedMask |= Missing;
+
+	const uint32_t Sequence = GroupIndex * _Settings.FecGroupSize + Index;
+	VoiceFrameData Frame;
+	if (Sequence < _Next || !DecodeFrame(Members.Xor, Frame))
+	{
+		return;
+	}
+
+	_Frames.emplace(Sequence, Entry{ std::move(Frame), Now });
+	_Stats.Recovered++;
+}
+
+void Inworld::VoiceJitterBuffer::ReleaseFront(const ReleaseCallback& Callback)
+{
+	auto Node = _Frames.extract(_Frames.begin());
+	_Next = Node.key() + 1;
+	_bReleased = true;
+	_Stats.Released++;
+	Callback(Node.key(), std::move(Node.mapped().Frame));
+}
+
+void Inworld::VoiceJitterBuffer::PruneGroups()
+{
+	if (!_Settings.FecGroupSize)
+	{
+		return;
+	}
+
+	while (!_Groups.empty() && (static_cast<uint64_t>(_Groups.begin()->first) + 1) * _Settings.FecGroupSize <= _Next)
+	{
+		_Groups.erase(_Groups.begin());
+	}
+}
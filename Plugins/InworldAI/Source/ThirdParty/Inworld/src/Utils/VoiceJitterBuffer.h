@@ -0,0 +1,127 @@
+/**
+ * Copyright 2022 Theai, Inc. (DBA Inworld)
+ *
+ * Use of this source code is governed by the Inworld.ai Software Development Kit License Agreement
+ * that can be found in the LICENSE.md file or at https://www.inworld.ai/sdk-license
+ */
+
+#pragma once
+
+#include "../Define.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace Inworld
+{
+	using VoiceFrameData = std::vector<uint8_t>;
+
+	// XOR parity over groups of consecutive frames, group N covers sequences [N * GroupSize, (N + 1) * GroupSize).
+	// A single lost frame of a group is rebuilt from the parity and the rest of the group. Frames may differ in size.
+	class INWORLD_EXPORT VoiceFecEncoder
+	{
+	public:
+		static constexpr uint32_t MaxGroupSize = 32;
+
+		explicit VoiceFecEncoder(uint32_t InGroupSize);
+
+		// Frames are added in sequence order. Returns true when Sequence completes its group, OutParity is then
+		// the parity of group Sequence / GroupSize.
+		bool Add(uint32_t Sequence, const VoiceFrameData& Frame, VoiceFrameData& OutParity);
+		void Reset();
+
+		uint32_t GetGroupSize() const { return _GroupSize; }
+
+	private:
+		uint32_t _GroupSize;
+		VoiceFrameData _Parity;
+		uint32_t _NumAdded = 0;
+		uint32_t _LastSequence = 0;
+	};
+
+	// Receiving end of an unreliable, sequenced voice stream. Frames are released in sequence order, a missing frame
+	// is waited for until a later one has been held for MaxWait or more than MaxFrames are held, then skipped.
+	// Frames arriving after their sequence was released or skipped are discarded. Sequences are not expected
+	// to wrap, at 10 frames a second that takes over 13 years.
+	class INWORLD_EXPORT VoiceJitterBuffer
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+		using ReleaseCallback = std::function<void(uint32_t Sequence, VoiceFrameData&& Frame)>;
+
+		struct Settings
+		{
+			std::chrono::milliseconds MaxWait { 200 };
+			uint32_t MaxFrames = 8;
+			// Parity group size of the sender, 0 when it sends no parity.
+			uint32_t FecGroupSize = 0;
+			// Time between consecutive frames at the sender, for the jitter estimate.
+			std::chrono::milliseconds FrameInterval { 100 };
+		};
+
+		struct Stats
+		{
+			uint64_t Received = 0;
+			uint64_t Released = 0;
+			uint64_t Recovered = 0;
+			uint64_t Lost = 0;
+			uint64_t Late = 0;
+			uint64_t Duplicates = 0;
+			// Interarrival jitter estimate as in RFC 3550, smoothed over the last 16 or so frames.
+			double JitterMs = 0.0;
+		};
+
+		VoiceJitterBuffer() : VoiceJitterBuffer(Settings()) {}
+		explicit VoiceJitterBuffer(const Settings& InSettings);
+
+		void PushFrame(uint32_t Sequence, VoiceFrameData&& Frame, Clock::time_point Now);
+		void PushParity(uint32_t Group, VoiceFrameData&& Parity, Clock::time_point Now);
+
+		// Releases the frames that are due.
+		void Release(Clock::time_point Now, const ReleaseCallback& Callback);
+		// Releases every held frame, skipping the missing ones, e.g. when the audio session ends.
+		// The sequence carries on, later frames continue from the last released one.
+		void Flush(const ReleaseCallback& Callback);
+		void Reset();
+
+		size_t GetNumHeld() const { return _Frames.size(); }
+
+		const Stats& GetStats() const { return _Stats; }
+		void ResetStats() { _Stats = Stats(); }
+
+	private:
+		struct Entry
+		{
+			VoiceFrameData Frame;
+			Clock::time_point Arrival;
+		};
+
+		// XOR of the parity and the frames received so far.
+		struct Group
+		{
+			VoiceFrameData Xor;
+			uint32_t ReceivedMask = 0;
+			bool bParity = false;
+		};
+
+		void UpdateJitter(uint32_t Sequence, Clock::time_point Now);
+		bool AddToGroup(uint32_t Sequence, const VoiceFrameData& Frame);
+		void TryRecover(uint32_t GroupIndex, Clock::time_point Now);
+		void ReleaseFront(const ReleaseCallback& Callback);
+		void PruneGroups();
+
+		Settings _Settings;
+		std::map<uint32_t, Entry> _Frames;
+		std::map<uint32_t, Group> _Groups;
+		uint32_t _Next = 0;
+		bool _bStarted = false;
+		bool _bReleased = false;
+		// Arrival time less the frame's place in the stream, of the last frame received.
+		double _LastTransitMs = 0.0;
+		bool _bHasTransit = false;
+		Stats _Stats;
+	};
+}
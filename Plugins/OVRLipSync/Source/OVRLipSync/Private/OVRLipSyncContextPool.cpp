@@ -0,0 +1,112 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#include "OVRLipSyncContextPool.h"
+#include "OVRLipSyncContextWrapper.h"
+#include "OVRLipSyncModule.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+
+static TAutoConsoleVariable<int32> CVarContextPoolMaxIdle(
+	TEXT("OVRLipSync.ContextPool.MaxIdle"), 64,
+	TEXT("Idle lip-sync contexts kept per provider and sample rate, 0 destroys every released context"));
+
+static FAutoConsoleCommand DumpContextPoolCommand(
+	TEXT("OVRLipSync.ContextPool.Dump"), TEXT("Log the counters of the lip-sync context pool"),
+	FConsoleCommandDelegate::CreateLambda([]() {
+		const FOVRLipSyncContextPool::FStats Stats = FOVRLipSyncContextPool::Get().GetStats();
+		UE_LOG(LogOvrLipSync, Log,
+			   TEXT("Context pool: created %d, reused %d, released %d, destroyed %d, in use %d (peak %d), idle %d"),
+			   Stats.Created, Stats.Reused, Stats.Released, Stats.Destroyed, Stats.InUse, Stats.PeakInUse, Stats.Idle);
+	}));
+
+FOVRLipSyncContextPool &FOVRLipSyncContextPool::Get()
+{
+	static FOVRLipSyncContextPool Pool;
+	return Pool;
+}
+
+TSharedPtr<UOVRLipSyncContextWrapper> FOVRLipSyncContextPool::Acquire(ovrLipSyncContextProvider Provider,
+																	   int SampleRate, int BufferSize, bool Accelerate)
+{
+	const FKey Key{Provider, SampleRate, BufferSize, Accelerate};
+
+	UOVRLipSyncContextWrapper *Context = nullptr;
+	{
+		FScopeLock Lock(&Mutex);
+		TArray<UOVRLipSyncContextWrapper *> *Idle = IdleContexts.Find(Key);
+		if (Idle && Idle->Num() > 0)
+		{
+			Context = Idle->Pop(false);
+			Stats.Reused++;
+			Stats.Idle--;
+		}
+		Stats.InUse++;
+		Stats.PeakInUse = FMath::Max(Stats.PeakInUse, Stats.InUse);
+	}
+
+	if (!Context)
+	{
+		// Outside the lock, it takes milliseconds.
+		Context = new UOVRLipSyncContextWrapper(Provider, SampleRate, BufferSize, FString(), Accelerate);
+		FScopeLock Lock(&Mutex);
+		Stats.Created++;
+	}
+
+	return MakeShareable(Context, [this, Key](UOVRLipSyncContextWrapper *Released) { Release(Released, Key); });
+}
+
+void FOVRLipSyncContextPool::Release(UOVRLipSyncContextWrapper *Context, const FKey &Key)
+{
+	const bool bReset = Context->IsValid() && Context->Reset();
+
+	FScopeLock Lock(&Mutex);
+	Stats.InUse--;
+	Stats.Released++;
+
+	TArray<UOVRLipSyncContextWrapper *> &Idle = IdleContexts.FindOrAdd(Key);
+	if (!bReset || bShutdown || Idle.Num() >= CVarContextPoolMaxIdle.GetValueOnAnyThread())
+	{
+		Stats.Destroyed++;
+		delete Context;
+		return;
+	}
+
+	Idle.Add(Context);
+	Stats.Idle++;
+}
+
+FOVRLipSyncContextPool::FStats FOVRLipSyncContextPool::GetStats() const
+{
+	FScopeLock Lock(&Mutex);
+	return Stats;
+}
+
+void FOVRLipSyncContextPool::Empty()
+{
+	TMap<FKey, TArray<UOVRLipSyncContextWrapper *>> Contexts;
+	{
+		FScopeLock Lock(&Mutex);
+		Contexts = MoveTemp(IdleContexts);
+		IdleContexts.Reset();
+		Stats.Destroyed += Stats.Idle;
+		Stats.Idle = 0;
+	}
+
+	for (auto &Entry : Contexts)
+	{
+		for (UOVRLipSyncContextWrapper *Context : Entry.Value)
+		{
+			delete Context;
+		}
+	}
+}
+
+void FOVRLipSyncContextPool::Shutdown()
+{
+	{
+		FScopeLock Lock(&Mutex);
+		bShutdown = true;
+	}
+	Empty();
+}
@@ -0,0 +1,150 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#include "OVRLipSyncContextPool.h"
+#include "OVRLipSyncContextWrapper.h"
+#include "OVRLipSyncModule.h"
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace
+{
+// Inworld characters speak 16 kHz mono, sequences are computed in 10 ms frames.
+constexpr int32 BenchmarkSampleRate = 16000;
+constexpr int32 BenchmarkBufferSize = 4096;
+constexpr int32 FrameSamples = BenchmarkSampleRate / 100;
+
+struct FModeResult
+{
+	int32 ContextsCreated = 0;
+	double SetupSeconds = 0.0;
+	double ProcessSeconds = 0.0;
+	double TeardownSeconds = 0.0;
+	int64 PeakMemoryBytes = 0;
+};
+
+// Roughly speech shaped: a few harmonics under a syllable rate envelope, and some noise.
+TArray<int16> MakeUtterance(float Seconds)
+{
+	FRandomStream Random(42);
+	TArray<int16> Samples;
+	Samples.SetNumUninitialized(FMath::Max(1, static_cast<int32>(Seconds * BenchmarkSampleRate)));
+	for (int32 Index = 0; Index < Samples.Num(); ++Index)
+	{
+		const float Time = static_cast<float>(Index) / BenchmarkSampleRate;
+		const float Envelope = 0.5f + 0.5f * FMath::Sin(2.f * PI * 4.f * Time);
+		float Value = 0.f;
+		for (int32 Harmonic = 1; Harmonic <= 4; ++Harmonic)
+		{
+			Value += FMath::Sin(2.f * PI * 140.f * Harmonic * Time) / Harmonic;
+		}
+		Value = Envelope * Value * 0.3f + Random.FRandRange(-0.05f, 0.05f);
+		Samples[Index] = static_cast<int16>(FMath::Clamp(Value, -1.f, 1.f) * 32767.f);
+	}
+	return Samples;
+}
+
+// As UInworldCharacterPlaybackAudioLip turns an utterance into a frame sequence.
+void ProcessUtterance(UOVRLipSyncContextWrapper &Context, const TArray<int16> &Utterance)
+{
+	TArray<float> Visemes;
+	float LaughterScore = 0.f;
+	int32_t FrameDelay = 0;
+	TArray<int16> Silence;
+	Silence.SetNumZeroed(FrameSamples);
+	Context.ProcessFrame(Silence.GetData(), FrameSamples, Visemes, LaughterScore, FrameDelay);
+	for (int32 Offset = 0; Offset + FrameSamples <= Utterance.Num(); Offset += FrameSamples)
+	{
+		Context.ProcessFrame(Utterance.GetData() + Offset, FrameSamples, Visemes, LaughterScore, FrameDelay);
+	}
+}
+
+FModeResult RunMode(bool bPooled, int32 Actors, int32 Utterances, const TArray<int16> &Utterance)
+{
+	FOVRLipSyncContextPool &Pool = FOVRLipSyncContextPool::Get();
+	Pool.Empty();
+	const int32 CreatedBefore = Pool.GetStats().Created;
+	const int64 MemoryBefore = static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical);
+
+	FModeResult Result;
+	TArray<TSharedPtr<UOVRLipSyncContextWrapper>> Contexts;
+	for (int32 Round = 0; Round < Utterances; ++Round)
+	{
+		// Every actor speaks at once, the worst case for the number of live contexts.
+		double Start = FPlatformTime::Seconds();
+		for (int32 Actor = 0; Actor < Actors; ++Actor)
+		{
+			if (bPooled)
+			{
+				Contexts.Add(Pool.Acquire(ovrLipSyncContextProvider_Enhanced, BenchmarkSampleRate, BenchmarkBufferSize));
+			}
+			else
+			{
+				Contexts.Add(MakeShared<UOVRLipSyncContextWrapper>(ovrLipSyncContextProvider_Enhanced,
+																   BenchmarkSampleRate, BenchmarkBufferSize));
+			}
+		}
+		Result.SetupSeconds += FPlatformTime::Seconds() - Start;
+		Result.PeakMemoryBytes = FMath::Max(
+			Result.PeakMemoryBytes, static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical) - MemoryBefore);
+
+		Start = FPlatformTime::Seconds();
+		for (const TSharedPtr<UOVRLipSyncContextWrapper> &Context : Contexts)
+		{
+			ProcessUtterance(*Context, Utterance);
+		}
+		Result.ProcessSeconds += FPlatformTime::Seconds() - Start;
+
+		Start = FPlatformTime::Seconds();
+		Contexts.Reset();
+		Result.TeardownSeconds += FPlatformTime::Seconds() - Start;
+	}
+
+	Result.ContextsCreated = bPooled ? Pool.GetStats().Created - CreatedBefore : Actors * Utterances;
+	return Result;
+}
+
+void LogMode(const TCHAR *Name, const FModeResult &Result, int32 Actors, int32 Utterances)
+{
+	const int32 Total = FMath::Max(1, Actors * Utterances);
+	UE_LOG(LogOvrLipSync, Log,
+		   TEXT("%s: %d contexts created, setup %.1f ms (%.3f ms per utterance), process %.1f ms, teardown %.1f ms, ")
+			   TEXT("peak memory +%.1f MB"),
+		   Name, Result.ContextsCreated, Result.SetupSeconds * 1000.0, Result.SetupSeconds * 1000.0 / Total,
+		   Result.ProcessSeconds * 1000.0, Result.TeardownSeconds * 1000.0,
+		   Result.PeakMemoryBytes / (1024.0 * 1024.0));
+}
+} // namespace
+
+// OVRLipSync.ContextPoolBenchmark [Actors=50] [Utterances=5] [Seconds=2]
+// Every actor turns an utterance into a viseme sequence per round, with a context of its own as before the pool,
+// then with pooled contexts. Blocks the game thread.
+static FAutoConsoleCommand ContextPoolBenchmarkCommand(
+	TEXT("OVRLipSync.ContextPoolBenchmark"),
+	TEXT("Compare per-actor and pooled lip-sync contexts. Args: [Actors=50] [Utterances=5] [Seconds=2]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString> &Args) {
+		const int32 Actors = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 50;
+		const int32 Utterances = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 5;
+		const float Seconds = Args.Num() > 2 ? FMath::Max(0.1f, FCString::Atof(*Args[2])) : 2.f;
+
+		const TArray<int16> Utterance = MakeUtterance(Seconds);
+		const FModeResult PerActor = RunMode(false, Actors, Utterances, Utterance);
+		const FModeResult Pooled = RunMode(true, Actors, Utterances, Utterance);
+
+		UE_LOG(LogOvrLipSync, Log, TEXT("Context pool benchmark: %d actors, %d utterances of %.1f s each"), Actors,
+			   Utterances, Seconds);
+		LogMode(TEXT("Per actor"), PerActor, Actors, Utterances);
+		LogMode(TEXT("Pooled"), Pooled, Actors, Utterances);
+
+		const FOVRLipSyncContextPool::FStats Stats = FOVRLipSyncContextPool::Get().GetStats();
+		UE_LOG(LogOvrLipSync, Log, TEXT("Pool: reused %d, destroyed %d, peak in use %d, idle %d"), Stats.Reused,
+			   Stats.Destroyed, Stats.PeakInUse, Stats.Idle);
+		// The benchmark's contexts are not kept around.
+		FOVRLipSyncContextPool::Get().Empty();
+	}));
+
+#endif
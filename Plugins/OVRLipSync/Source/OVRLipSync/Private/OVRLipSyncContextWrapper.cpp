@@ -29,6 +29,7 @@
 
 #include <Core.h>
 #include <algorithm>
+#include "Misc/ScopeLock.h"
 
 UOVRLipSyncContextWrapper::UOVRLipSyncContextWrapper(ovrLipSyncContextProvider ProviderKind, int SampleRate,
 													 int BufferSize, FString ModelPath, bool EnableAcceleration)
@@ -39,7 +40,7 @@ UOVRLipSyncContextWrapper::UOVRLipSyncContextWrapper(ovrLipSyncContextProvider P
 	auto pluginDir = OVRLipSyncPlugin->GetBaseDir();
 	auto libDir = FPaths::Combine(pluginDir, TEXT("ThirdParty"), TEXT("Lib"),
 								  FPlatformProcess::GetBinariesSubdirectory());
-	UE_LOG(LogOvrLipSync, Error, TEXT("Dir: %s"), *libDir);
+	UE_LOG(LogOvrLipSync, Verbose, TEXT("Dir: %s"), *libDir);
 	TArray<char> libDirChar(libDir.GetCharArray());
 	auto rc = ovrLipSync_InitializeEx(SampleRate, BufferSize, libDirChar.GetData());
 #else
@@ -62,6 +63,22 @@ UOVRLipSyncContextWrapper::UOVRLipSyncContextWrapper(ovrLipSyncContextProvider P
 
 UOVRLipSyncContextWrapper::~UOVRLipSyncContextWrapper() { ovrLipSync_DestroyContext(LipSyncContext); }
 
+bool UOVRLipSyncContextWrapper::Reset()
+{
+	{
+		FScopeLock Lock(&AsyncCallbackMutex);
+		AsyncCallback = [](const TArray<float> &, float) {};
+		AsyncGeneration++;
+	}
+	auto rc = ovrLipSync_ResetContext(LipSyncContext);
+	if (rc != ovrLipSyncSuccess)
+	{
+		UE_LOG(LogOvrLipSync, Error, TEXT("Failed to reset context: %d"), rc);
+		return false;
+	}
+	return true;
+}
+
 void UOVRLipSyncContextWrapper::ProcessFrame(const int16_t *AudioBuffer, int AudioBufferSize, TArray<float> &Visemes,
 											 float &LaughterScore, int32_t &FrameDelay, bool Stereo)
 {
@@ -86,23 +103,40 @@ void UOVRLipSyncContextWrapper::ProcessFrame(const int16_t *AudioBuffer, int Aud
 
 namespace
 {
+//@Inworld: opaque of an async frame, the callback is called once per submitted frame, on error too.
+struct FAsyncFrame
+{
+	UOVRLipSyncContextWrapper *Wrapper;
+	uint32 Generation;
+};
+
 void ProcessFrameCallback(void *opaque, const ovrLipSyncFrame *pFrame, ovrLipSyncResult result)
 {
+	TUniquePtr<FAsyncFrame> Frame(reinterpret_cast<FAsyncFrame *>(opaque));
 	if (result != ovrLipSyncSuccess)
 	{
 		UE_LOG(LogOvrLipSync, Error, TEXT("Async prediction failed: %d"), result);
 		return;
 	}
-	auto wrapper = reinterpret_cast<UOVRLipSyncContextWrapper *>(opaque);
 	TArray<float> Visemes(pFrame->visemes, pFrame->visemesLength);
-	wrapper->InvokeAsyncCallback(Visemes, pFrame->laughterScore);
+	Frame->Wrapper->InvokeAsyncCallback(Visemes, pFrame->laughterScore, Frame->Generation);
 }
 } // namespace
 
-void UOVRLipSyncContextWrapper::SetAsyncCallback(const AsyncCallbackType &Callback) { AsyncCallback = Callback; }
+void UOVRLipSyncContextWrapper::SetAsyncCallback(const AsyncCallbackType &Callback)
+{
+	FScopeLock Lock(&AsyncCallbackMutex);
+	AsyncCallback = Callback;
+}
 
-void UOVRLipSyncContextWrapper::InvokeAsyncCallback(const TArray<float> &Visemes, float LaughterScore)
+void UOVRLipSyncContextWrapper::InvokeAsyncCallback(const TArray<float> &Visemes, float LaughterScore, uint32 Generation)
 {
+	// Held while the callback runs, Reset doesn't return while the previous owner is being called.
+	FScopeLock Lock(&AsyncCallbackMutex);
+	if (Generation != AsyncGeneration)
+	{
+		return;
+	}
 	if (!AsyncCallback)
 	{
 		UE_LOG(LogOvrLipSync, Error, TEXT("Trying invoke unintialized async callback"));
@@ -113,12 +147,18 @@ void UOVRLipSyncContextWrapper::InvokeAsyncCallback(const TArray<float> &Visemes
 
 void UOVRLipSyncContextWrapper::ProcessFrameAsync(const int16_t *AudioBuffer, int AudioBufferSize, bool Stereo)
 {
+	FAsyncFrame *Frame = new FAsyncFrame{this, 0};
+	{
+		FScopeLock Lock(&AsyncCallbackMutex);
+		Frame->Generation = AsyncGeneration;
+	}
 	auto rc = ovrLipSync_ProcessFrameAsync(
 		LipSyncContext, AudioBuffer, AudioBufferSize,
-		Stereo ? ovrLipSyncAudioDataType_S16_Stereo : ovrLipSyncAudioDataType_S16_Mono, ProcessFrameCallback, this);
+		Stereo ? ovrLipSyncAudioDataType_S16_Stereo : ovrLipSyncAudioDataType_S16_Mono, ProcessFrameCallback, Frame);
 	if (rc != ovrLipSyncSuccess)
 	{
 		UE_LOG(LogOvrLipSync, Error, TEXT("Failed to start async prediction: %d"), rc);
+		delete Frame;
 		return;
 	}
 }
@@ -28,6 +28,8 @@
 #include "AndroidPermissionFunctionLibrary.h"
 #endif
 #include "OVRLipSyncContextWrapper.h"
+//@Inworld
+#include "OVRLipSyncContextPool.h"
 #include "Voice/Public/VoiceModule.h"
 
 #include <Core.h>
@@ -59,8 +61,9 @@ void UOVRLipSyncActorComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	LipSyncContext = MakeShared<UOVRLipSyncContextWrapper>(ContextProviderFromProviderKind(ProviderKind), SampleRate,
-														   BufferSize, FString(), EnableHardwareAcceleration);
+	//@Inworld: shared context pool, EndPlay returns the context
+	LipSyncContext = FOVRLipSyncContextPool::Get().Acquire(ContextProviderFromProviderKind(ProviderKind), SampleRate,
+														   BufferSize, EnableHardwareAcceleration);
 	LipSyncContext->SetAsyncCallback([this](const TArray<float> &NewVisemes, float NewLaughterScore) {
 		Visemes = NewVisemes;
 		LaughterScore = NewLaughterScore;
@@ -24,13 +24,20 @@
 
 #include "Modules/ModuleManager.h"
 #include "OVRLipSync.h"
+//@Inworld
+#include "OVRLipSyncContextPool.h"
 
 DEFINE_LOG_CATEGORY(LogOvrLipSync);
 
 class FOVRLipSyncModule : public IModuleInterface
 {
 public:
-	void ShutdownModule() override { ovrLipSync_Shutdown(); }
+	void ShutdownModule() override
+	{
+		//@Inworld: pooled contexts are destroyed while the library is still up
+		FOVRLipSyncContextPool::Get().Shutdown();
+		ovrLipSync_Shutdown();
+	}
 };
 
 IMPLEMENT_MODULE(FOVRLipSyncModule, OVRLipSync);
@@ -0,0 +1,69 @@
+// Copyright 2023 Theai, Inc. (DBA Inworld) All Rights Reserved.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "OVRLipSync.h"
+
+class UOVRLipSyncContextWrapper;
+
+// Process-wide pool of lip-sync contexts. Creating one initializes the library and loads the provider's model,
+// which costs milliseconds and memory per actor or utterance; pooled contexts are created once per concurrent
+// user instead. Contexts are keyed by everything they are created with, model file contexts are not pooled.
+// Thread safe.
+class OVRLIPSYNC_API FOVRLipSyncContextPool
+{
+public:
+	struct FStats
+	{
+		int32 Created = 0;
+		// Acquires served by an idle context.
+		int32 Reused = 0;
+		int32 Released = 0;
+		// Released contexts the pool had no room for, or that failed to reset.
+		int32 Destroyed = 0;
+		int32 InUse = 0;
+		int32 PeakInUse = 0;
+		int32 Idle = 0;
+	};
+
+	static FOVRLipSyncContextPool &Get();
+
+	// The context goes back to the pool, reset, when the last reference is dropped. Its async callback is
+	// replaced then and frames still in flight are dropped, neither the previous nor the next owner gets them.
+	TSharedPtr<UOVRLipSyncContextWrapper> Acquire(ovrLipSyncContextProvider Provider, int SampleRate = 48000,
+												  int BufferSize = 4096, bool Accelerate = true);
+
+	FStats GetStats() const;
+
+	// Destroys the idle contexts.
+	void Empty();
+	// Before the library is shut down. Contexts released after are destroyed.
+	void Shutdown();
+
+private:
+	struct FKey
+	{
+		ovrLipSyncContextProvider Provider;
+		int SampleRate;
+		int BufferSize;
+		bool Accelerate;
+
+		bool operator==(const FKey &Other) const
+		{
+			return Provider == Other.Provider && SampleRate == Other.SampleRate && BufferSize == Other.BufferSize &&
+				   Accelerate == Other.Accelerate;
+		}
+		friend uint32 GetTypeHash(const FKey &Key)
+		{
+			const uint32 Hash = HashCombine(::GetTypeHash(static_cast<int32>(Key.Provider)), ::GetTypeHash(Key.SampleRate));
+			return HashCombine(Hash, HashCombine(::GetTypeHash(Key.BufferSize), ::GetTypeHash(Key.Accelerate)));
+		}
+	};
+
+	void Release(UOVRLipSyncContextWrapper *Context, const FKey &Key);
+
+	mutable FCriticalSection Mutex;
+	TMap<FKey, TArray<UOVRLipSyncContextWrapper *>> IdleContexts;
+	FStats Stats;
+	bool bShutdown = false;
+};
@@ -38,10 +38,20 @@ public:
 	// Async processing
 	using AsyncCallbackType = TFunction<void(const TArray<float> &Visemes, float LaughterScore)>;
 	void SetAsyncCallback(const AsyncCallbackType &AsyncCallback);
-	void InvokeAsyncCallback(const TArray<float> &Visemes, float LaughterScore);
+	//@Inworld: Generation is the one the frame was submitted in, results of an older one are dropped.
+	void InvokeAsyncCallback(const TArray<float> &Visemes, float LaughterScore, uint32 Generation);
 	void ProcessFrameAsync(const int16_t *Data, int DataSize, bool Stereo = false);
 
+	//@Inworld: used by FOVRLipSyncContextPool
+	bool IsValid() const { return LipSyncContext != 0; }
+	// Back to the state of a new context, results of async frames still in flight are dropped. Waits for a
+	// callback running on the lip-sync worker, the previous callback is not called once it returns.
+	bool Reset();
+
 private:
+	// The async callback runs on the lip-sync worker thread.
+	FCriticalSection AsyncCallbackMutex;
 	AsyncCallbackType AsyncCallback;
+	uint32 AsyncGeneration = 0;
 	ovrLipSyncContext LipSyncContext = 0;
 };
@@ -12,6 +12,7 @@
 
 #include "OVRLipSyncFrame.h"
 #include "OVRLipSyncContextWrapper.h"
+#include "OVRLipSyncContextPool.h"
 #include "OVRLipSync.h"
 #include "OVRLipSyncPlaybackActorComponent.h"
 
@@ -80,10 +81,10 @@ UOVRLipSyncFrameSequence* UInworldCharacterPlaybackAudioLip::SoundWaveToLipSyncS
 	int32 FrameDelayInMs = 0;
 	TArray<float> Visemes;
 
-	UOVRLipSyncContextWrapper Context(ovrLipSyncContextProvider_Enhanced, SampleRate, 4096, FString());
+	TSharedPtr<UOVRLipSyncContextWrapper> Context = FOVRLipSyncContextPool::Get().Acquire(ovrLipSyncContextProvider_Enhanced, SampleRate, 4096);
 	TArray<int16> Samples;
 	Samples.SetNumZeroed(ChunkSize);
-	Context.ProcessFrame(Samples.GetData(), ChunkSizeSamples, Visemes, LaughterScore, FrameDelayInMs, NumChannels > 1);
+	Context->ProcessFrame(Samples.GetData(), ChunkSizeSamples, Visemes, LaughterScore, FrameDelayInMs, NumChannels > 1);
 
 	const int32 FrameOffset = static_cast<int32>(FrameDelayInMs * SampleRate / 1000 * NumChannels);
 
@@ -93,7 +94,7 @@ UOVRLipSyncFrameSequence* UInworldCharacterPlaybackAudioLip::SoundWaveToLipSyncS
 		const int32 RemainingSamples = PCMDataSize - Offset;
 		if (RemainingSamples >= ChunkSize)
 		{
-			Context.ProcessFrame(PCMData + Offset, ChunkSizeSamples, Visemes, LaughterScore, FrameDelayInMs, NumChannels > 1);
+			Context->ProcessFrame(PCMData + Offset, ChunkSizeSamples, Visemes, LaughterScore, FrameDelayInMs, NumChannels > 1);
 		}
 		else
 		{
@@ -106,7 +107,7 @@ UOVRLipSyncFrameSequence* UInworldCharacterPlaybackAudioLip::SoundWaveToLipSyncS
 			{
 				FMemory::Memset(Samples.GetData(), 0, ChunkSize);
 			}
-			Context.ProcessFrame(Samples.GetData(), ChunkSizeSamples, Visemes, LaughterScore, FrameDelayInMs, NumChannels > 1);
+			Context->ProcessFrame(Samples.GetData(), ChunkSizeSamples, Visemes, LaughterScore, FrameDelayInMs, NumChannels > 1);
 		}
 
 		if (Offset >= FrameOffset)
@@ -18,7 +18,7 @@ void UOriginInteractionWatcher::BeginWatch(UInworldCharacterComponent* Character
 	WatchedCharacter = CharacterToStartWatching;
 
 	UInworldCharacterPlaybackHistory* History = Cast<UInworldCharacterPlaybackHistory>(WatchedCharacter->GetPlayback(UInworldCharacterPlaybackHistory::StaticClass()));
-	if(History) History->OnInteractionsChanged.AddDynamic(this, &UOriginInteractionWatcher::OnWatchedCharacterInteractionsChanged);
+	if(History) History->OnInteractionChanged.AddDynamic(this, &UOriginInteractionWatcher::OnWatchedCharacterInteractionChanged);
 }
 
 void UOriginInteractionWatcher::EndWatch()
@@ -28,27 +28,53 @@ void UOriginInteractionWatcher::EndWatch()
 		return;
 	}
 
-	NumProcessedInteractions = 0;
+	PendingInteractions.Empty();
 
 	UInworldCharacterPlaybackHistory* History = Cast<UInworldCharacterPlaybackHistory>(WatchedCharacter->GetPlayback(UInworldCharacterPlaybackHistory::StaticClass()));
-	History->OnInteractionsChanged.RemoveDynamic(this, &UOriginInteractionWatcher::OnWatchedCharacterInteractionsChanged);
+	if(History) History->OnInteractionChanged.RemoveDynamic(this, &UOriginInteractionWatcher::OnWatchedCharacterInteractionChanged);
 
 	WatchedCharacter = nullptr;
 }
 
-void UOriginInteractionWatcher::OnWatchedCharacterInteractionsChanged(const TArray<FInworldCharacterInteraction>& Interactions)
+void UOriginInteractionWatcher::OnWatchedCharacterInteractionChanged(const FInworldCharacterInteraction& Interaction, EInworldCharacterInteractionChange Change)
 {
-	for (int32 i = NumProcessedInteractions; i < Interactions.Num(); ++i)
+	if (Change == EInworldCharacterInteractionChange::Added)
 	{
-		const FInworldCharacterInteraction& Interaction = Interactions[i];
-		if (Interaction.bTextFinal)
+		PendingInteractions.Add(Interaction);
+	}
+	else
+	{
+		// Interactions already broadcast are no longer pending, their later changes are ignored.
+		const int32 Index = PendingInteractions.IndexOfByPredicate([&Interaction](const auto& I) { return I.UtteranceId == Interaction.UtteranceId; });
+		if (Index == INDEX_NONE)
+		{
+			return;
+		}
+		if (Change == EInworldCharacterInteractionChange::Updated)
 		{
-			OnOriginInteraction.Broadcast(WatchedCharacter.Get(), Interaction.bPlayerInteraction, Interaction.InteractionId, Interaction.Text);
-			NumProcessedInteractions = i + 1;
+			PendingInteractions[Index] = Interaction;
 		}
 		else
 		{
-			break;
+			PendingInteractions.RemoveAt(Index);
 		}
 	}
+
+	int32 NumFinal = 0;
+	while (NumFinal < PendingInteractions.Num() && PendingInteractions[NumFinal].bTextFinal)
+	{
+		NumFinal++;
+	}
+	if (NumFinal == 0)
+	{
+		return;
+	}
+
+	// Taken out first, handlers may end the watch.
+	TArray<FInworldCharacterInteraction> Finals(PendingInteractions.GetData(), NumFinal);
+	PendingInteractions.RemoveAt(0, NumFinal);
+	for (const FInworldCharacterInteraction& Final : Finals)
+	{
+		OnOriginInteraction.Broadcast(WatchedCharacter.Get(), Final.bPlayerInteraction, Final.InteractionId, Final.Text);
+	}
 }
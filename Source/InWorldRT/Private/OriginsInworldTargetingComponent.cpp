@@ -197,6 +197,11 @@ void UOriginsInworldTargetingComponent::UpdateTargetCharacter()
     TWeakObjectPtr<UInworldCharacterComponent> TargetCharacter = PermanentTargetCharacter.IsValid() ? PermanentTargetCharacter : FocusTargetCharacter;
     if (TargetCharacter.IsValid())
     {
+        if (TargetCharacter->GetAgentId().IsEmpty())
+        {
+            InworldSubsystem->PossessCharacterComponent(TargetCharacter->GetBrainName());
+        }
+
         // Swap with proxy component if one exists, and mark the fake one as the pass-thru
         TWeakObjectPtr<UInworldCharacterComponent> ResolvedTargetCharacter = static_cast<UInworldCharacterComponent*>(InworldSubsystem->GetCharacterComponentByAgentId(TargetCharacter->GetAgentId()));
         if (ResolvedTargetCharacter != nullptr && ResolvedTargetCharacter->IsA<UInworldCharacterProxyComponent>())
@@ -32,10 +32,11 @@ public:
 
 private:
 	UFUNCTION()
-	void OnWatchedCharacterInteractionsChanged(const TArray<FInworldCharacterInteraction>& Interactions);
+	void OnWatchedCharacterInteractionChanged(const FInworldCharacterInteraction& Interaction, EInworldCharacterInteractionChange Change);
 
 	UPROPERTY()
 	TWeakObjectPtr<UInworldCharacterComponent> WatchedCharacter;
 
-	int32 NumProcessedInteractions = 0;
+	// Interactions not broadcast yet, in order. Held back until they and the ones before them are final.
+	TArray<FInworldCharacterInteraction> PendingInteractions;
 };